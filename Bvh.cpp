@@ -0,0 +1,597 @@
+#include "Bvh.h"
+#include "MatrixSimd.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+const float kInfinity = std::numeric_limits<float>::infinity();
+const uint32_t kDeferred = ~0u - 1;
+// これより深いところはSAHを使わずに真ん中で分ける(検索のスタックが溢れないように)
+const uint32_t kMaxSahDepth = 32;
+// 子を1つ辿る手間(三角形1枚の判定を1とする)
+const float kTraversalCost = 1.0f;
+// 0の成分を置き換える値(逆数がinfにならないように)
+const float kMinDirection = 1e-20f;
+// 箱の奥の距離を少し伸ばし、丸め誤差で箱の面の上の交点を落とさないようにする
+const float kFarScale = 1.0000004f;
+
+const BvhIntersectFunction kBvhIntersectFunctions[kMatrixBackendCount] = {
+    BvhIntersectScalar,
+#ifdef CG3_MATH_SSE
+    BvhIntersectSSE,
+    BvhIntersectSSE,
+#else
+    BvhIntersectScalar,
+    BvhIntersectScalar,
+#endif
+};
+
+AABB MakeEmptyAABB() { return { { kInfinity, kInfinity, kInfinity }, { -kInfinity, -kInfinity, -kInfinity } }; }
+
+void Merge(AABB& aabb, const Vector3& point)
+{
+    aabb.min = { std::min(aabb.min.x, point.x), std::min(aabb.min.y, point.y), std::min(aabb.min.z, point.z) };
+    aabb.max = { std::max(aabb.max.x, point.x), std::max(aabb.max.y, point.y), std::max(aabb.max.z, point.z) };
+}
+
+void Merge(AABB& aabb, const AABB& other)
+{
+    Merge(aabb, other.min);
+    Merge(aabb, other.max);
+}
+
+// 表面積の半分(空の箱は0)
+float HalfArea(const AABB& aabb)
+{
+    float x = aabb.max.x - aabb.min.x;
+    float y = aabb.max.y - aabb.min.y;
+    float z = aabb.max.z - aabb.min.z;
+    return x < 0.0f ? 0.0f : x * y + y * z + z * x;
+}
+
+float GetAxis(const Vector3& v, uint32_t axis) { return axis == 0 ? v.x : axis == 1 ? v.y : v.z; }
+
+// 2分木のノード。leftがkBvhNoneなら葉、kDeferredなら後でスレッドに分けて作る部分木(rightが番号)
+struct BuildNode {
+    AABB bounds;
+    uint32_t left;
+    uint32_t right;
+    uint32_t begin; // orderでの範囲
+    uint32_t count;
+};
+
+struct BuildTask {
+    uint32_t begin;
+    uint32_t end;
+    uint32_t depth;
+    std::vector<BuildNode> nodes; // 0番が部分木の根
+};
+
+struct BuildInput {
+    std::vector<AABB> triangleBounds;
+    std::vector<Vector3> centroids;
+    std::vector<uint32_t> order; // 三角形の番号。作りながら並べ替える
+};
+
+struct Split {
+    float cost;
+    uint32_t axis;
+    uint32_t bin; // このビンより前を左にする
+};
+
+uint32_t GetBin(float centroid, float minCentroid, float scale) { return std::min(kBvhBinCount - 1, uint32_t((centroid - minCentroid) * scale)); }
+
+// 各軸のビンでSAHの一番小さい分け方を探す(重心が全て同じなら見つからずcostはinf)
+Split FindSplit(const BuildInput& input, uint32_t begin, uint32_t end, const AABB& centroidBounds)
+{
+    Split best = { kInfinity, 0, 0 };
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        float minCentroid = GetAxis(centroidBounds.min, axis);
+        float extent = GetAxis(centroidBounds.max, axis) - minCentroid;
+        if (!(extent > 0.0f)) {
+            continue;
+        }
+        float scale = float(kBvhBinCount) / extent;
+        AABB binBounds[kBvhBinCount];
+        uint32_t binCounts[kBvhBinCount] = {};
+        std::fill(std::begin(binBounds), std::end(binBounds), MakeEmptyAABB());
+        for (uint32_t i = begin; i < end; ++i) {
+            uint32_t triangle = input.order[i];
+            uint32_t bin = GetBin(GetAxis(input.centroids[triangle], axis), minCentroid, scale);
+            Merge(binBounds[bin], input.triangleBounds[triangle]);
+            ++binCounts[bin];
+        }
+
+        // 右から足した面積と数を先に求め、左から足しながら比べる
+        float rightAreas[kBvhBinCount];
+        uint32_t rightCounts[kBvhBinCount];
+        AABB rightBounds = MakeEmptyAABB();
+        uint32_t rightCount = 0;
+        for (uint32_t bin = kBvhBinCount - 1; bin > 0; --bin) {
+            Merge(rightBounds, binBounds[bin]);
+            rightCount += binCounts[bin];
+            rightAreas[bin] = HalfArea(rightBounds);
+            rightCounts[bin] = rightCount;
+        }
+        AABB leftBounds = MakeEmptyAABB();
+        uint32_t leftCount = 0;
+        for (uint32_t bin = 1; bin < kBvhBinCount; ++bin) {
+            Merge(leftBounds, binBounds[bin - 1]);
+            leftCount += binCounts[bin - 1];
+            if (leftCount == 0 || rightCounts[bin] == 0) {
+                continue;
+            }
+            float cost = HalfArea(leftBounds) * float(leftCount) + rightAreas[bin] * float(rightCounts[bin]);
+            if (cost < best.cost) {
+                best = { cost, axis, bin };
+            }
+        }
+    }
+    return best;
+}
+
+uint32_t BuildSubtree(BuildInput& input, std::vector<BuildNode>& nodes, uint32_t begin, uint32_t end, uint32_t depth, std::vector<BuildTask>* tasks)
+{
+    uint32_t nodeIndex = uint32_t(nodes.size());
+    nodes.push_back({ MakeEmptyAABB(), kBvhNone, kBvhNone, begin, end - begin });
+
+    AABB bounds = MakeEmptyAABB();
+    AABB centroidBounds = MakeEmptyAABB();
+    for (uint32_t i = begin; i < end; ++i) {
+        Merge(bounds, input.triangleBounds[input.order[i]]);
+        Merge(centroidBounds, input.centroids[input.order[i]]);
+    }
+    nodes[nodeIndex].bounds = bounds;
+
+    uint32_t count = end - begin;
+    if (tasks && count <= kBvhParallelTriangleCount) {
+        nodes[nodeIndex].left = kDeferred;
+        nodes[nodeIndex].right = uint32_t(tasks->size());
+        tasks->push_back({ begin, end, depth, {} });
+        return nodeIndex;
+    }
+    if (count == 1) {
+        return nodeIndex;
+    }
+
+    uint32_t middle = begin;
+    if (depth < kMaxSahDepth) {
+        Split split = FindSplit(input, begin, end, centroidBounds);
+        float area = HalfArea(bounds);
+        float splitCost = area > 0.0f ? kTraversalCost + split.cost / area : kInfinity;
+        if (count <= kBvhMaxLeafTriangles && float(count) <= splitCost) {
+            return nodeIndex;
+        }
+        if (split.cost < kInfinity) {
+            float minCentroid = GetAxis(centroidBounds.min, split.axis);
+            float scale = float(kBvhBinCount) / (GetAxis(centroidBounds.max, split.axis) - minCentroid);
+            middle = uint32_t(std::partition(input.order.begin() + begin, input.order.begin() + end, [&](uint32_t triangle) {
+                return GetBin(GetAxis(input.centroids[triangle], split.axis), minCentroid, scale) < split.bin;
+            }) - input.order.begin());
+        }
+    } else if (count <= kBvhMaxLeafTriangles) {
+        return nodeIndex;
+    }
+
+    // SAHで分けられなければ、重心の広がりが一番大きい軸の真ん中で数を半分に分ける
+    if (middle == begin || middle == end) {
+        Vector3 extent = { centroidBounds.max.x - centroidBounds.min.x, centroidBounds.max.y - centroidBounds.min.y, centroidBounds.max.z - centroidBounds.min.z };
+        uint32_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+        middle = begin + count / 2;
+        std::nth_element(input.order.begin() + begin, input.order.begin() + middle, input.order.begin() + end, [&](uint32_t a, uint32_t b) {
+            float centroidA = GetAxis(input.centroids[a], axis);
+            float centroidB = GetAxis(input.centroids[b], axis);
+            return centroidA < centroidB || (centroidA == centroidB && a < b);
+        });
+    }
+
+    uint32_t left = BuildSubtree(input, nodes, begin, middle, depth + 1, tasks);
+    uint32_t right = BuildSubtree(input, nodes, middle, end, depth + 1, tasks);
+    nodes[nodeIndex].left = left;
+    nodes[nodeIndex].right = right;
+    return nodeIndex;
+}
+
+// 2分木を4分木にまとめて並べる
+class Collapser {
+public:
+    Collapser(const BuildInput& input, const std::vector<BuildTask>& tasks, const std::vector<VertexData>& vertices, const uint32_t* indices,
+        std::vector<BvhNode>& nodes, std::vector<BvhTrianglePack>& packs)
+        : input_(input)
+        , tasks_(tasks)
+        , vertices_(vertices)
+        , indices_(indices)
+        , nodes_(nodes)
+        , packs_(packs)
+    {
+    }
+
+    struct NodeRef {
+        const std::vector<BuildNode>* nodes;
+        uint32_t index;
+        const BuildNode& Get() const { return (*nodes)[index]; }
+    };
+
+    // 後で作った部分木なら、その根にする
+    NodeRef Resolve(NodeRef ref) const
+    {
+        while (ref.Get().left == kDeferred) {
+            ref = { &tasks_[ref.Get().right].nodes, 0 };
+        }
+        return ref;
+    }
+
+    uint32_t Collapse(NodeRef ref)
+    {
+        // 子が4つになるまで、面積が一番大きい内側のノードをその2つの子に置き換える
+        NodeRef candidates[4];
+        uint32_t candidateCount = 0;
+        if (ref.Get().left == kBvhNone) {
+            candidates[candidateCount++] = ref;
+        } else {
+            candidates[candidateCount++] = Resolve({ ref.nodes, ref.Get().left });
+            candidates[candidateCount++] = Resolve({ ref.nodes, ref.Get().right });
+        }
+        while (candidateCount < 4) {
+            uint32_t expand = kBvhNone;
+            float maxArea = -1.0f;
+            for (uint32_t i = 0; i < candidateCount; ++i) {
+                if (candidates[i].Get().left != kBvhNone && maxArea < HalfArea(candidates[i].Get().bounds)) {
+                    expand = i;
+                    maxArea = HalfArea(candidates[i].Get().bounds);
+                }
+            }
+            if (expand == kBvhNone) {
+                break;
+            }
+            NodeRef expanded = candidates[expand];
+            std::move_backward(candidates + expand + 1, candidates + candidateCount, candidates + candidateCount + 1);
+            candidates[expand] = Resolve({ expanded.nodes, expanded.Get().left });
+            candidates[expand + 1] = Resolve({ expanded.nodes, expanded.Get().right });
+            ++candidateCount;
+        }
+
+        uint32_t nodeIndex = uint32_t(nodes_.size());
+        nodes_.emplace_back();
+        for (uint32_t i = 0; i < 4; ++i) {
+            BvhNode& node = nodes_[nodeIndex];
+            if (candidateCount <= i) {
+                node.minX[i] = node.minY[i] = node.minZ[i] = kInfinity;
+                node.maxX[i] = node.maxY[i] = node.maxZ[i] = kInfinity;
+                node.children[i] = kBvhNone;
+                node.packCounts[i] = 0;
+                continue;
+            }
+            const BuildNode& child = candidates[i].Get();
+            node.minX[i] = child.bounds.min.x;
+            node.minY[i] = child.bounds.min.y;
+            node.minZ[i] = child.bounds.min.z;
+            node.maxX[i] = child.bounds.max.x;
+            node.maxY[i] = child.bounds.max.y;
+            node.maxZ[i] = child.bounds.max.z;
+            if (child.left == kBvhNone) {
+                node.children[i] = uint32_t(packs_.size());
+                node.packCounts[i] = AppendPacks(child.begin, child.count);
+            } else {
+                // 作っている間にnodes_が伸びるので、番号で書き込む
+                uint32_t childIndex = Collapse(candidates[i]);
+                nodes_[nodeIndex].children[i] = childIndex;
+                nodes_[nodeIndex].packCounts[i] = 0;
+            }
+        }
+        return nodeIndex;
+    }
+
+private:
+    uint32_t AppendPacks(uint32_t begin, uint32_t count)
+    {
+        uint32_t packCount = (count + 3) / 4;
+        for (uint32_t p = 0; p < packCount; ++p) {
+            BvhTrianglePack pack = {};
+            for (uint32_t lane = 0; lane < 4; ++lane) {
+                uint32_t i = p * 4 + lane;
+                pack.triangleIndices[lane] = kBvhNone;
+                if (count <= i) {
+                    continue;
+                }
+                uint32_t triangle = input_.order[begin + i];
+                const Vector4& p0 = vertices_[indices_[triangle * 3]].position;
+                const Vector4& p1 = vertices_[indices_[triangle * 3 + 1]].position;
+                const Vector4& p2 = vertices_[indices_[triangle * 3 + 2]].position;
+                pack.v0x[lane] = p0.x;
+                pack.v0y[lane] = p0.y;
+                pack.v0z[lane] = p0.z;
+                pack.e1x[lane] = p1.x - p0.x;
+                pack.e1y[lane] = p1.y - p0.y;
+                pack.e1z[lane] = p1.z - p0.z;
+                pack.e2x[lane] = p2.x - p0.x;
+                pack.e2y[lane] = p2.y - p0.y;
+                pack.e2z[lane] = p2.z - p0.z;
+                pack.triangleIndices[lane] = triangle;
+            }
+            packs_.push_back(pack);
+        }
+        return packCount;
+    }
+
+    const BuildInput& input_;
+    const std::vector<BuildTask>& tasks_;
+    const std::vector<VertexData>& vertices_;
+    const uint32_t* indices_;
+    std::vector<BvhNode>& nodes_;
+    std::vector<BvhTrianglePack>& packs_;
+};
+
+Vector3 Sub(const Vector3& a, const Vector3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+float Dot(const Vector3& a, const Vector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+// 点pに一番近い三角形(a, a + ab, a + ac)の上の点とpの距離の2乗(Ericson, Real-Time Collision Detection 5.1.5)
+float DistanceSquaredToTriangle(const Vector3& p, const Vector3& a, const Vector3& ab, const Vector3& ac)
+{
+    auto distanceSquared = [&](const Vector3& q) { return Dot(Sub(p, q), Sub(p, q)); };
+    Vector3 ap = Sub(p, a);
+    float d1 = Dot(ab, ap);
+    float d2 = Dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        return distanceSquared(a);
+    }
+    Vector3 bp = Sub(ap, ab);
+    float d3 = Dot(ab, bp);
+    float d4 = Dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) {
+        return Dot(bp, bp);
+    }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        float v = d1 / (d1 - d3);
+        return distanceSquared({ a.x + ab.x * v, a.y + ab.y * v, a.z + ab.z * v });
+    }
+    Vector3 cp = Sub(ap, ac);
+    float d5 = Dot(ab, cp);
+    float d6 = Dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) {
+        return Dot(cp, cp);
+    }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        float w = d2 / (d2 - d6);
+        return distanceSquared({ a.x + ac.x * w, a.y + ac.y * w, a.z + ac.z * w });
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        return distanceSquared({ a.x + ab.x + (ac.x - ab.x) * w, a.y + ab.y + (ac.y - ab.y) * w, a.z + ab.z + (ac.z - ab.z) * w });
+    }
+    float denominator = 1.0f / (va + vb + vc);
+    float v = vb * denominator;
+    float w = vc * denominator;
+    return distanceSquared({ a.x + ab.x * v + ac.x * w, a.y + ab.y * v + ac.y * w, a.z + ab.z * v + ac.z * w });
+}
+
+float InverseDirection(float direction)
+{
+    return 1.0f / (std::abs(direction) < kMinDirection ? (direction < 0.0f ? -kMinDirection : kMinDirection) : direction);
+}
+
+// 検索のスタックに積むもの
+struct StackEntry {
+    uint32_t index;
+    uint32_t packCount; // 0ならノード
+    float tNear;
+};
+
+} // namespace
+
+Ray MakeScreenRay(const Matrix4x4& inverseMatrix, float ndcX, float ndcY)
+{
+    auto transform = [&](float z) {
+        const float(&m)[4][4] = inverseMatrix.m;
+        float x = ndcX * m[0][0] + ndcY * m[1][0] + z * m[2][0] + m[3][0];
+        float y = ndcX * m[0][1] + ndcY * m[1][1] + z * m[2][1] + m[3][1];
+        float w = ndcX * m[0][3] + ndcY * m[1][3] + z * m[2][3] + m[3][3];
+        float zz = ndcX * m[0][2] + ndcY * m[1][2] + z * m[2][2] + m[3][2];
+        return Vector3 { x / w, y / w, zz / w };
+    };
+    Vector3 nearPoint = transform(0.0f);
+    Vector3 farPoint = transform(1.0f);
+    return { nearPoint, Sub(farPoint, nearPoint) };
+}
+
+bool BvhIntersectScalar(const BvhNode* nodes, const BvhTrianglePack* packs, const Ray& ray, float maxT, RayHit* hit)
+{
+    const Vector3& origin = ray.origin;
+    const Vector3& direction = ray.direction;
+    Vector3 inverse = { InverseDirection(direction.x), InverseDirection(direction.y), InverseDirection(direction.z) };
+    float bestT = maxT;
+    bool isHit = false;
+
+    StackEntry stack[kBvhStackSize];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = { 0, 0, 0.0f };
+    while (stackSize > 0) {
+        StackEntry entry = stack[--stackSize];
+        if (bestT <= entry.tNear) {
+            continue;
+        }
+
+        if (entry.packCount != 0) {
+            for (uint32_t p = entry.index; p < entry.index + entry.packCount; ++p) {
+                const BvhTrianglePack& pack = packs[p];
+                for (uint32_t lane = 0; lane < 4; ++lane) {
+                    float px = direction.y * pack.e2z[lane] - direction.z * pack.e2y[lane];
+                    float py = direction.z * pack.e2x[lane] - direction.x * pack.e2z[lane];
+                    float pz = direction.x * pack.e2y[lane] - direction.y * pack.e2x[lane];
+                    float det = pack.e1x[lane] * px + pack.e1y[lane] * py + pack.e1z[lane] * pz;
+                    float inverseDet = 1.0f / det;
+                    float sx = origin.x - pack.v0x[lane];
+                    float sy = origin.y - pack.v0y[lane];
+                    float sz = origin.z - pack.v0z[lane];
+                    float u = (sx * px + sy * py + sz * pz) * inverseDet;
+                    float qx = sy * pack.e1z[lane] - sz * pack.e1y[lane];
+                    float qy = sz * pack.e1x[lane] - sx * pack.e1z[lane];
+                    float qz = sx * pack.e1y[lane] - sy * pack.e1x[lane];
+                    float v = (direction.x * qx + direction.y * qy + direction.z * qz) * inverseDet;
+                    float t = (pack.e2x[lane] * qx + pack.e2y[lane] * qy + pack.e2z[lane] * qz) * inverseDet;
+                    if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t < bestT) {
+                        if (!hit) {
+                            return true;
+                        }
+                        bestT = t;
+                        *hit = { t, pack.triangleIndices[lane], u, v };
+                        isHit = true;
+                    }
+                }
+            }
+            continue;
+        }
+
+        // 当たった子を近い順に並べ、遠いものから積む
+        const BvhNode& node = nodes[entry.index];
+        StackEntry children[4];
+        uint32_t childCount = 0;
+        for (uint32_t i = 0; i < 4; ++i) {
+            float tx0 = (node.minX[i] - origin.x) * inverse.x;
+            float tx1 = (node.maxX[i] - origin.x) * inverse.x;
+            float ty0 = (node.minY[i] - origin.y) * inverse.y;
+            float ty1 = (node.maxY[i] - origin.y) * inverse.y;
+            float tz0 = (node.minZ[i] - origin.z) * inverse.z;
+            float tz1 = (node.maxZ[i] - origin.z) * inverse.z;
+            float tNear = std::max(std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::min(tz0, tz1)), 0.0f);
+            float tFar = std::min(std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::max(tz0, tz1)), bestT) * kFarScale;
+            if (tNear <= tFar) {
+                uint32_t position = childCount++;
+                while (position > 0 && children[position - 1].tNear > tNear) {
+                    children[position] = children[position - 1];
+                    --position;
+                }
+                children[position] = { node.children[i], node.packCounts[i], tNear };
+            }
+        }
+        while (childCount > 0) {
+            stack[stackSize++] = children[--childCount];
+        }
+    }
+    return isHit;
+}
+
+void Bvh::Build(const ModelData& modelData, uint32_t threadCount)
+{
+    Build(modelData.vertices, modelData.indices.data(), modelData.indices.size(), threadCount);
+}
+
+void Bvh::Build(const std::vector<VertexData>& vertices, const uint32_t* indices, size_t indexCount, uint32_t threadCount)
+{
+    Clear();
+    uint32_t triangleCount = uint32_t(indexCount / 3);
+    if (triangleCount == 0) {
+        return;
+    }
+    threadCount = GetWorkerThreadCount(threadCount);
+
+    BuildInput input;
+    input.triangleBounds.resize(triangleCount);
+    input.centroids.resize(triangleCount);
+    input.order.resize(triangleCount);
+    std::iota(input.order.begin(), input.order.end(), 0u);
+    const uint32_t kChunkSize = 65536;
+    ParallelFor((triangleCount + kChunkSize - 1) / kChunkSize, threadCount, [&](uint32_t chunk) {
+        uint32_t end = std::min(triangleCount, (chunk + 1) * kChunkSize);
+        for (uint32_t triangle = chunk * kChunkSize; triangle < end; ++triangle) {
+            AABB bounds = MakeEmptyAABB();
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                const Vector4& p = vertices[indices[triangle * 3 + corner]].position;
+                Merge(bounds, Vector3 { p.x, p.y, p.z });
+            }
+            input.triangleBounds[triangle] = bounds;
+            input.centroids[triangle] = { (bounds.min.x + bounds.max.x) * 0.5f, (bounds.min.y + bounds.max.y) * 0.5f, (bounds.min.z + bounds.max.z) * 0.5f };
+        }
+    });
+
+    // 上の方は1スレッドで分け、小さくなった部分木をスレッドに分けて作る(大きいものから取る)
+    std::vector<BuildNode> topNodes;
+    std::vector<BuildTask> tasks;
+    BuildSubtree(input, topNodes, 0, triangleCount, 0, &tasks);
+    std::vector<uint32_t> taskOrder(tasks.size());
+    std::iota(taskOrder.begin(), taskOrder.end(), 0u);
+    std::stable_sort(taskOrder.begin(), taskOrder.end(), [&](uint32_t a, uint32_t b) { return tasks[a].end - tasks[a].begin > tasks[b].end - tasks[b].begin; });
+    ParallelFor(uint32_t(tasks.size()), threadCount, [&](uint32_t i) {
+        BuildTask& task = tasks[taskOrder[i]];
+        BuildSubtree(input, task.nodes, task.begin, task.end, task.depth, nullptr);
+    });
+
+    nodes_.reserve(triangleCount / 2 + 1);
+    packs_.reserve(triangleCount / 2 + 1);
+    Collapser collapser(input, tasks, vertices, indices, nodes_, packs_);
+    collapser.Collapse(collapser.Resolve({ &topNodes, 0 }));
+    bounds_ = topNodes[0].bounds;
+    triangleCount_ = triangleCount;
+}
+
+void Bvh::Clear()
+{
+    nodes_.clear();
+    packs_.clear();
+    bounds_ = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+    triangleCount_ = 0;
+}
+
+bool Bvh::Intersect(const Ray& ray, float maxT, RayHit& hit) const
+{
+    if (nodes_.empty()) {
+        return false;
+    }
+    return kBvhIntersectFunctions[GetActiveMatrixBackend()](nodes_.data(), packs_.data(), ray, maxT, &hit);
+}
+
+bool Bvh::IsOccluded(const Ray& ray, float maxT) const
+{
+    if (nodes_.empty()) {
+        return false;
+    }
+    return kBvhIntersectFunctions[GetActiveMatrixBackend()](nodes_.data(), packs_.data(), ray, maxT, nullptr);
+}
+
+size_t Bvh::QuerySphere(const Sphere& sphere, std::vector<uint32_t>& triangleIndices) const
+{
+    if (nodes_.empty()) {
+        return 0;
+    }
+    size_t startSize = triangleIndices.size();
+    const Vector3& center = sphere.center;
+    float radiusSquared = sphere.radius * sphere.radius;
+
+    uint32_t stack[kBvhStackSize];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const BvhNode& node = nodes_[stack[--stackSize]];
+        for (uint32_t i = 0; i < 4; ++i) {
+            // 箱の中で一番近い点までの距離
+            float dx = std::clamp(center.x, node.minX[i], node.maxX[i]) - center.x;
+            float dy = std::clamp(center.y, node.minY[i], node.maxY[i]) - center.y;
+            float dz = std::clamp(center.z, node.minZ[i], node.maxZ[i]) - center.z;
+            if (!(dx * dx + dy * dy + dz * dz <= radiusSquared)) {
+                continue;
+            }
+            if (node.packCounts[i] == 0) {
+                stack[stackSize++] = node.children[i];
+                continue;
+            }
+            for (uint32_t p = node.children[i]; p < node.children[i] + node.packCounts[i]; ++p) {
+                const BvhTrianglePack& pack = packs_[p];
+                for (uint32_t lane = 0; lane < 4 && pack.triangleIndices[lane] != kBvhNone; ++lane) {
+                    float distanceSquared = DistanceSquaredToTriangle(center, { pack.v0x[lane], pack.v0y[lane], pack.v0z[lane] },
+                        { pack.e1x[lane], pack.e1y[lane], pack.e1z[lane] }, { pack.e2x[lane], pack.e2y[lane], pack.e2z[lane] });
+                    if (distanceSquared <= radiusSquared) {
+                        triangleIndices.push_back(pack.triangleIndices[lane]);
+                    }
+                }
+            }
+        }
+    }
+    return triangleIndices.size() - startSize;
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include "Model.h"
+#include "MyMath.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 三角形のBVH(レイと球の当たり判定)
+//
+// 構築: 各軸kBvhBinCount個のビンで求めたSAH(表面積ヒューリスティック)で2分木を作り、4分木にまとめて
+//       深さ優先で配列に並べる(1つ目の子はすぐ後ろに来る)。三角形がkBvhParallelTriangleCount枚以下に
+//       なった部分木はスレッドに分けて作る。分け方はスレッド数によらないので、結果は常に同じ
+// ノード: 4つの子の箱をSoAで持ち、レイ1本と4つの箱を同時に判定する。
+//       葉の三角形は4枚ずつSoAでまとめ(BvhTrianglePack)、4枚を同時に判定する。
+//       SSE4.1ではSIMD、それ以外はスカラーで同じ式を計算するので結果は一致する
+//       (実装はMatrix4x4と同じくGetActiveMatrixBackendで選ぶ。AVX2のときもSSE4.1の実装を使う)
+// 検索: 頂点と同じ(モデルの)ローカル空間で行う。三角形は両面とも当たる。
+//       見つかった三角形の番号は元のindicesでの3つずつの番号
+
+const uint32_t kBvhBinCount = 16;
+const uint32_t kBvhMaxLeafTriangles = 8; // 葉の三角形の数の上限(BvhTrianglePack 2つ分)
+const uint32_t kBvhParallelTriangleCount = 16384;
+const uint32_t kBvhStackSize = 256; // 検索で使うスタックの大きさ(構築で深さを抑えているので溢れない)
+const uint32_t kBvhNone = ~0u;
+
+// 4つの子。使わない子の箱は min = max = +inf にしてあり、どの判定にも当たらない
+struct alignas(16) BvhNode {
+    float minX[4];
+    float minY[4];
+    float minZ[4];
+    float maxX[4];
+    float maxY[4];
+    float maxZ[4];
+    uint32_t children[4]; // packCountが0なら子のノードの番号、それ以外なら葉の最初のBvhTrianglePackの番号
+    uint32_t packCounts[4];
+};
+static_assert(sizeof(BvhNode) == 128);
+
+// 三角形4枚(Möller-Trumboreで使う頂点0と2辺)。足りない分は辺が0でどのレイにも当たらない
+struct alignas(16) BvhTrianglePack {
+    float v0x[4];
+    float v0y[4];
+    float v0z[4];
+    float e1x[4];
+    float e1y[4];
+    float e1z[4];
+    float e2x[4];
+    float e2y[4];
+    float e2z[4];
+    uint32_t triangleIndices[4]; // 足りない分はkBvhNone
+};
+static_assert(sizeof(BvhTrianglePack) == 160);
+
+// origin + direction * t (0 <= t)。directionは正規化しなくてよく、tはdirectionの長さを単位にする
+struct Ray {
+    Vector3 origin;
+    Vector3 direction;
+};
+
+struct RayHit {
+    float t;
+    uint32_t triangleIndex;
+    float u; // 交点 = (1 - u - v) * p0 + u * p1 + v * p2
+    float v;
+};
+
+// スクリーンの点(NDC。xは-1から1で右、yは-1から1で上)を通るレイを、逆行列で移した空間で作る。
+// inverseMatrixにInverse(WVP)を渡せばモデルのローカル空間で、t = 0が手前のクリップ面、t = 1が奥のクリップ面
+Ray MakeScreenRay(const Matrix4x4& inverseMatrix, float ndcX, float ndcY);
+
+class Bvh {
+public:
+    // modelData.indices(LODは含めない)の三角形で作る。threadCountが0ならCPUのスレッド数
+    void Build(const ModelData& modelData, uint32_t threadCount = 1);
+    void Build(const std::vector<VertexData>& vertices, const uint32_t* indices, size_t indexCount, uint32_t threadCount = 1);
+    void Clear();
+
+    // tがmaxTより小さい一番近い交点。無ければfalse(hitは変えない)
+    bool Intersect(const Ray& ray, float maxT, RayHit& hit) const;
+    // tがmaxTより小さい交点があるか(一番近いものを探さないぶん速い)
+    bool IsOccluded(const Ray& ray, float maxT) const;
+    // 球と重なる三角形の番号をtriangleIndicesの後ろに足し、足した数を返す(順番は決まっていない)
+    size_t QuerySphere(const Sphere& sphere, std::vector<uint32_t>& triangleIndices) const;
+
+    bool IsEmpty() const { return nodes_.empty(); }
+    const AABB& GetBounds() const { return bounds_; }
+    size_t GetTriangleCount() const { return triangleCount_; }
+    size_t GetNodeCount() const { return nodes_.size(); }
+    size_t GetPackCount() const { return packs_.size(); }
+    size_t GetMemorySize() const { return nodes_.size() * sizeof(BvhNode) + packs_.size() * sizeof(BvhTrianglePack); }
+    const std::vector<BvhNode>& GetNodes() const { return nodes_; }
+    const std::vector<BvhTrianglePack>& GetPacks() const { return packs_; }
+
+private:
+    std::vector<BvhNode> nodes_; // 0番が根
+    std::vector<BvhTrianglePack> packs_;
+    AABB bounds_ = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+    size_t triangleCount_ = 0;
+};
+
+// 以下はSIMD実装用
+// hitがnullptrなら何かに当たった時点でtrueを返す。当たったときだけhitを書き換える
+using BvhIntersectFunction = bool (*)(const BvhNode* nodes, const BvhTrianglePack* packs, const Ray& ray, float maxT, RayHit* hit);
+bool BvhIntersectScalar(const BvhNode* nodes, const BvhTrianglePack* packs, const Ray& ray, float maxT, RayHit* hit);
+#ifdef CG3_MATH_SSE
+bool BvhIntersectSSE(const BvhNode* nodes, const BvhTrianglePack* packs, const Ray& ray, float maxT, RayHit* hit);
+#endif
@@ -0,0 +1,162 @@
+#include "Bvh.h"
+#include <smmintrin.h>
+
+namespace {
+
+// 0の成分を置き換える値と箱の奥の距離に掛ける値(BvhIntersectScalarと同じ)
+const float kMinDirection = 1e-20f;
+const float kFarScale = 1.0000004f;
+
+float InverseDirection(float direction)
+{
+    return 1.0f / (-kMinDirection < direction && direction < kMinDirection ? (direction < 0.0f ? -kMinDirection : kMinDirection) : direction);
+}
+
+struct StackEntry {
+    uint32_t index;
+    uint32_t packCount;
+    float tNear;
+};
+
+// レイの各成分をレジスタ全体に広げたもの
+struct RayLanes {
+    __m128 originX;
+    __m128 originY;
+    __m128 originZ;
+    __m128 directionX;
+    __m128 directionY;
+    __m128 directionZ;
+    __m128 inverseX;
+    __m128 inverseY;
+    __m128 inverseZ;
+};
+
+// 4つの子の箱に当たったbitと、当たった距離(BvhIntersectScalarと同じ順番で計算する)
+int IntersectBoxes(const RayLanes& ray, const BvhNode& node, float maxT, __m128& tNear)
+{
+    __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX), ray.originX), ray.inverseX);
+    __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), ray.originX), ray.inverseX);
+    __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY), ray.originY), ray.inverseY);
+    __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), ray.originY), ray.inverseY);
+    __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ), ray.originZ), ray.inverseZ);
+    __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), ray.originZ), ray.inverseZ);
+    tNear = _mm_max_ps(_mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_min_ps(tz0, tz1)), _mm_setzero_ps());
+    __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_max_ps(tz0, tz1)), _mm_set1_ps(maxT));
+    tFar = _mm_mul_ps(tFar, _mm_set1_ps(kFarScale));
+    return _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+}
+
+// 三角形4枚に当たったbitと、当たった距離とuv
+int IntersectTriangles(const RayLanes& ray, const BvhTrianglePack& pack, float maxT, __m128& t, __m128& u, __m128& v)
+{
+    __m128 e1x = _mm_load_ps(pack.e1x);
+    __m128 e1y = _mm_load_ps(pack.e1y);
+    __m128 e1z = _mm_load_ps(pack.e1z);
+    __m128 e2x = _mm_load_ps(pack.e2x);
+    __m128 e2y = _mm_load_ps(pack.e2y);
+    __m128 e2z = _mm_load_ps(pack.e2z);
+
+    __m128 px = _mm_sub_ps(_mm_mul_ps(ray.directionY, e2z), _mm_mul_ps(ray.directionZ, e2y));
+    __m128 py = _mm_sub_ps(_mm_mul_ps(ray.directionZ, e2x), _mm_mul_ps(ray.directionX, e2z));
+    __m128 pz = _mm_sub_ps(_mm_mul_ps(ray.directionX, e2y), _mm_mul_ps(ray.directionY, e2x));
+    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 inverseDet = _mm_div_ps(one, det);
+    __m128 sx = _mm_sub_ps(ray.originX, _mm_load_ps(pack.v0x));
+    __m128 sy = _mm_sub_ps(ray.originY, _mm_load_ps(pack.v0y));
+    __m128 sz = _mm_sub_ps(ray.originZ, _mm_load_ps(pack.v0z));
+    u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverseDet);
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+    __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+    __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+    v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ray.directionX, qx), _mm_mul_ps(ray.directionY, qy)), _mm_mul_ps(ray.directionZ, qz)), inverseDet);
+    t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverseDet);
+
+    __m128 zero = _mm_setzero_ps();
+    __m128 isHit = _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero));
+    isHit = _mm_and_ps(isHit, _mm_cmple_ps(_mm_add_ps(u, v), one));
+    isHit = _mm_and_ps(isHit, _mm_cmpge_ps(t, zero));
+    isHit = _mm_and_ps(isHit, _mm_cmplt_ps(t, _mm_set1_ps(maxT)));
+    return _mm_movemask_ps(isHit);
+}
+
+}
+
+bool BvhIntersectSSE(const BvhNode* nodes, const BvhTrianglePack* packs, const Ray& ray, float maxT, RayHit* hit)
+{
+    RayLanes lanes = {
+        _mm_set1_ps(ray.origin.x),
+        _mm_set1_ps(ray.origin.y),
+        _mm_set1_ps(ray.origin.z),
+        _mm_set1_ps(ray.direction.x),
+        _mm_set1_ps(ray.direction.y),
+        _mm_set1_ps(ray.direction.z),
+        _mm_set1_ps(InverseDirection(ray.direction.x)),
+        _mm_set1_ps(InverseDirection(ray.direction.y)),
+        _mm_set1_ps(InverseDirection(ray.direction.z)),
+    };
+    float bestT = maxT;
+    bool isHit = false;
+
+    StackEntry stack[kBvhStackSize];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = { 0, 0, 0.0f };
+    while (stackSize > 0) {
+        StackEntry entry = stack[--stackSize];
+        if (bestT <= entry.tNear) {
+            continue;
+        }
+
+        if (entry.packCount != 0) {
+            for (uint32_t p = entry.index; p < entry.index + entry.packCount; ++p) {
+                alignas(16) float t[4], u[4], v[4];
+                __m128 tLanes, uLanes, vLanes;
+                int hitMask = IntersectTriangles(lanes, packs[p], bestT, tLanes, uLanes, vLanes);
+                if (hitMask == 0) {
+                    continue;
+                }
+                if (!hit) {
+                    return true;
+                }
+                _mm_store_ps(t, tLanes);
+                _mm_store_ps(u, uLanes);
+                _mm_store_ps(v, vLanes);
+                // スカラー版と同じく、番号の小さい順に近いものへ置き換える
+                for (uint32_t lane = 0; lane < 4; ++lane) {
+                    if ((hitMask >> lane) & 1 && t[lane] < bestT) {
+                        bestT = t[lane];
+                        *hit = { t[lane], packs[p].triangleIndices[lane], u[lane], v[lane] };
+                        isHit = true;
+                    }
+                }
+            }
+            continue;
+        }
+
+        const BvhNode& node = nodes[entry.index];
+        __m128 tNearLanes;
+        int hitMask = IntersectBoxes(lanes, node, bestT, tNearLanes);
+        if (hitMask == 0) {
+            continue;
+        }
+        alignas(16) float tNear[4];
+        _mm_store_ps(tNear, tNearLanes);
+        StackEntry children[4];
+        uint32_t childCount = 0;
+        for (uint32_t i = 0; i < 4; ++i) {
+            if (((hitMask >> i) & 1) == 0) {
+                continue;
+            }
+            uint32_t position = childCount++;
+            while (position > 0 && children[position - 1].tNear > tNear[i]) {
+                children[position] = children[position - 1];
+                --position;
+            }
+            children[position] = { node.children[i], node.packCounts[i], tNear[i] };
+        }
+        while (childCount > 0) {
+            stack[stackSize++] = children[--childCount];
+        }
+    }
+    return isHit;
+}
@@ -0,0 +1,144 @@
+#include "Camera.h"
+#include <numbers>
+
+namespace {
+
+// 板ポリの表をカメラに向けるためにY軸で半回転させる
+constexpr Matrix4x4 kBackToFrontMatrix = MakeRotateYMatrix(std::numbers::pi_v<float>);
+static_assert(kBackToFrontMatrix.m[0][0] == -1.0f && kBackToFrontMatrix.m[1][1] == 1.0f && kBackToFrontMatrix.m[2][2] == -1.0f);
+static_assert(-1e-6f < kBackToFrontMatrix.m[0][2] && kBackToFrontMatrix.m[0][2] < 1e-6f);
+
+}
+
+Camera::Camera()
+    : transform_ { { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } }
+    , fovY_(0.45f)
+    , aspectRatio_(16.0f / 9.0f)
+    , nearClip_(0.1f)
+    , farClip_(100.0f)
+    , worldMatrix_(MakeIdentity4x4())
+    , viewMatrix_(MakeIdentity4x4())
+    , billboardMatrix_(MakeIdentity4x4())
+    , projectionMatrix_(MakeIdentity4x4())
+    , viewProjectionMatrix_(MakeIdentity4x4())
+    , frustum_ {}
+    , isViewDirty_(true)
+    , isProjectionDirty_(true)
+    , isViewProjectionDirty_(true)
+    , viewUpdateCount_(0)
+    , projectionUpdateCount_(0)
+{
+}
+
+void Camera::SetTransform(const Transform& transform)
+{
+    transform_ = transform;
+    isViewDirty_ = true;
+}
+
+void Camera::SetRotate(const Vector3& rotate)
+{
+    transform_.rotate = rotate;
+    isViewDirty_ = true;
+}
+
+void Camera::SetTranslate(const Vector3& translate)
+{
+    transform_.translate = translate;
+    isViewDirty_ = true;
+}
+
+void Camera::SetProjection(float fovY, float aspectRatio, float nearClip, float farClip)
+{
+    fovY_ = fovY;
+    aspectRatio_ = aspectRatio;
+    nearClip_ = nearClip;
+    farClip_ = farClip;
+    isProjectionDirty_ = true;
+}
+
+void Camera::SetAspectRatio(float aspectRatio)
+{
+    aspectRatio_ = aspectRatio;
+    isProjectionDirty_ = true;
+}
+
+const Matrix4x4& Camera::GetWorldMatrix() const
+{
+    UpdateView();
+    return worldMatrix_;
+}
+
+const Matrix4x4& Camera::GetViewMatrix() const
+{
+    UpdateView();
+    return viewMatrix_;
+}
+
+const Matrix4x4& Camera::GetProjectionMatrix() const
+{
+    UpdateProjection();
+    return projectionMatrix_;
+}
+
+const Matrix4x4& Camera::GetViewProjectionMatrix() const
+{
+    UpdateViewProjection();
+    return viewProjectionMatrix_;
+}
+
+const Matrix4x4& Camera::GetBillboardMatrix() const
+{
+    UpdateView();
+    return billboardMatrix_;
+}
+
+const Frustum& Camera::GetFrustum() const
+{
+    UpdateViewProjection();
+    return frustum_;
+}
+
+void Camera::UpdateView() const
+{
+    if (!isViewDirty_) {
+        return;
+    }
+    worldMatrix_ = MakeAffineMatrix(transform_);
+    // 拡縮していなければ回転と平行移動だけの逆行列で済む
+    const Vector3& scale = transform_.scale;
+    bool isRigid = scale.x == 1.0f && scale.y == 1.0f && scale.z == 1.0f;
+    viewMatrix_ = isRigid ? InverseRigid(worldMatrix_) : InverseAffine(worldMatrix_);
+
+    billboardMatrix_ = Multiply(kBackToFrontMatrix, worldMatrix_);
+    billboardMatrix_.m[3][0] = 0.0f;
+    billboardMatrix_.m[3][1] = 0.0f;
+    billboardMatrix_.m[3][2] = 0.0f;
+
+    isViewDirty_ = false;
+    isViewProjectionDirty_ = true;
+    ++viewUpdateCount_;
+}
+
+void Camera::UpdateProjection() const
+{
+    if (!isProjectionDirty_) {
+        return;
+    }
+    projectionMatrix_ = MakePrespectiveFovMatrix(fovY_, aspectRatio_, nearClip_, farClip_);
+    isProjectionDirty_ = false;
+    isViewProjectionDirty_ = true;
+    ++projectionUpdateCount_;
+}
+
+void Camera::UpdateViewProjection() const
+{
+    UpdateView();
+    UpdateProjection();
+    if (!isViewProjectionDirty_) {
+        return;
+    }
+    viewProjectionMatrix_ = Multiply(viewMatrix_, projectionMatrix_);
+    frustum_ = MakeFrustum(viewProjectionMatrix_);
+    isViewProjectionDirty_ = false;
+}
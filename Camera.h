@@ -0,0 +1,61 @@
+#pragma once
+#include "MyMath.h"
+
+// カメラ
+//
+// Transformと射影のパラメータを持ち、ビュー/射影/ビュープロジェクション/ビルボード行列と
+// 視錐台を必要になったときだけ作り直す。
+// Setで値が変わったものに印を付けておき、Getで印が付いているものだけ計算する。
+class Camera {
+public:
+    Camera();
+
+    void SetTransform(const Transform& transform);
+    void SetRotate(const Vector3& rotate);
+    void SetTranslate(const Vector3& translate);
+    void SetProjection(float fovY, float aspectRatio, float nearClip, float farClip);
+    void SetAspectRatio(float aspectRatio);
+
+    const Transform& GetTransform() const { return transform_; }
+    float GetFovY() const { return fovY_; }
+    float GetAspectRatio() const { return aspectRatio_; }
+    float GetNearClip() const { return nearClip_; }
+    float GetFarClip() const { return farClip_; }
+
+    // カメラ自身のワールド行列
+    const Matrix4x4& GetWorldMatrix() const;
+    const Matrix4x4& GetViewMatrix() const;
+    const Matrix4x4& GetProjectionMatrix() const;
+    const Matrix4x4& GetViewProjectionMatrix() const;
+    // 板ポリをカメラに向ける回転(平行移動は0)
+    const Matrix4x4& GetBillboardMatrix() const;
+    const Frustum& GetFrustum() const;
+
+    // 作り直した回数(計測用)
+    uint32_t GetViewUpdateCount() const { return viewUpdateCount_; }
+    uint32_t GetProjectionUpdateCount() const { return projectionUpdateCount_; }
+
+private:
+    void UpdateView() const;
+    void UpdateProjection() const;
+    void UpdateViewProjection() const;
+
+    Transform transform_;
+    float fovY_;
+    float aspectRatio_;
+    float nearClip_;
+    float farClip_;
+
+    // 以下はGetで必要になったときに作るキャッシュ
+    mutable Matrix4x4 worldMatrix_;
+    mutable Matrix4x4 viewMatrix_;
+    mutable Matrix4x4 billboardMatrix_;
+    mutable Matrix4x4 projectionMatrix_;
+    mutable Matrix4x4 viewProjectionMatrix_;
+    mutable Frustum frustum_;
+    mutable bool isViewDirty_;
+    mutable bool isProjectionDirty_;
+    mutable bool isViewProjectionDirty_;
+    mutable uint32_t viewUpdateCount_;
+    mutable uint32_t projectionUpdateCount_;
+};
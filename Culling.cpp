@@ -0,0 +1,80 @@
+#include "Culling.h"
+#include "MatrixSimd.h"
+#include <bit>
+#include <cstring>
+
+namespace {
+
+struct CullingKernels {
+    CullSpheresFunction cullSpheres;
+    CullAABBsFunction cullAABBs;
+};
+
+const CullingKernels kCullingKernels[kMatrixBackendCount] = {
+    { CullSpheresScalar, CullAABBsScalar },
+#ifdef CG3_MATH_SSE
+    { CullSpheresSSE, CullAABBsSSE },
+#else
+    { CullSpheresScalar, CullAABBsScalar },
+#endif
+#ifdef CG3_MATH_AVX2
+    { CullSpheresAVX2, CullAABBsAVX2 },
+#else
+    { CullSpheresScalar, CullAABBsScalar },
+#endif
+};
+
+size_t CountVisible(const uint32_t* visibleMask, size_t count)
+{
+    size_t visibleCount = 0;
+    for (size_t word = 0; word < GetVisibleMaskWordCount(count); ++word) {
+        visibleCount += std::popcount(visibleMask[word]);
+    }
+    return visibleCount;
+}
+
+}
+
+void CullSpheresScalar(const Frustum& frustum, const Sphere* spheres, size_t count, uint32_t* visibleMask)
+{
+    for (size_t i = 0; i < count; ++i) {
+        if (IsCollision(frustum, spheres[i])) {
+            visibleMask[i / 32] |= 1u << (i % 32);
+        }
+    }
+}
+
+void CullAABBsScalar(const Frustum& frustum, const AABB* aabbs, size_t count, uint32_t* visibleMask)
+{
+    for (size_t i = 0; i < count; ++i) {
+        if (IsCollision(frustum, aabbs[i])) {
+            visibleMask[i / 32] |= 1u << (i % 32);
+        }
+    }
+}
+
+size_t CullSpheres(const Frustum& frustum, const Sphere* spheres, size_t count, uint32_t* visibleMask)
+{
+    std::memset(visibleMask, 0, sizeof(uint32_t) * GetVisibleMaskWordCount(count));
+    kCullingKernels[GetActiveMatrixBackend()].cullSpheres(frustum, spheres, count, visibleMask);
+    return CountVisible(visibleMask, count);
+}
+
+size_t CullAABBs(const Frustum& frustum, const AABB* aabbs, size_t count, uint32_t* visibleMask)
+{
+    std::memset(visibleMask, 0, sizeof(uint32_t) * GetVisibleMaskWordCount(count));
+    kCullingKernels[GetActiveMatrixBackend()].cullAABBs(frustum, aabbs, count, visibleMask);
+    return CountVisible(visibleMask, count);
+}
+
+size_t MakeVisibleList(const uint32_t* visibleMask, size_t count, uint32_t* visibleIndices)
+{
+    size_t visibleCount = 0;
+    for (size_t word = 0; word < GetVisibleMaskWordCount(count); ++word) {
+        // 立っているbitを下から順に取り出す
+        for (uint32_t bits = visibleMask[word]; bits != 0; bits &= bits - 1) {
+            visibleIndices[visibleCount++] = uint32_t(word * 32 + std::countr_zero(bits));
+        }
+    }
+    return visibleCount;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "MyMath.h"
+#include <cstddef>
+#include <cstdint>
+
+// 視錐台カリング
+//
+// 球やAABBの配列をまとめて視錐台と判定し、見えているものを1bitずつのマスクにする。
+// マスクはuint32_tの配列で、i番目の結果は visibleMask[i / 32] の (i % 32) bit目に入る。
+// (count + 31) / 32 個分の領域が必要で、使わない上位bitは0になる。
+// SSE4.1なら4個、AVX2なら8個を同時に判定し、実装はMatrix4x4と同じくGetActiveMatrixBackendで選ぶ。
+// 判定はIsCollision(Frustum, Sphere/AABB)と同じ式なので結果は完全に一致する。
+
+inline size_t GetVisibleMaskWordCount(size_t count) { return (count + 31) / 32; }
+inline bool IsVisible(const uint32_t* visibleMask, size_t index) { return (visibleMask[index / 32] >> (index % 32)) & 1; }
+
+// 見えているものを1にしたマスクを作り、見えている数を返す
+size_t CullSpheres(const Frustum& frustum, const Sphere* spheres, size_t count, uint32_t* visibleMask);
+size_t CullAABBs(const Frustum& frustum, const AABB* aabbs, size_t count, uint32_t* visibleMask);
+// マスクから見えているものの番号を小さい順に並べ、その数を返す
+size_t MakeVisibleList(const uint32_t* visibleMask, size_t count, uint32_t* visibleIndices);
+
+// 以下はSIMD実装用
+// visibleMaskは0で埋めてから渡す
+using CullSpheresFunction = void (*)(const Frustum& frustum, const Sphere* spheres, size_t count, uint32_t* visibleMask);
+using CullAABBsFunction = void (*)(const Frustum& frustum, const AABB* aabbs, size_t count, uint32_t* visibleMask);
+void CullSpheresScalar(const Frustum& frustum, const Sphere* spheres, size_t count, uint32_t* visibleMask);
+void CullAABBsScalar(const Frustum& frustum, const AABB* aabbs, size_t count, uint32_t* visibleMask);
+#ifdef CG3_MATH_SSE
+void CullSpheresSSE(const Frustum& frustum, const Sphere* spheres, size_t count, uint32_t* visibleMask);
+void CullAABBsSSE(const Frustum& frustum, const AABB* aabbs, size_t count, uint32_t* visibleMask);
+#endif
+#ifdef CG3_MATH_AVX2
+void CullSpheresAVX2(const Frustum& frustum, const Sphere* spheres, size_t count, uint32_t* visibleMask);
+void CullAABBsAVX2(const Frustum& frustum, const AABB* aabbs, size_t count, uint32_t* visibleMask);
+#endif
@@ -0,0 +1,136 @@
+#include "Culling.h"
+#include <cstring>
+#include <immintrin.h>
+
+namespace {
+
+const size_t kLanes = 8;
+
+// 平面の各成分をレジスタ全体に広げたもの
+struct PlaneLanes {
+    __m256 normalX;
+    __m256 normalY;
+    __m256 normalZ;
+    __m256 distance;
+};
+
+void LoadPlanes(const Frustum& frustum, PlaneLanes (&planes)[6])
+{
+    for (int p = 0; p < 6; ++p) {
+        planes[p].normalX = _mm256_set1_ps(frustum.planes[p].normal.x);
+        planes[p].normalY = _mm256_set1_ps(frustum.planes[p].normal.y);
+        planes[p].normalZ = _mm256_set1_ps(frustum.planes[p].normal.z);
+        planes[p].distance = _mm256_set1_ps(frustum.planes[p].distance);
+    }
+}
+
+// 平面までの距離(IsCollisionと同じ順番で足す)
+__m256 Distance(const PlaneLanes& plane, __m256 x, __m256 y, __m256 z)
+{
+    __m256 distance = _mm256_mul_ps(plane.normalX, x);
+    distance = _mm256_add_ps(distance, _mm256_mul_ps(plane.normalY, y));
+    distance = _mm256_add_ps(distance, _mm256_mul_ps(plane.normalZ, z));
+    return _mm256_add_ps(distance, plane.distance);
+}
+
+// lo番目の4要素を下位、lo + 4番目の4要素を上位に読む
+__m256 LoadPair(const float* lo, const float* hi)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)), _mm_loadu_ps(hi), 1);
+}
+
+// 128bit毎に4x4を転置する
+void Transpose4(__m256& r0, __m256& r1, __m256& r2, __m256& r3)
+{
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+    __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    r0 = _mm256_shuffle_ps(t0, t2, 0x44);
+    r1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+    r2 = _mm256_shuffle_ps(t1, t3, 0x44);
+    r3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+}
+
+// 8個分の球の見えているbit
+uint32_t CullSphereLanes(const PlaneLanes (&planes)[6], const Sphere* spheres)
+{
+    __m256 centerX = LoadPair(&spheres[0].center.x, &spheres[4].center.x);
+    __m256 centerY = LoadPair(&spheres[1].center.x, &spheres[5].center.x);
+    __m256 centerZ = LoadPair(&spheres[2].center.x, &spheres[6].center.x);
+    __m256 radius = LoadPair(&spheres[3].center.x, &spheres[7].center.x);
+    Transpose4(centerX, centerY, centerZ, radius);
+    __m256 negativeRadius = _mm256_xor_ps(radius, _mm256_set1_ps(-0.0f));
+
+    __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (const PlaneLanes& plane : planes) {
+        visible = _mm256_and_ps(visible, _mm256_cmp_ps(Distance(plane, centerX, centerY, centerZ), negativeRadius, _CMP_GE_OQ));
+    }
+    return uint32_t(_mm256_movemask_ps(visible));
+}
+
+// 8個分のAABBの見えているbit
+uint32_t CullAABBLanes(const PlaneLanes (&planes)[6], const AABB* aabbs)
+{
+    // min.xからの4要素とmin.zからの4要素を読めば、AABBの外を読まずに6要素揃う
+    __m256 minX = LoadPair(&aabbs[0].min.x, &aabbs[4].min.x);
+    __m256 minY = LoadPair(&aabbs[1].min.x, &aabbs[5].min.x);
+    __m256 minZ = LoadPair(&aabbs[2].min.x, &aabbs[6].min.x);
+    __m256 unused0 = LoadPair(&aabbs[3].min.x, &aabbs[7].min.x);
+    Transpose4(minX, minY, minZ, unused0);
+    __m256 unused1 = LoadPair(&aabbs[0].min.z, &aabbs[4].min.z);
+    __m256 maxX = LoadPair(&aabbs[1].min.z, &aabbs[5].min.z);
+    __m256 maxY = LoadPair(&aabbs[2].min.z, &aabbs[6].min.z);
+    __m256 maxZ = LoadPair(&aabbs[3].min.z, &aabbs[7].min.z);
+    Transpose4(unused1, maxX, maxY, maxZ);
+
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256 centerX = _mm256_mul_ps(_mm256_add_ps(minX, maxX), half);
+    __m256 centerY = _mm256_mul_ps(_mm256_add_ps(minY, maxY), half);
+    __m256 centerZ = _mm256_mul_ps(_mm256_add_ps(minZ, maxZ), half);
+    __m256 extentX = _mm256_mul_ps(_mm256_sub_ps(maxX, minX), half);
+    __m256 extentY = _mm256_mul_ps(_mm256_sub_ps(maxY, minY), half);
+    __m256 extentZ = _mm256_mul_ps(_mm256_sub_ps(maxZ, minZ), half);
+
+    __m256 signMask = _mm256_set1_ps(-0.0f);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (const PlaneLanes& plane : planes) {
+        __m256 distance = Distance(plane, centerX, centerY, centerZ);
+        __m256 radius = _mm256_mul_ps(_mm256_andnot_ps(signMask, plane.normalX), extentX);
+        radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_andnot_ps(signMask, plane.normalY), extentY));
+        radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_andnot_ps(signMask, plane.normalZ), extentZ));
+        visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_GE_OQ));
+    }
+    return uint32_t(_mm256_movemask_ps(visible));
+}
+
+// kLanes個ずつ判定する。端数は埋めた配列で判定して使わないbitを落とす
+template <typename Bounds, typename CullLanes>
+void CullBounds(const Frustum& frustum, const Bounds* bounds, size_t count, uint32_t* visibleMask, CullLanes cullLanes)
+{
+    PlaneLanes planes[6];
+    LoadPlanes(frustum, planes);
+    size_t i = 0;
+    for (; i + kLanes <= count; i += kLanes) {
+        visibleMask[i / 32] |= cullLanes(planes, bounds + i) << (i % 32);
+    }
+    if (i < count) {
+        Bounds tail[kLanes] = {};
+        std::memcpy(tail, bounds + i, sizeof(Bounds) * (count - i));
+        uint32_t bits = cullLanes(planes, tail) & ((1u << (count - i)) - 1);
+        visibleMask[i / 32] |= bits << (i % 32);
+    }
+}
+
+}
+
+void CullSpheresAVX2(const Frustum& frustum, const Sphere* spheres, size_t count, uint32_t* visibleMask)
+{
+    CullBounds(frustum, spheres, count, visibleMask, CullSphereLanes);
+}
+
+void CullAABBsAVX2(const Frustum& frustum, const AABB* aabbs, size_t count, uint32_t* visibleMask)
+{
+    CullBounds(frustum, aabbs, count, visibleMask, CullAABBLanes);
+}
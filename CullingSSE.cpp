@@ -0,0 +1,117 @@
+#include "Culling.h"
+#include <cstring>
+#include <smmintrin.h>
+
+namespace {
+
+const size_t kLanes = 4;
+
+// 平面の各成分をレジスタ全体に広げたもの
+struct PlaneLanes {
+    __m128 normalX;
+    __m128 normalY;
+    __m128 normalZ;
+    __m128 distance;
+};
+
+void LoadPlanes(const Frustum& frustum, PlaneLanes (&planes)[6])
+{
+    for (int p = 0; p < 6; ++p) {
+        planes[p].normalX = _mm_set1_ps(frustum.planes[p].normal.x);
+        planes[p].normalY = _mm_set1_ps(frustum.planes[p].normal.y);
+        planes[p].normalZ = _mm_set1_ps(frustum.planes[p].normal.z);
+        planes[p].distance = _mm_set1_ps(frustum.planes[p].distance);
+    }
+}
+
+// 平面までの距離(IsCollisionと同じ順番で足す)
+__m128 Distance(const PlaneLanes& plane, __m128 x, __m128 y, __m128 z)
+{
+    __m128 distance = _mm_mul_ps(plane.normalX, x);
+    distance = _mm_add_ps(distance, _mm_mul_ps(plane.normalY, y));
+    distance = _mm_add_ps(distance, _mm_mul_ps(plane.normalZ, z));
+    return _mm_add_ps(distance, plane.distance);
+}
+
+// 4個分の球の見えているbit
+uint32_t CullSphereLanes(const PlaneLanes (&planes)[6], const Sphere* spheres)
+{
+    __m128 centerX = _mm_loadu_ps(&spheres[0].center.x);
+    __m128 centerY = _mm_loadu_ps(&spheres[1].center.x);
+    __m128 centerZ = _mm_loadu_ps(&spheres[2].center.x);
+    __m128 radius = _mm_loadu_ps(&spheres[3].center.x);
+    _MM_TRANSPOSE4_PS(centerX, centerY, centerZ, radius);
+    __m128 negativeRadius = _mm_xor_ps(radius, _mm_set1_ps(-0.0f));
+
+    __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (const PlaneLanes& plane : planes) {
+        visible = _mm_and_ps(visible, _mm_cmpge_ps(Distance(plane, centerX, centerY, centerZ), negativeRadius));
+    }
+    return uint32_t(_mm_movemask_ps(visible));
+}
+
+// 4個分のAABBの見えているbit
+uint32_t CullAABBLanes(const PlaneLanes (&planes)[6], const AABB* aabbs)
+{
+    // min.xからの4要素とmin.zからの4要素を読めば、AABBの外を読まずに6要素揃う
+    __m128 minX = _mm_loadu_ps(&aabbs[0].min.x);
+    __m128 minY = _mm_loadu_ps(&aabbs[1].min.x);
+    __m128 minZ = _mm_loadu_ps(&aabbs[2].min.x);
+    __m128 unused0 = _mm_loadu_ps(&aabbs[3].min.x);
+    _MM_TRANSPOSE4_PS(minX, minY, minZ, unused0);
+    __m128 unused1 = _mm_loadu_ps(&aabbs[0].min.z);
+    __m128 maxX = _mm_loadu_ps(&aabbs[1].min.z);
+    __m128 maxY = _mm_loadu_ps(&aabbs[2].min.z);
+    __m128 maxZ = _mm_loadu_ps(&aabbs[3].min.z);
+    _MM_TRANSPOSE4_PS(unused1, maxX, maxY, maxZ);
+
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 centerX = _mm_mul_ps(_mm_add_ps(minX, maxX), half);
+    __m128 centerY = _mm_mul_ps(_mm_add_ps(minY, maxY), half);
+    __m128 centerZ = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half);
+    __m128 extentX = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+    __m128 extentY = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+    __m128 extentZ = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+
+    __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 zero = _mm_setzero_ps();
+    __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (const PlaneLanes& plane : planes) {
+        __m128 distance = Distance(plane, centerX, centerY, centerZ);
+        __m128 radius = _mm_mul_ps(_mm_andnot_ps(signMask, plane.normalX), extentX);
+        radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(signMask, plane.normalY), extentY));
+        radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(signMask, plane.normalZ), extentZ));
+        visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+    }
+    return uint32_t(_mm_movemask_ps(visible));
+}
+
+// kLanes個ずつ判定する。端数は埋めた配列で判定して使わないbitを落とす
+template <typename Bounds, typename CullLanes>
+void CullBounds(const Frustum& frustum, const Bounds* bounds, size_t count, uint32_t* visibleMask, CullLanes cullLanes)
+{
+    PlaneLanes planes[6];
+    LoadPlanes(frustum, planes);
+    size_t i = 0;
+    for (; i + kLanes <= count; i += kLanes) {
+        visibleMask[i / 32] |= cullLanes(planes, bounds + i) << (i % 32);
+    }
+    if (i < count) {
+        Bounds tail[kLanes] = {};
+        std::memcpy(tail, bounds + i, sizeof(Bounds) * (count - i));
+        uint32_t bits = cullLanes(planes, tail) & ((1u << (count - i)) - 1);
+        visibleMask[i / 32] |= bits << (i % 32);
+    }
+}
+
+}
+
+void CullSpheresSSE(const Frustum& frustum, const Sphere* spheres, size_t count, uint32_t* visibleMask)
+{
+    CullBounds(frustum, spheres, count, visibleMask, CullSphereLanes);
+}
+
+void CullAABBsSSE(const Frustum& frustum, const AABB* aabbs, size_t count, uint32_t* visibleMask)
+{
+    CullBounds(frustum, aabbs, count, visibleMask, CullAABBLanes);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "MyMath.h"
+#include <cstdint>
+
+// シェーダーに送るデータ
+struct Material {
+    Vector4 color;
+    int32_t enableLighting;
+    float padding[3];
+    Matrix4x4 uvTransform;
+    float shininess;
+};
+struct TransformationMatrix {
+    Matrix4x4 WVP;
+    Matrix4x4 world;
+    Matrix4x4 worldInverseTranspose;
+};
+struct ParticleForGPU {
+    Matrix4x4 WVP;
+    Matrix4x4 world;
+    Vector4 color;
+};
+struct DirectionalLight {
+    Vector4 color;
+    Vector3 direction;
+    float intensity;
+};
+struct PointLigth {
+    Vector4 color; // 色
+    Vector3 position; // 位置
+    float intensity; // 輝度
+    float radius; // ライトの届く最大距離
+    float decay; // 減衰率
+    float Padding[2];
+};
+struct CameraForGPU {
+    Vector3 worldPosition;
+};
+struct SpotLigth {
+    Vector4 color;
+    Vector3 position;
+    float intensity;
+    Vector3 direction;
+    float distance;
+    float decay;
+    float cosAngle;
+    float cosFalloffStart; // スポットライトの内側の角度（減衰開始の余弦）
+    float padding[2];
+};
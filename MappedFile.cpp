@@ -0,0 +1,227 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& filePath)
+{
+    Close();
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle_ = file;
+    isOpen_ = true;
+    if (size.QuadPart == 0) {
+        // 空のファイルはマップできないので何も読まない
+        return true;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        Close();
+        return false;
+    }
+    mappingHandle_ = mapping;
+    data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!data_) {
+        Close();
+        return false;
+    }
+    size_ = size_t(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mappingHandle_) {
+        CloseHandle(mappingHandle_);
+    }
+    if (fileHandle_) {
+        CloseHandle(fileHandle_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    isOpen_ = false;
+    fileHandle_ = nullptr;
+    mappingHandle_ = nullptr;
+}
+
+TemporaryMappedFile::~TemporaryMappedFile()
+{
+    Close();
+}
+
+bool TemporaryMappedFile::Create(const std::string& directoryPath, size_t size)
+{
+    Close();
+    char path[MAX_PATH];
+    if (GetTempFileNameA(directoryPath.c_str(), "cg3", 0, path) == 0) {
+        return false;
+    }
+    // 閉じたときに消す
+    HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        DeleteFileA(path);
+        return false;
+    }
+    fileHandle_ = file;
+    if (size == 0) {
+        return true;
+    }
+    LARGE_INTEGER fileSize;
+    fileSize.QuadPart = LONGLONG(size);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, DWORD(fileSize.HighPart), fileSize.LowPart, nullptr);
+    if (!mapping) {
+        Close();
+        return false;
+    }
+    mappingHandle_ = mapping;
+    data_ = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0));
+    if (!data_) {
+        Close();
+        return false;
+    }
+    size_ = size;
+    return true;
+}
+
+void TemporaryMappedFile::Close()
+{
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mappingHandle_) {
+        CloseHandle(mappingHandle_);
+    }
+    if (fileHandle_) {
+        CloseHandle(fileHandle_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    fileHandle_ = nullptr;
+    mappingHandle_ = nullptr;
+}
+
+void TemporaryMappedFile::Release()
+{
+    // ロックしていないページにVirtualUnlockを呼ぶと、ワーキングセットから外れる
+    if (data_) {
+        VirtualUnlock(data_, size_);
+    }
+}
+
+#else
+
+bool MappedFile::Open(const std::string& filePath)
+{
+    Close();
+    int file = open(filePath.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0) {
+        close(file);
+        return false;
+    }
+    isOpen_ = true;
+    if (status.st_size == 0) {
+        close(file);
+        return true;
+    }
+    void* data = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    // マップしたあとはファイルを閉じてもよい
+    close(file);
+    if (data == MAP_FAILED) {
+        isOpen_ = false;
+        return false;
+    }
+    // 先頭から順に読むだけなので先読みさせる
+    madvise(data, size_t(status.st_size), MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(data);
+    size_ = size_t(status.st_size);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    isOpen_ = false;
+}
+
+TemporaryMappedFile::~TemporaryMappedFile()
+{
+    Close();
+}
+
+bool TemporaryMappedFile::Create(const std::string& directoryPath, size_t size)
+{
+    Close();
+    std::string path = directoryPath + "/cg3spill_XXXXXX";
+    int file = mkstemp(path.data());
+    if (file < 0) {
+        return false;
+    }
+    // 名前はすぐに消す(マップしている間は中身が残る)
+    unlink(path.c_str());
+    if (size == 0) {
+        close(file);
+        return true;
+    }
+    if (ftruncate(file, off_t(size)) != 0) {
+        close(file);
+        return false;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<char*>(data);
+    size_ = size;
+    return true;
+}
+
+void TemporaryMappedFile::Close()
+{
+    if (data_) {
+        munmap(data_, size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+void TemporaryMappedFile::Release()
+{
+    // 共有マップのページは外しても書いた中身はファイルに残る
+    if (data_) {
+        madvise(data_, size_, MADV_DONTNEED);
+    }
+}
+
+#endif
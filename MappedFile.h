@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// ファイルを読み取り専用でメモリにマップする
+//
+// 中身はコピーせずにGetDataからそのまま読む。マップはデストラクタで解除する。
+// 空のファイルも開けるが、そのときGetDataはnullptrでGetSizeは0になる。
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 開けなければfalse
+    bool Open(const std::string& filePath);
+    void Close();
+
+    bool IsOpen() const { return isOpen_; }
+    const char* GetData() const { return data_; }
+    size_t GetSize() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool isOpen_ = false;
+#ifdef _WIN32
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#endif
+};
+
+// 作業用の一時ファイルを読み書きできるようにマップする
+//
+// メモリに置くと大きすぎる配列をファイルに逃がすのに使う。作るときに大きさを決め(中身は0)、
+// ファイルは閉じたときに消える(途中で落ちても残らないように、POSIXでは作ってすぐに名前を消す)。
+// 触ったページはプロセスのメモリ(RSS)に数えられるので、Releaseで手放すとファイルへ書き出してから外れる。
+class TemporaryMappedFile {
+public:
+    TemporaryMappedFile() = default;
+    ~TemporaryMappedFile();
+    TemporaryMappedFile(const TemporaryMappedFile&) = delete;
+    TemporaryMappedFile& operator=(const TemporaryMappedFile&) = delete;
+
+    // directoryPathに大きさsizeの一時ファイルを作る。作れなければfalse
+    bool Create(const std::string& directoryPath, size_t size);
+    void Close();
+
+    char* GetData() const { return data_; }
+    size_t GetSize() const { return size_; }
+
+    // 読み書きしたページをプロセスのメモリから外す(中身はファイルに残り、次に触ったときに読み直す)
+    void Release();
+
+private:
+    char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#endif
+};
@@ -0,0 +1,188 @@
+#include "MatrixSimd.h"
+#include "SinCosSimd.h"
+#include <immintrin.h>
+
+namespace {
+
+// 2x2行列は(m00,m01,m10,m11)の順で、上下128bitに1つずつ入れて2組まとめて計算する
+#define SHUFFLE_MASK(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+#define SWIZZLE(v, x, y, z, w) _mm_shuffle_ps((v), (v), SHUFFLE_MASK(x, y, z, w))
+#define SWIZZLE256(v, x, y, z, w) _mm256_permute_ps((v), SHUFFLE_MASK(x, y, z, w))
+
+// A*B
+inline __m256 Mat2Mul(__m256 a, __m256 b)
+{
+    return _mm256_add_ps(_mm256_mul_ps(a, SWIZZLE256(b, 0, 3, 0, 3)), _mm256_mul_ps(SWIZZLE256(a, 1, 0, 3, 2), SWIZZLE256(b, 2, 1, 2, 1)));
+}
+// adj(A)*B
+inline __m256 Mat2AdjMul(__m256 a, __m256 b)
+{
+    return _mm256_sub_ps(_mm256_mul_ps(SWIZZLE256(a, 3, 3, 0, 0), b), _mm256_mul_ps(SWIZZLE256(a, 1, 1, 2, 2), SWIZZLE256(b, 2, 3, 0, 1)));
+}
+// A*adj(B)
+inline __m256 Mat2MulAdj(__m256 a, __m256 b)
+{
+    return _mm256_sub_ps(_mm256_mul_ps(a, SWIZZLE256(b, 3, 0, 3, 0)), _mm256_mul_ps(SWIZZLE256(a, 1, 0, 3, 2), SWIZZLE256(b, 2, 1, 2, 1)));
+}
+
+// 上位と下位の128bitを入れ替える
+inline __m256 SwapLane(__m256 v)
+{
+    return _mm256_permute2f128_ps(v, v, 0x01);
+}
+
+}
+
+Matrix4x4 MultiplyAVX2(const Matrix4x4& m1, const Matrix4x4& m2)
+{
+    // m2の各行を上下両方に置く
+    __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[0]));
+    __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[1]));
+    __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[2]));
+    __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[3]));
+
+    Matrix4x4 num;
+    for (int row = 0; row < 4; row += 2) {
+        // 2行ずつ。スカラー版と同じく左から順に足していく
+        __m256 a = _mm256_loadu_ps(m1.m[row]);
+        __m256 r = _mm256_mul_ps(SWIZZLE256(a, 0, 0, 0, 0), b0);
+        r = _mm256_add_ps(r, _mm256_mul_ps(SWIZZLE256(a, 1, 1, 1, 1), b1));
+        r = _mm256_add_ps(r, _mm256_mul_ps(SWIZZLE256(a, 2, 2, 2, 2), b2));
+        r = _mm256_add_ps(r, _mm256_mul_ps(SWIZZLE256(a, 3, 3, 3, 3), b3));
+        _mm256_storeu_ps(num.m[row], r);
+    }
+    return num;
+}
+
+Matrix4x4 InverseAVX2(const Matrix4x4& m)
+{
+    __m128 r0 = _mm_loadu_ps(m.m[0]);
+    __m128 r1 = _mm_loadu_ps(m.m[1]);
+    __m128 r2 = _mm_loadu_ps(m.m[2]);
+    __m128 r3 = _mm_loadu_ps(m.m[3]);
+
+    // 4x4を2x2のブロック[A B; C D]に分ける
+    __m128 a = _mm_movelh_ps(r0, r1);
+    __m128 b = _mm_movehl_ps(r1, r0);
+    __m128 c = _mm_movelh_ps(r2, r3);
+    __m128 d = _mm_movehl_ps(r3, r2);
+
+    // 各ブロックの行列式 (|A|, |B|, |C|, |D|)
+    __m128 detSub = _mm_sub_ps(
+        _mm_mul_ps(_mm_shuffle_ps(r0, r2, SHUFFLE_MASK(0, 2, 0, 2)), _mm_shuffle_ps(r1, r3, SHUFFLE_MASK(1, 3, 1, 3))),
+        _mm_mul_ps(_mm_shuffle_ps(r0, r2, SHUFFLE_MASK(1, 3, 1, 3)), _mm_shuffle_ps(r1, r3, SHUFFLE_MASK(0, 2, 0, 2))));
+
+    __m256 ad = _mm256_set_m128(d, a);
+    __m256 bc = _mm256_set_m128(c, b);
+    __m256 da = SwapLane(ad);
+    __m256 cb = SwapLane(bc);
+
+    // (adj(D)C, adj(A)B)
+    __m256 dcab = Mat2AdjMul(da, cb);
+    // (|D|A - B adj(D)C, |A|D - C adj(A)B) = (X, W)
+    __m256 detDA = _mm256_set_m128(SWIZZLE(detSub, 0, 0, 0, 0), SWIZZLE(detSub, 3, 3, 3, 3));
+    __m256 xw = _mm256_sub_ps(_mm256_mul_ps(detDA, ad), Mat2Mul(bc, dcab));
+    // (|B|C - D adj(adj(A)B), |C|B - A adj(adj(D)C)) = (Y, Z)
+    __m256 detBC = _mm256_set_m128(SWIZZLE(detSub, 2, 2, 2, 2), SWIZZLE(detSub, 1, 1, 1, 1));
+    __m256 yz = _mm256_sub_ps(_mm256_mul_ps(detBC, cb), Mat2MulAdj(da, SwapLane(dcab)));
+
+    // |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+    __m128 dc = _mm256_castps256_ps128(dcab);
+    __m128 ab = _mm256_extractf128_ps(dcab, 1);
+    __m128 det = _mm_add_ps(_mm_mul_ps(SWIZZLE(detSub, 0, 0, 0, 0), SWIZZLE(detSub, 3, 3, 3, 3)), _mm_mul_ps(SWIZZLE(detSub, 1, 1, 1, 1), SWIZZLE(detSub, 2, 2, 2, 2)));
+    __m128 tr = _mm_mul_ps(ab, SWIZZLE(dc, 0, 2, 1, 3));
+    tr = _mm_hadd_ps(tr, tr);
+    tr = _mm_hadd_ps(tr, tr);
+    det = _mm_sub_ps(det, tr);
+
+    if (_mm_cvtss_f32(det) == 0.0f) {
+        return m;
+    }
+
+    __m128 rcpDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+    __m256 rcpDet256 = _mm256_set_m128(rcpDet, rcpDet);
+    xw = _mm256_mul_ps(xw, rcpDet256);
+    yz = _mm256_mul_ps(yz, rcpDet256);
+
+    // (X, Z) と (Y, W) に組み替えて、余因子行列の並びに戻しながら書き込む
+    __m256 xz = _mm256_blend_ps(xw, yz, 0xF0);
+    __m256 yw = _mm256_blend_ps(yz, xw, 0xF0);
+    __m256 rows02 = _mm256_shuffle_ps(xz, yw, SHUFFLE_MASK(3, 1, 3, 1));
+    __m256 rows13 = _mm256_shuffle_ps(xz, yw, SHUFFLE_MASK(2, 0, 2, 0));
+
+    Matrix4x4 num;
+    _mm256_storeu_ps(num.m[0], _mm256_permute2f128_ps(rows02, rows13, 0x20));
+    _mm256_storeu_ps(num.m[2], _mm256_permute2f128_ps(rows02, rows13, 0x31));
+    return num;
+}
+
+Matrix4x4 MakeAffineMatrixAVX2(const Vector3& scale, const Vector3& rotate, const Vector3& translate)
+{
+    // 3軸分のsin/cosを1回で求める
+    __m128 sin;
+    __m128 cos;
+    SinCos128(_mm_setr_ps(rotate.x, rotate.y, rotate.z, 0.0f), sin, cos);
+    alignas(16) float sins[4];
+    alignas(16) float coss[4];
+    _mm_store_ps(sins, sin);
+    _mm_store_ps(coss, cos);
+    float cx = coss[0];
+    float sx = sins[0];
+    float cy = coss[1];
+    float sy = sins[1];
+    float cz = coss[2];
+    float sz = sins[2];
+
+    // rotateY * rotateZ
+    __m128 yz0 = _mm_mul_ps(_mm_setr_ps(cy, cy, -sy, 0.0f), _mm_setr_ps(cz, sz, 1.0f, 0.0f));
+    __m128 yz1 = _mm_setr_ps(-sz, cz, 0.0f, 0.0f);
+    __m128 yz2 = _mm_mul_ps(_mm_setr_ps(sy, sy, cy, 0.0f), _mm_setr_ps(cz, sz, 1.0f, 0.0f));
+
+    // rotateX * (rotateY * rotateZ) の1行目と2行目をまとめて計算
+    __m256 yz11 = _mm256_set_m128(yz1, yz1);
+    __m256 yz22 = _mm256_set_m128(yz2, yz2);
+    __m256 xyz12 = _mm256_add_ps(
+        _mm256_mul_ps(_mm256_setr_ps(cx, cx, cx, cx, -sx, -sx, -sx, -sx), yz11),
+        _mm256_mul_ps(_mm256_setr_ps(sx, sx, sx, sx, cx, cx, cx, cx), yz22));
+
+    // w成分は+0に揃える
+    __m256 zero = _mm256_setzero_ps();
+    __m256 rows01 = _mm256_set_m128(_mm256_castps256_ps128(xyz12), yz0);
+    rows01 = _mm256_mul_ps(rows01, _mm256_setr_ps(scale.x, scale.x, scale.x, scale.x, scale.y, scale.y, scale.y, scale.y));
+    rows01 = _mm256_blend_ps(rows01, zero, 0x88);
+    __m128 row2 = _mm_mul_ps(_mm256_extractf128_ps(xyz12, 1), _mm_set1_ps(scale.z));
+    row2 = _mm_blend_ps(row2, _mm_setzero_ps(), 0x8);
+
+    Matrix4x4 num;
+    _mm256_storeu_ps(num.m[0], rows01);
+    _mm256_storeu_ps(num.m[2], _mm256_set_m128(_mm_setr_ps(translate.x, translate.y, translate.z, 1.0f), row2));
+    return num;
+}
+
+void SinCosAVX2(const float* radians, float* sins, float* coss, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 sin;
+        __m256 cos;
+        SinCos256(_mm256_loadu_ps(radians + i), sin, cos);
+        _mm256_storeu_ps(sins + i, sin);
+        _mm256_storeu_ps(coss + i, cos);
+    }
+    if (i < count) {
+        // 端数は一旦8要素に詰めて計算する
+        alignas(32) float buffer[3][8] = {};
+        for (size_t j = 0; i + j < count; ++j) {
+            buffer[0][j] = radians[i + j];
+        }
+        __m256 sin;
+        __m256 cos;
+        SinCos256(_mm256_load_ps(buffer[0]), sin, cos);
+        _mm256_store_ps(buffer[1], sin);
+        _mm256_store_ps(buffer[2], cos);
+        for (size_t j = 0; i + j < count; ++j) {
+            sins[i + j] = buffer[1][j];
+            coss[i + j] = buffer[2][j];
+        }
+    }
+}
@@ -0,0 +1,260 @@
+#include "MatrixSimd.h"
+#include "SinCosSimd.h"
+#include <smmintrin.h>
+
+namespace {
+
+// 2x2行列は(m00,m01,m10,m11)の順で1本のレジスタに入れる
+#define SHUFFLE_MASK(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+#define SWIZZLE(v, x, y, z, w) _mm_shuffle_ps((v), (v), SHUFFLE_MASK(x, y, z, w))
+
+// A*B
+inline __m128 Mat2Mul(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, SWIZZLE(b, 0, 3, 0, 3)), _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+// adj(A)*B
+inline __m128 Mat2AdjMul(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(SWIZZLE(a, 3, 3, 0, 0), b), _mm_mul_ps(SWIZZLE(a, 1, 1, 2, 2), SWIZZLE(b, 2, 3, 0, 1)));
+}
+// A*adj(B)
+inline __m128 Mat2MulAdj(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, SWIZZLE(b, 3, 0, 3, 0)), _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+}
+
+Matrix4x4 MultiplySSE(const Matrix4x4& m1, const Matrix4x4& m2)
+{
+    __m128 b0 = _mm_loadu_ps(m2.m[0]);
+    __m128 b1 = _mm_loadu_ps(m2.m[1]);
+    __m128 b2 = _mm_loadu_ps(m2.m[2]);
+    __m128 b3 = _mm_loadu_ps(m2.m[3]);
+
+    Matrix4x4 num;
+    for (int row = 0; row < 4; ++row) {
+        // スカラー版と同じく左から順に足していく
+        __m128 a = _mm_loadu_ps(m1.m[row]);
+        __m128 r = _mm_mul_ps(SWIZZLE(a, 0, 0, 0, 0), b0);
+        r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(a, 1, 1, 1, 1), b1));
+        r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(a, 2, 2, 2, 2), b2));
+        r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(a, 3, 3, 3, 3), b3));
+        _mm_storeu_ps(num.m[row], r);
+    }
+    return num;
+}
+
+Matrix4x4 InverseSSE(const Matrix4x4& m)
+{
+    __m128 r0 = _mm_loadu_ps(m.m[0]);
+    __m128 r1 = _mm_loadu_ps(m.m[1]);
+    __m128 r2 = _mm_loadu_ps(m.m[2]);
+    __m128 r3 = _mm_loadu_ps(m.m[3]);
+
+    // 4x4を2x2のブロック[A B; C D]に分ける
+    __m128 a = _mm_movelh_ps(r0, r1);
+    __m128 b = _mm_movehl_ps(r1, r0);
+    __m128 c = _mm_movelh_ps(r2, r3);
+    __m128 d = _mm_movehl_ps(r3, r2);
+
+    // 各ブロックの行列式 (|A|, |B|, |C|, |D|)
+    __m128 detSub = _mm_sub_ps(
+        _mm_mul_ps(_mm_shuffle_ps(r0, r2, SHUFFLE_MASK(0, 2, 0, 2)), _mm_shuffle_ps(r1, r3, SHUFFLE_MASK(1, 3, 1, 3))),
+        _mm_mul_ps(_mm_shuffle_ps(r0, r2, SHUFFLE_MASK(1, 3, 1, 3)), _mm_shuffle_ps(r1, r3, SHUFFLE_MASK(0, 2, 0, 2))));
+    __m128 detA = SWIZZLE(detSub, 0, 0, 0, 0);
+    __m128 detB = SWIZZLE(detSub, 1, 1, 1, 1);
+    __m128 detC = SWIZZLE(detSub, 2, 2, 2, 2);
+    __m128 detD = SWIZZLE(detSub, 3, 3, 3, 3);
+
+    __m128 dc = Mat2AdjMul(d, c);
+    __m128 ab = Mat2AdjMul(a, b);
+    __m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), Mat2Mul(b, dc));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), Mat2Mul(c, ab));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), Mat2MulAdj(d, ab));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), Mat2MulAdj(a, dc));
+
+    // |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+    __m128 det = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+    __m128 tr = _mm_mul_ps(ab, SWIZZLE(dc, 0, 2, 1, 3));
+    tr = _mm_hadd_ps(tr, tr);
+    tr = _mm_hadd_ps(tr, tr);
+    det = _mm_sub_ps(det, tr);
+
+    if (_mm_cvtss_f32(det) == 0.0f) {
+        return m;
+    }
+
+    __m128 rcpDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+    x = _mm_mul_ps(x, rcpDet);
+    y = _mm_mul_ps(y, rcpDet);
+    z = _mm_mul_ps(z, rcpDet);
+    w = _mm_mul_ps(w, rcpDet);
+
+    // 余因子行列の並びに戻しながら書き込む
+    Matrix4x4 num;
+    _mm_storeu_ps(num.m[0], _mm_shuffle_ps(x, y, SHUFFLE_MASK(3, 1, 3, 1)));
+    _mm_storeu_ps(num.m[1], _mm_shuffle_ps(x, y, SHUFFLE_MASK(2, 0, 2, 0)));
+    _mm_storeu_ps(num.m[2], _mm_shuffle_ps(z, w, SHUFFLE_MASK(3, 1, 3, 1)));
+    _mm_storeu_ps(num.m[3], _mm_shuffle_ps(z, w, SHUFFLE_MASK(2, 0, 2, 0)));
+    return num;
+}
+
+Matrix4x4 MakeAffineMatrixSSE(const Vector3& scale, const Vector3& rotate, const Vector3& translate)
+{
+    // 3軸分のsin/cosを1回で求める
+    __m128 sin;
+    __m128 cos;
+    SinCos128(_mm_setr_ps(rotate.x, rotate.y, rotate.z, 0.0f), sin, cos);
+    alignas(16) float sins[4];
+    alignas(16) float coss[4];
+    _mm_store_ps(sins, sin);
+    _mm_store_ps(coss, cos);
+    float cx = coss[0];
+    float sx = sins[0];
+    float cy = coss[1];
+    float sy = sins[1];
+    float cz = coss[2];
+    float sz = sins[2];
+
+    // rotateY * rotateZ
+    __m128 yz0 = _mm_mul_ps(_mm_setr_ps(cy, cy, -sy, 0.0f), _mm_setr_ps(cz, sz, 1.0f, 0.0f));
+    __m128 yz1 = _mm_setr_ps(-sz, cz, 0.0f, 0.0f);
+    __m128 yz2 = _mm_mul_ps(_mm_setr_ps(sy, sy, cy, 0.0f), _mm_setr_ps(cz, sz, 1.0f, 0.0f));
+
+    // rotateX * (rotateY * rotateZ)
+    __m128 xyz1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(cx), yz1), _mm_mul_ps(_mm_set1_ps(sx), yz2));
+    __m128 xyz2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-sx), yz1), _mm_mul_ps(_mm_set1_ps(cx), yz2));
+
+    // w成分は+0に揃える
+    __m128 zero = _mm_setzero_ps();
+    Matrix4x4 num;
+    _mm_storeu_ps(num.m[0], _mm_blend_ps(_mm_mul_ps(_mm_set1_ps(scale.x), yz0), zero, 0x8));
+    _mm_storeu_ps(num.m[1], _mm_blend_ps(_mm_mul_ps(_mm_set1_ps(scale.y), xyz1), zero, 0x8));
+    _mm_storeu_ps(num.m[2], _mm_blend_ps(_mm_mul_ps(_mm_set1_ps(scale.z), xyz2), zero, 0x8));
+    _mm_storeu_ps(num.m[3], _mm_setr_ps(translate.x, translate.y, translate.z, 1.0f));
+    return num;
+}
+
+namespace {
+
+// a×b (w成分は0になる)
+inline __m128 Cross(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(SWIZZLE(a, 1, 2, 0, 3), SWIZZLE(b, 2, 0, 1, 3)), _mm_mul_ps(SWIZZLE(a, 2, 0, 1, 3), SWIZZLE(b, 1, 2, 0, 3)));
+}
+
+// (x, y, z, 0) の -t*L を求め、w成分を1にする
+inline __m128 InverseTranslate(__m128 t, __m128 l0, __m128 l1, __m128 l2)
+{
+    __m128 r = _mm_mul_ps(SWIZZLE(t, 0, 0, 0, 0), l0);
+    r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(t, 1, 1, 1, 1), l1));
+    r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(t, 2, 2, 2, 2), l2));
+    return _mm_blend_ps(_mm_sub_ps(_mm_setzero_ps(), r), _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), 0x8);
+}
+
+}
+
+Matrix4x4 InverseAffineSSE(const Matrix4x4& m)
+{
+    __m128 r0 = _mm_loadu_ps(m.m[0]);
+    __m128 r1 = _mm_loadu_ps(m.m[1]);
+    __m128 r2 = _mm_loadu_ps(m.m[2]);
+    __m128 t = _mm_loadu_ps(m.m[3]);
+
+    // 余因子行列の各行は残り2行の外積
+    __m128 c0 = Cross(r1, r2);
+    __m128 c1 = Cross(r2, r0);
+    __m128 c2 = Cross(r0, r1);
+    __m128 det = _mm_dp_ps(r0, c0, 0x7F);
+    if (_mm_cvtss_f32(det) == 0.0f) {
+        return m;
+    }
+
+    // L^-1 = 余因子行列の転置/行列式
+    __m128 rcpDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+    c0 = _mm_mul_ps(c0, rcpDet);
+    c1 = _mm_mul_ps(c1, rcpDet);
+    c2 = _mm_mul_ps(c2, rcpDet);
+    __m128 c3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    Matrix4x4 num;
+    _mm_storeu_ps(num.m[0], c0);
+    _mm_storeu_ps(num.m[1], c1);
+    _mm_storeu_ps(num.m[2], c2);
+    _mm_storeu_ps(num.m[3], InverseTranslate(t, c0, c1, c2));
+    return num;
+}
+
+Matrix4x4 InverseRigidSSE(const Matrix4x4& m)
+{
+    __m128 r0 = _mm_loadu_ps(m.m[0]);
+    __m128 r1 = _mm_loadu_ps(m.m[1]);
+    __m128 r2 = _mm_loadu_ps(m.m[2]);
+    __m128 r3 = _mm_setzero_ps();
+    __m128 t = _mm_loadu_ps(m.m[3]);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    Matrix4x4 num;
+    _mm_storeu_ps(num.m[0], r0);
+    _mm_storeu_ps(num.m[1], r1);
+    _mm_storeu_ps(num.m[2], r2);
+    _mm_storeu_ps(num.m[3], InverseTranslate(t, r0, r1, r2));
+    return num;
+}
+
+Matrix4x4 MakeNormalMatrixSSE(const Matrix4x4& m)
+{
+    __m128 r0 = _mm_loadu_ps(m.m[0]);
+    __m128 r1 = _mm_loadu_ps(m.m[1]);
+    __m128 r2 = _mm_loadu_ps(m.m[2]);
+
+    // (L^-1)^T = 余因子行列/行列式
+    __m128 c0 = Cross(r1, r2);
+    __m128 c1 = Cross(r2, r0);
+    __m128 c2 = Cross(r0, r1);
+    __m128 det = _mm_dp_ps(r0, c0, 0x7F);
+    if (_mm_cvtss_f32(det) != 0.0f) {
+        __m128 rcpDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+        c0 = _mm_mul_ps(c0, rcpDet);
+        c1 = _mm_mul_ps(c1, rcpDet);
+        c2 = _mm_mul_ps(c2, rcpDet);
+    }
+
+    Matrix4x4 num;
+    _mm_storeu_ps(num.m[0], c0);
+    _mm_storeu_ps(num.m[1], c1);
+    _mm_storeu_ps(num.m[2], c2);
+    _mm_storeu_ps(num.m[3], _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+    return num;
+}
+
+void SinCosSSE(const float* radians, float* sins, float* coss, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 sin;
+        __m128 cos;
+        SinCos128(_mm_loadu_ps(radians + i), sin, cos);
+        _mm_storeu_ps(sins + i, sin);
+        _mm_storeu_ps(coss + i, cos);
+    }
+    if (i < count) {
+        // 端数は一旦4要素に詰めて計算する
+        alignas(16) float buffer[3][4] = {};
+        for (size_t j = 0; i + j < count; ++j) {
+            buffer[0][j] = radians[i + j];
+        }
+        __m128 sin;
+        __m128 cos;
+        SinCos128(_mm_load_ps(buffer[0]), sin, cos);
+        _mm_store_ps(buffer[1], sin);
+        _mm_store_ps(buffer[2], cos);
+        for (size_t j = 0; i + j < count; ++j) {
+            sins[i + j] = buffer[1][j];
+            coss[i + j] = buffer[2][j];
+        }
+    }
+}
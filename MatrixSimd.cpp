@@ -0,0 +1,131 @@
+#include "MatrixSimd.h"
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace {
+
+bool CpuHasSSE41()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4] {};
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("sse4.1");
+#else
+    return false;
+#endif
+}
+
+bool CpuHasAVX2()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4] {};
+    __cpuid(info, 1);
+    // OSがYMMレジスタを保存してくれるか
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+const MatrixKernels kMatrixKernels[kMatrixBackendCount] = {
+    { MultiplyScalar, InverseScalar, MakeAffineMatrixScalar, InverseAffineScalar, InverseRigidScalar, MakeNormalMatrixScalar, SinCosScalar },
+#ifdef CG3_MATH_SSE
+    { MultiplySSE, InverseSSE, MakeAffineMatrixSSE, InverseAffineSSE, InverseRigidSSE, MakeNormalMatrixSSE, SinCosSSE },
+#else
+    { MultiplyScalar, InverseScalar, MakeAffineMatrixScalar, InverseAffineScalar, InverseRigidScalar, MakeNormalMatrixScalar, SinCosScalar },
+#endif
+#ifdef CG3_MATH_AVX2
+    { MultiplyAVX2, InverseAVX2, MakeAffineMatrixAVX2, InverseAffineSSE, InverseRigidSSE, MakeNormalMatrixSSE, SinCosAVX2 },
+#else
+    { MultiplyScalar, InverseScalar, MakeAffineMatrixScalar, InverseAffineScalar, InverseRigidScalar, MakeNormalMatrixScalar, SinCosScalar },
+#endif
+};
+
+MatrixBackend SelectMatrixBackend()
+{
+    if (IsMatrixBackendSupported(kMatrixBackendAVX2)) {
+        return kMatrixBackendAVX2;
+    }
+    if (IsMatrixBackendSupported(kMatrixBackendSSE)) {
+        return kMatrixBackendSSE;
+    }
+    return kMatrixBackendScalar;
+}
+
+MatrixBackend& ActiveBackend()
+{
+    static MatrixBackend backend = SelectMatrixBackend();
+    return backend;
+}
+
+}
+
+bool IsMatrixBackendSupported(MatrixBackend backend)
+{
+    switch (backend) {
+    case kMatrixBackendScalar:
+        return true;
+    case kMatrixBackendSSE:
+#ifdef CG3_MATH_SSE
+        return CpuHasSSE41();
+#else
+        return false;
+#endif
+    case kMatrixBackendAVX2:
+#ifdef CG3_MATH_AVX2
+        return CpuHasAVX2();
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+const char* GetMatrixBackendName(MatrixBackend backend)
+{
+    switch (backend) {
+    case kMatrixBackendScalar:
+        return "scalar";
+    case kMatrixBackendSSE:
+        return "sse4.1";
+    case kMatrixBackendAVX2:
+        return "avx2";
+    default:
+        return "unknown";
+    }
+}
+
+const MatrixKernels& GetMatrixKernels(MatrixBackend backend)
+{
+    if (!IsMatrixBackendSupported(backend)) {
+        return kMatrixKernels[kMatrixBackendScalar];
+    }
+    return kMatrixKernels[backend];
+}
+
+MatrixBackend GetActiveMatrixBackend()
+{
+    return ActiveBackend();
+}
+
+void SetActiveMatrixBackend(MatrixBackend backend)
+{
+    ActiveBackend() = IsMatrixBackendSupported(backend) ? backend : kMatrixBackendScalar;
+}
+
+const MatrixKernels& GetActiveMatrixKernels()
+{
+    return kMatrixKernels[ActiveBackend()];
+}
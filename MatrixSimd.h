@@ -0,0 +1,74 @@
+#pragma once
+#include "MyMath.h"
+
+// Matrix4x4のSIMD実装
+//
+// CG3_MATH_SSE / CG3_MATH_AVX2 が定義されているときだけ対応する実装をビルドし、
+// 実行時にCPUが対応している一番速いものを選ぶ。
+//
+// スカラー版との誤差
+//  Multiply         : 掛け算と足し算の順番をスカラー版と揃えているので完全に一致する(0ULP)
+//  MakeAffineMatrix : sin/cosをSinCosの多項式近似で求めるので、回転部分に
+//                     最大要素 * 2^-21 程度の誤差が出る(拡縮と平行移動は一致する)
+//  Inverse          : 2x2ブロックに分けて余因子を求めるので丸めが変わる。
+//                     各要素の誤差は 逆行列の最大要素 * 2^-16 以内(条件数1e3未満の行列で確認)
+//                     行列式が0のときはスカラー版と同じく元の行列を返す
+//  InverseAffine / InverseRigid / MakeNormalMatrix
+//                   : 余因子を外積で求めるので丸めが変わる(相対誤差1e-6程度)。
+//                     3x3の計算は128bitで足りるのでAVX2でもSSE4.1版を使う
+//  SinCos           : スカラー版はstd::sin/std::cos。SIMD版は多項式近似で、
+//                     |x| < 8192 なら誤差は絶対値で 2^-22 以内(SinCosSimd.h)
+#if defined(CG3_MATH_AVX2) && !defined(CG3_MATH_SSE)
+#error "CG3_MATH_AVX2 requires CG3_MATH_SSE"
+#endif
+
+enum MatrixBackend {
+    kMatrixBackendScalar, // SIMDなし
+    kMatrixBackendSSE, // SSE4.1
+    kMatrixBackendAVX2, // AVX2
+    kMatrixBackendCount,
+};
+
+struct MatrixKernels {
+    Matrix4x4 (*multiply)(const Matrix4x4& m1, const Matrix4x4& m2);
+    Matrix4x4 (*inverse)(const Matrix4x4& m);
+    Matrix4x4 (*makeAffineMatrix)(const Vector3& scale, const Vector3& rotate, const Vector3& translate);
+    Matrix4x4 (*inverseAffine)(const Matrix4x4& m);
+    Matrix4x4 (*inverseRigid)(const Matrix4x4& m);
+    Matrix4x4 (*makeNormalMatrix)(const Matrix4x4& m);
+    void (*sinCos)(const float* radians, float* sins, float* coss, size_t count);
+};
+
+// ビルドされていて、このCPUで動くか
+bool IsMatrixBackendSupported(MatrixBackend backend);
+const char* GetMatrixBackendName(MatrixBackend backend);
+// 指定したバックエンドの関数表(未対応ならスカラー版)
+const MatrixKernels& GetMatrixKernels(MatrixBackend backend);
+
+// Multiply/Inverse/MakeAffineMatrixなどが使うバックエンド
+MatrixBackend GetActiveMatrixBackend();
+void SetActiveMatrixBackend(MatrixBackend backend);
+const MatrixKernels& GetActiveMatrixKernels();
+
+// バックエンド毎の実装
+Matrix4x4 InverseScalar(const Matrix4x4& m);
+Matrix4x4 MakeAffineMatrixScalar(const Vector3& scale, const Vector3& rotate, const Vector3& translate);
+Matrix4x4 InverseAffineScalar(const Matrix4x4& m);
+Matrix4x4 InverseRigidScalar(const Matrix4x4& m);
+Matrix4x4 MakeNormalMatrixScalar(const Matrix4x4& m);
+void SinCosScalar(const float* radians, float* sins, float* coss, size_t count);
+#ifdef CG3_MATH_SSE
+Matrix4x4 MultiplySSE(const Matrix4x4& m1, const Matrix4x4& m2);
+Matrix4x4 InverseSSE(const Matrix4x4& m);
+Matrix4x4 MakeAffineMatrixSSE(const Vector3& scale, const Vector3& rotate, const Vector3& translate);
+Matrix4x4 InverseAffineSSE(const Matrix4x4& m);
+Matrix4x4 InverseRigidSSE(const Matrix4x4& m);
+Matrix4x4 MakeNormalMatrixSSE(const Matrix4x4& m);
+void SinCosSSE(const float* radians, float* sins, float* coss, size_t count);
+#endif
+#ifdef CG3_MATH_AVX2
+Matrix4x4 MultiplyAVX2(const Matrix4x4& m1, const Matrix4x4& m2);
+Matrix4x4 InverseAVX2(const Matrix4x4& m);
+Matrix4x4 MakeAffineMatrixAVX2(const Vector3& scale, const Vector3& rotate, const Vector3& translate);
+void SinCosAVX2(const float* radians, float* sins, float* coss, size_t count);
+#endif
@@ -0,0 +1,562 @@
+#include "MeshCache.h"
+#include "MeshLod.h"
+#include "Meshlet.h"
+#include "MeshOptimizer.h"
+#include "ObjParser.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+const char kMeshCacheMagic[8] = "CG3MESH";
+
+// 並びを変えたらkMeshCacheVersionを上げる
+static_assert(sizeof(MeshCacheHeader) == 160 && sizeof(MeshCacheDependency) == 32);
+static_assert(sizeof(MeshCacheSubmesh) == 16 && sizeof(MeshCacheMaterial) == 16 && sizeof(MeshCacheLod) == 16);
+static_assert(sizeof(Meshlet) == 32 && sizeof(Sphere) == 16);
+
+uint64_t AlignOffset(uint64_t offset) { return (offset + 15) & ~uint64_t(15); }
+
+int64_t GetWriteTime(const std::string& path, std::error_code& error)
+{
+    return int64_t(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+}
+
+// HashBytesを少しずつ計算する。8バイトずつ掛け算で混ぜる(暗号用ではない)
+const uint64_t kHashMultiplier = 0x9E3779B97F4A7C15ull;
+
+uint64_t BeginHash(uint64_t size)
+{
+    return 0xCBF29CE484222325ull ^ (size * kHashMultiplier);
+}
+
+// sizeは8の倍数
+uint64_t HashWords(uint64_t hash, const unsigned char* bytes, size_t size)
+{
+    for (size_t i = 0; i < size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * kHashMultiplier;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+// 最後の8バイト未満
+uint64_t EndHash(uint64_t hash, const unsigned char* bytes, size_t size)
+{
+    uint64_t tail = 0;
+    std::memcpy(&tail, bytes, size);
+    hash = (hash ^ tail) * kHashMultiplier;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// ファイルをマップせずに少しずつ読んでハッシュを取る(HashBytesと同じ値になる)
+bool HashFile(const std::string& path, uint64_t& hash)
+{
+    const size_t kChunkSize = 1024 * 1024;
+    std::ifstream file(path, std::ios_base::binary);
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(path, error);
+    if (!file.is_open() || error) {
+        return false;
+    }
+    std::vector<unsigned char> buffer(kChunkSize);
+    hash = BeginHash(size);
+    for (uint64_t remaining = size; remaining > 0;) {
+        size_t chunkSize = size_t(std::min<uint64_t>(remaining, kChunkSize));
+        if (!file.read(reinterpret_cast<char*>(buffer.data()), std::streamsize(chunkSize))) {
+            return false;
+        }
+        remaining -= chunkSize;
+        size_t wordSize = chunkSize & ~size_t(7);
+        hash = HashWords(hash, buffer.data(), wordSize);
+        // kChunkSizeは8の倍数なので、端数が出るのは最後だけ
+        if (remaining == 0) {
+            hash = EndHash(hash, buffer.data() + wordSize, chunkSize - wordSize);
+        }
+    }
+    if (size == 0) {
+        hash = EndHash(hash, buffer.data(), 0);
+    }
+    return true;
+}
+
+// 範囲がファイルの中に収まっているか
+bool IsInFile(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+{
+    return offset <= fileSize && count <= (fileSize - offset) / elementSize;
+}
+
+// [offset, offset + count)が[0, size)に収まっているか
+bool IsInRange(uint64_t offset, uint64_t count, uint64_t size)
+{
+    return offset <= size && count <= size - offset;
+}
+
+// サブメッシュがindexCount個のindexの中にあり、マテリアルの番号が表の中にあるか
+bool IsValidSubmeshes(const MeshCacheSubmesh* submeshes, uint32_t submeshCount, uint64_t indexCount, uint32_t materialCount)
+{
+    for (uint32_t i = 0; i < submeshCount; ++i) {
+        if (!IsInRange(submeshes[i].indexOffset, submeshes[i].indexCount, indexCount) || submeshes[i].materialIndex >= materialCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 範囲を確かめた後で、各部分の中の位置と番号がそれぞれの表の中にあるか
+bool IsValidContents(const MeshCacheHeader& header, const char* data)
+{
+    const MeshCacheSubmesh* submeshes = reinterpret_cast<const MeshCacheSubmesh*>(data + header.submeshOffset);
+    if (!IsValidSubmeshes(submeshes, header.submeshCount, header.indexCount, header.materialCount)) {
+        return false;
+    }
+    // LODのindexは元のメッシュの後ろ、サブメッシュの表はLOD毎に続けて置いてある
+    uint64_t totalIndexCount = uint64_t(header.indexCount) + header.lodIndexCount;
+    uint64_t totalSubmeshCount = uint64_t(header.submeshCount) * (uint64_t(header.lodCount) + 1);
+    const MeshCacheLod* lods = reinterpret_cast<const MeshCacheLod*>(data + header.lodOffset);
+    for (uint32_t i = 0; i < header.lodCount; ++i) {
+        const MeshCacheLod& lod = lods[i];
+        if (!IsInRange(lod.indexOffset, lod.indexCount, totalIndexCount) || !IsInRange(lod.submeshOffset, header.submeshCount, totalSubmeshCount)
+            || !IsValidSubmeshes(submeshes + lod.submeshOffset, header.submeshCount, lod.indexCount, header.materialCount)) {
+            return false;
+        }
+    }
+    const Meshlet* meshlets = reinterpret_cast<const Meshlet*>(data + header.meshletOffset);
+    for (uint32_t i = 0; i < header.meshletCount; ++i) {
+        if (!IsInRange(meshlets[i].indexOffset, uint64_t(meshlets[i].triangleCount) * 3, header.indexCount)
+            || meshlets[i].materialIndex >= header.materialCount) {
+            return false;
+        }
+    }
+    // indexの値(LODの分も)が頂点の中を指しているか。分岐せずに最大値を取る
+    const uint32_t* indices = reinterpret_cast<const uint32_t*>(data + header.indexOffset);
+    uint32_t maxIndex = 0;
+    for (uint64_t i = 0; i < totalIndexCount; ++i) {
+        maxIndex = std::max(maxIndex, indices[i]);
+    }
+    return totalIndexCount == 0 || maxIndex < header.vertexCount;
+}
+
+}
+
+uint64_t HashBytes(const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    size_t wordSize = size & ~size_t(7);
+    return EndHash(HashWords(BeginHash(size), bytes, wordSize), bytes + wordSize, size - wordSize);
+}
+
+bool MeshCacheFile::Open(const std::string& cachePath)
+{
+    header_ = nullptr;
+    if (!file_.Open(cachePath) || file_.GetSize() < sizeof(MeshCacheHeader)) {
+        return false;
+    }
+    const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(file_.GetData());
+    uint64_t size = file_.GetSize();
+    if (std::memcmp(header->magic, kMeshCacheMagic, sizeof(kMeshCacheMagic)) != 0 || header->version != kMeshCacheVersion
+        || header->vertexStride != sizeof(VertexData) || header->fileSize != size) {
+        return false;
+    }
+    // 壊れたファイルで範囲外を読まないように確かめる
+    if (!IsInFile(header->vertexOffset, header->vertexCount, sizeof(VertexData), size)
+        || !IsInFile(header->indexOffset, uint64_t(header->indexCount) + header->lodIndexCount, sizeof(uint32_t), size)
+        || !IsInFile(header->submeshOffset, uint64_t(header->submeshCount) * (uint64_t(header->lodCount) + 1), sizeof(MeshCacheSubmesh), size)
+        || !IsInFile(header->materialOffset, header->materialCount, sizeof(MeshCacheMaterial), size)
+        || !IsInFile(header->lodOffset, header->lodCount, sizeof(MeshCacheLod), size)
+        || !IsInFile(header->meshletOffset, header->meshletCount, sizeof(Meshlet), size)
+        || !IsInFile(header->meshletBoundsOffset, header->meshletCount, sizeof(Sphere), size)
+        || !IsInFile(header->dependencyOffset, header->dependencyCount, sizeof(MeshCacheDependency), size)
+        || !IsInFile(header->stringOffset, header->stringSize, 1, size) || !IsValidContents(*header, file_.GetData())) {
+        return false;
+    }
+    header_ = header;
+    return true;
+}
+
+bool MeshCacheFile::IsUpToDate() const
+{
+    for (uint32_t i = 0; i < header_->dependencyCount; ++i) {
+        const MeshCacheDependency& dependency = GetDependencies()[i];
+        std::string path(GetString(dependency.path));
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(path, error);
+        if (error || size != dependency.size) {
+            return false;
+        }
+        int64_t writeTime = GetWriteTime(path, error);
+        if (!error && writeTime == dependency.writeTime) {
+            continue;
+        }
+        // 時刻だけ変わった(コピーしたなど)なら中身で比べる
+        MappedFile source;
+        if (!source.Open(path) || HashBytes(source.GetData(), source.GetSize()) != dependency.hash) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const VertexData* MeshCacheFile::GetVertices() const
+{
+    return reinterpret_cast<const VertexData*>(file_.GetData() + header_->vertexOffset);
+}
+
+const uint32_t* MeshCacheFile::GetIndices() const
+{
+    return reinterpret_cast<const uint32_t*>(file_.GetData() + header_->indexOffset);
+}
+
+const MeshCacheSubmesh* MeshCacheFile::GetSubmeshes() const
+{
+    return reinterpret_cast<const MeshCacheSubmesh*>(file_.GetData() + header_->submeshOffset);
+}
+
+const MeshCacheMaterial* MeshCacheFile::GetMaterials() const
+{
+    return reinterpret_cast<const MeshCacheMaterial*>(file_.GetData() + header_->materialOffset);
+}
+
+const MeshCacheLod* MeshCacheFile::GetLods() const
+{
+    return reinterpret_cast<const MeshCacheLod*>(file_.GetData() + header_->lodOffset);
+}
+
+const Meshlet* MeshCacheFile::GetMeshlets() const
+{
+    return reinterpret_cast<const Meshlet*>(file_.GetData() + header_->meshletOffset);
+}
+
+const Sphere* MeshCacheFile::GetMeshletBounds() const
+{
+    return reinterpret_cast<const Sphere*>(file_.GetData() + header_->meshletBoundsOffset);
+}
+
+const MeshCacheDependency* MeshCacheFile::GetDependencies() const
+{
+    return reinterpret_cast<const MeshCacheDependency*>(file_.GetData() + header_->dependencyOffset);
+}
+
+std::string_view MeshCacheFile::GetString(const MeshCacheString& string) const
+{
+    if (uint64_t(string.offset) + string.length > header_->stringSize) {
+        return {};
+    }
+    return std::string_view(file_.GetData() + header_->stringOffset + string.offset, string.length);
+}
+
+ModelData MeshCacheFile::ToModelData() const
+{
+    ModelData modelData;
+    modelData.vertices.assign(GetVertices(), GetVertices() + header_->vertexCount);
+    modelData.indices.assign(GetIndices(), GetIndices() + header_->indexCount);
+    for (uint32_t i = 0; i < header_->submeshCount; ++i) {
+        const MeshCacheSubmesh& submesh = GetSubmeshes()[i];
+        modelData.submeshes.push_back({ submesh.indexOffset, submesh.indexCount, submesh.materialIndex });
+    }
+    for (uint32_t i = 0; i < header_->materialCount; ++i) {
+        const MeshCacheMaterial& material = GetMaterials()[i];
+        modelData.materials.push_back({ std::string(GetString(material.name)), std::string(GetString(material.textureFilePath)) });
+    }
+    for (uint32_t i = 0; i < header_->lodCount; ++i) {
+        const MeshCacheLod& source = GetLods()[i];
+        MeshLod lod;
+        lod.indices.assign(GetIndices() + source.indexOffset, GetIndices() + source.indexOffset + source.indexCount);
+        for (uint32_t s = 0; s < header_->submeshCount; ++s) {
+            const MeshCacheSubmesh& submesh = GetSubmeshes()[source.submeshOffset + s];
+            lod.submeshes.push_back({ submesh.indexOffset, submesh.indexCount, submesh.materialIndex });
+        }
+        lod.error = source.error;
+        modelData.lods.push_back(std::move(lod));
+    }
+    modelData.meshlets.assign(GetMeshlets(), GetMeshlets() + header_->meshletCount);
+    modelData.meshletBounds.assign(GetMeshletBounds(), GetMeshletBounds() + header_->meshletCount);
+    return modelData;
+}
+
+bool WriteMeshCache(const std::string& cachePath, const ModelData& modelData, const std::vector<std::string>& dependencyPaths)
+{
+    std::string strings;
+    auto addString = [&strings](const std::string& string) {
+        MeshCacheString result = { uint32_t(strings.size()), uint32_t(string.size()) };
+        strings += string;
+        return result;
+    };
+
+    std::vector<MeshCacheDependency> dependencies;
+    for (const std::string& path : dependencyPaths) {
+        MappedFile source;
+        std::error_code error;
+        int64_t writeTime = GetWriteTime(path, error);
+        if (!source.Open(path) || error) {
+            return false;
+        }
+        dependencies.push_back({ addString(path), source.GetSize(), writeTime, HashBytes(source.GetData(), source.GetSize()) });
+    }
+    std::vector<MeshCacheSubmesh> submeshes;
+    for (const Submesh& submesh : modelData.submeshes) {
+        submeshes.push_back({ submesh.indexOffset, submesh.indexCount, submesh.materialIndex, 0 });
+    }
+    if (modelData.meshletBounds.size() != modelData.meshlets.size()) {
+        return false;
+    }
+    std::vector<MeshCacheLod> lods;
+    uint32_t lodIndexCount = 0;
+    for (const MeshLod& lod : modelData.lods) {
+        if (lod.submeshes.size() != modelData.submeshes.size()) {
+            return false;
+        }
+        lods.push_back({ uint32_t(modelData.indices.size()) + lodIndexCount, uint32_t(lod.indices.size()), uint32_t(submeshes.size()), lod.error });
+        for (const Submesh& submesh : lod.submeshes) {
+            submeshes.push_back({ submesh.indexOffset, submesh.indexCount, submesh.materialIndex, 0 });
+        }
+        lodIndexCount += uint32_t(lod.indices.size());
+    }
+    std::vector<MeshCacheMaterial> materials;
+    for (const MaterialData& material : modelData.materials) {
+        materials.push_back({ addString(material.name), addString(material.textureFilePath) });
+    }
+
+    MeshCacheHeader header = {};
+    std::memcpy(header.magic, kMeshCacheMagic, sizeof(kMeshCacheMagic));
+    header.version = kMeshCacheVersion;
+    header.vertexStride = sizeof(VertexData);
+    header.vertexCount = uint32_t(modelData.vertices.size());
+    header.indexCount = uint32_t(modelData.indices.size());
+    header.submeshCount = uint32_t(modelData.submeshes.size());
+    header.materialCount = uint32_t(materials.size());
+    header.dependencyCount = uint32_t(dependencies.size());
+    header.stringSize = uint32_t(strings.size());
+    header.lodCount = uint32_t(lods.size());
+    header.lodIndexCount = lodIndexCount;
+    header.meshletCount = uint32_t(modelData.meshlets.size());
+    header.bounds = CalculateBounds(modelData);
+    header.vertexOffset = AlignOffset(sizeof(MeshCacheHeader));
+    header.indexOffset = AlignOffset(header.vertexOffset + sizeof(VertexData) * modelData.vertices.size());
+    header.submeshOffset = AlignOffset(header.indexOffset + sizeof(uint32_t) * (modelData.indices.size() + lodIndexCount));
+    header.materialOffset = AlignOffset(header.submeshOffset + sizeof(MeshCacheSubmesh) * submeshes.size());
+    header.lodOffset = AlignOffset(header.materialOffset + sizeof(MeshCacheMaterial) * materials.size());
+    header.meshletOffset = AlignOffset(header.lodOffset + sizeof(MeshCacheLod) * lods.size());
+    header.meshletBoundsOffset = AlignOffset(header.meshletOffset + sizeof(Meshlet) * modelData.meshlets.size());
+    header.dependencyOffset = AlignOffset(header.meshletBoundsOffset + sizeof(Sphere) * modelData.meshletBounds.size());
+    header.stringOffset = AlignOffset(header.dependencyOffset + sizeof(MeshCacheDependency) * dependencies.size());
+    header.fileSize = header.stringOffset + strings.size();
+
+    std::string temporaryPath = cachePath + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios_base::binary | std::ios_base::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        uint64_t position = 0;
+        auto write = [&](uint64_t offset, const void* data, size_t size) {
+            // 境界までを0で埋める
+            static const char kZeros[16] = {};
+            file.write(kZeros, std::streamsize(offset - position));
+            file.write(static_cast<const char*>(data), std::streamsize(size));
+            position = offset + size;
+        };
+        write(0, &header, sizeof(header));
+        write(header.vertexOffset, modelData.vertices.data(), sizeof(VertexData) * modelData.vertices.size());
+        write(header.indexOffset, modelData.indices.data(), sizeof(uint32_t) * modelData.indices.size());
+        for (const MeshLod& lod : modelData.lods) {
+            write(position, lod.indices.data(), sizeof(uint32_t) * lod.indices.size());
+        }
+        write(header.submeshOffset, submeshes.data(), sizeof(MeshCacheSubmesh) * submeshes.size());
+        write(header.materialOffset, materials.data(), sizeof(MeshCacheMaterial) * materials.size());
+        write(header.lodOffset, lods.data(), sizeof(MeshCacheLod) * lods.size());
+        write(header.meshletOffset, modelData.meshlets.data(), sizeof(Meshlet) * modelData.meshlets.size());
+        write(header.meshletBoundsOffset, modelData.meshletBounds.data(), sizeof(Sphere) * modelData.meshletBounds.size());
+        write(header.dependencyOffset, dependencies.data(), sizeof(MeshCacheDependency) * dependencies.size());
+        write(header.stringOffset, strings.data(), strings.size());
+        if (!file.good()) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, cachePath, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
+
+std::string GetMeshCachePath(const std::string& directoryPath, const std::string& filename)
+{
+    return directoryPath + "/" + std::filesystem::path(filename).stem().string() + ".cg3mesh";
+}
+
+ModelData LoadObjFileCached(const std::string& directoryPath, const std::string& filename, uint32_t threadCount, bool* usedCache)
+{
+    std::string cachePath = GetMeshCachePath(directoryPath, filename);
+    {
+        MeshCacheFile cache;
+        if (cache.Open(cachePath) && cache.IsUpToDate()) {
+            if (usedCache) {
+                *usedCache = true;
+            }
+            return cache.ToModelData();
+        }
+    }
+    if (usedCache) {
+        *usedCache = false;
+    }
+
+    std::string objPath = directoryPath + "/" + filename;
+    MappedFile file;
+    if (!file.Open(objPath)) {
+        return LoadObjFile(directoryPath, filename, threadCount); // 開けないときの扱いは同じにする
+    }
+    ModelData modelData = ParseObj(file.GetData(), file.GetSize(), directoryPath, threadCount);
+    OptimizeMesh(modelData);
+    BuildMeshlets(modelData);
+    BuildLodChain(modelData);
+    std::vector<std::string> dependencyPaths = { objPath };
+    for (const std::string& materialFilename : FindObjMaterialLibraries(file.GetData(), file.GetSize())) {
+        dependencyPaths.push_back(directoryPath + "/" + materialFilename);
+    }
+    WriteMeshCache(cachePath, modelData, dependencyPaths);
+    return modelData;
+}
+
+bool ImportObjStreaming(const std::string& directoryPath, const std::string& filename, const std::string& cachePath, const ObjStreamOptions& options,
+    ObjStreamInfo* info)
+{
+    MeshCacheHeader header = {};
+    std::memcpy(header.magic, kMeshCacheMagic, sizeof(kMeshCacheMagic));
+    header.version = kMeshCacheVersion;
+    header.vertexStride = sizeof(VertexData);
+    header.vertexOffset = AlignOffset(sizeof(MeshCacheHeader));
+
+    std::string temporaryPath = cachePath + ".tmp";
+    ObjStreamInfo streamInfo;
+    bool isWritten = false;
+    {
+        std::ofstream file(temporaryPath, std::ios_base::binary | std::ios_base::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        uint64_t position = 0;
+        auto write = [&](uint64_t offset, const void* data, size_t size) {
+            // 境界までを0で埋める
+            static const char kZeros[16] = {};
+            file.write(kZeros, std::streamsize(offset - position));
+            file.write(static_cast<const char*>(data), std::streamsize(size));
+            position = offset + size;
+        };
+        // ヘッダーは数が決まってから書き直す
+        write(0, &header, sizeof(header));
+
+        // 頂点とindexは受け取ったそばから書く
+        uint64_t vertexCount = 0;
+        uint64_t indexCount = 0;
+        ObjStreamOutput output;
+        output.writeVertices = [&](const VertexData* vertices, size_t count) {
+            if (vertexCount == 0) {
+                const Vector4& first = vertices[0].position;
+                header.bounds = { { first.x, first.y, first.z }, { first.x, first.y, first.z } };
+            }
+            for (size_t i = 0; i < count; ++i) {
+                const Vector4& p = vertices[i].position;
+                header.bounds.min = { std::min(header.bounds.min.x, p.x), std::min(header.bounds.min.y, p.y), std::min(header.bounds.min.z, p.z) };
+                header.bounds.max = { std::max(header.bounds.max.x, p.x), std::max(header.bounds.max.y, p.y), std::max(header.bounds.max.z, p.z) };
+            }
+            write(vertexCount == 0 ? header.vertexOffset : position, vertices, sizeof(VertexData) * count);
+            vertexCount += count;
+            return file.good();
+        };
+        output.writeIndices = [&](const uint32_t* indices, size_t count) {
+            if (indexCount == 0) {
+                header.indexOffset = AlignOffset(std::max<uint64_t>(position, header.vertexOffset));
+            }
+            write(indexCount == 0 ? header.indexOffset : position, indices, sizeof(uint32_t) * count);
+            indexCount += count;
+            return file.good();
+        };
+        if (!StreamObj(directoryPath, filename, options, output, streamInfo)) {
+            file.close();
+            std::error_code error;
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+        if (indexCount == 0) {
+            header.indexOffset = AlignOffset(std::max<uint64_t>(position, header.vertexOffset));
+        }
+
+        std::string strings;
+        auto addString = [&strings](const std::string& string) {
+            MeshCacheString result = { uint32_t(strings.size()), uint32_t(string.size()) };
+            strings += string;
+            return result;
+        };
+        // 元のファイルもマップせずに少しずつ読んでハッシュを取る
+        std::vector<MeshCacheDependency> dependencies;
+        std::vector<std::string> dependencyPaths = { directoryPath + "/" + filename };
+        for (const std::string& materialFilename : streamInfo.materialLibraries) {
+            dependencyPaths.push_back(directoryPath + "/" + materialFilename);
+        }
+        bool hasDependencies = true;
+        for (const std::string& path : dependencyPaths) {
+            std::error_code error;
+            uint64_t size = std::filesystem::file_size(path, error);
+            int64_t writeTime = error ? 0 : GetWriteTime(path, error);
+            uint64_t hash = 0;
+            if (error || !HashFile(path, hash)) {
+                hasDependencies = false;
+                break;
+            }
+            dependencies.push_back({ addString(path), size, writeTime, hash });
+        }
+        std::vector<MeshCacheSubmesh> submeshes;
+        for (const Submesh& submesh : streamInfo.submeshes) {
+            submeshes.push_back({ submesh.indexOffset, submesh.indexCount, submesh.materialIndex, 0 });
+        }
+        std::vector<MeshCacheMaterial> materials;
+        for (const MaterialData& material : streamInfo.materials) {
+            materials.push_back({ addString(material.name), addString(material.textureFilePath) });
+        }
+
+        // LODとメッシュレットは無い
+        header.vertexCount = uint32_t(vertexCount);
+        header.indexCount = uint32_t(indexCount);
+        header.submeshCount = uint32_t(submeshes.size());
+        header.materialCount = uint32_t(materials.size());
+        header.dependencyCount = uint32_t(dependencies.size());
+        header.stringSize = uint32_t(strings.size());
+        header.submeshOffset = AlignOffset(header.indexOffset + sizeof(uint32_t) * indexCount);
+        header.materialOffset = AlignOffset(header.submeshOffset + sizeof(MeshCacheSubmesh) * submeshes.size());
+        header.lodOffset = AlignOffset(header.materialOffset + sizeof(MeshCacheMaterial) * materials.size());
+        header.meshletOffset = header.lodOffset;
+        header.meshletBoundsOffset = header.lodOffset;
+        header.dependencyOffset = header.lodOffset;
+        header.stringOffset = AlignOffset(header.dependencyOffset + sizeof(MeshCacheDependency) * dependencies.size());
+        header.fileSize = header.stringOffset + strings.size();
+        write(header.submeshOffset, submeshes.data(), sizeof(MeshCacheSubmesh) * submeshes.size());
+        write(header.materialOffset, materials.data(), sizeof(MeshCacheMaterial) * materials.size());
+        write(header.dependencyOffset, dependencies.data(), sizeof(MeshCacheDependency) * dependencies.size());
+        write(header.stringOffset, strings.data(), strings.size());
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        isWritten = hasDependencies && file.good();
+    }
+    std::error_code error;
+    if (isWritten) {
+        std::filesystem::rename(temporaryPath, cachePath, error);
+    }
+    if (!isWritten || error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    if (info) {
+        *info = std::move(streamInfo);
+    }
+    return true;
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include "MappedFile.h"
+#include "Model.h"
+#include "ObjParser.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 読み込んだモデルのキャッシュ(.cg3mesh)
+//
+// objを1回読んだら頂点・index・サブメッシュ・マテリアル・LOD・メッシュレット・AABBをそのままの並びで書き出し、
+// 次からはファイルをマップして使う(中身はindexが頂点の数を超えていないかを確かめるために1回読むだけ)。
+// 元のファイル(objとmtl)のサイズ・更新時刻・ハッシュを持っていて、
+// サイズと更新時刻が同じならそのまま使い、更新時刻だけ違うときはハッシュを比べる。
+// バージョンやVertexDataの大きさが違うものは使わない。リトルエンディアンのみ。
+// 並びや書き込む前の処理(OptimizeMeshなど)を変えたらバージョンを上げる。
+//
+// ファイルの並び(各部分の先頭は16バイト境界)
+//   MeshCacheHeader
+//   VertexData[vertexCount]
+//   uint32_t[indexCount + lodIndexCount] (元のメッシュの後ろにLODを順に続ける。CopyIndicesと同じ並び)
+//   MeshCacheSubmesh[submeshCount * (lodCount + 1)] (元のメッシュ、LOD1、LOD2…の順)
+//   MeshCacheMaterial[materialCount]
+//   MeshCacheLod[lodCount]
+//   Meshlet[meshletCount]
+//   Sphere[meshletCount] (メッシュレットの境界球)
+//   MeshCacheDependency[dependencyCount]
+//   文字列(パスとマテリアルの名前。終端の0は無い)
+
+const uint32_t kMeshCacheVersion = 6;
+
+// 文字列の部分での位置
+struct MeshCacheString {
+    uint32_t offset;
+    uint32_t length;
+};
+// 元のファイル
+struct MeshCacheDependency {
+    MeshCacheString path;
+    uint64_t size;
+    int64_t writeTime; // std::filesystem::last_write_timeの値
+    uint64_t hash;
+};
+// indexの範囲と使うマテリアル
+struct MeshCacheSubmesh {
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    uint32_t materialIndex;
+    uint32_t reserved;
+};
+struct MeshCacheMaterial {
+    MeshCacheString name;
+    MeshCacheString textureFilePath;
+};
+// LOD1から順に
+struct MeshCacheLod {
+    uint32_t indexOffset; // 元のメッシュのindexの先頭からの位置
+    uint32_t indexCount;
+    uint32_t submeshOffset; // サブメッシュの表での位置
+    float error;
+};
+struct MeshCacheHeader {
+    char magic[8]; // "CG3MESH"
+    uint32_t version;
+    uint32_t vertexStride; // sizeof(VertexData)
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t submeshCount; // 元のメッシュの数(各LODも同じ数)
+    uint32_t materialCount;
+    uint32_t dependencyCount;
+    uint32_t stringSize;
+    uint32_t lodCount;
+    uint32_t lodIndexCount;
+    uint32_t meshletCount;
+    uint32_t reserved;
+    AABB bounds;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t submeshOffset;
+    uint64_t materialOffset;
+    uint64_t lodOffset;
+    uint64_t meshletOffset;
+    uint64_t meshletBoundsOffset;
+    uint64_t dependencyOffset;
+    uint64_t stringOffset;
+    uint64_t fileSize;
+};
+
+// キャッシュをマップして中を見る。頂点とindexはマップした所を直接指すので、
+// アップロード用のバッファへそのままコピーできる
+class MeshCacheFile {
+public:
+    // 形式が合わなければfalse(元のファイルとの比較はIsUpToDateで行う)
+    bool Open(const std::string& cachePath);
+
+    // 以下はOpenが成功してから使う
+    // 元のファイルが変わっていなければtrue
+    bool IsUpToDate() const;
+
+    const MeshCacheHeader& GetHeader() const { return *header_; }
+    const VertexData* GetVertices() const;
+    const uint32_t* GetIndices() const;
+    const MeshCacheSubmesh* GetSubmeshes() const;
+    const MeshCacheMaterial* GetMaterials() const;
+    const MeshCacheLod* GetLods() const;
+    const Meshlet* GetMeshlets() const;
+    const Sphere* GetMeshletBounds() const;
+    const MeshCacheDependency* GetDependencies() const;
+    std::string_view GetString(const MeshCacheString& string) const;
+
+    // ModelDataにコピーする
+    ModelData ToModelData() const;
+
+private:
+    MappedFile file_;
+    const MeshCacheHeader* header_ = nullptr;
+};
+
+// データのハッシュ(64bit)
+uint64_t HashBytes(const void* data, size_t size);
+
+// キャッシュを書く。dependencyPathsは元のファイル(書いた時点のサイズ・更新時刻・ハッシュを記録する)。
+// 一時ファイルに書いてから置き換えるので、途中で失敗しても壊れたキャッシュは残らない
+bool WriteMeshCache(const std::string& cachePath, const ModelData& modelData, const std::vector<std::string>& dependencyPaths);
+
+// objのキャッシュの場所(objと同じディレクトリに 名前.cg3mesh)
+std::string GetMeshCachePath(const std::string& directoryPath, const std::string& filename);
+
+// objをStreamObjで少しずつ読み、頂点とindexを受け取ったそばからcachePathへ書く(ModelData全体をメモリに置かない)。
+// 使うメモリはoptions.memoryBudgetくらいで収まる。全体が要るOptimizeMesh・メッシュレット・LODは作らない。
+// 元のファイルはLoadObjFileCachedと同じものを記録するので、GetMeshCachePathに書けば次からはそのまま使われる
+bool ImportObjStreaming(const std::string& directoryPath, const std::string& filename, const std::string& cachePath,
+    const ObjStreamOptions& options = {}, ObjStreamInfo* info = nullptr);
+
+// キャッシュが使えればそこから読み、使えなければobjを読んでOptimizeMeshで並べ直し、
+// BuildMeshletsでメッシュレットに分け、BuildLodChainでLODを作ってからキャッシュを書く
+// (書けなくても読み込みは続ける)。usedCacheには使ったかどうかを入れる
+ModelData LoadObjFileCached(const std::string& directoryPath, const std::string& filename, uint32_t threadCount = 1, bool* usedCache = nullptr);
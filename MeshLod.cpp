@@ -0,0 +1,543 @@
+#include "MeshLod.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+const uint32_t kNone = ~0u;
+
+// 面の二次誤差(平面までの距離の2乗を面積で重み付けして足したもの)
+struct Quadric {
+    float a00, a01, a02, a11, a12, a22;
+    float b0, b1, b2;
+    float c;
+    float weight;
+};
+
+void AddQuadric(Quadric& quadric, const Quadric& other)
+{
+    quadric.a00 += other.a00;
+    quadric.a01 += other.a01;
+    quadric.a02 += other.a02;
+    quadric.a11 += other.a11;
+    quadric.a12 += other.a12;
+    quadric.a22 += other.a22;
+    quadric.b0 += other.b0;
+    quadric.b1 += other.b1;
+    quadric.b2 += other.b2;
+    quadric.c += other.c;
+    quadric.weight += other.weight;
+}
+
+// dot(normal, p) + distance = 0 の平面(normalは単位ベクトル)
+Quadric MakePlaneQuadric(const Vector3& normal, float distance, float weight)
+{
+    return { weight * normal.x * normal.x, weight * normal.x * normal.y, weight * normal.x * normal.z, weight * normal.y * normal.y,
+        weight * normal.y * normal.z, weight * normal.z * normal.z, weight * normal.x * distance, weight * normal.y * distance,
+        weight * normal.z * distance, weight * distance * distance, weight };
+}
+
+// 平面までの距離の2乗の重み付き平均
+float EvaluateQuadric(const Quadric& quadric, const Vector3& p)
+{
+    if (quadric.weight <= 0.0f) {
+        return 0.0f;
+    }
+    float value = quadric.a00 * p.x * p.x + quadric.a11 * p.y * p.y + quadric.a22 * p.z * p.z
+        + 2.0f * (quadric.a01 * p.x * p.y + quadric.a02 * p.x * p.z + quadric.a12 * p.y * p.z)
+        + 2.0f * (quadric.b0 * p.x + quadric.b1 * p.y + quadric.b2 * p.z) + quadric.c;
+    return std::max(value, 0.0f) / quadric.weight;
+}
+
+Vector3 Subtract(const Vector3& a, const Vector3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+Vector3 CrossProduct(const Vector3& a, const Vector3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+float DotProduct(const Vector3& a, const Vector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+// uvと法線の差の2乗
+float AttributeDistance(const VertexData& a, const VertexData& b)
+{
+    float du = a.texcoord.x - b.texcoord.x;
+    float dv = a.texcoord.y - b.texcoord.y;
+    Vector3 dn = Subtract(a.normal, b.normal);
+    return du * du + dv * dv + DotProduct(dn, dn);
+}
+
+// aをbへ寄せる候補
+struct Collapse {
+    float cost;
+    uint32_t from;
+    uint32_t to;
+};
+
+class Simplifier {
+public:
+    Simplifier(const std::vector<VertexData>& vertices, const uint32_t* indices, size_t indexCount, float attributeWeight);
+
+    // 1回分。潰した数を返す
+    size_t RunPass(size_t targetTriangleCount, bool limitError);
+    size_t GetTriangleCount() const { return indices_.size() / 3; }
+    std::vector<uint32_t>& GetIndices() { return indices_; }
+    // モデルの単位
+    float GetError() const { return std::sqrt(maxError_) / scale_; }
+
+private:
+    // 点(位置が同じ頂点のまとまり)毎に、使う三角形と頂点の一覧を作る
+    void BuildAdjacency();
+    // 隣の点(小さい順)
+    void GatherRing(uint32_t point, std::vector<uint32_t>& ring) const;
+    // fromの頂点をそれぞれtoのどの頂点へ付け替えるか決め、ずれの最大を返す
+    float MatchWedges(uint32_t from, uint32_t to, std::vector<uint32_t>* targets);
+    float CalculateCost(uint32_t from, uint32_t to, float* geometricError);
+    bool IsCollapseValid(uint32_t from, uint32_t to);
+
+    const std::vector<VertexData>& vertices_;
+    float attributeWeight_;
+    float scale_; // メッシュの大きさを1にする倍率
+    float maxError_ = 0.0f; // 潰したものの二次誤差の最大(大きさを1にした単位)
+    std::vector<uint32_t> indices_;
+    std::vector<uint32_t> points_; // 頂点毎の点の番号(その点の頂点で一番小さい番号。使われない頂点はkNone)
+    std::vector<Vector3> positions_; // 頂点毎の位置(大きさを1にしたもの)
+    std::vector<Quadric> quadrics_; // 点毎
+    std::vector<bool> isLocked_; // 点毎。縁などで動かさない
+    // 以下はパス毎に作り直す
+    std::vector<uint32_t> adjacencyOffsets_; // 点毎にその点を使う三角形
+    std::vector<uint32_t> adjacencyTriangles_;
+    std::vector<uint32_t> wedgeOffsets_; // 点毎にその点の頂点(三角形の並びで初めて出てきた順)
+    std::vector<uint32_t> wedges_;
+    std::vector<bool> isWedgeGathered_;
+    std::vector<bool> isPassLocked_; // このパスで周りが変わった点
+    std::vector<uint32_t> collapseTargets_; // 点毎の寄せる先(kNoneなら寄せない)
+    std::vector<uint32_t> wedgeTargets_; // 頂点毎の付け替え先
+    // 作業用
+    std::vector<uint32_t> ring_;
+    std::vector<uint32_t> otherRing_;
+};
+
+Simplifier::Simplifier(const std::vector<VertexData>& vertices, const uint32_t* indices, size_t indexCount, float attributeWeight)
+    : vertices_(vertices)
+    , attributeWeight_(attributeWeight)
+{
+    size_t vertexCount = vertices.size();
+
+    // 位置がビット単位で同じ頂点を1つの点にまとめる(番号の小さいものを代表にする)
+    std::vector<uint32_t> used;
+    {
+        std::vector<bool> isUsed(vertexCount, false);
+        for (size_t i = 0; i < indexCount; ++i) {
+            if (!isUsed[indices[i]]) {
+                isUsed[indices[i]] = true;
+                used.push_back(indices[i]);
+            }
+        }
+    }
+    auto lessPosition = [&vertices](uint32_t a, uint32_t b) {
+        int order = std::memcmp(&vertices[a].position, &vertices[b].position, sizeof(float) * 3);
+        return order != 0 ? order < 0 : a < b;
+    };
+    std::sort(used.begin(), used.end(), lessPosition);
+    points_.assign(vertexCount, kNone);
+    for (size_t i = 0; i < used.size(); ++i) {
+        bool isSame = i > 0 && std::memcmp(&vertices[used[i]].position, &vertices[used[i - 1]].position, sizeof(float) * 3) == 0;
+        points_[used[i]] = isSame ? points_[used[i - 1]] : used[i];
+    }
+
+    // 大きさを1にした位置
+    Vector3 min = { 0.0f, 0.0f, 0.0f };
+    Vector3 max = { 0.0f, 0.0f, 0.0f };
+    for (size_t i = 0; i < used.size(); ++i) {
+        const Vector4& p = vertices[used[i]].position;
+        min = i == 0 ? Vector3 { p.x, p.y, p.z } : Vector3 { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+        max = i == 0 ? Vector3 { p.x, p.y, p.z } : Vector3 { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+    }
+    float extent = std::max({ max.x - min.x, max.y - min.y, max.z - min.z });
+    scale_ = extent > 0.0f ? 1.0f / extent : 1.0f;
+    positions_.resize(vertexCount);
+    for (uint32_t vertex : used) {
+        const Vector4& p = vertices[vertex].position;
+        positions_[vertex] = { (p.x - min.x) * scale_, (p.y - min.y) * scale_, (p.z - min.z) * scale_ };
+    }
+
+    // 潰れている三角形は最初に除く
+    indices_.reserve(indexCount);
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        uint32_t p0 = points_[indices[i]];
+        uint32_t p1 = points_[indices[i + 1]];
+        uint32_t p2 = points_[indices[i + 2]];
+        if (p0 != p1 && p1 != p2 && p2 != p0) {
+            indices_.insert(indices_.end(), indices + i, indices + i + 3);
+        }
+    }
+
+    // 面の平面を点に足す
+    quadrics_.assign(vertexCount, Quadric {});
+    for (size_t i = 0; i < indices_.size(); i += 3) {
+        const Vector3& p0 = positions_[indices_[i]];
+        Vector3 normal = CrossProduct(Subtract(positions_[indices_[i + 1]], p0), Subtract(positions_[indices_[i + 2]], p0));
+        float length = std::sqrt(DotProduct(normal, normal));
+        if (length == 0.0f) {
+            continue;
+        }
+        normal = { normal.x / length, normal.y / length, normal.z / length };
+        Quadric quadric = MakePlaneQuadric(normal, -DotProduct(normal, p0), length * 0.5f);
+        for (int corner = 0; corner < 3; ++corner) {
+            AddQuadric(quadrics_[points_[indices_[i + corner]]], quadric);
+        }
+    }
+
+    // 辺を(小さい点, 大きい点)で並べ、向き毎に数える。
+    // 片方の向きにしか無い辺は縁、同じ向きが2本以上ある辺は3枚以上で共有されているので、その両端を動かさない
+    std::vector<uint64_t> edges;
+    edges.reserve(indices_.size());
+    for (size_t i = 0; i < indices_.size(); i += 3) {
+        for (int corner = 0; corner < 3; ++corner) {
+            uint32_t a = points_[indices_[i + corner]];
+            uint32_t b = points_[indices_[i + (corner + 1) % 3]];
+            // 向きは一番下のbitに入れる
+            edges.push_back(a < b ? (uint64_t(a) << 33 | uint64_t(b) << 1) : (uint64_t(b) << 33 | uint64_t(a) << 1 | 1));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    isLocked_.assign(vertexCount, false);
+    for (size_t begin = 0; begin < edges.size();) {
+        size_t end = begin;
+        uint32_t counts[2] = { 0, 0 };
+        while (end < edges.size() && (edges[end] >> 1) == (edges[begin] >> 1)) {
+            ++counts[edges[end] & 1];
+            ++end;
+        }
+        if (counts[0] != 1 || counts[1] != 1) {
+            isLocked_[uint32_t(edges[begin] >> 33)] = true;
+            isLocked_[uint32_t((edges[begin] >> 1) & 0xFFFFFFFF)] = true;
+        }
+        begin = end;
+    }
+
+    collapseTargets_.assign(vertexCount, kNone);
+    wedgeTargets_.assign(vertexCount, kNone);
+    isPassLocked_.assign(vertexCount, false);
+    isWedgeGathered_.assign(vertexCount, false);
+}
+
+void Simplifier::BuildAdjacency()
+{
+    size_t vertexCount = vertices_.size();
+    adjacencyOffsets_.assign(vertexCount + 1, 0);
+    for (uint32_t index : indices_) {
+        ++adjacencyOffsets_[points_[index] + 1];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        adjacencyOffsets_[v + 1] += adjacencyOffsets_[v];
+    }
+    adjacencyTriangles_.resize(indices_.size());
+    std::vector<uint32_t> cursors(adjacencyOffsets_.begin(), adjacencyOffsets_.end() - 1);
+    for (size_t i = 0; i < indices_.size(); ++i) {
+        adjacencyTriangles_[cursors[points_[indices_[i]]]++] = uint32_t(i / 3);
+    }
+
+    wedgeOffsets_.assign(vertexCount + 1, 0);
+    for (uint32_t index : indices_) {
+        if (!isWedgeGathered_[index]) {
+            isWedgeGathered_[index] = true;
+            ++wedgeOffsets_[points_[index] + 1];
+        }
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        wedgeOffsets_[v + 1] += wedgeOffsets_[v];
+    }
+    wedges_.resize(wedgeOffsets_[vertexCount]);
+    cursors.assign(wedgeOffsets_.begin(), wedgeOffsets_.end() - 1);
+    for (uint32_t index : indices_) {
+        if (isWedgeGathered_[index]) {
+            isWedgeGathered_[index] = false;
+            wedges_[cursors[points_[index]]++] = index;
+        }
+    }
+}
+
+void Simplifier::GatherRing(uint32_t point, std::vector<uint32_t>& ring) const
+{
+    ring.clear();
+    for (uint32_t a = adjacencyOffsets_[point]; a < adjacencyOffsets_[point + 1]; ++a) {
+        const uint32_t* triangle = &indices_[adjacencyTriangles_[a] * 3];
+        for (int corner = 0; corner < 3; ++corner) {
+            uint32_t other = points_[triangle[corner]];
+            if (other != point) {
+                ring.push_back(other);
+            }
+        }
+    }
+    std::sort(ring.begin(), ring.end());
+    ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+}
+
+float Simplifier::MatchWedges(uint32_t from, uint32_t to, std::vector<uint32_t>* targets)
+{
+    float maxDistance = 0.0f;
+    for (uint32_t w = wedgeOffsets_[from]; w < wedgeOffsets_[from + 1]; ++w) {
+        uint32_t wedge = wedges_[w];
+        // 同じ距離なら先にあるもの
+        uint32_t best = wedges_[wedgeOffsets_[to]];
+        float bestDistance = AttributeDistance(vertices_[wedge], vertices_[best]);
+        for (uint32_t t = wedgeOffsets_[to] + 1; t < wedgeOffsets_[to + 1]; ++t) {
+            float distance = AttributeDistance(vertices_[wedge], vertices_[wedges_[t]]);
+            if (distance < bestDistance) {
+                best = wedges_[t];
+                bestDistance = distance;
+            }
+        }
+        maxDistance = std::max(maxDistance, bestDistance);
+        if (targets) {
+            (*targets)[wedge] = best;
+        }
+    }
+    return maxDistance;
+}
+
+float Simplifier::CalculateCost(uint32_t from, uint32_t to, float* geometricError)
+{
+    Quadric quadric = quadrics_[from];
+    AddQuadric(quadric, quadrics_[to]);
+    *geometricError = EvaluateQuadric(quadric, positions_[to]);
+    return *geometricError + attributeWeight_ * MatchWedges(from, to, nullptr);
+}
+
+bool Simplifier::IsCollapseValid(uint32_t from, uint32_t to)
+{
+    const Vector3& target = positions_[to];
+    // fromとtoの両方を使う三角形(内側の辺なら2枚)は消え、残りはfromをtoへ動かしたときに裏返らないこと
+    uint32_t opposites[2];
+    uint32_t sharedCount = 0;
+    for (uint32_t a = adjacencyOffsets_[from]; a < adjacencyOffsets_[from + 1]; ++a) {
+        const uint32_t* triangle = &indices_[adjacencyTriangles_[a] * 3];
+        Vector3 corners[3];
+        bool hasTarget = false;
+        uint32_t opposite = kNone;
+        for (int corner = 0; corner < 3; ++corner) {
+            uint32_t point = points_[triangle[corner]];
+            corners[corner] = positions_[triangle[corner]];
+            hasTarget = hasTarget || point == to;
+            opposite = point != from && point != to ? point : opposite;
+        }
+        if (hasTarget) {
+            if (sharedCount == 2) {
+                return false;
+            }
+            opposites[sharedCount++] = opposite;
+            continue;
+        }
+        Vector3 before = CrossProduct(Subtract(corners[1], corners[0]), Subtract(corners[2], corners[0]));
+        for (int corner = 0; corner < 3; ++corner) {
+            if (points_[triangle[corner]] == from) {
+                corners[corner] = target;
+            }
+        }
+        Vector3 after = CrossProduct(Subtract(corners[1], corners[0]), Subtract(corners[2], corners[0]));
+        if (DotProduct(before, after) <= 0.0f) {
+            return false;
+        }
+    }
+    if (sharedCount != 2) {
+        return false;
+    }
+    // 両方の隣にある点が消える三角形の頂点だけでなければ、潰すと面が重なる(つながり方が変わる)
+    GatherRing(from, ring_);
+    GatherRing(to, otherRing_);
+    size_t commonCount = 0;
+    for (size_t i = 0, j = 0; i < ring_.size() && j < otherRing_.size();) {
+        if (ring_[i] < otherRing_[j]) {
+            ++i;
+        } else if (otherRing_[j] < ring_[i]) {
+            ++j;
+        } else {
+            if (ring_[i] != opposites[0] && ring_[i] != opposites[1]) {
+                return false;
+            }
+            ++commonCount;
+            ++i;
+            ++j;
+        }
+    }
+    return commonCount == 2 && opposites[0] != opposites[1];
+}
+
+size_t Simplifier::RunPass(size_t targetTriangleCount, bool limitError)
+{
+    size_t triangleCount = GetTriangleCount();
+    if (triangleCount <= targetTriangleCount) {
+        return 0;
+    }
+    BuildAdjacency();
+
+    // 内側の辺は2枚の三角形に逆向きで入っているので、小さい点から大きい点への向きの方だけ見る
+    std::vector<Collapse> candidates;
+    for (size_t i = 0; i < indices_.size(); i += 3) {
+        for (int corner = 0; corner < 3; ++corner) {
+            uint32_t a = points_[indices_[i + corner]];
+            uint32_t b = points_[indices_[i + (corner + 1) % 3]];
+            if (a > b || (isLocked_[a] && isLocked_[b])) {
+                continue;
+            }
+            float geometricError;
+            float costA = isLocked_[a] ? INFINITY : CalculateCost(a, b, &geometricError);
+            float costB = isLocked_[b] ? INFINITY : CalculateCost(b, a, &geometricError);
+            candidates.push_back(costA <= costB ? Collapse { costA, a, b } : Collapse { costB, b, a });
+        }
+    }
+    // 1回潰すと三角形は2枚減る。周りの点が止まって安い候補を潰せないまま高いものばかり潰さないように、
+    // 必要な数の分の候補の誤差の1.5倍までにしておく(並べ替えるのはそこまでの候補だけ)
+    auto less = [](const Collapse& x, const Collapse& y) {
+        return x.cost != y.cost ? x.cost < y.cost : x.from != y.from ? x.from < y.from : x.to < y.to;
+    };
+    size_t removeCount = triangleCount - targetTriangleCount;
+    float costLimit = INFINITY;
+    if (limitError && !candidates.empty()) {
+        std::vector<Collapse>::iterator goal = candidates.begin() + std::min(candidates.size() - 1, (removeCount + 1) / 2);
+        std::nth_element(candidates.begin(), goal, candidates.end(), less);
+        costLimit = goal->cost * 1.5f;
+        candidates.erase(std::partition(candidates.begin(), candidates.end(), [costLimit](const Collapse& c) { return c.cost <= costLimit; }),
+            candidates.end());
+    }
+    std::sort(candidates.begin(), candidates.end(), less);
+
+    std::fill(isPassLocked_.begin(), isPassLocked_.end(), false);
+    size_t collapseCount = 0;
+    size_t removedCount = 0;
+    for (const Collapse& candidate : candidates) {
+        if (removedCount >= removeCount) {
+            break;
+        }
+        if (isPassLocked_[candidate.from] || isPassLocked_[candidate.to] || !IsCollapseValid(candidate.from, candidate.to)) {
+            continue;
+        }
+        float geometricError;
+        CalculateCost(candidate.from, candidate.to, &geometricError);
+        maxError_ = std::max(maxError_, geometricError);
+        MatchWedges(candidate.from, candidate.to, &wedgeTargets_);
+        AddQuadric(quadrics_[candidate.to], quadrics_[candidate.from]);
+        collapseTargets_[candidate.from] = candidate.to;
+        // 周りの三角形はこのパスの中ではもう変えない(隣接の一覧を作り直すまで)
+        GatherRing(candidate.from, ring_);
+        for (uint32_t point : ring_) {
+            isPassLocked_[point] = true;
+        }
+        isPassLocked_[candidate.from] = true;
+        ++collapseCount;
+        removedCount += 2;
+    }
+
+    // indexを付け替え、潰れた三角形を除く
+    size_t writeIndex = 0;
+    for (size_t i = 0; i < indices_.size(); i += 3) {
+        uint32_t triangle[3];
+        for (int corner = 0; corner < 3; ++corner) {
+            uint32_t index = indices_[i + corner];
+            triangle[corner] = collapseTargets_[points_[index]] != kNone ? wedgeTargets_[index] : index;
+        }
+        uint32_t p0 = points_[triangle[0]];
+        uint32_t p1 = points_[triangle[1]];
+        uint32_t p2 = points_[triangle[2]];
+        if (p0 != p1 && p1 != p2 && p2 != p0) {
+            std::copy(triangle, triangle + 3, indices_.begin() + writeIndex);
+            writeIndex += 3;
+        }
+    }
+    indices_.resize(writeIndex);
+    for (const Collapse& candidate : candidates) {
+        collapseTargets_[candidate.from] = kNone;
+    }
+    return collapseCount;
+}
+
+}
+
+std::vector<uint32_t> SimplifyMesh(const std::vector<VertexData>& vertices, const uint32_t* indices, size_t indexCount, size_t targetIndexCount,
+    float* error, float attributeWeight)
+{
+    Simplifier simplifier(vertices, indices, indexCount, attributeWeight);
+    size_t targetTriangleCount = targetIndexCount / 3;
+    bool limitError = true;
+    while (simplifier.GetTriangleCount() > targetTriangleCount) {
+        if (simplifier.RunPass(targetTriangleCount, limitError) > 0) {
+            limitError = true;
+        } else if (limitError) {
+            limitError = false; // 安い候補が全て潰せなかったときは、高いものも試す
+        } else {
+            break;
+        }
+    }
+    if (error) {
+        *error = simplifier.GetError();
+    }
+    return std::move(simplifier.GetIndices());
+}
+
+void BuildLodChain(ModelData& modelData)
+{
+    modelData.lods.clear();
+    float error = 0.0f;
+    for (float ratio : kLodTriangleRatios) {
+        const std::vector<uint32_t>& sourceIndices = modelData.lods.empty() ? modelData.indices : modelData.lods.back().indices;
+        const std::vector<Submesh>& sourceSubmeshes = modelData.lods.empty() ? modelData.submeshes : modelData.lods.back().submeshes;
+        MeshLod lod;
+        float levelError = 0.0f;
+        for (size_t s = 0; s < sourceSubmeshes.size(); ++s) {
+            const Submesh& source = sourceSubmeshes[s];
+            size_t targetIndexCount = size_t(float(modelData.submeshes[s].indexCount / 3) * ratio) * 3;
+            float submeshError = 0.0f;
+            std::vector<uint32_t> indices = SimplifyMesh(modelData.vertices, sourceIndices.data() + source.indexOffset, source.indexCount,
+                targetIndexCount, &submeshError);
+            OptimizeVertexCache(indices.data(), indices.size(), modelData.vertices.size());
+            lod.submeshes.push_back({ uint32_t(lod.indices.size()), uint32_t(indices.size()), source.materialIndex });
+            lod.indices.insert(lod.indices.end(), indices.begin(), indices.end());
+            levelError = std::max(levelError, submeshError);
+        }
+        // 1つ前のLODからのずれを足していく
+        error += levelError;
+        lod.error = error;
+        if (lod.indices.size() >= sourceIndices.size()) {
+            break;
+        }
+        modelData.lods.push_back(std::move(lod));
+    }
+}
+
+uint32_t GetLodIndexOffset(const ModelData& modelData, uint32_t level)
+{
+    if (level == 0) {
+        return 0;
+    }
+    size_t offset = modelData.indices.size();
+    for (uint32_t i = 1; i < level; ++i) {
+        offset += modelData.lods[i - 1].indices.size();
+    }
+    return uint32_t(offset);
+}
+
+const std::vector<Submesh>& GetLodSubmeshes(const ModelData& modelData, uint32_t level)
+{
+    return level == 0 ? modelData.submeshes : modelData.lods[level - 1].submeshes;
+}
+
+float CalculateScreenSize(const Camera& camera, const Sphere& sphere)
+{
+    const Vector3& eye = camera.GetTransform().translate;
+    Vector3 offset = Subtract(sphere.center, eye);
+    float distance = std::sqrt(DotProduct(offset, offset));
+    if (distance <= sphere.radius) {
+        return INFINITY;
+    }
+    // 距離distanceでの画面の高さは 2 * distance * tan(fovY / 2)
+    return sphere.radius / (distance * std::tan(camera.GetFovY() * 0.5f));
+}
+
+uint32_t SelectLod(float screenSize, uint32_t lodCount)
+{
+    uint32_t level = 0;
+    while (level + 1 < lodCount && level < std::size(kLodScreenSizes) && screenSize < kLodScreenSizes[level]) {
+        ++level;
+    }
+    return level;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "Camera.h"
+#include "Model.h"
+#include "MyMath.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+// LOD(詳細度)の生成と選択
+//
+// 生成: 辺を潰して三角形を減らす(Garland-Heckbertの二次誤差)
+//   - 頂点を隣の頂点へ寄せる縮約だけを行い、新しい頂点は作らない。
+//     LODは元の頂点バッファをそのまま使い、indexだけを別に持つ
+//   - 位置が同じ頂点(uvや法線の継ぎ目)は1つの点として扱う。寄せるときはそれぞれを
+//     寄せる先で一番近いuvと法線を持つ頂点に付け替え、そのずれも誤差に足す
+//   - メッシュの縁、マテリアルの境目、3枚以上の三角形が共有する辺にある点は動かさない
+//   - 三角形が裏返る縮約と、つながり方が変わる縮約はしない
+//   - 候補を誤差の小さい順に並べ、周りが重ならないものをまとめて潰すのを繰り返す。
+//     同じ入力なら結果は常に同じ
+// 選択: ワールド空間の境界球が画面の高さのどれだけを占めるかで決める
+
+// 元の三角形の数に対する各LODの割合
+const float kLodTriangleRatios[] = { 0.5f, 0.25f, 0.125f };
+// 境界球の直径が画面の高さのこの割合より小さければ、LOD i+1 を使う
+const float kLodScreenSizes[] = { 0.5f, 0.25f, 0.125f };
+static_assert(std::size(kLodTriangleRatios) == std::size(kLodScreenSizes));
+
+// uvと法線のずれの2乗に掛ける重み(位置はメッシュの大きさを1にした距離の2乗)
+const float kSimplifyAttributeWeight = 0.01f;
+
+// 三角形をtargetIndexCount / 3枚以下まで減らしたindexを返す(縁などで減らせなければそこで止まる)。
+// errorには、寄せた点の元の面からの距離(二次誤差の平方根)の最大をモデルの単位で入れる
+std::vector<uint32_t> SimplifyMesh(const std::vector<VertexData>& vertices, const uint32_t* indices, size_t indexCount, size_t targetIndexCount,
+    float* error = nullptr, float attributeWeight = kSimplifyAttributeWeight);
+
+// modelData.lodsを作り直す。サブメッシュ毎に1つ前のLODから減らし、頂点キャッシュに合わせて並べ直す
+// (それ以上減らせなくなったらそこで止めるので、LODの数はkLodTriangleRatiosより少ないことがある)
+void BuildLodChain(ModelData& modelData);
+
+// LODの数(元のメッシュを含む)
+inline uint32_t GetLodCount(const ModelData& modelData) { return uint32_t(modelData.lods.size() + 1); }
+// CopyIndicesで書き込んだindexの中で、そのLODが始まる位置
+uint32_t GetLodIndexOffset(const ModelData& modelData, uint32_t level);
+// そのLODのサブメッシュ(indexOffsetはGetLodIndexOffsetからの位置)
+const std::vector<Submesh>& GetLodSubmeshes(const ModelData& modelData, uint32_t level);
+
+// ワールド空間の境界球の直径が画面の高さに占める割合(カメラが球の中にあれば大きな値)
+float CalculateScreenSize(const Camera& camera, const Sphere& sphere);
+// 画面の大きさからLODを選ぶ(lodCountはGetLodCount)
+uint32_t SelectLod(float screenSize, uint32_t lodCount);
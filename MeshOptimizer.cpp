@@ -0,0 +1,243 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+// 頂点毎に、その頂点を使う三角形の一覧(三角形の番号を頂点順に続けて並べたもの)
+struct TriangleAdjacency {
+    std::vector<uint32_t> offsets; // vertexCount + 1
+    std::vector<uint32_t> triangles;
+};
+
+TriangleAdjacency BuildAdjacency(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+    TriangleAdjacency adjacency;
+    adjacency.offsets.assign(vertexCount + 1, 0);
+    for (size_t i = 0; i < indexCount; ++i) {
+        ++adjacency.offsets[indices[i] + 1];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        adjacency.offsets[v + 1] += adjacency.offsets[v];
+    }
+    adjacency.triangles.resize(indexCount);
+    std::vector<uint32_t> cursors(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    for (size_t i = 0; i < indexCount; ++i) {
+        adjacency.triangles[cursors[indices[i]]++] = uint32_t(i / 3);
+    }
+    return adjacency;
+}
+
+// 三角形の面積の2倍の大きさの法線と重心
+void CalculateTriangle(const uint32_t* triangle, const std::vector<VertexData>& vertices, Vector3& normal, Vector3& center)
+{
+    const Vector4& p0 = vertices[triangle[0]].position;
+    const Vector4& p1 = vertices[triangle[1]].position;
+    const Vector4& p2 = vertices[triangle[2]].position;
+    Vector3 e0 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+    Vector3 e1 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+    normal = { e0.y * e1.z - e0.z * e1.y, e0.z * e1.x - e0.x * e1.z, e0.x * e1.y - e0.y * e1.x };
+    center = { (p0.x + p1.x + p2.x) / 3.0f, (p0.y + p1.y + p2.y) / 3.0f, (p0.z + p1.z + p2.z) / 3.0f };
+}
+
+}
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats = {};
+    if (indexCount == 0) {
+        return stats;
+    }
+    // 入った時刻(それまでに処理した頂点数)を持ち、cacheSize個以上後に入ったものがあれば追い出されている
+    std::vector<uint64_t> timestamps(vertexCount, 0);
+    std::vector<bool> isUsed(vertexCount, false);
+    uint64_t time = uint64_t(cacheSize) + 1;
+    size_t misses = 0;
+    size_t usedVertexCount = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t index = indices[i];
+        if (time - timestamps[index] > cacheSize) {
+            timestamps[index] = time++;
+            ++misses;
+        }
+        if (!isUsed[index]) {
+            isUsed[index] = true;
+            ++usedVertexCount;
+        }
+    }
+    stats.acmr = float(misses) / float(indexCount / 3);
+    stats.atvr = float(misses) / float(usedVertexCount);
+    stats.hitRate = 1.0f - float(misses) / float(indexCount);
+    return stats;
+}
+
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* clusterOffsets)
+{
+    if (clusterOffsets) {
+        clusterOffsets->clear();
+    }
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+    TriangleAdjacency adjacency = BuildAdjacency(indices, indexCount, vertexCount);
+    // 残っている三角形の数
+    std::vector<uint32_t> liveCounts(vertexCount, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        liveCounts[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+    std::vector<uint64_t> timestamps(vertexCount, 0);
+    std::vector<bool> isEmitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds; // 最近使った頂点(戻る先の候補)
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve(indexCount);
+    uint64_t time = uint64_t(cacheSize) + 1;
+    size_t cursor = 0; // 候補が無いときに次を探し始めるindexの位置
+    uint32_t missesInTriangle = 0;
+
+    int64_t fanning = indices[0];
+    while (fanning >= 0) {
+        // fanningを使う三角形を全て出す
+        candidates.clear();
+        for (uint32_t a = adjacency.offsets[fanning]; a < adjacency.offsets[fanning + 1]; ++a) {
+            uint32_t triangle = adjacency.triangles[a];
+            if (isEmitted[triangle]) {
+                continue;
+            }
+            isEmitted[triangle] = true;
+            missesInTriangle = 0;
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                uint32_t index = indices[triangle * 3 + corner];
+                result.push_back(index);
+                deadEnds.push_back(index);
+                candidates.push_back(index);
+                --liveCounts[index];
+                if (time - timestamps[index] > cacheSize) {
+                    timestamps[index] = time++;
+                    ++missesInTriangle;
+                }
+            }
+            // 3つともキャッシュに無ければ、そこから新しい塊にする
+            if (clusterOffsets && (missesInTriangle == 3 || result.size() == 3)) {
+                clusterOffsets->push_back(uint32_t(result.size() / 3 - 1));
+            }
+        }
+
+        // 次の頂点は、三角形を出し切ってもキャッシュに残っているもののうち一番古いもの
+        fanning = -1;
+        uint64_t bestPriority = 0;
+        for (uint32_t candidate : candidates) {
+            if (liveCounts[candidate] == 0) {
+                continue;
+            }
+            uint64_t priority = 0;
+            if (time - timestamps[candidate] + 2 * liveCounts[candidate] <= cacheSize) {
+                priority = time - timestamps[candidate];
+            }
+            if (fanning < 0 || priority > bestPriority) {
+                fanning = candidate;
+                bestPriority = priority;
+            }
+        }
+        // 無ければ最近使った頂点に戻り、それも無ければ入力の順に探す
+        while (fanning < 0 && !deadEnds.empty()) {
+            uint32_t deadEnd = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveCounts[deadEnd] > 0) {
+                fanning = deadEnd;
+            }
+        }
+        for (; fanning < 0 && cursor < indexCount; ++cursor) {
+            if (liveCounts[indices[cursor]] > 0) {
+                fanning = indices[cursor];
+            }
+        }
+    }
+    std::copy(result.begin(), result.end(), indices);
+}
+
+void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<VertexData>& vertices, const std::vector<uint32_t>& clusterOffsets)
+{
+    size_t triangleCount = indexCount / 3;
+    size_t clusterCount = clusterOffsets.size();
+    if (clusterCount <= 1) {
+        return;
+    }
+    // メッシュ全体の中心(面積の重み付き)
+    Vector3 meshCenter = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+    std::vector<Vector3> clusterNormals(clusterCount, { 0.0f, 0.0f, 0.0f });
+    std::vector<Vector3> clusterCenters(clusterCount, { 0.0f, 0.0f, 0.0f });
+    std::vector<float> clusterAreas(clusterCount, 0.0f);
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster) {
+        size_t end = cluster + 1 < clusterCount ? clusterOffsets[cluster + 1] : triangleCount;
+        for (size_t triangle = clusterOffsets[cluster]; triangle < end; ++triangle) {
+            Vector3 normal;
+            Vector3 center;
+            CalculateTriangle(indices + triangle * 3, vertices, normal, center);
+            float area = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+            clusterNormals[cluster] = { clusterNormals[cluster].x + normal.x, clusterNormals[cluster].y + normal.y, clusterNormals[cluster].z + normal.z };
+            clusterCenters[cluster] = { clusterCenters[cluster].x + center.x * area, clusterCenters[cluster].y + center.y * area,
+                clusterCenters[cluster].z + center.z * area };
+            clusterAreas[cluster] += area;
+        }
+        meshCenter = { meshCenter.x + clusterCenters[cluster].x, meshCenter.y + clusterCenters[cluster].y, meshCenter.z + clusterCenters[cluster].z };
+        meshArea += clusterAreas[cluster];
+    }
+    if (meshArea > 0.0f) {
+        meshCenter = { meshCenter.x / meshArea, meshCenter.y / meshArea, meshCenter.z / meshArea };
+    }
+
+    // 塊の中心から見て外側を向いている度合い。大きいものは他を隠しやすいので先に描く
+    std::vector<float> scores(clusterCount, 0.0f);
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster) {
+        const Vector3& normal = clusterNormals[cluster];
+        float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        if (length == 0.0f || clusterAreas[cluster] == 0.0f) {
+            continue;
+        }
+        Vector3 center = { clusterCenters[cluster].x / clusterAreas[cluster], clusterCenters[cluster].y / clusterAreas[cluster],
+            clusterCenters[cluster].z / clusterAreas[cluster] };
+        scores[cluster] = ((center.x - meshCenter.x) * normal.x + (center.y - meshCenter.y) * normal.y + (center.z - meshCenter.z) * normal.z) / length;
+    }
+    std::vector<uint32_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&scores](uint32_t a, uint32_t b) { return scores[a] > scores[b]; });
+
+    std::vector<uint32_t> sorted;
+    sorted.reserve(indexCount);
+    for (uint32_t cluster : order) {
+        size_t end = cluster + 1 < clusterCount ? clusterOffsets[cluster + 1] : triangleCount;
+        sorted.insert(sorted.end(), indices + clusterOffsets[cluster] * 3, indices + end * 3);
+    }
+    std::copy(sorted.begin(), sorted.end(), indices);
+}
+
+void OptimizeVertexFetch(ModelData& modelData)
+{
+    const uint32_t kUnused = ~0u;
+    std::vector<uint32_t> remap(modelData.vertices.size(), kUnused);
+    std::vector<VertexData> vertices;
+    vertices.reserve(modelData.vertices.size());
+    for (uint32_t& index : modelData.indices) {
+        if (remap[index] == kUnused) {
+            remap[index] = uint32_t(vertices.size());
+            vertices.push_back(modelData.vertices[index]);
+        }
+        index = remap[index];
+    }
+    modelData.vertices = std::move(vertices);
+}
+
+void OptimizeMesh(ModelData& modelData)
+{
+    std::vector<uint32_t> clusterOffsets;
+    for (const Submesh& submesh : modelData.submeshes) {
+        uint32_t* indices = modelData.indices.data() + submesh.indexOffset;
+        OptimizeVertexCache(indices, submesh.indexCount, modelData.vertices.size(), kVertexCacheSize, &clusterOffsets);
+        OptimizeOverdraw(indices, submesh.indexCount, modelData.vertices, clusterOffsets);
+    }
+    OptimizeVertexFetch(modelData);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Model.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 読み込んだメッシュの描画順と頂点の並びを整える
+//
+// 1. 頂点キャッシュ: Tipsify(Sanderら)で、最近使った頂点を共有する三角形が続くように並べ直す
+// 2. オーバードロー: 1の並びをキャッシュが切れる所で塊に分け、外側を向いている塊を先に描くように並べ替える
+//    (塊の中の順番は変えないので、キャッシュの効き方はほとんど変わらない)
+// 3. 頂点の取得: 頂点をindexで初めて使われる順に並べ替え、メモリを前から順に読むようにする
+// サブメッシュの範囲とマテリアルの順番は変えない。同じ入力なら結果は常に同じ。
+
+// GPUの変換後頂点キャッシュの大きさの見込み(FIFO)
+const uint32_t kVertexCacheSize = 16;
+
+// FIFOの頂点キャッシュを真似して数えた結果
+struct VertexCacheStats {
+    float acmr; // 三角形1枚あたりの頂点処理数(3が最悪、格子なら0.5くらいまで下がる)
+    float atvr; // 頂点1つあたりの処理数(1が最小)
+    float hitRate; // indexのうちキャッシュに当たった割合
+};
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = kVertexCacheSize);
+
+// indicesの三角形の順番を頂点キャッシュに合わせて並べ直す。
+// clusterOffsetsを渡すと、キャッシュが切れる所(塊の始まりの三角形の番号)を入れる
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = kVertexCacheSize,
+    std::vector<uint32_t>* clusterOffsets = nullptr);
+
+// OptimizeVertexCacheで分けた塊を、外側を向いているものから順に並べ替える
+void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<VertexData>& vertices, const std::vector<uint32_t>& clusterOffsets);
+
+// 頂点をindexで初めて使われる順に並べ替え、indexを付け替える(使われない頂点は消す)
+void OptimizeVertexFetch(ModelData& modelData);
+
+// サブメッシュ毎に1と2を行い、最後に3を行う
+void OptimizeMesh(ModelData& modelData);
@@ -0,0 +1,174 @@
+#include "Meshlet.h"
+#include "Culling.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const uint32_t kNone = ~0u;
+
+Vector3 ToVector3(const Vector4& v) { return { v.x, v.y, v.z }; }
+Vector3 Subtract(const Vector3& a, const Vector3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+float DotProduct(const Vector3& a, const Vector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+// 表の向きの単位ベクトル(潰れた三角形は0)
+Vector3 CalculateFaceNormal(const uint32_t* triangle, const std::vector<VertexData>& vertices)
+{
+    Vector3 p0 = ToVector3(vertices[triangle[0]].position);
+    Vector3 e0 = Subtract(ToVector3(vertices[triangle[1]].position), p0);
+    Vector3 e1 = Subtract(ToVector3(vertices[triangle[2]].position), p0);
+    Vector3 normal = { e0.y * e1.z - e0.z * e1.y, e0.z * e1.x - e0.x * e1.z, e0.x * e1.y - e0.y * e1.x };
+    float length = std::sqrt(DotProduct(normal, normal));
+    return length > 0.0f ? Vector3 { normal.x / length, normal.y / length, normal.z / length } : Vector3 { 0.0f, 0.0f, 0.0f };
+}
+
+// 並べ終わった塊の境界球と円錐
+void CalculateMeshletBounds(const ModelData& modelData, Meshlet& meshlet, Sphere& bounds)
+{
+    const uint32_t* indices = modelData.indices.data() + meshlet.indexOffset;
+    uint32_t indexCount = meshlet.triangleCount * 3;
+
+    // 境界球はAABBの中心から一番遠い頂点まで
+    Vector3 min = ToVector3(modelData.vertices[indices[0]].position);
+    Vector3 max = min;
+    for (uint32_t i = 0; i < indexCount; ++i) {
+        const Vector4& p = modelData.vertices[indices[i]].position;
+        min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+        max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+    }
+    bounds = { { (min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f }, 0.0f };
+    for (uint32_t i = 0; i < indexCount; ++i) {
+        Vector3 offset = Subtract(ToVector3(modelData.vertices[indices[i]].position), bounds.center);
+        bounds.radius = std::max(bounds.radius, std::sqrt(DotProduct(offset, offset)));
+    }
+
+    // 円錐の軸は表の向きの平均、広がりは軸から一番離れた向きまで
+    Vector3 axis = { 0.0f, 0.0f, 0.0f };
+    for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+        Vector3 normal = CalculateFaceNormal(indices + t * 3, modelData.vertices);
+        axis = { axis.x + normal.x, axis.y + normal.y, axis.z + normal.z };
+    }
+    float length = std::sqrt(DotProduct(axis, axis));
+    meshlet.coneAxis = { 0.0f, 0.0f, 0.0f };
+    meshlet.coneCutoff = 1.0f;
+    if (length == 0.0f) {
+        return;
+    }
+    axis = { axis.x / length, axis.y / length, axis.z / length };
+    float minDot = 1.0f;
+    for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+        Vector3 normal = CalculateFaceNormal(indices + t * 3, modelData.vertices);
+        // 潰れた三角形は描いても見えないので広がりに入れない
+        if (DotProduct(normal, normal) > 0.0f) {
+            minDot = std::min(minDot, DotProduct(normal, axis));
+        }
+    }
+    // 90度以上広がっていれば、どこから見てもどれかは表を向きうる
+    if (minDot > 0.0f) {
+        meshlet.coneAxis = axis;
+        meshlet.coneCutoff = std::sqrt(std::max(0.0f, 1.0f - minDot * minDot));
+    }
+}
+
+}
+
+void BuildMeshlets(ModelData& modelData)
+{
+    modelData.meshlets.clear();
+    modelData.meshletBounds.clear();
+    const uint32_t* indices = modelData.indices.data();
+    std::vector<uint32_t> meshletOfVertex(modelData.vertices.size(), kNone); // 最後に入った塊の番号
+
+    for (const Submesh& submesh : modelData.submeshes) {
+        uint32_t firstTriangle = submesh.indexOffset / 3;
+        uint32_t endTriangle = firstTriangle + submesh.indexCount / 3;
+        Meshlet meshlet = {};
+        for (uint32_t triangle = firstTriangle; triangle < endTriangle; ++triangle) {
+            // 入れると上限を超えるなら、そこで塊を閉じて次の塊を始める
+            uint32_t meshletIndex = uint32_t(modelData.meshlets.size());
+            uint32_t newCount = 0;
+            for (int corner = 0; corner < 3; ++corner) {
+                newCount += meshletOfVertex[indices[triangle * 3 + corner]] != meshletIndex;
+            }
+            if (meshlet.triangleCount == kMeshletMaxTriangles || meshlet.vertexCount + newCount > kMeshletMaxVertices) {
+                modelData.meshlets.push_back(meshlet);
+                meshlet.triangleCount = 0;
+                ++meshletIndex;
+            }
+            if (meshlet.triangleCount == 0) {
+                meshlet = { triangle * 3, 0, 0, submesh.materialIndex, { 0.0f, 0.0f, 0.0f }, 1.0f };
+            }
+            ++meshlet.triangleCount;
+            for (int corner = 0; corner < 3; ++corner) {
+                uint32_t vertex = indices[triangle * 3 + corner];
+                if (meshletOfVertex[vertex] != meshletIndex) {
+                    meshletOfVertex[vertex] = meshletIndex;
+                    ++meshlet.vertexCount;
+                }
+            }
+        }
+        if (meshlet.triangleCount > 0) {
+            modelData.meshlets.push_back(meshlet);
+        }
+    }
+
+    modelData.meshletBounds.resize(modelData.meshlets.size());
+    for (size_t i = 0; i < modelData.meshlets.size(); ++i) {
+        CalculateMeshletBounds(modelData, modelData.meshlets[i], modelData.meshletBounds[i]);
+    }
+}
+
+bool IsMeshletBackfacing(const Meshlet& meshlet, const Sphere& bounds, const Vector3& cameraPosition)
+{
+    if (meshlet.coneCutoff >= 1.0f) {
+        return false;
+    }
+    // 球の中のどの点pへの視線 p - cameraPosition も、軸との角度が 90度 - 広がり 以内なら全て裏向き
+    // (|d|とrからの見積もりなので控えめに判定する)
+    Vector3 offset = Subtract(bounds.center, cameraPosition);
+    float distance = std::sqrt(DotProduct(offset, offset));
+    return DotProduct(offset, meshlet.coneAxis) >= meshlet.coneCutoff * distance + bounds.radius * (1.0f + meshlet.coneCutoff);
+}
+
+void CullMeshlets(const std::vector<Meshlet>& meshlets, const std::vector<Sphere>& bounds, const Matrix4x4& worldMatrix,
+    const Matrix4x4& worldViewProjectionMatrix, const Vector3& cameraPosition, std::vector<uint32_t>& visibleMask, std::vector<Submesh>& drawRanges,
+    MeshletCullStats* stats)
+{
+    drawRanges.clear();
+    // WVPから取り出した視錐台とカメラの位置はローカル空間なので、境界球と円錐はそのまま比べられる
+    // (拡縮が軸毎に違っても、ワールド空間での判定と同じになる)
+    Frustum frustum = MakeFrustum(worldViewProjectionMatrix);
+    Matrix4x4 inverseWorldMatrix = InverseAffine(worldMatrix);
+    const Vector3& p = cameraPosition;
+    const Matrix4x4& m = inverseWorldMatrix;
+    Vector3 localCameraPosition = { p.x * m.m[0][0] + p.y * m.m[1][0] + p.z * m.m[2][0] + m.m[3][0],
+        p.x * m.m[0][1] + p.y * m.m[1][1] + p.z * m.m[2][1] + m.m[3][1], p.x * m.m[0][2] + p.y * m.m[1][2] + p.z * m.m[2][2] + m.m[3][2] };
+
+    visibleMask.resize(GetVisibleMaskWordCount(meshlets.size()));
+    CullSpheres(frustum, bounds.data(), meshlets.size(), visibleMask.data());
+    MeshletCullStats result = {};
+    result.meshletCount = uint32_t(meshlets.size());
+    for (size_t i = 0; i < meshlets.size(); ++i) {
+        const Meshlet& meshlet = meshlets[i];
+        result.triangleCount += meshlet.triangleCount;
+        if (!IsVisible(visibleMask.data(), i)) {
+            result.frustumCulledTriangleCount += meshlet.triangleCount;
+            continue;
+        }
+        if (IsMeshletBackfacing(meshlet, bounds[i], localCameraPosition)) {
+            result.backfaceCulledTriangleCount += meshlet.triangleCount;
+            continue;
+        }
+        ++result.visibleMeshletCount;
+        uint32_t indexCount = meshlet.triangleCount * 3;
+        if (!drawRanges.empty() && drawRanges.back().materialIndex == meshlet.materialIndex
+            && drawRanges.back().indexOffset + drawRanges.back().indexCount == meshlet.indexOffset) {
+            drawRanges.back().indexCount += indexCount;
+        } else {
+            drawRanges.push_back({ meshlet.indexOffset, indexCount, meshlet.materialIndex });
+        }
+    }
+    if (stats) {
+        *stats = result;
+    }
+}
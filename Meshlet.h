@@ -0,0 +1,41 @@
+#pragma once
+#include "Model.h"
+#include "MyMath.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// メッシュレット(三角形の小さな塊)の生成とCPUでのカリング
+//
+// 生成: サブメッシュ毎に、OptimizeMeshで並べたindicesの順のまま、頂点kMeshletMaxVertices個・
+//       三角形kMeshletMaxTriangles枚を超える所で切って塊にする。indicesと頂点は並べ替えないので、
+//       頂点キャッシュ・オーバードロー・頂点の取得の順番はOptimizeMeshの結果がそのまま残る
+//       (Tipsifyの順は隣の三角形へ進んでいくので、続けて切っても塊はまとまった形になる)。
+//       塊毎に境界球と、三角形の表の向きを囲む円錐(向きの平均と広がり)を持つ。
+// カリング: 境界球が視錐台の外にある塊と、カメラから全ての三角形が裏を向いている塊を除き、
+//       残りのindexの範囲を作る(続いていて同じマテリアルのものはつなげて描画の回数を減らす)。
+// 三角形の表は cross(p1 - p0, p2 - p0) の向き(ObjParserが作る法線と同じ)
+
+const uint32_t kMeshletMaxVertices = 64;
+const uint32_t kMeshletMaxTriangles = 124;
+
+// modelData.meshletsとmeshletBoundsを作る(OptimizeMeshの後に呼ぶ。indicesとサブメッシュの範囲は変えない)
+void BuildMeshlets(ModelData& modelData);
+
+// cameraPositionから見て、境界球の中の三角形が全て裏を向いているか(ローカル空間)
+bool IsMeshletBackfacing(const Meshlet& meshlet, const Sphere& bounds, const Vector3& cameraPosition);
+
+// カリングで除いた数
+struct MeshletCullStats {
+    uint32_t meshletCount;
+    uint32_t visibleMeshletCount;
+    size_t triangleCount;
+    size_t frustumCulledTriangleCount; // 視錐台の外
+    size_t backfaceCulledTriangleCount; // 裏向き
+};
+
+// 見えるメッシュレットのindexの範囲をdrawRangesに入れる。
+// worldViewProjectionMatrixはモデルのWVP、cameraPositionはワールド空間。visibleMaskは作業用
+void CullMeshlets(const std::vector<Meshlet>& meshlets, const std::vector<Sphere>& bounds, const Matrix4x4& worldMatrix,
+    const Matrix4x4& worldViewProjectionMatrix, const Vector3& cameraPosition, std::vector<uint32_t>& visibleMask, std::vector<Submesh>& drawRanges,
+    MeshletCullStats* stats = nullptr);
@@ -0,0 +1,206 @@
+#include "Model.h"
+#include "MappedFile.h"
+#include "ObjParser.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+std::vector<MaterialData> LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename)
+{
+    std::vector<MaterialData> materials; // 構築するMaterialData
+    std::string line; // ファイルから読み込んだ1行を格納するもの
+    std::ifstream file(directoryPath + "/" + filename); // ファイルを開く
+    assert(file.is_open()); // 開けられないなら止める
+
+    while (std::getline(file, line)) {
+        std::string identifier;
+        std::istringstream s(line);
+        s >> identifier;
+
+        // identfierに応じた処理
+        if (identifier == "newmtl") {
+            materials.emplace_back();
+            s >> materials.back().name;
+        } else if (identifier == "map_Kd") {
+            std::string textureFilename;
+            s >> textureFilename;
+            // newmtlより前なら名前の無いマテリアルにする
+            if (materials.empty()) {
+                materials.emplace_back();
+            }
+            // 連結してファイルパスにする
+            materials.back().textureFilePath = directoryPath + "/" + textureFilename;
+        }
+    }
+    return materials;
+}
+
+ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename, uint32_t threadCount)
+{
+    MappedFile file;
+    bool isOpen = file.Open(directoryPath + "/" + filename);
+    assert(isOpen); // 開けられないなら止める
+    (void)isOpen;
+    return ParseObj(file.GetData(), file.GetSize(), directoryPath, threadCount);
+}
+
+ModelData LoadObjFileStream(const std::string& directoryPath, const std::string& filename)
+{
+    ModelData modelData; // 構築するmodeldata
+    std::vector<Vector4> positions; // 位置
+    std::vector<Vector3> normals; // 法線
+    std::vector<Vector2> texcoords; // テクスチャ座標
+    std::vector<uint32_t> triangleNames; // 三角形毎のusemtlの名前の番号
+    std::vector<std::string> names = { "" }; // usemtlの名前(0はusemtlより前)
+    std::vector<std::string> libraries; // mtllibのファイル名
+    uint32_t currentName = 0;
+    std::string line; // ファイルから読んだ1行を格納するもの
+
+    // ファイルを開く
+    std::ifstream file(directoryPath + "/" + filename);
+    assert(file.is_open()); // 開けられないなら止める
+
+    while (std::getline(file, line)) {
+        std::string identifier;
+        std::istringstream s(line);
+        s >> identifier; // 先頭の識別子を読む
+
+        // identifierに応じた処理
+        if (identifier == "v") {
+            Vector4 position;
+            s >> position.x >> position.y >> position.z;
+            position.w = 1.0f;
+            positions.push_back(position);
+        } else if (identifier == "vt") {
+            Vector2 texcoord;
+            s >> texcoord.x >> texcoord.y;
+            texcoords.push_back(texcoord);
+        } else if (identifier == "vn") {
+            Vector3 normal;
+            s >> normal.x >> normal.y >> normal.z;
+            normals.push_back(normal);
+        } else if (identifier == "f") {
+            // 面は三角形限定,その他未対応
+
+            VertexData triangle[3];
+
+            for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex) {
+                std::string vertexDefinition;
+                s >> vertexDefinition;
+                // 頂点の要素へのindexは[位置/uv/法線]で格納されているので.分割してindexを取得する
+                std::istringstream v(vertexDefinition);
+                uint32_t elementIndeices[3];
+                for (int32_t element = 0; element < 3; ++element) {
+                    std::string index;
+                    std::getline(v, index, '/'); // 区切りインデクスを読んでいく
+                    elementIndeices[element] = std::stoi(index);
+                }
+                // 要素へのindexから,実際の要素の値を取得して,頂点を構築する
+                Vector4 position = positions[elementIndeices[0] - 1];
+                Vector2 texcoord = texcoords[elementIndeices[1] - 1];
+                Vector3 normal = normals[elementIndeices[2] - 1];
+
+                // 位置の反転&法線の反転&左下原点
+                position.x *= -1.0f;
+                texcoord.y = 1.0f - texcoord.y;
+                normal.x *= -1.0f;
+
+                triangle[faceVertex] = { position, texcoord, normal };
+            }
+            // 頂点を逆順で登録することで、周り順を逆にする
+            modelData.vertices.push_back(triangle[2]);
+            modelData.vertices.push_back(triangle[1]);
+            modelData.vertices.push_back(triangle[0]);
+            triangleNames.push_back(currentName);
+        } else if (identifier == "usemtl") {
+            std::string materialName;
+            s >> materialName;
+            currentName = uint32_t(std::find(names.begin(), names.end(), materialName) - names.begin());
+            if (currentName == names.size()) {
+                names.push_back(materialName);
+            }
+        } else if (identifier == "mtllib") {
+            // materialTemplateLibraryファイルの名前を取得する
+            std::string materialFilename;
+            s >> materialFilename;
+            // 基本的のobjファイルと同一階級にmtlは存在させるので,最後にまとめて読む
+            libraries.push_back(materialFilename);
+        }
+    }
+
+    modelData.indices.resize(modelData.vertices.size());
+    for (uint32_t index = 0; index < modelData.indices.size(); ++index) {
+        modelData.indices[index] = index;
+    }
+    BuildObjSubmeshes(modelData, triangleNames, std::vector<std::string_view>(names.begin(), names.end()),
+        std::vector<std::string_view>(libraries.begin(), libraries.end()), directoryPath);
+    return modelData;
+}
+
+uint32_t GetIndexSize(const ModelData& modelData)
+{
+    return modelData.vertices.size() <= 0x10000 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+size_t GetTotalIndexCount(const ModelData& modelData)
+{
+    size_t count = modelData.indices.size();
+    for (const MeshLod& lod : modelData.lods) {
+        count += lod.indices.size();
+    }
+    return count;
+}
+
+void CopyIndices(const ModelData& modelData, void* destination)
+{
+    uint32_t indexSize = GetIndexSize(modelData);
+    char* cursor = static_cast<char*>(destination);
+    auto copy = [&](const std::vector<uint32_t>& source) {
+        if (indexSize == sizeof(uint32_t)) {
+            std::memcpy(cursor, source.data(), sizeof(uint32_t) * source.size());
+        } else {
+            uint16_t* indices = reinterpret_cast<uint16_t*>(cursor);
+            for (size_t i = 0; i < source.size(); ++i) {
+                indices[i] = uint16_t(source[i]);
+            }
+        }
+        cursor += indexSize * source.size();
+    };
+    copy(modelData.indices);
+    for (const MeshLod& lod : modelData.lods) {
+        copy(lod.indices);
+    }
+}
+
+MeshStats CalculateMeshStats(const ModelData& modelData)
+{
+    MeshStats stats;
+    stats.sourceVertexCount = modelData.indices.size();
+    stats.vertexCount = modelData.vertices.size();
+    stats.indexSize = GetIndexSize(modelData);
+    stats.sourceBytes = sizeof(VertexData) * stats.sourceVertexCount;
+    stats.bytes = sizeof(VertexData) * stats.vertexCount + stats.indexSize * modelData.indices.size();
+    stats.vertexReductionRatio = stats.vertexCount ? float(stats.sourceVertexCount) / float(stats.vertexCount) : 0.0f;
+    return stats;
+}
+
+AABB CalculateBounds(const ModelData& modelData)
+{
+    if (modelData.vertices.empty()) {
+        return { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+    }
+    const Vector4& first = modelData.vertices.front().position;
+    AABB bounds = { { first.x, first.y, first.z }, { first.x, first.y, first.z } };
+    for (const VertexData& vertex : modelData.vertices) {
+        bounds.min.x = std::min(bounds.min.x, vertex.position.x);
+        bounds.min.y = std::min(bounds.min.y, vertex.position.y);
+        bounds.min.z = std::min(bounds.min.z, vertex.position.z);
+        bounds.max.x = std::max(bounds.max.x, vertex.position.x);
+        bounds.max.y = std::max(bounds.max.y, vertex.position.y);
+        bounds.max.z = std::max(bounds.max.z, vertex.position.z);
+    }
+    return bounds;
+}
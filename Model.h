@@ -0,0 +1,76 @@
+#pragma once
+#include "MyMath.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct VertexData {
+    Vector4 position;
+    Vector2 texcoord;
+    Vector3 normal;
+};
+struct MaterialData {
+    std::string name; // newmtlの名前
+    std::string textureFilePath; // 無ければ空
+};
+// indicesの範囲と使うマテリアル
+struct Submesh {
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    uint32_t materialIndex; // materialsの番号
+};
+// 三角形を減らしたもの(MeshLod.hのBuildLodChainで作る)。頂点は元のメッシュのものを使う
+struct MeshLod {
+    std::vector<uint32_t> indices;
+    std::vector<Submesh> submeshes; // 元のメッシュのサブメッシュと同じ数・同じ順番(空になったものも残す)
+    float error; // 元のメッシュからのずれの見込み(モデルの単位)
+};
+// 三角形の小さな塊(Meshlet.hのBuildMeshletsで作る)。境界球はModelData::meshletBoundsに別に持つ
+struct Meshlet {
+    uint32_t indexOffset; // indicesでの位置
+    uint32_t triangleCount;
+    uint32_t vertexCount; // 使う頂点の数
+    uint32_t materialIndex;
+    Vector3 coneAxis; // 三角形の表の向きの平均(単位ベクトル)
+    float coneCutoff; // 表の向きの広がりの角度のsin。1なら裏向きかどうかを判定しない
+};
+// 同じ頂点はまとめてあり、indicesの3つずつで三角形1枚になる
+// 三角形はマテリアル毎にまとめてあり、サブメッシュ1つにつき描画1回で描ける
+struct ModelData {
+    std::vector<VertexData> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<Submesh> submeshes;
+    std::vector<MaterialData> materials;
+    std::vector<MeshLod> lods; // 細かいものから順に。空ならLOD無し
+    std::vector<Meshlet> meshlets; // 元のメッシュのindicesを分けたもの。空なら無し
+    std::vector<Sphere> meshletBounds; // meshletsと同じ順のローカル空間の境界球(CullSpheresにそのまま渡す)
+};
+// 頂点をまとめてどれだけ減ったか
+struct MeshStats {
+    size_t sourceVertexCount; // 三角形毎に頂点を持ったときの数(indexの数と同じ)
+    size_t vertexCount;
+    uint32_t indexSize; // 2か4
+    size_t sourceBytes; // 三角形毎に頂点を持ったときの頂点データの大きさ
+    size_t bytes; // 頂点データとindexの大きさ
+    float vertexReductionRatio; // sourceVertexCount / vertexCount
+};
+
+// mtlファイルを読む(newmtl毎に1つ)
+std::vector<MaterialData> LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename);
+// objファイルを読む(メモリにマップしてParseObjで読む)
+// threadCountが2以上なら並列に読む(0ならCPUのスレッド数)。結果はスレッド数によらず同じ
+ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename, uint32_t threadCount = 1);
+// 1行ずつistringstreamで読む元の実装(比較用)。頂点はまとめず、indexは0から順に振る
+// (サブメッシュの分け方はLoadObjFileと同じ)
+ModelData LoadObjFileStream(const std::string& directoryPath, const std::string& filename);
+// GPUに送るindexの大きさ。頂点が65536個以下なら16bitで足りる
+uint32_t GetIndexSize(const ModelData& modelData);
+// indicesと全てのLODのindexの数
+size_t GetTotalIndexCount(const ModelData& modelData);
+// indicesの後ろにLODのindexを順に続けて、GetIndexSizeの大きさに詰めて書き込む
+// (destinationはGetIndexSize * GetTotalIndexCountバイト)
+void CopyIndices(const ModelData& modelData, void* destination);
+MeshStats CalculateMeshStats(const ModelData& modelData);
+// 頂点を囲むAABB(頂点が無ければ原点の点)
+AABB CalculateBounds(const ModelData& modelData);
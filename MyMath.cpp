@@ -0,0 +1,397 @@
+#include "MyMath.h"
+#include "MatrixSimd.h"
+#include <cmath>
+#include <numbers>
+
+Matrix4x4 InverseScalar(const Matrix4x4& m)
+{
+    float determinant;
+    Matrix4x4 num;
+
+    determinant = m.m[0][0] * m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[0][0] * m.m[1][2] * m.m[2][3] * m.m[3][1] + m.m[0][0] * m.m[1][3] * m.m[2][1] * m.m[3][2]
+        - m.m[0][0] * m.m[1][3] * m.m[2][2] * m.m[3][1] - m.m[0][0] * m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[0][0] * m.m[1][1] * m.m[2][3] * m.m[3][2]
+        - m.m[0][1] * m.m[1][0] * m.m[2][2] * m.m[3][3] - m.m[0][2] * m.m[1][0] * m.m[2][3] * m.m[3][1] - m.m[0][3] * m.m[1][0] * m.m[2][1] * m.m[3][2]
+        + m.m[0][3] * m.m[1][0] * m.m[2][2] * m.m[3][1] + m.m[0][2] * m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[0][1] * m.m[1][0] * m.m[2][3] * m.m[3][2]
+        + m.m[0][1] * m.m[1][2] * m.m[2][0] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] * m.m[3][1] + m.m[0][3] * m.m[1][1] * m.m[2][0] * m.m[3][2]
+        - m.m[0][3] * m.m[1][2] * m.m[2][0] * m.m[3][1] - m.m[0][2] * m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[0][1] * m.m[1][3] * m.m[2][0] * m.m[3][2]
+        - m.m[0][1] * m.m[1][2] * m.m[2][3] * m.m[3][0] - m.m[0][2] * m.m[1][3] * m.m[2][1] * m.m[3][0] - m.m[0][3] * m.m[1][1] * m.m[2][2] * m.m[3][0]
+        + m.m[0][3] * m.m[1][2] * m.m[2][1] * m.m[3][0] + m.m[0][2] * m.m[1][1] * m.m[2][3] * m.m[3][0] + m.m[0][1] * m.m[1][3] * m.m[2][2] * m.m[3][0];
+
+    if (determinant == 0.0f) {
+        return m;
+    };
+
+    num.m[0][0] = (m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[1][2] * m.m[2][3] * m.m[3][1] + m.m[1][3] * m.m[2][1] * m.m[3][2] - m.m[1][3] * m.m[2][2] * m.m[3][1] - m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[1][1] * m.m[2][3] * m.m[3][2]) / determinant;
+    num.m[0][1] = (-m.m[0][1] * m.m[2][2] * m.m[3][3] - m.m[0][2] * m.m[2][3] * m.m[3][1] - m.m[0][3] * m.m[2][1] * m.m[3][2] + m.m[0][3] * m.m[2][2] * m.m[3][1] + m.m[0][2] * m.m[2][1] * m.m[3][3] + m.m[0][1] * m.m[2][3] * m.m[3][2]) / determinant;
+    num.m[0][2] = (m.m[0][1] * m.m[1][2] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[3][1] + m.m[0][3] * m.m[1][1] * m.m[3][2] - m.m[0][3] * m.m[1][2] * m.m[3][1] - m.m[0][2] * m.m[1][1] * m.m[3][3] - m.m[0][1] * m.m[1][3] * m.m[3][2]) / determinant;
+    num.m[0][3] = (-m.m[0][1] * m.m[1][2] * m.m[2][3] - m.m[0][2] * m.m[1][3] * m.m[2][1] - m.m[0][3] * m.m[1][1] * m.m[2][2] + m.m[0][3] * m.m[1][2] * m.m[2][1] + m.m[0][2] * m.m[1][1] * m.m[2][3] + m.m[0][1] * m.m[1][3] * m.m[2][2]) / determinant;
+
+    num.m[1][0] = (-m.m[1][0] * m.m[2][2] * m.m[3][3] - m.m[1][2] * m.m[2][3] * m.m[3][0] - m.m[1][3] * m.m[2][0] * m.m[3][2] + m.m[1][3] * m.m[2][2] * m.m[3][0] + m.m[1][2] * m.m[2][0] * m.m[3][3] + m.m[1][0] * m.m[2][3] * m.m[3][2]) / determinant;
+    num.m[1][1] = (m.m[0][0] * m.m[2][2] * m.m[3][3] + m.m[0][2] * m.m[2][3] * m.m[3][0] + m.m[0][3] * m.m[2][0] * m.m[3][2] - m.m[0][3] * m.m[2][2] * m.m[3][0] - m.m[0][2] * m.m[2][0] * m.m[3][3] - m.m[0][0] * m.m[2][3] * m.m[3][2]) / determinant;
+    num.m[1][2] = (-m.m[0][0] * m.m[1][2] * m.m[3][3] - m.m[0][2] * m.m[1][3] * m.m[3][0] - m.m[0][3] * m.m[1][0] * m.m[3][2] + m.m[0][3] * m.m[1][2] * m.m[3][0] + m.m[0][2] * m.m[1][0] * m.m[3][3] + m.m[0][0] * m.m[1][3] * m.m[3][2]) / determinant;
+    num.m[1][3] = (m.m[0][0] * m.m[1][2] * m.m[2][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] + m.m[0][3] * m.m[1][0] * m.m[2][2] - m.m[0][3] * m.m[1][2] * m.m[2][0] - m.m[0][2] * m.m[1][0] * m.m[2][3] - m.m[0][0] * m.m[1][3] * m.m[2][2]) / determinant;
+
+    num.m[2][0] = (m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[1][1] * m.m[2][3] * m.m[3][0] + m.m[1][3] * m.m[2][0] * m.m[3][1] - m.m[1][3] * m.m[2][1] * m.m[3][0] - m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[1][0] * m.m[2][3] * m.m[3][1]) / determinant;
+    num.m[2][1] = (-m.m[0][0] * m.m[2][1] * m.m[3][3] - m.m[0][1] * m.m[2][3] * m.m[3][0] - m.m[0][3] * m.m[2][0] * m.m[3][1] + m.m[0][3] * m.m[2][1] * m.m[3][0] + m.m[0][1] * m.m[2][0] * m.m[3][3] + m.m[0][0] * m.m[2][3] * m.m[3][1]) / determinant;
+    num.m[2][2] = (m.m[0][0] * m.m[1][1] * m.m[3][3] + m.m[0][1] * m.m[1][3] * m.m[3][0] + m.m[0][3] * m.m[1][0] * m.m[3][1] - m.m[0][3] * m.m[1][1] * m.m[3][0] - m.m[0][1] * m.m[1][0] * m.m[3][3] - m.m[0][0] * m.m[1][3] * m.m[3][1]) / determinant;
+    num.m[2][3] = (-m.m[0][0] * m.m[1][1] * m.m[2][3] - m.m[0][1] * m.m[1][3] * m.m[2][0] - m.m[0][3] * m.m[1][0] * m.m[2][1] + m.m[0][3] * m.m[1][1] * m.m[2][0] + m.m[0][1] * m.m[1][0] * m.m[2][3] + m.m[0][0] * m.m[1][3] * m.m[2][1]) / determinant;
+
+    num.m[3][0] = (-m.m[1][0] * m.m[2][1] * m.m[3][2] - m.m[1][1] * m.m[2][2] * m.m[3][0] - m.m[1][2] * m.m[2][0] * m.m[3][1] + m.m[1][2] * m.m[2][1] * m.m[3][0] + m.m[1][1] * m.m[2][0] * m.m[3][2] + m.m[1][0] * m.m[2][2] * m.m[3][1]) / determinant;
+    num.m[3][1] = (m.m[0][0] * m.m[2][1] * m.m[3][2] + m.m[0][1] * m.m[2][2] * m.m[3][0] + m.m[0][2] * m.m[2][0] * m.m[3][1] - m.m[0][2] * m.m[2][1] * m.m[3][0] - m.m[0][1] * m.m[2][0] * m.m[3][2] - m.m[0][0] * m.m[2][2] * m.m[3][1]) / determinant;
+    num.m[3][2] = (-m.m[0][0] * m.m[1][1] * m.m[3][2] - m.m[0][1] * m.m[1][2] * m.m[3][0] - m.m[0][2] * m.m[1][0] * m.m[3][1] + m.m[0][2] * m.m[1][1] * m.m[3][0] + m.m[0][1] * m.m[1][0] * m.m[3][2] + m.m[0][0] * m.m[1][2] * m.m[3][1]) / determinant;
+    num.m[3][3] = (m.m[0][0] * m.m[1][1] * m.m[2][2] + m.m[0][1] * m.m[1][2] * m.m[2][0] + m.m[0][2] * m.m[1][0] * m.m[2][1] - m.m[0][2] * m.m[1][1] * m.m[2][0] - m.m[0][1] * m.m[1][0] * m.m[2][2] - m.m[0][0] * m.m[1][2] * m.m[2][1]) / determinant;
+
+    return num;
+}
+Vector3 Normalize(const Vector3& v)
+{
+    float Normalize;
+    Vector3 num;
+    Normalize = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+    num.x = v.x / Normalize;
+    num.y = v.y / Normalize;
+    num.z = v.z / Normalize;
+    return num;
+}
+Matrix4x4 MakeAffineMatrixScalar(const Vector3& scale, const Vector3& rotate, const Vector3& translate)
+{
+    Matrix4x4 rotateX = MakeRotateXMatrix(rotate.x);
+    Matrix4x4 rotateY = MakeRotateYMatrix(rotate.y);
+    Matrix4x4 rotateZ = MakeRotateZMatrix(rotate.z);
+    Matrix4x4 rotateXYZ = MultiplyScalar(rotateX, MultiplyScalar(rotateY, rotateZ));
+
+    Matrix4x4 num;
+    num.m[0][0] = scale.x * rotateXYZ.m[0][0];
+    num.m[0][1] = scale.x * rotateXYZ.m[0][1];
+    num.m[0][2] = scale.x * rotateXYZ.m[0][2];
+    num.m[0][3] = 0.0f * 0.0f * 0.0f * 0.0f;
+    num.m[1][0] = scale.y * rotateXYZ.m[1][0];
+    num.m[1][1] = scale.y * rotateXYZ.m[1][1];
+    num.m[1][2] = scale.y * rotateXYZ.m[1][2];
+    num.m[1][3] = 0.0f * 0.0f * 0.0f * 0.0f;
+    num.m[2][0] = scale.z * rotateXYZ.m[2][0];
+    num.m[2][1] = scale.z * rotateXYZ.m[2][1];
+    num.m[2][2] = scale.z * rotateXYZ.m[2][2];
+    num.m[2][3] = 0.0f * 0.0f * 0.0f * 0.0f;
+    num.m[3][0] = translate.x;
+    num.m[3][1] = translate.y;
+    num.m[3][2] = translate.z;
+    num.m[3][3] = 1.0f;
+    return num;
+}
+void SinCosScalar(const float* radians, float* sins, float* coss, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        sins[i] = std::sin(radians[i]);
+        coss[i] = std::cos(radians[i]);
+    }
+}
+
+// 実行中のCPUで使える一番速い実装に振り分ける
+Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2)
+{
+    return GetActiveMatrixKernels().multiply(m1, m2);
+}
+Matrix4x4 Inverse(const Matrix4x4& m)
+{
+    return GetActiveMatrixKernels().inverse(m);
+}
+Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Vector3& translate)
+{
+    return GetActiveMatrixKernels().makeAffineMatrix(scale, rotate, translate);
+}
+void SinCos(const float* radians, float* sins, float* coss, size_t count)
+{
+    GetActiveMatrixKernels().sinCos(radians, sins, coss, count);
+}
+
+namespace {
+
+// 3x3部分の余因子行列 (cofactor.m[i][j] が m[i][j] の余因子)
+Matrix4x4 MakeCofactor3x3(const Matrix4x4& m)
+{
+    Matrix4x4 cofactor {};
+    cofactor.m[0][0] = m.m[1][1] * m.m[2][2] - m.m[1][2] * m.m[2][1];
+    cofactor.m[0][1] = m.m[1][2] * m.m[2][0] - m.m[1][0] * m.m[2][2];
+    cofactor.m[0][2] = m.m[1][0] * m.m[2][1] - m.m[1][1] * m.m[2][0];
+    cofactor.m[1][0] = m.m[0][2] * m.m[2][1] - m.m[0][1] * m.m[2][2];
+    cofactor.m[1][1] = m.m[0][0] * m.m[2][2] - m.m[0][2] * m.m[2][0];
+    cofactor.m[1][2] = m.m[0][1] * m.m[2][0] - m.m[0][0] * m.m[2][1];
+    cofactor.m[2][0] = m.m[0][1] * m.m[1][2] - m.m[0][2] * m.m[1][1];
+    cofactor.m[2][1] = m.m[0][2] * m.m[1][0] - m.m[0][0] * m.m[1][2];
+    cofactor.m[2][2] = m.m[0][0] * m.m[1][1] - m.m[0][1] * m.m[1][0];
+    return cofactor;
+}
+
+}
+
+Matrix4x4 InverseAffineScalar(const Matrix4x4& m)
+{
+    Matrix4x4 cofactor = MakeCofactor3x3(m);
+    float determinant = m.m[0][0] * cofactor.m[0][0] + m.m[0][1] * cofactor.m[0][1] + m.m[0][2] * cofactor.m[0][2];
+    if (determinant == 0.0f) {
+        return m;
+    }
+    float rcpDeterminant = 1.0f / determinant;
+
+    // 3x3部分は余因子行列の転置/行列式
+    Matrix4x4 num;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            num.m[i][j] = cofactor.m[j][i] * rcpDeterminant;
+        }
+        num.m[i][3] = 0.0f;
+    }
+    // 平行移動は -t * L^-1
+    for (int j = 0; j < 3; ++j) {
+        num.m[3][j] = -(m.m[3][0] * num.m[0][j] + m.m[3][1] * num.m[1][j] + m.m[3][2] * num.m[2][j]);
+    }
+    num.m[3][3] = 1.0f;
+    return num;
+}
+
+Matrix4x4 InverseRigidScalar(const Matrix4x4& m)
+{
+    Matrix4x4 num;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            num.m[i][j] = m.m[j][i];
+        }
+        num.m[i][3] = 0.0f;
+    }
+    for (int j = 0; j < 3; ++j) {
+        num.m[3][j] = -(m.m[3][0] * m.m[j][0] + m.m[3][1] * m.m[j][1] + m.m[3][2] * m.m[j][2]);
+    }
+    num.m[3][3] = 1.0f;
+    return num;
+}
+
+Matrix4x4 MakeNormalMatrixScalar(const Matrix4x4& m)
+{
+    // (L^-1)^T = 余因子行列/行列式
+    Matrix4x4 num = MakeCofactor3x3(m);
+    float determinant = m.m[0][0] * num.m[0][0] + m.m[0][1] * num.m[0][1] + m.m[0][2] * num.m[0][2];
+    if (determinant != 0.0f) {
+        float rcpDeterminant = 1.0f / determinant;
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                num.m[i][j] *= rcpDeterminant;
+            }
+        }
+    }
+    num.m[3][3] = 1.0f;
+    return num;
+}
+
+Matrix4x4 InverseAffine(const Matrix4x4& m)
+{
+    return GetActiveMatrixKernels().inverseAffine(m);
+}
+Matrix4x4 InverseRigid(const Matrix4x4& m)
+{
+    return GetActiveMatrixKernels().inverseRigid(m);
+}
+Matrix4x4 MakeNormalMatrix(const Matrix4x4& m)
+{
+    return GetActiveMatrixKernels().makeNormalMatrix(m);
+}
+
+Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Quaternion& rotate, const Vector3& translate)
+{
+    Matrix4x4 rotateMatrix = MakeRotateMatrix(rotate);
+    Matrix4x4 num;
+    for (int j = 0; j < 3; ++j) {
+        num.m[0][j] = scale.x * rotateMatrix.m[0][j];
+        num.m[1][j] = scale.y * rotateMatrix.m[1][j];
+        num.m[2][j] = scale.z * rotateMatrix.m[2][j];
+    }
+    num.m[0][3] = 0.0f;
+    num.m[1][3] = 0.0f;
+    num.m[2][3] = 0.0f;
+    num.m[3][0] = translate.x;
+    num.m[3][1] = translate.y;
+    num.m[3][2] = translate.z;
+    num.m[3][3] = 1.0f;
+    return num;
+}
+
+Matrix4x4 MakeAffineMatrix(const Transform& transform)
+{
+    if (transform.useQuaternion) {
+        return MakeAffineMatrix(transform.scale, transform.quaternion, transform.translate);
+    }
+    return MakeAffineMatrix(transform.scale, transform.rotate, transform.translate);
+}
+
+float Norm(const Quaternion& q)
+{
+    return std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+}
+
+Quaternion Normalize(const Quaternion& q)
+{
+    float norm = Norm(q);
+    if (norm == 0.0f) {
+        return q;
+    }
+    return { q.x / norm, q.y / norm, q.z / norm, q.w / norm };
+}
+
+Quaternion Inverse(const Quaternion& q)
+{
+    float normSq = q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w;
+    if (normSq == 0.0f) {
+        return q;
+    }
+    Quaternion conjugate = Conjugate(q);
+    return { conjugate.x / normSq, conjugate.y / normSq, conjugate.z / normSq, conjugate.w / normSq };
+}
+
+Quaternion MakeRotateAxisAngleQuaternion(const Vector3& axis, float angle)
+{
+    Vector3 n = Normalize(axis);
+    float s = std::sin(angle * 0.5f);
+    return { n.x * s, n.y * s, n.z * s, std::cos(angle * 0.5f) };
+}
+
+Quaternion MakeEulerQuaternion(const Vector3& rotate)
+{
+    // X→Y→Zの順に回すので qZ * qY * qX
+    float cx = std::cos(rotate.x * 0.5f);
+    float sx = std::sin(rotate.x * 0.5f);
+    float cy = std::cos(rotate.y * 0.5f);
+    float sy = std::sin(rotate.y * 0.5f);
+    float cz = std::cos(rotate.z * 0.5f);
+    float sz = std::sin(rotate.z * 0.5f);
+
+    Quaternion num;
+    num.x = sx * cy * cz - cx * sy * sz;
+    num.y = cx * sy * cz + sx * cy * sz;
+    num.z = cx * cy * sz - sx * sy * cz;
+    num.w = cx * cy * cz + sx * sy * sz;
+    return num;
+}
+
+Vector3 MakeEulerAngles(const Quaternion& q)
+{
+    // MakeRotateMatrix(q)の要素から求める。ジンバルロック付近(cosYが小さい)ではfloatの精度が落ちる
+    // m[0][0] = cosY cosZ, m[0][1] = cosY sinZ, m[0][2] = -sinY, m[1][2] = sinX cosY, m[2][2] = cosX cosY
+    float m00 = 1.0f - 2.0f * (q.y * q.y + q.z * q.z);
+    float m01 = 2.0f * (q.x * q.y + q.z * q.w);
+    float m02 = 2.0f * (q.x * q.z - q.y * q.w);
+    float m12 = 2.0f * (q.y * q.z + q.x * q.w);
+    float m22 = 1.0f - 2.0f * (q.x * q.x + q.y * q.y);
+    float cosY = std::sqrt(m00 * m00 + m01 * m01);
+
+    Vector3 num;
+    num.y = std::atan2(-m02, cosY);
+    if (cosY < 1e-6f) {
+        // ジンバルロック。Zの回転をXに寄せる
+        float m11 = 1.0f - 2.0f * (q.x * q.x + q.z * q.z);
+        float m21 = 2.0f * (q.y * q.z - q.x * q.w);
+        num.x = std::atan2(-m21, m11);
+        num.z = 0.0f;
+        return num;
+    }
+    num.x = std::atan2(m12, m22);
+    num.z = std::atan2(m01, m00);
+    return num;
+}
+
+Quaternion Slerp(const Quaternion& q0, const Quaternion& q1, float t)
+{
+    float dot = q0.x * q1.x + q0.y * q1.y + q0.z * q1.z + q0.w * q1.w;
+    Quaternion end = q1;
+    if (dot < 0.0f) {
+        end = { -q1.x, -q1.y, -q1.z, -q1.w };
+        dot = -dot;
+    }
+    // ほぼ同じ向きのときはsinθが0に近くなるので線形補間にする
+    if (dot >= 0.9995f) {
+        return Nlerp(q0, end, t);
+    }
+    float theta = std::acos(dot);
+    float rcpSinTheta = 1.0f / std::sin(theta);
+    float scale0 = std::sin((1.0f - t) * theta) * rcpSinTheta;
+    float scale1 = std::sin(t * theta) * rcpSinTheta;
+    return { scale0 * q0.x + scale1 * end.x, scale0 * q0.y + scale1 * end.y, scale0 * q0.z + scale1 * end.z, scale0 * q0.w + scale1 * end.w };
+}
+
+Quaternion Nlerp(const Quaternion& q0, const Quaternion& q1, float t)
+{
+    float dot = q0.x * q1.x + q0.y * q1.y + q0.z * q1.z + q0.w * q1.w;
+    float scale1 = dot < 0.0f ? -t : t;
+    float scale0 = 1.0f - t;
+    return Normalize(Quaternion { scale0 * q0.x + scale1 * q1.x, scale0 * q0.y + scale1 * q1.y, scale0 * q0.z + scale1 * q1.z, scale0 * q0.w + scale1 * q1.w });
+}
+
+bool IsCollision(const Frustum& frustum, const Sphere& sphere)
+{
+    for (const Plane& plane : frustum.planes) {
+        float distance = plane.normal.x * sphere.center.x + plane.normal.y * sphere.center.y + plane.normal.z * sphere.center.z + plane.distance;
+        if (distance < -sphere.radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IsCollision(const Frustum& frustum, const AABB& aabb)
+{
+    Vector3 center = { (aabb.min.x + aabb.max.x) * 0.5f, (aabb.min.y + aabb.max.y) * 0.5f, (aabb.min.z + aabb.max.z) * 0.5f };
+    Vector3 extent = { (aabb.max.x - aabb.min.x) * 0.5f, (aabb.max.y - aabb.min.y) * 0.5f, (aabb.max.z - aabb.min.z) * 0.5f };
+    for (const Plane& plane : frustum.planes) {
+        // 平面の法線方向に一番出ている頂点までの距離
+        float distance = plane.normal.x * center.x + plane.normal.y * center.y + plane.normal.z * center.z + plane.distance;
+        float radius = std::abs(plane.normal.x) * extent.x + std::abs(plane.normal.y) * extent.y + std::abs(plane.normal.z) * extent.z;
+        if (distance + radius < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+AABB TransformAABB(const AABB& aabb, const Matrix4x4& matrix)
+{
+    // 行列の要素毎に小さい方と大きい方を足していく(Arvoの方法)
+    AABB result;
+    float* resultMin = &result.min.x;
+    float* resultMax = &result.max.x;
+    const float* min = &aabb.min.x;
+    const float* max = &aabb.max.x;
+    for (int j = 0; j < 3; ++j) {
+        resultMin[j] = matrix.m[3][j];
+        resultMax[j] = matrix.m[3][j];
+        for (int i = 0; i < 3; ++i) {
+            float a = min[i] * matrix.m[i][j];
+            float b = max[i] * matrix.m[i][j];
+            resultMin[j] += a < b ? a : b;
+            resultMax[j] += a < b ? b : a;
+        }
+    }
+    return result;
+}
+
+Frustum MakeFrustum(const Matrix4x4& viewProjection)
+{
+    // 行ベクトルなのでクリップ座標の各成分は列との内積になる
+    const Matrix4x4& m = viewProjection;
+    float planes[6][4];
+    for (int i = 0; i < 4; ++i) {
+        planes[0][i] = m.m[i][3] + m.m[i][0]; // -w <= x
+        planes[1][i] = m.m[i][3] - m.m[i][0]; // x <= w
+        planes[2][i] = m.m[i][3] + m.m[i][1]; // -w <= y
+        planes[3][i] = m.m[i][3] - m.m[i][1]; // y <= w
+        planes[4][i] = m.m[i][2]; // 0 <= z
+        planes[5][i] = m.m[i][3] - m.m[i][2]; // z <= w
+    }
+
+    Frustum frustum;
+    for (int p = 0; p < 6; ++p) {
+        float length = std::sqrt(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+        float rcpLength = length > 0.0f ? 1.0f / length : 0.0f;
+        frustum.planes[p].normal = { planes[p][0] * rcpLength, planes[p][1] * rcpLength, planes[p][2] * rcpLength };
+        frustum.planes[p].distance = planes[p][3] * rcpLength;
+    }
+    return frustum;
+}
@@ -0,0 +1,356 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <type_traits>
+
+struct Vector2 {
+    float x;
+    float y;
+};
+struct Vector3 {
+    float x;
+    float y;
+    float z;
+};
+struct Vector4 {
+    float x;
+    float y;
+    float z;
+    float w;
+};
+struct Quaternion {
+    float x;
+    float y;
+    float z;
+    float w;
+};
+struct Matrix4x4 {
+    float m[4][4];
+};
+struct AABB {
+    Vector3 min;
+    Vector3 max;
+};
+struct Sphere {
+    Vector3 center;
+    float radius;
+};
+// dot(normal, p) + distance >= 0 の側が内側
+struct Plane {
+    Vector3 normal;
+    float distance;
+};
+// 視錐台。planesは左、右、下、上、手前、奥の順で法線は内向き
+struct Frustum {
+    Plane planes[6];
+};
+struct Transform {
+    Vector3 scale;
+    Vector3 rotate;
+    Vector3 translate;
+    // useQuaternionのときはrotate(オイラー角)の代わりにこちらで回転する
+    Quaternion quaternion = { 0.0f, 0.0f, 0.0f, 1.0f };
+    bool useQuaternion = false;
+};
+
+// 行列
+constexpr Matrix4x4 MakeIdentity4x4();
+constexpr Matrix4x4 MakeRotateXMatrix(float radian);
+constexpr Matrix4x4 MakeRotateYMatrix(float radian);
+constexpr Matrix4x4 MakeRotateZMatrix(float radian);
+constexpr Matrix4x4 MakeScaleMatrix(const Vector3& scale);
+constexpr Matrix4x4 MakeTranslateMatrix(const Vector3& translate);
+// 実行時はSIMD版に切り替わる。コンパイル時に掛けるときはMultiplyScalarを使う
+Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2);
+constexpr Matrix4x4 MultiplyScalar(const Matrix4x4& m1, const Matrix4x4& m2);
+Matrix4x4 Inverse(const Matrix4x4& m);
+// 最後の列が(0,0,0,1)の行列の逆行列。3x3部分だけ余因子で解く
+Matrix4x4 InverseAffine(const Matrix4x4& m);
+// 回転と平行移動だけの行列の逆行列。回転は転置、平行移動は逆向きにする
+Matrix4x4 InverseRigid(const Matrix4x4& m);
+// 法線用の逆転置行列。3x3部分の余因子から作り、平行移動は0にする
+Matrix4x4 MakeNormalMatrix(const Matrix4x4& m);
+Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Vector3& translate);
+Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Quaternion& rotate, const Vector3& translate);
+Matrix4x4 MakeAffineMatrix(const Transform& transform);
+constexpr Matrix4x4 MakePrespectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip);
+constexpr Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float bottom, float nearClip, float farClip);
+
+// クォータニオン
+// 回転の順番はMakeAffineMatrixと同じくX→Y→Z
+constexpr Quaternion MakeIdentityQuaternion();
+constexpr Quaternion Multiply(const Quaternion& q1, const Quaternion& q2);
+constexpr Quaternion Conjugate(const Quaternion& q);
+float Norm(const Quaternion& q);
+Quaternion Normalize(const Quaternion& q);
+Quaternion Inverse(const Quaternion& q);
+Quaternion MakeRotateAxisAngleQuaternion(const Vector3& axis, float angle);
+Quaternion MakeEulerQuaternion(const Vector3& rotate);
+Vector3 MakeEulerAngles(const Quaternion& q);
+constexpr Vector3 RotateVector(const Vector3& vector, const Quaternion& q);
+constexpr Matrix4x4 MakeRotateMatrix(const Quaternion& q);
+// 球面線形補間。tが0でq0、1でq1。短い方の回り方を選ぶ
+Quaternion Slerp(const Quaternion& q0, const Quaternion& q1, float t);
+// 線形補間して正規化する。Slerpより安いが角速度は一定にならない
+Quaternion Nlerp(const Quaternion& q0, const Quaternion& q1, float t);
+
+// 三角関数
+// コンパイル時は級数展開(doubleで計算してfloatに丸める)、実行時はstd::sin/cos/tanを使う。
+// 実行時の結果は今までと変わらない。コンパイル時の結果との差は1ULP程度
+constexpr float Sin(float radian);
+constexpr float Cos(float radian);
+constexpr float Tan(float radian);
+// radians[i]のsinとcosをまとめて求める。SIMD版は多項式近似(誤差はMatrixSimd.h)
+void SinCos(const float* radians, float* sins, float* coss, size_t count);
+
+// ベクトル
+constexpr Vector3 Multiply(const Vector3& m1, const float& m2);
+Vector3 Normalize(const Vector3& v);
+
+// 当たり判定
+constexpr bool IsCollision(const AABB& aabb, const Vector3& point);
+// 視錐台と重なっているか(6平面の内側にかかっていれば重なっているとみなす)
+bool IsCollision(const Frustum& frustum, const Sphere& sphere);
+bool IsCollision(const Frustum& frustum, const AABB& aabb);
+// ローカルのAABBをワールド行列で変換して、それを囲むAABBを作る
+AABB TransformAABB(const AABB& aabb, const Matrix4x4& matrix);
+// ビュープロジェクション行列から視錐台の6平面を取り出す(D3Dのクリップ空間 0 <= z <= w)
+Frustum MakeFrustum(const Matrix4x4& viewProjection);
+
+constexpr Vector3 operator*(const Vector3& m1, const float& m2);
+constexpr Vector3& operator+=(Vector3& lhv, const Vector3& rhv);
+
+// 以下はconstexprの関数の定義
+
+// コンパイル時用のsin/cos。[-π, π]に畳んでからテイラー展開する
+constexpr double ConstexprReduceRadian(double radian)
+{
+    const double kTwoPi = 2.0 * std::numbers::pi;
+    double turns = radian / kTwoPi;
+    double rounded = double(static_cast<long long>(turns + (turns >= 0.0 ? 0.5 : -0.5)));
+    return radian - rounded * kTwoPi;
+}
+constexpr double ConstexprSin(double radian)
+{
+    double x = ConstexprReduceRadian(radian);
+    double term = x;
+    double sum = x;
+    for (int i = 1; i < 16; ++i) {
+        term *= -x * x / double((2 * i) * (2 * i + 1));
+        sum += term;
+    }
+    return sum;
+}
+constexpr double ConstexprCos(double radian)
+{
+    double x = ConstexprReduceRadian(radian);
+    double term = 1.0;
+    double sum = 1.0;
+    for (int i = 1; i < 16; ++i) {
+        term *= -x * x / double((2 * i - 1) * (2 * i));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr float Sin(float radian)
+{
+    if (std::is_constant_evaluated()) {
+        return float(ConstexprSin(radian));
+    }
+    return std::sin(radian);
+}
+constexpr float Cos(float radian)
+{
+    if (std::is_constant_evaluated()) {
+        return float(ConstexprCos(radian));
+    }
+    return std::cos(radian);
+}
+constexpr float Tan(float radian)
+{
+    if (std::is_constant_evaluated()) {
+        return float(ConstexprSin(radian) / ConstexprCos(radian));
+    }
+    return std::tan(radian);
+}
+
+constexpr Matrix4x4 MakeIdentity4x4()
+{
+    Matrix4x4 num;
+    num = { { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 } };
+    return num;
+}
+
+constexpr Matrix4x4 MakeRotateXMatrix(float radian)
+{
+    Matrix4x4 num;
+    num = { 1, 0, 0, 0,
+        0, Cos(radian), Sin(radian), 0,
+        0, Sin(-radian), Cos(radian), 0,
+        0, 0, 0, 1 };
+    return num;
+}
+
+constexpr Matrix4x4 MakeRotateYMatrix(float radian)
+{
+    Matrix4x4 num;
+    num = { Cos(radian), 0, Sin(-radian), 0,
+        0, 1, 0, 0,
+        Sin(radian), 0, Cos(radian), 0,
+        0, 0, 0, 1 };
+    return num;
+}
+
+constexpr Matrix4x4 MakeRotateZMatrix(float radian)
+{
+    Matrix4x4 num;
+    num = { Cos(radian), Sin(radian), 0, 0,
+        Sin(-radian), Cos(radian), 0, 0,
+        0, 0, 1, 0,
+        0, 0, 0, 1 };
+    return num;
+}
+
+constexpr Matrix4x4 MakeScaleMatrix(const Vector3& scale)
+{
+    Matrix4x4 result { scale.x, 0.0f, 0.0f, 0.0f, 0.0f, scale.y, 0.0f, 0.0f, 0.0f, 0.0f, scale.z, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+
+    return result;
+}
+
+constexpr Matrix4x4 MakeTranslateMatrix(const Vector3& translate)
+{
+    Matrix4x4 result { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, translate.x, translate.y, translate.z, 1.0f };
+
+    return result;
+}
+
+constexpr Matrix4x4 MultiplyScalar(const Matrix4x4& m1, const Matrix4x4& m2)
+{
+    Matrix4x4 num;
+    num.m[0][0] = m1.m[0][0] * m2.m[0][0] + m1.m[0][1] * m2.m[1][0] + m1.m[0][2] * m2.m[2][0] + m1.m[0][3] * m2.m[3][0];
+    num.m[0][1] = m1.m[0][0] * m2.m[0][1] + m1.m[0][1] * m2.m[1][1] + m1.m[0][2] * m2.m[2][1] + m1.m[0][3] * m2.m[3][1];
+    num.m[0][2] = m1.m[0][0] * m2.m[0][2] + m1.m[0][1] * m2.m[1][2] + m1.m[0][2] * m2.m[2][2] + m1.m[0][3] * m2.m[3][2];
+    num.m[0][3] = m1.m[0][0] * m2.m[0][3] + m1.m[0][1] * m2.m[1][3] + m1.m[0][2] * m2.m[2][3] + m1.m[0][3] * m2.m[3][3];
+
+    num.m[1][0] = m1.m[1][0] * m2.m[0][0] + m1.m[1][1] * m2.m[1][0] + m1.m[1][2] * m2.m[2][0] + m1.m[1][3] * m2.m[3][0];
+    num.m[1][1] = m1.m[1][0] * m2.m[0][1] + m1.m[1][1] * m2.m[1][1] + m1.m[1][2] * m2.m[2][1] + m1.m[1][3] * m2.m[3][1];
+    num.m[1][2] = m1.m[1][0] * m2.m[0][2] + m1.m[1][1] * m2.m[1][2] + m1.m[1][2] * m2.m[2][2] + m1.m[1][3] * m2.m[3][2];
+    num.m[1][3] = m1.m[1][0] * m2.m[0][3] + m1.m[1][1] * m2.m[1][3] + m1.m[1][2] * m2.m[2][3] + m1.m[1][3] * m2.m[3][3];
+
+    num.m[2][0] = m1.m[2][0] * m2.m[0][0] + m1.m[2][1] * m2.m[1][0] + m1.m[2][2] * m2.m[2][0] + m1.m[2][3] * m2.m[3][0];
+    num.m[2][1] = m1.m[2][0] * m2.m[0][1] + m1.m[2][1] * m2.m[1][1] + m1.m[2][2] * m2.m[2][1] + m1.m[2][3] * m2.m[3][1];
+    num.m[2][2] = m1.m[2][0] * m2.m[0][2] + m1.m[2][1] * m2.m[1][2] + m1.m[2][2] * m2.m[2][2] + m1.m[2][3] * m2.m[3][2];
+    num.m[2][3] = m1.m[2][0] * m2.m[0][3] + m1.m[2][1] * m2.m[1][3] + m1.m[2][2] * m2.m[2][3] + m1.m[2][3] * m2.m[3][3];
+
+    num.m[3][0] = m1.m[3][0] * m2.m[0][0] + m1.m[3][1] * m2.m[1][0] + m1.m[3][2] * m2.m[2][0] + m1.m[3][3] * m2.m[3][0];
+    num.m[3][1] = m1.m[3][0] * m2.m[0][1] + m1.m[3][1] * m2.m[1][1] + m1.m[3][2] * m2.m[2][1] + m1.m[3][3] * m2.m[3][1];
+    num.m[3][2] = m1.m[3][0] * m2.m[0][2] + m1.m[3][1] * m2.m[1][2] + m1.m[3][2] * m2.m[2][2] + m1.m[3][3] * m2.m[3][2];
+    num.m[3][3] = m1.m[3][0] * m2.m[0][3] + m1.m[3][1] * m2.m[1][3] + m1.m[3][2] * m2.m[2][3] + m1.m[3][3] * m2.m[3][3];
+
+    return num;
+}
+
+constexpr Vector3 Multiply(const Vector3& m1, const float& m2)
+{
+    Vector3 num;
+    num.x = m1.x * m2;
+    num.y = m1.y * m2;
+    num.z = m1.z * m2;
+
+    return num;
+}
+
+constexpr Matrix4x4 MakePrespectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip)
+{
+    Matrix4x4 num;
+    num = { (1 / aspectRatio) * (1 / Tan(fovY / 2)), 0, 0, 0, 0, (1 / Tan(fovY / 2)), 0, 0, 0, 0, farClip / (farClip - nearClip), 1, 0, 0, (-nearClip * farClip) / (farClip - nearClip) };
+    return num;
+}
+
+constexpr Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float bottom, float nearClip, float farClip)
+{
+    Matrix4x4 num;
+    num = { 2 / (right - left), 0, 0, 0, 0, 2 / (top - bottom), 0, 0, 0, 0, 1 / (farClip - nearClip), 0, (left + right) / (left - right),
+        (top + bottom) / (bottom - top),
+        nearClip / (nearClip - farClip), 1 };
+    return num;
+}
+
+constexpr Quaternion MakeIdentityQuaternion()
+{
+    return { 0.0f, 0.0f, 0.0f, 1.0f };
+}
+
+constexpr Quaternion Multiply(const Quaternion& q1, const Quaternion& q2)
+{
+    Quaternion num;
+    num.x = q1.w * q2.x + q1.x * q2.w + q1.y * q2.z - q1.z * q2.y;
+    num.y = q1.w * q2.y - q1.x * q2.z + q1.y * q2.w + q1.z * q2.x;
+    num.z = q1.w * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.w;
+    num.w = q1.w * q2.w - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z;
+    return num;
+}
+
+constexpr Quaternion Conjugate(const Quaternion& q)
+{
+    return { -q.x, -q.y, -q.z, q.w };
+}
+
+constexpr Vector3 RotateVector(const Vector3& vector, const Quaternion& q)
+{
+    // v + 2w(u×v) + 2u×(u×v)  (uはqのベクトル部)
+    Vector3 t = {
+        2.0f * (q.y * vector.z - q.z * vector.y),
+        2.0f * (q.z * vector.x - q.x * vector.z),
+        2.0f * (q.x * vector.y - q.y * vector.x),
+    };
+    Vector3 num;
+    num.x = vector.x + q.w * t.x + (q.y * t.z - q.z * t.y);
+    num.y = vector.y + q.w * t.y + (q.z * t.x - q.x * t.z);
+    num.z = vector.z + q.w * t.z + (q.x * t.y - q.y * t.x);
+    return num;
+}
+
+constexpr Matrix4x4 MakeRotateMatrix(const Quaternion& q)
+{
+    float xx = q.x * q.x;
+    float yy = q.y * q.y;
+    float zz = q.z * q.z;
+    float xy = q.x * q.y;
+    float xz = q.x * q.z;
+    float yz = q.y * q.z;
+    float wx = q.w * q.x;
+    float wy = q.w * q.y;
+    float wz = q.w * q.z;
+
+    Matrix4x4 num;
+    num = { 1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f,
+        2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f,
+        2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f };
+    return num;
+}
+
+constexpr bool IsCollision(const AABB& aabb, const Vector3& point)
+{
+    if ((aabb.min.x <= point.x && aabb.max.x >= point.x)
+        && (aabb.min.y <= point.y && aabb.max.y >= point.y)
+        && (aabb.min.z <= point.z && aabb.max.z >= point.z)) {
+        return true;
+    }
+    return false;
+}
+
+constexpr Vector3 operator*(const Vector3& m1, const float& m2) { return Multiply(m1, m2); }
+
+constexpr Vector3& operator+=(Vector3& lhv, const Vector3& rhv)
+{
+    lhv.x += rhv.x;
+    lhv.y += rhv.y;
+    lhv.z += rhv.z;
+    return lhv;
+}
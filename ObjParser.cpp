@@ -0,0 +1,1071 @@
+#include "ObjParser.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "VertexWelder.h"
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// 並列で読むときの1チャンクの最小サイズ(これより小さいファイルはスレッドを増やさない)
+const size_t kMinChunkSize = 256 * 1024;
+
+bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+const char* SkipSpaces(const char* p, const char* end)
+{
+    while (p < end && IsSpace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+// 次の行の先頭(最後の行なら終端)
+const char* FindLineEnd(const char* p, const char* end)
+{
+    const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+    return lineEnd ? lineEnd : end;
+}
+
+// 先頭の識別子(空白までの文字列)
+std::string_view ReadToken(const char*& p, const char* end)
+{
+    p = SkipSpaces(p, end);
+    const char* start = p;
+    while (p < end && !IsSpace(*p)) {
+        ++p;
+    }
+    return std::string_view(start, size_t(p - start));
+}
+
+// 読めなければ0にする(istreamの>>と同じ)
+float ReadFloat(const char*& p, const char* end)
+{
+    p = SkipSpaces(p, end);
+    // from_charsは先頭の+を読まない
+    if (p < end && *p == '+') {
+        ++p;
+    }
+    float value = 0.0f;
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) {
+        return 0.0f;
+    }
+    p = result.ptr;
+    return value;
+}
+
+bool ReadIndex(const char*& p, const char* end, int32_t& index)
+{
+    std::from_chars_result result = std::from_chars(p, end, index);
+    if (result.ec != std::errc()) {
+        return false;
+    }
+    p = result.ptr;
+    return true;
+}
+
+Vector4 ReadPosition(const char*& p, const char* end)
+{
+    Vector4 position;
+    position.x = ReadFloat(p, end);
+    position.y = ReadFloat(p, end);
+    position.z = ReadFloat(p, end);
+    position.w = 1.0f;
+    return position;
+}
+
+Vector2 ReadTexcoord(const char*& p, const char* end)
+{
+    Vector2 texcoord;
+    texcoord.x = ReadFloat(p, end);
+    texcoord.y = ReadFloat(p, end);
+    return texcoord;
+}
+
+Vector3 ReadNormal(const char*& p, const char* end)
+{
+    Vector3 normal;
+    normal.x = ReadFloat(p, end);
+    normal.y = ReadFloat(p, end);
+    normal.z = ReadFloat(p, end);
+    return normal;
+}
+
+// 面の頂点の 位置/uv/法線 のindex(1始まり。負の番号は読んだ時点の数で正の番号にしてある)。無い要素は0
+struct ObjCorner {
+    int32_t position;
+    int32_t texcoord;
+    int32_t normal;
+};
+struct ObjTriangle {
+    ObjCorner corners[3];
+};
+
+// 1つの面の頂点数の上限(これより多い面は読まない)
+const uint32_t kMaxFaceCorners = 64;
+
+// 要素の数(面を読む時点でのv/vt/vnの数)
+struct ObjElementOffsets {
+    size_t positionCount;
+    size_t texcoordCount;
+    size_t normalCount;
+};
+
+// 負の番号(後ろから数える)を正の番号にする。範囲外ならfalse
+bool ResolveIndex(int32_t& index, size_t count)
+{
+    if (index < 0) {
+        index = int32_t(int64_t(count) + index + 1);
+    }
+    return 0 < index && size_t(index) <= count;
+}
+
+// 面を読む。頂点は v, v/vt, v//vn, v/vt/vn のどれでもよく、3つ以上なら何個でもよい(kMaxFaceCornersまで)。
+// indexは読んだ時点の要素の数で確かめる(後で定義される要素は使えない)
+bool ReadFace(const char*& p, const char* end, const ObjElementOffsets& counts, ObjCorner (&corners)[kMaxFaceCorners], uint32_t& cornerCount)
+{
+    cornerCount = 0;
+    for (p = SkipSpaces(p, end); p < end && *p != '#'; p = SkipSpaces(p, end)) {
+        if (cornerCount == kMaxFaceCorners) {
+            return false;
+        }
+        ObjCorner& corner = corners[cornerCount++];
+        corner = {};
+        if (!ReadIndex(p, end, corner.position) || !ResolveIndex(corner.position, counts.positionCount)) {
+            return false;
+        }
+        if (p < end && *p == '/') {
+            ++p;
+            // v//vnならuvは無い
+            if (p < end && *p != '/' && (!ReadIndex(p, end, corner.texcoord) || !ResolveIndex(corner.texcoord, counts.texcoordCount))) {
+                return false;
+            }
+            if (p < end && *p == '/') {
+                ++p;
+                if (!ReadIndex(p, end, corner.normal) || !ResolveIndex(corner.normal, counts.normalCount)) {
+                    return false;
+                }
+            }
+        }
+        if (p < end && !IsSpace(*p)) {
+            return false; // 頂点の後ろに余計な文字がある
+        }
+    }
+    return cornerCount >= 3;
+}
+
+// 多角形の法線(Newellの方法。凹んでいても向きが正しく出る)
+Vector3 CalculatePolygonNormal(const ObjCorner* corners, uint32_t cornerCount, const Vector4* positions)
+{
+    Vector3 normal = { 0.0f, 0.0f, 0.0f };
+    for (uint32_t i = 0; i < cornerCount; ++i) {
+        const Vector4& a = positions[corners[i].position - 1];
+        const Vector4& b = positions[corners[(i + 1) % cornerCount].position - 1];
+        normal.x += (a.y - b.y) * (a.z + b.z);
+        normal.y += (a.z - b.z) * (a.x + b.x);
+        normal.z += (a.x - b.x) * (a.y + b.y);
+    }
+    return normal;
+}
+
+// 面を三角形に分ける。trianglesに書いた数を返す(cornerCount - 2)
+// 四角形以上は法線の一番大きい軸を捨てた平面で耳を切り取っていく。凸なら0番からの扇形と同じになる。
+// 一直線に並んでいるなどで耳が見つからなければ、残りは扇形にする
+uint32_t TriangulateFace(const ObjCorner* corners, uint32_t cornerCount, const Vector4* positions, ObjTriangle* triangles)
+{
+    if (cornerCount == 3) {
+        triangles[0] = { { corners[0], corners[1], corners[2] } };
+        return 1;
+    }
+    Vector3 normal = CalculatePolygonNormal(corners, cornerCount, positions);
+    float absX = std::abs(normal.x);
+    float absY = std::abs(normal.y);
+    float absZ = std::abs(normal.z);
+    // 捨てる軸の残り2つ(u, v)を法線の向きから見て反時計回りになる順で取る
+    int32_t axisU = 1;
+    int32_t axisV = 2;
+    float sign = normal.x;
+    if (absY >= absX && absY >= absZ) {
+        axisU = 2;
+        axisV = 0;
+        sign = normal.y;
+    } else if (absZ >= absX && absZ >= absY) {
+        axisU = 0;
+        axisV = 1;
+        sign = normal.z;
+    }
+    float u[kMaxFaceCorners];
+    float v[kMaxFaceCorners];
+    uint32_t remaining[kMaxFaceCorners];
+    for (uint32_t i = 0; i < cornerCount; ++i) {
+        const float* position = &positions[corners[i].position - 1].x;
+        u[i] = position[axisU];
+        v[i] = sign < 0.0f ? -position[axisV] : position[axisV];
+        remaining[i] = i;
+    }
+    auto cross = [&](uint32_t a, uint32_t b, uint32_t c) { return (u[b] - u[a]) * (v[c] - v[a]) - (v[b] - v[a]) * (u[c] - u[a]); };
+
+    uint32_t triangleCount = 0;
+    uint32_t remainingCount = cornerCount;
+    while (remainingCount > 3) {
+        bool isClipped = false;
+        for (uint32_t i = 1; i <= remainingCount && !isClipped; ++i) {
+            uint32_t previous = remaining[i - 1];
+            uint32_t current = remaining[i % remainingCount];
+            uint32_t next = remaining[(i + 1) % remainingCount];
+            if (cross(previous, current, next) <= 0.0f) {
+                continue; // 凹んでいる頂点
+            }
+            // 他の頂点が中に入っていれば耳ではない
+            bool isEar = true;
+            for (uint32_t j = 0; j < remainingCount && isEar; ++j) {
+                uint32_t other = remaining[j];
+                if (other != previous && other != current && other != next) {
+                    isEar = cross(previous, current, other) < 0.0f || cross(current, next, other) < 0.0f || cross(next, previous, other) < 0.0f;
+                }
+            }
+            if (isEar) {
+                triangles[triangleCount++] = { { corners[previous], corners[current], corners[next] } };
+                std::copy(remaining + i % remainingCount + 1, remaining + remainingCount, remaining + i % remainingCount);
+                --remainingCount;
+                isClipped = true;
+            }
+        }
+        if (!isClipped) {
+            break;
+        }
+    }
+    for (uint32_t i = 1; i + 1 < remainingCount; ++i) {
+        triangles[triangleCount++] = { { corners[remaining[0]], corners[remaining[i]], corners[remaining[i + 1]] } };
+    }
+    return triangleCount;
+}
+
+bool HasMissingNormal(const ObjTriangle& triangle)
+{
+    return triangle.corners[0].normal == 0 || triangle.corners[1].normal == 0 || triangle.corners[2].normal == 0;
+}
+
+// 法線の無い頂点を持つ三角形の法線(面積の重み付き)を、位置毎に足していく
+// 外積は一定数ずつSoAに並べてまとめて計算する(ループがベクトル化されるように)
+void AccumulateFaceNormals(const ObjTriangle* triangles, size_t triangleCount, const Vector4* positions, Vector3* normals)
+{
+    const size_t kBatchSize = 256;
+    float ex0[kBatchSize], ey0[kBatchSize], ez0[kBatchSize];
+    float ex1[kBatchSize], ey1[kBatchSize], ez1[kBatchSize];
+    float nx[kBatchSize], ny[kBatchSize], nz[kBatchSize];
+    const ObjTriangle* batch[kBatchSize];
+    for (size_t t = 0; t < triangleCount;) {
+        size_t count = 0;
+        for (; t < triangleCount && count < kBatchSize; ++t) {
+            const ObjTriangle& triangle = triangles[t];
+            if (!HasMissingNormal(triangle)) {
+                continue;
+            }
+            const Vector4& p0 = positions[triangle.corners[0].position - 1];
+            const Vector4& p1 = positions[triangle.corners[1].position - 1];
+            const Vector4& p2 = positions[triangle.corners[2].position - 1];
+            ex0[count] = p1.x - p0.x;
+            ey0[count] = p1.y - p0.y;
+            ez0[count] = p1.z - p0.z;
+            ex1[count] = p2.x - p0.x;
+            ey1[count] = p2.y - p0.y;
+            ez1[count] = p2.z - p0.z;
+            batch[count++] = &triangle;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            nx[i] = ey0[i] * ez1[i] - ez0[i] * ey1[i];
+            ny[i] = ez0[i] * ex1[i] - ex0[i] * ez1[i];
+            nz[i] = ex0[i] * ey1[i] - ey0[i] * ex1[i];
+        }
+        for (size_t i = 0; i < count; ++i) {
+            for (const ObjCorner& corner : batch[i]->corners) {
+                if (corner.normal == 0) {
+                    Vector3& normal = normals[corner.position - 1];
+                    normal.x += nx[i];
+                    normal.y += ny[i];
+                    normal.z += nz[i];
+                }
+            }
+        }
+    }
+}
+
+// 足した法線を正規化する(足していない位置は上向きにする)
+void NormalizeNormals(Vector3* normals, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        Vector3& normal = normals[i];
+        float lengthSquared = normal.x * normal.x + normal.y * normal.y + normal.z * normal.z;
+        if (lengthSquared > 0.0f) {
+            float rcpLength = 1.0f / std::sqrt(lengthSquared);
+            normal = { normal.x * rcpLength, normal.y * rcpLength, normal.z * rcpLength };
+        } else {
+            normal = { 0.0f, 1.0f, 0.0f };
+        }
+    }
+}
+
+// 三角形の頂点を作る。uvが無ければ(0, 0)、法線が無ければgeneratedNormals(位置毎に作ったもの)を使う
+void MakeTriangle(const ObjTriangle& face, const Vector4* positions, const Vector2* texcoords, const Vector3* normals,
+    const Vector3* generatedNormals, VertexData (&triangle)[3])
+{
+    for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex) {
+        const ObjCorner& corner = face.corners[faceVertex];
+        Vector4 position = positions[corner.position - 1];
+        Vector2 texcoord = { 0.0f, 1.0f };
+        if (corner.texcoord != 0) {
+            texcoord = texcoords[corner.texcoord - 1];
+        }
+        Vector3 normal = corner.normal != 0 ? normals[corner.normal - 1] : generatedNormals[corner.position - 1];
+
+        // 位置の反転&法線の反転&左下原点
+        position.x *= -1.0f;
+        texcoord.y = 1.0f - texcoord.y;
+        normal.x *= -1.0f;
+
+        triangle[faceVertex] = { position, texcoord, normal };
+    }
+}
+
+// 頂点を逆順で登録することで、周り順を逆にする
+void AddTriangle(const VertexData (&triangle)[3], VertexWelder& welder, std::vector<uint32_t>& indices)
+{
+    indices.push_back(welder.Add(triangle[2]));
+    indices.push_back(welder.Add(triangle[1]));
+    indices.push_back(welder.Add(triangle[0]));
+}
+
+// usemtlの名前の番号。0はusemtlより前の面(名前は空)
+const uint32_t kNoMaterialName = 0;
+
+uint32_t FindOrAddName(std::vector<std::string_view>& names, std::string_view name)
+{
+    for (uint32_t i = 0; i < names.size(); ++i) {
+        if (names[i] == name) {
+            return i;
+        }
+    }
+    names.push_back(name);
+    return uint32_t(names.size() - 1);
+}
+
+uint32_t FindOrAddMaterial(std::vector<MaterialData>& materials, std::string_view name)
+{
+    for (uint32_t i = 0; i < materials.size(); ++i) {
+        if (materials[i].name == name) {
+            return i;
+        }
+    }
+    // ライブラリに無いものはテクスチャ無しのマテリアルにする
+    materials.push_back({ std::string(name), "" });
+    return uint32_t(materials.size() - 1);
+}
+
+ModelData ParseObjSerial(const char* data, size_t size, const std::string& directoryPath)
+{
+    ObjElementCounts counts = CountObjElements(data, size);
+    ModelData modelData;
+    std::vector<Vector4> positions;
+    std::vector<Vector2> texcoords;
+    std::vector<Vector3> normals;
+    std::vector<ObjTriangle> triangles;
+    std::vector<uint32_t> triangleNames;
+    std::vector<std::string_view> names = { "" };
+    std::vector<std::string_view> libraries;
+    positions.reserve(counts.positionCount);
+    texcoords.reserve(counts.texcoordCount);
+    normals.reserve(counts.normalCount);
+    triangles.reserve(counts.faceCount);
+    triangleNames.reserve(counts.faceCount);
+    uint32_t currentName = kNoMaterialName;
+    bool hasMissingNormal = false;
+
+    const char* end = data + size;
+    for (const char* line = data; line < end;) {
+        const char* lineEnd = FindLineEnd(line, end);
+        const char* p = line;
+        std::string_view identifier = ReadToken(p, lineEnd);
+
+        if (identifier == "v") {
+            positions.push_back(ReadPosition(p, lineEnd));
+        } else if (identifier == "vt") {
+            texcoords.push_back(ReadTexcoord(p, lineEnd));
+        } else if (identifier == "vn") {
+            normals.push_back(ReadNormal(p, lineEnd));
+        } else if (identifier == "f") {
+            ObjCorner corners[kMaxFaceCorners];
+            uint32_t cornerCount = 0;
+            bool isValid = ReadFace(p, lineEnd, { positions.size(), texcoords.size(), normals.size() }, corners, cornerCount);
+            assert(isValid); // 読めない面かindexが範囲外
+            if (isValid) {
+                ObjTriangle faceTriangles[kMaxFaceCorners - 2];
+                uint32_t triangleCount = TriangulateFace(corners, cornerCount, positions.data(), faceTriangles);
+                for (uint32_t t = 0; t < triangleCount; ++t) {
+                    triangles.push_back(faceTriangles[t]);
+                    triangleNames.push_back(currentName);
+                    hasMissingNormal = hasMissingNormal || HasMissingNormal(faceTriangles[t]);
+                }
+            }
+        } else if (identifier == "usemtl") {
+            currentName = FindOrAddName(names, ReadToken(p, lineEnd));
+        } else if (identifier == "mtllib") {
+            libraries.push_back(ReadToken(p, lineEnd));
+        }
+        // o(オブジェクト)とg(グループ)はマテリアル毎にまとめるので使わない
+        line = lineEnd + 1;
+    }
+
+    // 法線の無い頂点があれば位置毎に作る(全ての面を読んでからでないと作れない)
+    std::vector<Vector3> generatedNormals;
+    if (hasMissingNormal) {
+        generatedNormals.resize(positions.size(), { 0.0f, 0.0f, 0.0f });
+        AccumulateFaceNormals(triangles.data(), triangles.size(), positions.data(), generatedNormals.data());
+        NormalizeNormals(generatedNormals.data(), generatedNormals.size());
+    }
+
+    modelData.indices.reserve(triangles.size() * 3);
+    // 格子状のメッシュなら頂点は位置の数くらいになる
+    VertexWelder welder(modelData.vertices, positions.size());
+    for (const ObjTriangle& face : triangles) {
+        VertexData triangle[3];
+        MakeTriangle(face, positions.data(), texcoords.data(), normals.data(), generatedNormals.data(), triangle);
+        AddTriangle(triangle, welder, modelData.indices);
+    }
+    BuildObjSubmeshes(modelData, triangleNames, names, libraries, directoryPath);
+    return modelData;
+}
+
+// チャンク内の面で、前のチャンクのusemtlを引き継ぐもの
+const uint32_t kInheritedName = ~0u;
+
+// 並列で読むときのファイルの一部分(行の途中では切らない)
+struct ObjChunk {
+    const char* begin;
+    const char* end;
+    ObjElementCounts counts;
+    // 前のチャンクまでの数の合計
+    ObjElementOffsets offsets;
+    size_t indexOffset;
+    // チャンク内の行をそのまま読んだもの
+    std::vector<Vector4> positions;
+    std::vector<Vector2> texcoords;
+    std::vector<Vector3> normals;
+    std::vector<ObjCorner> corners; // 面の頂点を続けて並べたもの
+    std::vector<uint32_t> faceCornerCounts; // 面毎の頂点数
+    std::vector<uint32_t> faceNames; // 面毎のusemtlの名前の番号(チャンク内のnamesの番号)
+    std::vector<std::string_view> names; // チャンク内で出てきたusemtlの名前
+    uint32_t lastName; // チャンクの最後のusemtl(次のチャンクが引き継ぐ)
+    std::vector<std::string_view> libraries; // mtllib
+    // 三角形に分けたもの
+    std::vector<ObjTriangle> triangles;
+    std::vector<uint32_t> triangleNames; // 三角形毎のusemtlの名前の番号(全体のnamesの番号)
+    bool hasMissingNormal;
+    // チャンク内でまとめた頂点とindex
+    std::vector<VertexData> vertices;
+    std::vector<uint32_t> indices;
+    // チャンク内の頂点番号から全体の頂点番号への対応
+    std::vector<uint32_t> remap;
+};
+
+void ParseChunk(ObjChunk& chunk)
+{
+    chunk.positions.reserve(chunk.counts.positionCount);
+    chunk.texcoords.reserve(chunk.counts.texcoordCount);
+    chunk.normals.reserve(chunk.counts.normalCount);
+    chunk.corners.reserve(chunk.counts.faceCount * 3);
+    chunk.faceCornerCounts.reserve(chunk.counts.faceCount);
+    chunk.faceNames.reserve(chunk.counts.faceCount);
+    // チャンクの最初のusemtlより前の面は、前のチャンクの最後のusemtlを使う
+    uint32_t currentName = kInheritedName;
+
+    for (const char* line = chunk.begin; line < chunk.end;) {
+        const char* lineEnd = FindLineEnd(line, chunk.end);
+        const char* p = line;
+        std::string_view identifier = ReadToken(p, lineEnd);
+
+        if (identifier == "v") {
+            chunk.positions.push_back(ReadPosition(p, lineEnd));
+        } else if (identifier == "vt") {
+            chunk.texcoords.push_back(ReadTexcoord(p, lineEnd));
+        } else if (identifier == "vn") {
+            chunk.normals.push_back(ReadNormal(p, lineEnd));
+        } else if (identifier == "f") {
+            // 先に数えてあるので、前のチャンクの分を足せば1行ずつ読んだときと同じ数になる
+            ObjElementOffsets counts = { chunk.offsets.positionCount + chunk.positions.size(),
+                chunk.offsets.texcoordCount + chunk.texcoords.size(), chunk.offsets.normalCount + chunk.normals.size() };
+            ObjCorner corners[kMaxFaceCorners];
+            uint32_t cornerCount = 0;
+            bool isValid = ReadFace(p, lineEnd, counts, corners, cornerCount);
+            assert(isValid); // 読めない面かindexが範囲外
+            if (isValid) {
+                chunk.corners.insert(chunk.corners.end(), corners, corners + cornerCount);
+                chunk.faceCornerCounts.push_back(cornerCount);
+                chunk.faceNames.push_back(currentName);
+            }
+        } else if (identifier == "usemtl") {
+            currentName = FindOrAddName(chunk.names, ReadToken(p, lineEnd));
+        } else if (identifier == "mtllib") {
+            chunk.libraries.push_back(ReadToken(p, lineEnd));
+        }
+        line = lineEnd + 1;
+    }
+    chunk.lastName = currentName;
+    assert(chunk.positions.size() == chunk.counts.positionCount && chunk.texcoords.size() == chunk.counts.texcoordCount
+        && chunk.normals.size() == chunk.counts.normalCount);
+}
+
+// 1. チャンク毎にv/vt/vn/fを数え、累積和で全体の配列のどこに入るかを決める(負のindexを読むのに使う)
+// 2. チャンク毎にv/vt/vn/fを読む(並列)
+// 3. v/vt/vnを全体の配列にまとめる(並列)
+// 4. チャンク毎に面を三角形に分ける(並列)
+// 5. 法線の無い頂点があれば、チャンクの順に面の法線を足して作る
+// 6. チャンク毎に面の頂点を作ってまとめる(並列)
+// 7. チャンク内でまとめた頂点を前のチャンクから順に全体でまとめる
+// 8. indexを全体の番号に付け替える(並列)
+// 9. マテリアル毎に並べ直す
+// 7で頂点を追加する順番は1行ずつ読んだときに初めて出てくる順番と同じで、5で足す順番も同じなので、
+// 結果はParseObjSerialと一致する。
+ModelData ParseObjParallel(const char* data, size_t size, const std::string& directoryPath, uint32_t threadCount)
+{
+    // 速さがばらついても偏らないように、スレッド数より細かく分ける
+    uint32_t chunkCount = uint32_t(std::min<size_t>(threadCount * 4, size / kMinChunkSize + 1));
+    // 行の途中にならないように、区切りを次の行の先頭までずらす
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* end = data + size;
+    const char* begin = data;
+    for (uint32_t c = 0; c < chunkCount; ++c) {
+        const char* chunkEnd = end;
+        if (c + 1 < chunkCount) {
+            const char* lineEnd = FindLineEnd(std::max(begin, data + size * (c + 1) / chunkCount), end);
+            chunkEnd = lineEnd < end ? lineEnd + 1 : end;
+        }
+        chunks[c].begin = begin;
+        chunks[c].end = chunkEnd;
+        begin = chunkEnd;
+    }
+
+    ParallelFor(chunkCount, threadCount,
+        [&](uint32_t c) { chunks[c].counts = CountObjElements(chunks[c].begin, size_t(chunks[c].end - chunks[c].begin)); });
+    ObjElementOffsets counts = {};
+    for (ObjChunk& chunk : chunks) {
+        chunk.offsets = counts;
+        counts.positionCount += chunk.counts.positionCount;
+        counts.texcoordCount += chunk.counts.texcoordCount;
+        counts.normalCount += chunk.counts.normalCount;
+    }
+
+    ParallelFor(chunkCount, threadCount, [&](uint32_t c) { ParseChunk(chunks[c]); });
+
+    ModelData modelData;
+    std::vector<std::string_view> names = { "" };
+    std::vector<std::string_view> libraries;
+    uint32_t currentName = kNoMaterialName;
+    for (ObjChunk& chunk : chunks) {
+        libraries.insert(libraries.end(), chunk.libraries.begin(), chunk.libraries.end());
+        // usemtlの名前を全体の番号にする。チャンク内で出てきた順に番号を振るので、1行ずつ読んだときと同じ番号になる
+        std::vector<uint32_t> nameMap(chunk.names.size());
+        for (size_t name = 0; name < chunk.names.size(); ++name) {
+            nameMap[name] = FindOrAddName(names, chunk.names[name]);
+        }
+        for (uint32_t& name : chunk.faceNames) {
+            name = name == kInheritedName ? currentName : nameMap[name];
+        }
+        if (chunk.lastName != kInheritedName) {
+            currentName = nameMap[chunk.lastName];
+        }
+    }
+
+    std::vector<Vector4> positions(counts.positionCount);
+    std::vector<Vector2> texcoords(counts.texcoordCount);
+    std::vector<Vector3> normals(counts.normalCount);
+    ParallelFor(chunkCount, threadCount, [&](uint32_t c) {
+        ObjChunk& chunk = chunks[c];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.offsets.positionCount);
+        std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), texcoords.begin() + chunk.offsets.texcoordCount);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.offsets.normalCount);
+        chunk.positions = {};
+        chunk.texcoords = {};
+        chunk.normals = {};
+    });
+
+    ParallelFor(chunkCount, threadCount, [&](uint32_t c) {
+        ObjChunk& chunk = chunks[c];
+        chunk.triangles.reserve(chunk.faceCornerCounts.size());
+        chunk.triangleNames.reserve(chunk.faceCornerCounts.size());
+        chunk.hasMissingNormal = false;
+        const ObjCorner* corners = chunk.corners.data();
+        for (size_t f = 0; f < chunk.faceCornerCounts.size(); ++f) {
+            ObjTriangle faceTriangles[kMaxFaceCorners - 2];
+            uint32_t triangleCount = TriangulateFace(corners, chunk.faceCornerCounts[f], positions.data(), faceTriangles);
+            for (uint32_t t = 0; t < triangleCount; ++t) {
+                chunk.triangles.push_back(faceTriangles[t]);
+                chunk.triangleNames.push_back(chunk.faceNames[f]);
+                chunk.hasMissingNormal = chunk.hasMissingNormal || HasMissingNormal(faceTriangles[t]);
+            }
+            corners += chunk.faceCornerCounts[f];
+        }
+        chunk.corners = {};
+        chunk.faceCornerCounts = {};
+        chunk.faceNames = {};
+    });
+
+    std::vector<Vector3> generatedNormals;
+    for (const ObjChunk& chunk : chunks) {
+        if (chunk.hasMissingNormal) {
+            generatedNormals.resize(positions.size(), { 0.0f, 0.0f, 0.0f });
+            AccumulateFaceNormals(chunk.triangles.data(), chunk.triangles.size(), positions.data(), generatedNormals.data());
+        }
+    }
+    if (!generatedNormals.empty()) {
+        NormalizeNormals(generatedNormals.data(), generatedNormals.size());
+    }
+
+    ParallelFor(chunkCount, threadCount, [&](uint32_t c) {
+        ObjChunk& chunk = chunks[c];
+        chunk.indices.reserve(chunk.triangles.size() * 3);
+        VertexWelder welder(chunk.vertices, chunk.triangles.size());
+        for (const ObjTriangle& face : chunk.triangles) {
+            VertexData triangle[3];
+            MakeTriangle(face, positions.data(), texcoords.data(), normals.data(), generatedNormals.data(), triangle);
+            AddTriangle(triangle, welder, chunk.indices);
+        }
+        chunk.triangles = {};
+    });
+
+    size_t indexCount = 0;
+    size_t localVertexCount = 0;
+    for (ObjChunk& chunk : chunks) {
+        chunk.indexOffset = indexCount;
+        indexCount += chunk.indices.size();
+        localVertexCount += chunk.vertices.size();
+    }
+    VertexWelder welder(modelData.vertices, localVertexCount);
+    for (ObjChunk& chunk : chunks) {
+        chunk.remap.resize(chunk.vertices.size());
+        for (size_t i = 0; i < chunk.vertices.size(); ++i) {
+            chunk.remap[i] = welder.Add(chunk.vertices[i]);
+        }
+        chunk.vertices = {};
+    }
+
+    modelData.indices.resize(indexCount);
+    std::vector<uint32_t> triangleNames(indexCount / 3);
+    ParallelFor(chunkCount, threadCount, [&](uint32_t c) {
+        const ObjChunk& chunk = chunks[c];
+        uint32_t* indices = modelData.indices.data() + chunk.indexOffset;
+        for (size_t i = 0; i < chunk.indices.size(); ++i) {
+            indices[i] = chunk.remap[chunk.indices[i]];
+        }
+        std::copy(chunk.triangleNames.begin(), chunk.triangleNames.end(), triangleNames.begin() + chunk.indexOffset / 3);
+    });
+
+    BuildObjSubmeshes(modelData, triangleNames, names, libraries, directoryPath);
+    return modelData;
+}
+
+// StreamObjで読むブロックの最小の大きさ(1行はこれより短いこと)
+const size_t kMinStreamBlockSize = 64 * 1024;
+
+// ファイルを先頭からblockSizeのバッファで読み、行の途中で切らずにfunction(begin, end)へ渡していく。
+// functionがfalseを返すか、読めないか、1行がバッファに入りきらなければfalse
+template <typename Function>
+bool ReadObjBlocks(const std::string& path, size_t blockSize, Function&& function)
+{
+    std::ifstream file(path, std::ios_base::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::vector<char> buffer(blockSize);
+    size_t filled = 0;
+    bool isEnd = false;
+    while (true) {
+        if (!isEnd) {
+            file.read(buffer.data() + filled, std::streamsize(blockSize - filled));
+            filled += size_t(file.gcount());
+            isEnd = file.eof();
+            if (file.bad()) {
+                return false;
+            }
+        }
+        if (filled == 0) {
+            return true;
+        }
+        // 最後の改行まで(ファイルの終わりなら全部)
+        size_t blockEnd = filled;
+        if (!isEnd) {
+            const char* lastLineEnd = nullptr;
+            for (size_t i = filled; i > 0 && !lastLineEnd; --i) {
+                lastLineEnd = buffer[i - 1] == '\n' ? &buffer[i - 1] : nullptr;
+            }
+            if (!lastLineEnd) {
+                return false;
+            }
+            blockEnd = size_t(lastLineEnd - buffer.data()) + 1;
+        }
+        if (!function(static_cast<const char*>(buffer.data()), static_cast<const char*>(buffer.data() + blockEnd))) {
+            return false;
+        }
+        std::memmove(buffer.data(), buffer.data() + blockEnd, filled - blockEnd);
+        filled -= blockEnd;
+    }
+}
+
+uint32_t FindOrAddName(std::vector<std::string>& names, std::string_view name)
+{
+    for (uint32_t i = 0; i < names.size(); ++i) {
+        if (names[i] == name) {
+            return i;
+        }
+    }
+    names.emplace_back(name);
+    return uint32_t(names.size() - 1);
+}
+
+}
+
+std::vector<uint32_t> BuildObjMaterials(ModelData& modelData, const std::vector<uint32_t>& nameTriangleCounts, const std::vector<std::string_view>& names,
+    const std::vector<std::string_view>& libraries, const std::string& directoryPath)
+{
+    for (std::string_view library : libraries) {
+        for (MaterialData& material : LoadMaterialTemplateFile(directoryPath, std::string(library))) {
+            // 同じ名前は先に読んだ方を使う
+            bool isDuplicate = false;
+            for (const MaterialData& other : modelData.materials) {
+                isDuplicate = isDuplicate || other.name == material.name;
+            }
+            if (!isDuplicate) {
+                modelData.materials.push_back(std::move(material));
+            }
+        }
+    }
+
+    // 使われている名前だけマテリアルの番号にする
+    std::vector<uint32_t> nameMaterials(names.size(), 0);
+    for (uint32_t name = 0; name < names.size(); ++name) {
+        if (nameTriangleCounts[name] != 0) {
+            nameMaterials[name] = FindOrAddMaterial(modelData.materials, names[name]);
+        }
+    }
+
+    // 数えて累積和を取り、マテリアルの番号順にサブメッシュを並べる
+    std::vector<uint32_t> materialOffsets(modelData.materials.size() + 1, 0);
+    for (uint32_t name = 0; name < names.size(); ++name) {
+        materialOffsets[nameMaterials[name] + 1] += nameTriangleCounts[name];
+    }
+    for (size_t material = 0; material < modelData.materials.size(); ++material) {
+        if (materialOffsets[material + 1] != 0) {
+            modelData.submeshes.push_back({ materialOffsets[material] * 3, materialOffsets[material + 1] * 3, uint32_t(material) });
+        }
+        materialOffsets[material + 1] += materialOffsets[material];
+    }
+    return nameMaterials;
+}
+
+void BuildObjSubmeshes(ModelData& modelData, const std::vector<uint32_t>& triangleNames, const std::vector<std::string_view>& names,
+    const std::vector<std::string_view>& libraries, const std::string& directoryPath)
+{
+    std::vector<uint32_t> nameTriangleCounts(names.size(), 0);
+    for (uint32_t name : triangleNames) {
+        ++nameTriangleCounts[name];
+    }
+    std::vector<uint32_t> nameMaterials = BuildObjMaterials(modelData, nameTriangleCounts, names, libraries, directoryPath);
+    if (modelData.submeshes.size() <= 1) {
+        return; // 1つなら並べ直さなくてよい
+    }
+    // サブメッシュの先頭から、同じマテリアルの中ではファイルの順に並べ直す
+    std::vector<uint32_t> materialCursors(modelData.materials.size(), 0);
+    for (const Submesh& submesh : modelData.submeshes) {
+        materialCursors[submesh.materialIndex] = submesh.indexOffset / 3;
+    }
+    std::vector<uint32_t> sorted(modelData.indices.size());
+    for (size_t triangle = 0; triangle < triangleNames.size(); ++triangle) {
+        uint32_t destination = materialCursors[nameMaterials[triangleNames[triangle]]]++;
+        std::copy_n(modelData.indices.begin() + triangle * 3, 3, sorted.begin() + destination * 3);
+    }
+    modelData.indices = std::move(sorted);
+}
+
+ObjElementCounts CountObjElements(const char* data, size_t size)
+{
+    ObjElementCounts counts = {};
+    const char* end = data + size;
+    for (const char* line = data; line < end;) {
+        const char* lineEnd = FindLineEnd(line, end);
+        const char* p = SkipSpaces(line, lineEnd);
+        // 識別子の次が空白か行末かで見分ける(ReadTokenと同じ区切り方にする)
+        size_t length = size_t(lineEnd - p);
+        if (length >= 1 && (length == 1 || IsSpace(p[1]))) {
+            counts.positionCount += p[0] == 'v';
+            counts.faceCount += p[0] == 'f';
+        } else if (length >= 2 && p[0] == 'v' && (length == 2 || IsSpace(p[2]))) {
+            counts.texcoordCount += p[1] == 't';
+            counts.normalCount += p[1] == 'n';
+        }
+        line = lineEnd + 1;
+    }
+    return counts;
+}
+
+std::vector<std::string> FindObjMaterialLibraries(const char* data, size_t size)
+{
+    std::vector<std::string> filenames;
+    const char* end = data + size;
+    for (const char* line = data; line < end;) {
+        const char* lineEnd = FindLineEnd(line, end);
+        const char* p = line;
+        if (ReadToken(p, lineEnd) == "mtllib") {
+            filenames.emplace_back(ReadToken(p, lineEnd));
+        }
+        line = lineEnd + 1;
+    }
+    return filenames;
+}
+
+ModelData ParseObj(const char* data, size_t size, const std::string& directoryPath, uint32_t threadCount)
+{
+    // 小さいファイルはスレッドを作る方が遅い
+    size_t maxChunkCount = size / kMinChunkSize + 1;
+    threadCount = uint32_t(std::min<size_t>(GetWorkerThreadCount(threadCount), maxChunkCount));
+    if (threadCount <= 1) {
+        return ParseObjSerial(data, size, directoryPath);
+    }
+    return ParseObjParallel(data, size, directoryPath, threadCount);
+}
+
+bool StreamObj(const std::string& directoryPath, const std::string& filename, const ObjStreamOptions& options, const ObjStreamOutput& output,
+    ObjStreamInfo& info)
+{
+    info = {};
+    std::string path = directoryPath + "/" + filename;
+    std::string temporaryDirectory = options.temporaryDirectory.empty() ? directoryPath : options.temporaryDirectory;
+    // 予算の1/4を読むバッファに、半分を頂点をまとめる表に(1頂点あたり頂点36バイト+表が最大16バイト)、残りを一時ファイルのページに使う
+    size_t blockSize = std::max(options.memoryBudget / 4, kMinStreamBlockSize);
+    size_t weldWindowSize = std::max<size_t>(options.memoryBudget / 2 / (sizeof(VertexData) + 16), 1024);
+
+    // 1回目: 数える
+    ObjElementCounts counts = {};
+    bool isRead = ReadObjBlocks(path, blockSize, [&](const char* begin, const char* end) {
+        ObjElementCounts blockCounts = CountObjElements(begin, size_t(end - begin));
+        counts.positionCount += blockCounts.positionCount;
+        counts.texcoordCount += blockCounts.texcoordCount;
+        counts.normalCount += blockCounts.normalCount;
+        counts.faceCount += blockCounts.faceCount;
+        return true;
+    });
+    if (!isRead) {
+        return false;
+    }
+    TemporaryMappedFile positionFile;
+    TemporaryMappedFile texcoordFile;
+    TemporaryMappedFile normalFile;
+    TemporaryMappedFile generatedNormalFile; // 法線の無い頂点が出てきたら作る
+    if (!positionFile.Create(temporaryDirectory, sizeof(Vector4) * counts.positionCount)
+        || !texcoordFile.Create(temporaryDirectory, sizeof(Vector2) * counts.texcoordCount)
+        || !normalFile.Create(temporaryDirectory, sizeof(Vector3) * counts.normalCount)) {
+        return false;
+    }
+    Vector4* positions = reinterpret_cast<Vector4*>(positionFile.GetData());
+    Vector2* texcoords = reinterpret_cast<Vector2*>(texcoordFile.GetData());
+    Vector3* normals = reinterpret_cast<Vector3*>(normalFile.GetData());
+    Vector3* generatedNormals = nullptr;
+    auto releaseTemporaryFiles = [&]() {
+        positionFile.Release();
+        texcoordFile.Release();
+        normalFile.Release();
+        generatedNormalFile.Release();
+    };
+
+    // 2回目: v/vt/vnを一時ファイルに置き、三角形をusemtl毎に数える
+    std::vector<std::string> names = { "" };
+    std::vector<uint32_t> nameTriangleCounts = { 0 };
+    uint32_t currentName = kNoMaterialName;
+    ObjElementOffsets offsets = {};
+    isRead = ReadObjBlocks(path, blockSize, [&](const char* begin, const char* end) {
+        for (const char* line = begin; line < end;) {
+            const char* lineEnd = FindLineEnd(line, end);
+            const char* p = line;
+            std::string_view identifier = ReadToken(p, lineEnd);
+
+            if (identifier == "v") {
+                if (offsets.positionCount == counts.positionCount) {
+                    return false; // 1回目から変わった
+                }
+                positions[offsets.positionCount++] = ReadPosition(p, lineEnd);
+            } else if (identifier == "vt") {
+                if (offsets.texcoordCount == counts.texcoordCount) {
+                    return false;
+                }
+                texcoords[offsets.texcoordCount++] = ReadTexcoord(p, lineEnd);
+            } else if (identifier == "vn") {
+                if (offsets.normalCount == counts.normalCount) {
+                    return false;
+                }
+                normals[offsets.normalCount++] = ReadNormal(p, lineEnd);
+            } else if (identifier == "f") {
+                ObjCorner corners[kMaxFaceCorners];
+                uint32_t cornerCount = 0;
+                bool isValid = ReadFace(p, lineEnd, offsets, corners, cornerCount);
+                assert(isValid); // 読めない面かindexが範囲外
+                if (isValid) {
+                    ObjTriangle faceTriangles[kMaxFaceCorners - 2];
+                    uint32_t triangleCount = TriangulateFace(corners, cornerCount, positions, faceTriangles);
+                    for (uint32_t t = 0; t < triangleCount; ++t) {
+                        if (HasMissingNormal(faceTriangles[t]) && !generatedNormals) {
+                            if (!generatedNormalFile.Create(temporaryDirectory, sizeof(Vector3) * counts.positionCount)) {
+                                return false;
+                            }
+                            generatedNormals = reinterpret_cast<Vector3*>(generatedNormalFile.GetData());
+                        }
+                        // ParseObjSerialと同じ順で足す
+                        if (generatedNormals) {
+                            AccumulateFaceNormals(&faceTriangles[t], 1, positions, generatedNormals);
+                        }
+                    }
+                    nameTriangleCounts[currentName] += triangleCount;
+                    info.triangleCount += triangleCount;
+                }
+            } else if (identifier == "usemtl") {
+                currentName = FindOrAddName(names, ReadToken(p, lineEnd));
+                nameTriangleCounts.resize(names.size(), 0);
+            } else if (identifier == "mtllib") {
+                info.materialLibraries.emplace_back(ReadToken(p, lineEnd));
+            }
+            line = lineEnd + 1;
+        }
+        releaseTemporaryFiles();
+        return true;
+    });
+    // サブメッシュのindexOffsetは32bit
+    if (!isRead || info.triangleCount * 3 > UINT32_MAX) {
+        return false;
+    }
+    if (generatedNormals) {
+        NormalizeNormals(generatedNormals, counts.positionCount);
+        generatedNormalFile.Release();
+    }
+
+    ModelData modelData;
+    std::vector<std::string_view> nameViews(names.begin(), names.end());
+    std::vector<std::string_view> libraryViews(info.materialLibraries.begin(), info.materialLibraries.end());
+    std::vector<uint32_t> nameMaterials = BuildObjMaterials(modelData, nameTriangleCounts, nameViews, libraryViews, directoryPath);
+    std::vector<uint32_t> materialCursors(modelData.materials.size(), 0);
+    for (const Submesh& submesh : modelData.submeshes) {
+        materialCursors[submesh.materialIndex] = submesh.indexOffset / 3;
+    }
+
+    // 3回目: 頂点を作ってまとめ、indexをマテリアル毎の位置に置く
+    TemporaryMappedFile indexFile;
+    if (!indexFile.Create(temporaryDirectory, sizeof(uint32_t) * 3 * info.triangleCount)) {
+        return false;
+    }
+    uint32_t* indices = reinterpret_cast<uint32_t*>(indexFile.GetData());
+    std::vector<VertexData> window;
+    window.reserve(weldWindowSize);
+    VertexWelder welder(window, weldWindowSize);
+    size_t windowBase = 0; // windowの先頭の頂点の番号
+    info.weldWindowCount = 1;
+    auto flushWindow = [&]() {
+        if (!window.empty() && !output.writeVertices(window.data(), window.size())) {
+            return false;
+        }
+        windowBase += window.size();
+        welder.Clear();
+        return true;
+    };
+    currentName = kNoMaterialName;
+    offsets = {};
+    size_t writtenTriangleCount = 0;
+    isRead = ReadObjBlocks(path, blockSize, [&](const char* begin, const char* end) {
+        for (const char* line = begin; line < end;) {
+            const char* lineEnd = FindLineEnd(line, end);
+            const char* p = line;
+            std::string_view identifier = ReadToken(p, lineEnd);
+
+            // v/vt/vnは数えるだけ(面のindexを確かめるのに使う)。2回目から変わっていたらやめる
+            if (identifier == "v") {
+                if (++offsets.positionCount > counts.positionCount) {
+                    return false;
+                }
+            } else if (identifier == "vt") {
+                if (++offsets.texcoordCount > counts.texcoordCount) {
+                    return false;
+                }
+            } else if (identifier == "vn") {
+                if (++offsets.normalCount > counts.normalCount) {
+                    return false;
+                }
+            } else if (identifier == "f") {
+                ObjCorner corners[kMaxFaceCorners];
+                uint32_t cornerCount = 0;
+                if (ReadFace(p, lineEnd, offsets, corners, cornerCount)) {
+                    ObjTriangle faceTriangles[kMaxFaceCorners - 2];
+                    uint32_t triangleCount = TriangulateFace(corners, cornerCount, positions, faceTriangles);
+                    writtenTriangleCount += triangleCount;
+                    if (writtenTriangleCount > info.triangleCount) {
+                        return false;
+                    }
+                    uint32_t material = nameMaterials[currentName];
+                    for (uint32_t t = 0; t < triangleCount; ++t) {
+                        if (window.size() + 3 > weldWindowSize) {
+                            if (!flushWindow()) {
+                                return false;
+                            }
+                            ++info.weldWindowCount;
+                        }
+                        VertexData triangle[3];
+                        MakeTriangle(faceTriangles[t], positions, texcoords, normals, generatedNormals, triangle);
+                        // AddTriangleと同じく逆順で登録する
+                        uint32_t* destination = indices + size_t(materialCursors[material]++) * 3;
+                        destination[0] = uint32_t(windowBase + welder.Add(triangle[2]));
+                        destination[1] = uint32_t(windowBase + welder.Add(triangle[1]));
+                        destination[2] = uint32_t(windowBase + welder.Add(triangle[0]));
+                    }
+                }
+            } else if (identifier == "usemtl") {
+                currentName = FindOrAddName(names, ReadToken(p, lineEnd));
+                if (currentName >= nameMaterials.size()) {
+                    return false;
+                }
+            }
+            line = lineEnd + 1;
+        }
+        // 頂点の番号は32bit
+        if (windowBase + window.size() > UINT32_MAX) {
+            return false;
+        }
+        releaseTemporaryFiles();
+        indexFile.Release();
+        return true;
+    });
+    if (!isRead || writtenTriangleCount != info.triangleCount || !flushWindow()) {
+        return false;
+    }
+    info.vertexCount = windowBase;
+
+    // indexを先頭から読むバッファと同じ大きさずつ渡す
+    size_t indexCount = info.triangleCount * 3;
+    size_t indexChunkSize = blockSize / sizeof(uint32_t);
+    for (size_t offset = 0; offset < indexCount; offset += indexChunkSize) {
+        if (!output.writeIndices(indices + offset, std::min(indexChunkSize, indexCount - offset))) {
+            return false;
+        }
+        indexFile.Release();
+    }
+
+    info.materials = std::move(modelData.materials);
+    info.submeshes = std::move(modelData.submeshes);
+    info.positionCount = counts.positionCount;
+    info.texcoordCount = counts.texcoordCount;
+    info.normalCount = counts.normalCount;
+    info.temporaryBytes = positionFile.GetSize() + texcoordFile.GetSize() + normalFile.GetSize() + generatedNormalFile.GetSize() + indexFile.GetSize();
+    return true;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "Model.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// メモリ上のobjを読む
+//
+// 1行ずつstd::from_charsで数値を取り出し、行毎の文字列やストリームは作らない。
+// 先にv/vt/vn/fの行を数えて、配列は1回だけreserveする。
+// 面は v, v/vt, v//vn, v/vt/vn のどれでもよく、負のindex(後ろから数える)も読める。
+// 四角形以上の面は耳を切り取って三角形に分ける(1行の頂点はスタック上の配列に読むので確保はしない)。
+// uvの無い頂点は(0, 0)、法線の無い頂点は位置を共有する面の法線を足して作ったものにする。
+// 頂点はVertexWelderでまとめる。三角形で 位置/uv/法線 が全てある面なら、indicesの順に頂点を並べ直すと
+// LoadObjFileStream(istringstream版)の結果と完全に一致する。
+// threadCountが2以上なら行単位でファイルを分けて並列に読む。結果は1スレッドで読んだものと同じになる。
+// 三角形はusemtlのマテリアル毎にまとめて並べ直し、マテリアル1つにつきサブメッシュを1つ作る
+// (描画するときにテクスチャを切り替える回数がマテリアルの数で済む)。
+
+// 行の数(fは三角形に分ける前の面の数)
+struct ObjElementCounts {
+    size_t positionCount; // v
+    size_t texcoordCount; // vt
+    size_t normalCount; // vn
+    size_t faceCount; // f
+};
+ObjElementCounts CountObjElements(const char* data, size_t size);
+
+// mtllibで指定されたファイル名(出てくる順)
+std::vector<std::string> FindObjMaterialLibraries(const char* data, size_t size);
+
+// mtllibのファイルを全て読み、usemtlの名前毎の三角形の数からマテリアルとサブメッシュを作る
+// (namesはBuildObjSubmeshesと同じ)。戻り値は名前毎のマテリアルの番号
+std::vector<uint32_t> BuildObjMaterials(ModelData& modelData, const std::vector<uint32_t>& nameTriangleCounts, const std::vector<std::string_view>& names,
+    const std::vector<std::string_view>& libraries, const std::string& directoryPath);
+
+// mtllibのファイルを全て読み、三角形をマテリアル毎にまとめてサブメッシュを作る
+// triangleNamesは三角形毎のusemtlの名前の番号(namesの番号。names[0]はusemtlより前の面で空にしておく)。
+// マテリアルの番号順に並べ、同じマテリアルの中ではファイルの順番のままにする。
+// mtlに無い名前とusemtlの無い面には、テクスチャの無いマテリアルを足す
+void BuildObjSubmeshes(ModelData& modelData, const std::vector<uint32_t>& triangleNames, const std::vector<std::string_view>& names,
+    const std::vector<std::string_view>& libraries, const std::string& directoryPath);
+
+// mtllibはdirectoryPathから読む。threadCountが0ならCPUのスレッド数を使う
+ModelData ParseObj(const char* data, size_t size, const std::string& directoryPath, uint32_t threadCount = 1);
+
+// 決まった量のメモリでobjを読む(StreamObj)
+//
+// ファイル全体もModelData全体もメモリに置かずに、先頭から決まった大きさのブロックずつ3回読む。
+//   1回目: v/vt/vn/fの行を数える
+//   2回目: v/vt/vnを一時ファイル(TemporaryMappedFile)に書き、面を三角形に分けてusemtl毎に数える
+//          (法線の無い頂点があれば、位置毎の法線も一時ファイルの上で足していく)
+//   3回目: 面の頂点を作ってまとめ、頂点は決まった数がたまる毎に、indexはマテリアル毎の位置に一時ファイルへ書く。
+//          最後にindexを先頭から順に渡す
+// 頂点は最近の決まった数の中でだけまとめるので、まとめきれなかった同じ頂点が残ることがある
+// (まとめる数に収まるファイルなら、ParseObjと頂点・index・サブメッシュが完全に一致する)。
+// 一時ファイルのページはブロック毎に手放す。面が近くの頂点を指していれば(普通の書き出しツールの出力)、
+// 使うメモリはmemoryBudgetくらいで収まる。
+struct ObjStreamOptions {
+    size_t memoryBudget = 64 * 1024 * 1024; // 読むバッファ・頂点をまとめる表・一時ファイルを触る量の合計の目安
+    std::string temporaryDirectory; // 一時ファイルを置く場所(空ならobjと同じディレクトリ)
+};
+// 読んだものを受け取る所。falseを返すと読むのをやめる
+struct ObjStreamOutput {
+    std::function<bool(const VertexData* vertices, size_t count)> writeVertices; // 頂点を番号の順に少しずつ
+    std::function<bool(const uint32_t* indices, size_t count)> writeIndices; // 頂点を全て渡した後、サブメッシュの順に少しずつ
+};
+// 読み終わったときの情報
+struct ObjStreamInfo {
+    std::vector<MaterialData> materials;
+    std::vector<Submesh> submeshes;
+    std::vector<std::string> materialLibraries; // mtllibのファイル名(出てくる順)
+    size_t positionCount;
+    size_t texcoordCount;
+    size_t normalCount;
+    size_t triangleCount;
+    size_t vertexCount; // 渡した頂点の数
+    uint32_t weldWindowCount; // 頂点をまとめる表を作り直した回数+1(1なら全体でまとめたのと同じ)
+    size_t temporaryBytes; // 一時ファイルの大きさの合計
+};
+// 開けない・読めない・indexが32bitに収まらない・outputがfalseを返したときはfalse
+bool StreamObj(const std::string& directoryPath, const std::string& filename, const ObjStreamOptions& options, const ObjStreamOutput& output,
+    ObjStreamInfo& info);
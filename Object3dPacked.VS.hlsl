@@ -0,0 +1,45 @@
+#include "object3d.hlsli"
+
+// PackedVertexData用(Object3d.VS.hlslと同じ出力)
+// 位置はAABBの中の0〜1なので、AABBに戻す行列をWVPとWorldに掛けておく
+
+struct TransformationMatrix
+{
+    float32_t4x4 WVP;
+    float32_t4x4 World;
+    float32_t4x4 worldInverseTranspose;
+};
+
+ConstantBuffer<TransformationMatrix> gTransformationMatrix : register(b0);
+
+struct VertexShaderInput
+{
+    float32_t4 position : POSITION0; // R16G16B16A16_UNORM (wは1)
+    float32_t2 texcoord : TEXCOORD0; // R16G16_FLOAT
+    float32_t2 normal : NORMAL0; // R16G16_SNORM (八面体)
+};
+
+// 八面体に写した法線を戻す(PackedVertex.cppのDecodeOctahedralと同じ)
+float32_t3 DecodeOctahedral(float32_t2 encoded)
+{
+    float32_t3 normal = float32_t3(encoded.x, encoded.y, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float32_t t = saturate(-normal.z);
+    normal.x += normal.x >= 0.0f ? -t : t;
+    normal.y += normal.y >= 0.0f ? -t : t;
+    return normalize(normal);
+}
+
+VertexShaderOutput main(VertexShaderInput input)
+{
+    VertexShaderOutput output;
+    // WVP
+    output.position = mul(input.position, gTransformationMatrix.WVP);
+    output.texcoord = input.texcoord;
+
+    float32_t3 normal = DecodeOctahedral(input.normal);
+    output.normal = normalize(mul(normal, (float32_t3x3) gTransformationMatrix.worldInverseTranspose));
+
+    output.worldPosition = mul(input.position, gTransformationMatrix.World).xyz;
+
+    return output;
+}
@@ -0,0 +1,172 @@
+#include "PackedVertex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+namespace {
+
+uint32_t FloatBits(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float BitsToFloat(uint32_t bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// 0〜1をUNORM16に
+uint16_t QuantizeUnorm16(float value) { return uint16_t(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f); }
+// -1〜1をSNORM16に
+int16_t QuantizeSnorm16(float value) { return int16_t(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f)); }
+
+// AABBの1軸を0〜1にするときの掛ける数(幅が0なら0にする)
+float InverseExtent(float min, float max) { return max > min ? 1.0f / (max - min) : 0.0f; }
+
+}
+
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits = FloatBits(value);
+    uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+    uint32_t absolute = bits & 0x7FFFFFFF;
+    if (absolute >= 0x7F800000) {
+        // 無限大とNaN(NaNは仮数の上位を残して静かなNaNにする)
+        return uint16_t(sign | 0x7C00 | (absolute > 0x7F800000 ? 0x200 | ((absolute >> 13) & 0x3FF) : 0));
+    }
+    if (absolute >= 0x477FF000) {
+        return uint16_t(sign | 0x7C00); // 65520以上は丸めると範囲外
+    }
+    if (absolute < 0x38800000) {
+        // 非正規化数。2^-24を単位にした整数へ丸める
+        float scaled = BitsToFloat(absolute) * 16777216.0f;
+        return uint16_t(sign | uint16_t(std::nearbyint(scaled)));
+    }
+    // 指数を付け替え、切り捨てる13bitで最近接偶数に丸める(繰り上がりは指数に入る)
+    uint32_t half = (absolute - 0x38000000) >> 13;
+    uint32_t rest = absolute & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+        ++half;
+    }
+    return uint16_t(sign | half);
+}
+
+float HalfToFloat(uint16_t value)
+{
+    uint32_t sign = uint32_t(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    if (exponent == 0) {
+        float magnitude = float(mantissa) / 16777216.0f;
+        return sign ? -magnitude : magnitude;
+    }
+    if (exponent == 0x1F) {
+        return BitsToFloat(sign | 0x7F800000 | (mantissa << 13));
+    }
+    return BitsToFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+void EncodeOctahedral(const Vector3& normal, int16_t (&encoded)[2])
+{
+    float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (sum == 0.0f) {
+        encoded[0] = 0;
+        encoded[1] = 0;
+        return;
+    }
+    float x = normal.x / sum;
+    float y = normal.y / sum;
+    // 下半分は対角線で折り返して外側の三角形に写す
+    if (normal.z < 0.0f) {
+        float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    encoded[0] = QuantizeSnorm16(x);
+    encoded[1] = QuantizeSnorm16(y);
+}
+
+Vector3 DecodeOctahedral(const int16_t (&encoded)[2])
+{
+    // SNORMの-32768は-1として読まれる
+    float x = std::max(float(encoded[0]) / 32767.0f, -1.0f);
+    float y = std::max(float(encoded[1]) / 32767.0f, -1.0f);
+    Vector3 normal = { x, y, 1.0f - std::abs(x) - std::abs(y) };
+    float t = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -t : t;
+    normal.y += normal.y >= 0.0f ? -t : t;
+    float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+    return { normal.x / length, normal.y / length, normal.z / length };
+}
+
+PackedVertexData PackVertex(const VertexData& vertex, const AABB& bounds)
+{
+    PackedVertexData packed;
+    packed.position[0] = QuantizeUnorm16((vertex.position.x - bounds.min.x) * InverseExtent(bounds.min.x, bounds.max.x));
+    packed.position[1] = QuantizeUnorm16((vertex.position.y - bounds.min.y) * InverseExtent(bounds.min.y, bounds.max.y));
+    packed.position[2] = QuantizeUnorm16((vertex.position.z - bounds.min.z) * InverseExtent(bounds.min.z, bounds.max.z));
+    packed.position[3] = 0xFFFF; // w = 1
+    packed.texcoord[0] = FloatToHalf(vertex.texcoord.x);
+    packed.texcoord[1] = FloatToHalf(vertex.texcoord.y);
+    EncodeOctahedral(vertex.normal, packed.normal);
+    return packed;
+}
+
+VertexData UnpackVertex(const PackedVertexData& vertex, const AABB& bounds)
+{
+    VertexData unpacked;
+    unpacked.position.x = bounds.min.x + float(vertex.position[0]) / 65535.0f * (bounds.max.x - bounds.min.x);
+    unpacked.position.y = bounds.min.y + float(vertex.position[1]) / 65535.0f * (bounds.max.y - bounds.min.y);
+    unpacked.position.z = bounds.min.z + float(vertex.position[2]) / 65535.0f * (bounds.max.z - bounds.min.z);
+    unpacked.position.w = 1.0f;
+    unpacked.texcoord.x = HalfToFloat(vertex.texcoord[0]);
+    unpacked.texcoord.y = HalfToFloat(vertex.texcoord[1]);
+    unpacked.normal = DecodeOctahedral(vertex.normal);
+    return unpacked;
+}
+
+std::vector<PackedVertexData> PackVertices(const std::vector<VertexData>& vertices, const AABB& bounds)
+{
+    std::vector<PackedVertexData> packed(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        packed[i] = PackVertex(vertices[i], bounds);
+    }
+    return packed;
+}
+
+Matrix4x4 MakeDequantizeMatrix(const AABB& bounds)
+{
+    Vector3 extent = { bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y, bounds.max.z - bounds.min.z };
+    return Multiply(MakeScaleMatrix(extent), MakeTranslateMatrix(bounds.min));
+}
+
+QuantizationError MeasureQuantizationError(const std::vector<VertexData>& vertices, const AABB& bounds)
+{
+    QuantizationError error = {};
+    Vector3 extent = { bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y, bounds.max.z - bounds.min.z };
+    auto relative = [](float difference, float scale) { return scale > 0.0f ? difference / scale : difference; };
+    for (const VertexData& vertex : vertices) {
+        VertexData unpacked = UnpackVertex(PackVertex(vertex, bounds), bounds);
+        error.position = std::max({ error.position, relative(std::abs(unpacked.position.x - vertex.position.x), extent.x),
+            relative(std::abs(unpacked.position.y - vertex.position.y), extent.y), relative(std::abs(unpacked.position.z - vertex.position.z), extent.z) });
+        error.texcoord = std::max({ error.texcoord, std::abs(unpacked.texcoord.x - vertex.texcoord.x) / std::max(1.0f, std::abs(vertex.texcoord.x)),
+            std::abs(unpacked.texcoord.y - vertex.texcoord.y) / std::max(1.0f, std::abs(vertex.texcoord.y)) });
+        float length = std::sqrt(vertex.normal.x * vertex.normal.x + vertex.normal.y * vertex.normal.y + vertex.normal.z * vertex.normal.z);
+        if (length > 0.0f) {
+            float cosine = (unpacked.normal.x * vertex.normal.x + unpacked.normal.y * vertex.normal.y + unpacked.normal.z * vertex.normal.z) / length;
+            // acosは1の近くで精度が落ちるので、外積の大きさとのatan2で角度を出す
+            Vector3 cross = { unpacked.normal.y * vertex.normal.z - unpacked.normal.z * vertex.normal.y,
+                unpacked.normal.z * vertex.normal.x - unpacked.normal.x * vertex.normal.z,
+                unpacked.normal.x * vertex.normal.y - unpacked.normal.y * vertex.normal.x };
+            float sine = std::sqrt(cross.x * cross.x + cross.y * cross.y + cross.z * cross.z) / length;
+            error.normalDegrees = std::max(error.normalDegrees, std::atan2(sine, cosine) * 180.0f / std::numbers::pi_v<float>);
+        }
+    }
+    return error;
+}
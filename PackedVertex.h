@@ -0,0 +1,50 @@
+#pragma once
+#include "Model.h"
+#include "MyMath.h"
+#include <cstdint>
+#include <vector>
+
+// 詰めた頂点形式(16バイト。VertexDataは36バイト)
+//
+// 位置: メッシュのAABBの中での位置を16bitのUNORMにする。wは65535にしておき、GPUでは1.0として読まれる。
+//       AABBへ戻す拡大と移動はMakeDequantizeMatrixの行列にしてワールド行列に掛けるので、シェーダーでは何もしない
+// uv:   半精度(R16G16_FLOAT)
+// 法線: 八面体に写して2つの16bit SNORMにする。シェーダーのDecodeOctahedralで戻す
+//
+// 入力レイアウトは POSITION R16G16B16A16_UNORM / TEXCOORD R16G16_FLOAT / NORMAL R16G16_SNORM (Object3dPacked.VS.hlsl)
+struct PackedVertexData {
+    uint16_t position[4];
+    uint16_t texcoord[2];
+    int16_t normal[2];
+};
+static_assert(sizeof(PackedVertexData) == 16);
+
+// 変換で出る誤差の上限(EncodeやPackVertexの結果がこれ以内に収まる)
+// 位置はAABBの各辺の長さに掛ける(丸めの半目盛りに、戻すときのfloatの計算誤差を少し足す)。
+// uvは値の大きさに掛ける(半精度の仮数は10bit)
+const float kPositionQuantizationError = 0.52f / 65535.0f;
+const float kTexcoordRelativeError = 1.0f / 2048.0f;
+const float kNormalQuantizationErrorDegrees = 0.01f;
+
+// 半精度(IEEE 754 binary16)との変換。最近接偶数丸め。範囲外は無限大、非正規化数も扱う
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+
+// 単位ベクトルを八面体に写して16bit SNORMにする
+void EncodeOctahedral(const Vector3& normal, int16_t (&encoded)[2]);
+Vector3 DecodeOctahedral(const int16_t (&encoded)[2]);
+
+PackedVertexData PackVertex(const VertexData& vertex, const AABB& bounds);
+VertexData UnpackVertex(const PackedVertexData& vertex, const AABB& bounds);
+std::vector<PackedVertexData> PackVertices(const std::vector<VertexData>& vertices, const AABB& bounds);
+
+// 詰めた位置(0〜1)をAABBの中の位置に戻す行列。ワールド行列の前に掛ける
+Matrix4x4 MakeDequantizeMatrix(const AABB& bounds);
+
+// 詰めて戻したときの最大誤差
+struct QuantizationError {
+    float position; // 各軸の差の最大(AABBの辺の長さとの比)
+    float texcoord; // 差の最大をmax(1, |uv|)で割ったもの
+    float normalDegrees; // 向きの差の最大
+};
+QuantizationError MeasureQuantizationError(const std::vector<VertexData>& vertices, const AABB& bounds);
@@ -0,0 +1,156 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// 簡単な並列実行
+//
+// ParallelForは呼ぶたびにスレッドを作って終わったら待つだけなので、1回の処理がある程度重いところで使う。
+// 毎フレーム呼ぶところでは、スレッドを作っておくThreadPoolを使う。
+
+// 使うスレッドの数。0ならCPUのスレッド数にする
+inline uint32_t GetWorkerThreadCount(uint32_t requestedCount)
+{
+    if (requestedCount != 0) {
+        return requestedCount;
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// function(i)を i = 0..count-1 について呼ぶ。どのiをどのスレッドが受け持つかは決まっていない。
+// 呼び出したスレッドも処理に加わる
+template <typename Function>
+void ParallelFor(uint32_t count, uint32_t threadCount, Function&& function)
+{
+    threadCount = std::min(threadCount, count);
+    if (threadCount <= 1) {
+        for (uint32_t i = 0; i < count; ++i) {
+            function(i);
+        }
+        return;
+    }
+    std::atomic<uint32_t> next = 0;
+    auto worker = [&]() {
+        for (uint32_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            function(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (uint32_t t = 1; t < threadCount; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+// 作っておいたスレッドでParallelForと同じことをする
+//
+// スレッドは作ったときから待たせておき、ParallelForの間だけ働かせる。
+// 呼び出したスレッドも処理に加わる。ParallelForは1つのスレッドからだけ呼ぶ
+class ThreadPool {
+public:
+    // threadCountは呼び出したスレッドを含めた数。0ならCPUのスレッド数
+    explicit ThreadPool(uint32_t threadCount = 0)
+    {
+        threadCount = GetWorkerThreadCount(threadCount);
+        threads_.reserve(threadCount - 1);
+        for (uint32_t t = 1; t < threadCount; ++t) {
+            threads_.emplace_back([this]() { WorkerMain(); });
+        }
+    }
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            isStopping_ = true;
+        }
+        startCondition_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    uint32_t GetThreadCount() const { return uint32_t(threads_.size()) + 1; }
+
+    // function(i)を i = 0..count-1 について呼ぶ。どのiをどのスレッドが受け持つかは決まっていない
+    template <typename Function>
+    void ParallelFor(uint32_t count, Function&& function)
+    {
+        using FunctionType = std::remove_reference_t<Function>;
+        Run(count, [](void* context, uint32_t i) { (*static_cast<FunctionType*>(context))(i); }, const_cast<void*>(static_cast<const void*>(&function)));
+    }
+
+private:
+    void Run(uint32_t count, void (*invoke)(void*, uint32_t), void* context)
+    {
+        if (threads_.empty() || count <= 1) {
+            for (uint32_t i = 0; i < count; ++i) {
+                invoke(context, i);
+            }
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            invoke_ = invoke;
+            context_ = context;
+            count_ = count;
+            next_ = 0;
+            workingCount_ = uint32_t(threads_.size());
+            ++generation_;
+        }
+        startCondition_.notify_all();
+        Work();
+        std::unique_lock<std::mutex> lock(mutex_);
+        finishCondition_.wait(lock, [this]() { return workingCount_ == 0; });
+    }
+
+    void Work()
+    {
+        for (uint32_t i = next_.fetch_add(1); i < count_; i = next_.fetch_add(1)) {
+            invoke_(context_, i);
+        }
+    }
+
+    void WorkerMain()
+    {
+        uint64_t generation = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                startCondition_.wait(lock, [&]() { return isStopping_ || generation_ != generation; });
+                if (isStopping_) {
+                    return;
+                }
+                generation = generation_;
+            }
+            Work();
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--workingCount_ == 0) {
+                finishCondition_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable startCondition_;
+    std::condition_variable finishCondition_;
+    uint64_t generation_ = 0; // ParallelForを呼ぶたびに増やし、ワーカーを起こす
+    uint32_t workingCount_ = 0; // 今の仕事を終えていないワーカーの数
+    bool isStopping_ = false;
+    // 今の仕事(generation_を増やす前にmutex_の中で書く)
+    void (*invoke_)(void*, uint32_t) = nullptr;
+    void* context_ = nullptr;
+    uint32_t count_ = 0;
+    std::atomic<uint32_t> next_ = 0;
+};
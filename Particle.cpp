@@ -0,0 +1,193 @@
+#include "Particle.h"
+#include "Culling.h"
+#include "MatrixSimd.h"
+#include <algorithm>
+
+namespace {
+
+const IntegrateParticlesFunction kIntegrateParticlesFunctions[kMatrixBackendCount] = {
+    IntegrateParticlesScalar,
+#ifdef CG3_MATH_SSE
+    IntegrateParticlesSSE,
+#else
+    IntegrateParticlesScalar,
+#endif
+#ifdef CG3_MATH_AVX2
+    IntegrateParticlesAVX2,
+#else
+    IntegrateParticlesScalar,
+#endif
+};
+
+bool IsDead(const uint32_t* deadMask, size_t index) { return (deadMask[index / 32] >> (index % 32)) & 1; }
+
+void SetDead(uint32_t* deadMask, size_t index, bool isDead)
+{
+    uint32_t bit = 1u << (index % 32);
+    deadMask[index / 32] = isDead ? deadMask[index / 32] | bit : deadMask[index / 32] & ~bit;
+}
+
+}
+
+void ParticlePool::Initialize(size_t capacity)
+{
+    positionX_.assign(capacity, 0.0f);
+    positionY_.assign(capacity, 0.0f);
+    positionZ_.assign(capacity, 0.0f);
+    velocityX_.assign(capacity, 0.0f);
+    velocityY_.assign(capacity, 0.0f);
+    velocityZ_.assign(capacity, 0.0f);
+    colors_.assign(capacity, { 0.0f, 0.0f, 0.0f, 0.0f });
+    lifeTimes_.assign(capacity, 0.0f);
+    currentTimes_.assign(capacity, 0.0f);
+    alphas_.assign(capacity, 0.0f);
+    deadMask_.assign(GetVisibleMaskWordCount(capacity), 0);
+    size_ = 0;
+    capacity_ = capacity;
+}
+
+bool ParticlePool::Add(const Particle& particle)
+{
+    if (IsFull()) {
+        return false;
+    }
+    size_t index = size_++;
+    positionX_[index] = particle.translate.x;
+    positionY_[index] = particle.translate.y;
+    positionZ_[index] = particle.translate.z;
+    velocityX_[index] = particle.velocity.x;
+    velocityY_[index] = particle.velocity.y;
+    velocityZ_[index] = particle.velocity.z;
+    colors_[index] = particle.color;
+    lifeTimes_[index] = particle.lifeTime;
+    currentTimes_[index] = particle.currentTime;
+    SetDead(deadMask_.data(), index, false);
+    return true;
+}
+
+size_t ParticlePool::Spawn(std::mt19937& randomEngine, const Vector3& translate, size_t count)
+{
+    // 満杯のときに乱数を進めないよう、入る分だけ作る
+    size_t spawnCount = count < capacity_ - size_ ? count : capacity_ - size_;
+    for (size_t i = 0; i < spawnCount; ++i) {
+        Add(MakeNewParticle(randomEngine, translate));
+    }
+    return spawnCount;
+}
+
+void ParticlePool::Kill(size_t index)
+{
+    size_t last = --size_;
+    positionX_[index] = positionX_[last];
+    positionY_[index] = positionY_[last];
+    positionZ_[index] = positionZ_[last];
+    velocityX_[index] = velocityX_[last];
+    velocityY_[index] = velocityY_[last];
+    velocityZ_[index] = velocityZ_[last];
+    colors_[index] = colors_[last];
+    lifeTimes_[index] = lifeTimes_[last];
+    currentTimes_[index] = currentTimes_[last];
+    alphas_[index] = alphas_[last];
+    SetDead(deadMask_.data(), index, IsDead(deadMask_.data(), last));
+}
+
+size_t ParticlePool::RemoveDead()
+{
+    size_t deadCount = 0;
+    for (size_t i = 0; i < size_;) {
+        // 32個とも生きていればまとめて飛ばす
+        if (i % 32 == 0 && deadMask_[i / 32] == 0) {
+            i += 32;
+            continue;
+        }
+        if (IsDead(deadMask_.data(), i)) {
+            // 最後のものが移ってくるので、同じ番号をもう一度調べる
+            Kill(i);
+            ++deadCount;
+            continue;
+        }
+        ++i;
+    }
+    return deadCount;
+}
+
+ParticleArrays ParticlePool::GetArrays()
+{
+    return {
+        positionX_.data(),
+        positionY_.data(),
+        positionZ_.data(),
+        velocityX_.data(),
+        velocityY_.data(),
+        velocityZ_.data(),
+        lifeTimes_.data(),
+        currentTimes_.data(),
+        alphas_.data(),
+        deadMask_.data(),
+    };
+}
+
+Particle ParticlePool::Get(size_t index) const
+{
+    return {
+        { positionX_[index], positionY_[index], positionZ_[index] },
+        { velocityX_[index], velocityY_[index], velocityZ_[index] },
+        colors_[index],
+        lifeTimes_[index],
+        currentTimes_[index],
+    };
+}
+
+Particle MakeNewParticle(std::mt19937& randomEngine, const Vector3& translate)
+{
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> distColor(0.0f, 1.0f);
+    std::uniform_real_distribution<float> distTime(1.0f, 3.0f);
+    Particle particle;
+    Vector3 randomTranslate { distribution(randomEngine), distribution(randomEngine), distribution(randomEngine) };
+    particle.translate = { translate.x + randomTranslate.x, translate.y + randomTranslate.y, translate.z + randomTranslate.z };
+    particle.velocity = { distribution(randomEngine), distribution(randomEngine), distribution(randomEngine) };
+    particle.color = { distColor(randomEngine), distColor(randomEngine), distColor(randomEngine), 1.0f };
+    particle.lifeTime = distTime(randomEngine);
+    particle.currentTime = 0;
+    return particle;
+}
+
+size_t Emit(const Emitter& emitter, std::mt19937& randomEngine, ParticlePool& pool)
+{
+    return pool.Spawn(randomEngine, emitter.transform.translate, emitter.count);
+}
+
+void IntegrateParticlesScalar(const ParticleArrays& particles, size_t begin, size_t end, const AccelerationField& field, float deltaTime)
+{
+    Vector3 acceleration = field.acceleration * deltaTime;
+    for (size_t word = begin / 32; word < GetVisibleMaskWordCount(end); ++word) {
+        uint32_t deadBits = 0;
+        for (size_t i = word * 32; i < std::min(end, word * 32 + 32); ++i) {
+            if (IsCollision(field.area, { particles.positionX[i], particles.positionY[i], particles.positionZ[i] })) {
+                particles.velocityX[i] += acceleration.x;
+                particles.velocityY[i] += acceleration.y;
+                particles.velocityZ[i] += acceleration.z;
+            }
+            particles.positionX[i] += particles.velocityX[i] * deltaTime;
+            particles.positionY[i] += particles.velocityY[i] * deltaTime;
+            particles.positionZ[i] += particles.velocityZ[i] * deltaTime;
+            particles.currentTimes[i] += deltaTime;
+            particles.alphas[i] = 1.0f - (particles.currentTimes[i] / particles.lifeTimes[i]);
+            if (particles.lifeTimes[i] <= particles.currentTimes[i]) {
+                deadBits |= 1u << (i % 32);
+            }
+        }
+        particles.deadMask[word] = deadBits;
+    }
+}
+
+void IntegrateParticles(ParticlePool& pool, const AccelerationField& field, float deltaTime)
+{
+    IntegrateParticles(pool, field, deltaTime, 0, pool.GetSize());
+}
+
+void IntegrateParticles(ParticlePool& pool, const AccelerationField& field, float deltaTime, size_t begin, size_t end)
+{
+    kIntegrateParticlesFunctions[GetActiveMatrixBackend()](pool.GetArrays(), begin, end, field, deltaTime);
+}
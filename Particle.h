@@ -0,0 +1,149 @@
+#pragma once
+#include "MyMath.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <random>
+#include <vector>
+
+const size_t kCacheLineSize = 64;
+// 並列に処理するときに1つのスレッドが受け持つ数。
+// 32の倍数(死んだマスクの1要素分)で、配列をキャッシュラインの境界で分けられる
+const size_t kParticleRangeSize = 16384;
+static_assert(kParticleRangeSize % 32 == 0 && kParticleRangeSize * sizeof(float) % kCacheLineSize == 0);
+
+// キャッシュラインの境界に揃えて確保する(範囲毎に別のスレッドで書いても、同じラインを取り合わないように)
+template <typename T>
+struct CacheAlignedAllocator {
+    using value_type = T;
+    CacheAlignedAllocator() = default;
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U>&) { }
+    T* allocate(size_t count) { return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(kCacheLineSize))); }
+    void deallocate(T* pointer, size_t) { ::operator delete(pointer, std::align_val_t(kCacheLineSize)); }
+    bool operator==(const CacheAlignedAllocator&) const { return true; }
+};
+
+// パーティクル1つ分の値(ParticlePoolに入れたり取り出したりするときに使う)。
+// 拡縮は1、回転は0で固定なので位置だけ持つ
+struct Particle {
+    Vector3 translate;
+    Vector3 velocity;
+    Vector4 color;
+    float lifeTime;
+    float currentTime;
+};
+struct Emitter {
+    Transform transform;
+    uint32_t count;
+    float frequency;
+    float ferquencyTime;
+};
+struct AccelerationField {
+    Vector3 acceleration;
+    AABB area;
+};
+
+// SIMD実装に渡す配列(ParticlePool::GetArrays)
+struct ParticleArrays {
+    float* positionX;
+    float* positionY;
+    float* positionZ;
+    float* velocityX;
+    float* velocityY;
+    float* velocityZ;
+    const float* lifeTimes;
+    float* currentTimes;
+    float* alphas;
+    uint32_t* deadMask; // i番目は deadMask[i / 32] の (i % 32) bit目(Culling.hのマスクと同じ形)
+};
+
+// パーティクルを要素毎の配列(SoA)で持つ入れ物
+//
+// Initializeで全ての配列を最大数まで確保し、その後は確保しない(満杯なら追加しない)。
+// 各配列の先頭はキャッシュラインの境界に揃えてある。
+// 生きているものは先頭からGetSize()個に詰めてあり、消すときは最後のものを移して詰める(順番は変わる)
+class ParticlePool {
+public:
+    void Initialize(size_t capacity);
+    void Clear() { size_ = 0; }
+
+    // 満杯ならfalse
+    bool Add(const Particle& particle);
+    // MakeNewParticleでcount個作って足す(入る分だけ)。足した数を返す
+    size_t Spawn(std::mt19937& randomEngine, const Vector3& translate, size_t count);
+    // index番目を消す。最後のものがindex番目に来る
+    void Kill(size_t index);
+    // IntegrateParticlesで寿命が尽きたとしたものを全て消す。消した数を返す
+    size_t RemoveDead();
+    Particle Get(size_t index) const;
+
+    size_t GetSize() const { return size_; }
+    size_t GetCapacity() const { return capacity_; }
+    bool IsFull() const { return size_ == capacity_; }
+
+    float* GetPositionX() { return positionX_.data(); }
+    float* GetPositionY() { return positionY_.data(); }
+    float* GetPositionZ() { return positionZ_.data(); }
+    float* GetVelocityX() { return velocityX_.data(); }
+    float* GetVelocityY() { return velocityY_.data(); }
+    float* GetVelocityZ() { return velocityZ_.data(); }
+    Vector4* GetColors() { return colors_.data(); }
+    float* GetLifeTimes() { return lifeTimes_.data(); }
+    float* GetCurrentTimes() { return currentTimes_.data(); }
+    const float* GetPositionX() const { return positionX_.data(); }
+    const float* GetPositionY() const { return positionY_.data(); }
+    const float* GetPositionZ() const { return positionZ_.data(); }
+    const float* GetVelocityX() const { return velocityX_.data(); }
+    const float* GetVelocityY() const { return velocityY_.data(); }
+    const float* GetVelocityZ() const { return velocityZ_.data(); }
+    const Vector4* GetColors() const { return colors_.data(); }
+    const float* GetLifeTimes() const { return lifeTimes_.data(); }
+    const float* GetCurrentTimes() const { return currentTimes_.data(); }
+    // IntegrateParticlesの結果
+    const float* GetAlphas() const { return alphas_.data(); }
+    const uint32_t* GetDeadMask() const { return deadMask_.data(); }
+    ParticleArrays GetArrays();
+
+private:
+    template <typename T>
+    using Array = std::vector<T, CacheAlignedAllocator<T>>;
+
+    Array<float> positionX_;
+    Array<float> positionY_;
+    Array<float> positionZ_;
+    Array<float> velocityX_;
+    Array<float> velocityY_;
+    Array<float> velocityZ_;
+    Array<Vector4> colors_;
+    Array<float> lifeTimes_;
+    Array<float> currentTimes_;
+    Array<float> alphas_;
+    Array<uint32_t> deadMask_; // 足したときは0にする
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+};
+
+// パーティクルを1つ生成する
+Particle MakeNewParticle(std::mt19937& randomEngine, const Vector3& translate);
+// エミッターからまとめて生成してpoolに足す。足した数を返す
+size_t Emit(const Emitter& emitter, std::mt19937& randomEngine, ParticlePool& pool);
+
+// 1フレーム分進める。加速度場の中にあるものの速度を変えてから動かし、経過時間を進め、
+// alpha(1 - 経過時間 / 寿命)と寿命が尽きたもののマスクを書き込む(消すのはRemoveDead)。
+// SSE4.1なら4個、AVX2なら8個を同時に計算し、実装はMatrix4x4と同じくGetActiveMatrixBackendで選ぶ。
+// 掛け算と足し算の順番を揃えているので、結果はスカラー版と完全に一致する
+void IntegrateParticles(ParticlePool& pool, const AccelerationField& field, float deltaTime);
+// [begin, end)だけ進める。beginは32の倍数(kParticleRangeSize毎に分ければ別のスレッドから同時に呼べる)
+void IntegrateParticles(ParticlePool& pool, const AccelerationField& field, float deltaTime, size_t begin, size_t end);
+
+// 以下はSIMD実装用
+// [begin, end)を進める。beginは32の倍数で、deadMaskはその範囲の要素を丸ごと書き換える(endより後ろのbitは0)
+using IntegrateParticlesFunction = void (*)(const ParticleArrays& particles, size_t begin, size_t end, const AccelerationField& field, float deltaTime);
+void IntegrateParticlesScalar(const ParticleArrays& particles, size_t begin, size_t end, const AccelerationField& field, float deltaTime);
+#ifdef CG3_MATH_SSE
+void IntegrateParticlesSSE(const ParticleArrays& particles, size_t begin, size_t end, const AccelerationField& field, float deltaTime);
+#endif
+#ifdef CG3_MATH_AVX2
+void IntegrateParticlesAVX2(const ParticleArrays& particles, size_t begin, size_t end, const AccelerationField& field, float deltaTime);
+#endif
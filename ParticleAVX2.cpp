@@ -0,0 +1,84 @@
+#include "Particle.h"
+#include <immintrin.h>
+
+namespace {
+
+const size_t kLanes = 8;
+
+// 加速度場と1フレームの時間をレジスタ全体に広げたもの
+struct FieldLanes {
+    __m256 accelerationX;
+    __m256 accelerationY;
+    __m256 accelerationZ;
+    __m256 minX;
+    __m256 minY;
+    __m256 minZ;
+    __m256 maxX;
+    __m256 maxY;
+    __m256 maxZ;
+    __m256 deltaTime;
+};
+
+// 8個分を進め、寿命が尽きたbitを返す(IntegrateParticlesScalarと同じ順番で計算する)
+uint32_t IntegrateLanes(const ParticleArrays& particles, size_t i, const FieldLanes& field)
+{
+    __m256 positionX = _mm256_loadu_ps(particles.positionX + i);
+    __m256 positionY = _mm256_loadu_ps(particles.positionY + i);
+    __m256 positionZ = _mm256_loadu_ps(particles.positionZ + i);
+    __m256 velocityX = _mm256_loadu_ps(particles.velocityX + i);
+    __m256 velocityY = _mm256_loadu_ps(particles.velocityY + i);
+    __m256 velocityZ = _mm256_loadu_ps(particles.velocityZ + i);
+
+    // 範囲外では足さない(-0 + 0 で符号が変わらないよう、足した結果と選ぶ)
+    __m256 isInside = _mm256_and_ps(_mm256_cmp_ps(field.minX, positionX, _CMP_LE_OQ), _mm256_cmp_ps(field.maxX, positionX, _CMP_GE_OQ));
+    isInside = _mm256_and_ps(isInside, _mm256_and_ps(_mm256_cmp_ps(field.minY, positionY, _CMP_LE_OQ), _mm256_cmp_ps(field.maxY, positionY, _CMP_GE_OQ)));
+    isInside = _mm256_and_ps(isInside, _mm256_and_ps(_mm256_cmp_ps(field.minZ, positionZ, _CMP_LE_OQ), _mm256_cmp_ps(field.maxZ, positionZ, _CMP_GE_OQ)));
+    velocityX = _mm256_blendv_ps(velocityX, _mm256_add_ps(velocityX, field.accelerationX), isInside);
+    velocityY = _mm256_blendv_ps(velocityY, _mm256_add_ps(velocityY, field.accelerationY), isInside);
+    velocityZ = _mm256_blendv_ps(velocityZ, _mm256_add_ps(velocityZ, field.accelerationZ), isInside);
+    _mm256_storeu_ps(particles.velocityX + i, velocityX);
+    _mm256_storeu_ps(particles.velocityY + i, velocityY);
+    _mm256_storeu_ps(particles.velocityZ + i, velocityZ);
+    _mm256_storeu_ps(particles.positionX + i, _mm256_add_ps(positionX, _mm256_mul_ps(velocityX, field.deltaTime)));
+    _mm256_storeu_ps(particles.positionY + i, _mm256_add_ps(positionY, _mm256_mul_ps(velocityY, field.deltaTime)));
+    _mm256_storeu_ps(particles.positionZ + i, _mm256_add_ps(positionZ, _mm256_mul_ps(velocityZ, field.deltaTime)));
+
+    __m256 lifeTime = _mm256_loadu_ps(particles.lifeTimes + i);
+    __m256 currentTime = _mm256_add_ps(_mm256_loadu_ps(particles.currentTimes + i), field.deltaTime);
+    _mm256_storeu_ps(particles.currentTimes + i, currentTime);
+    _mm256_storeu_ps(particles.alphas + i, _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_div_ps(currentTime, lifeTime)));
+    return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(lifeTime, currentTime, _CMP_LE_OQ)));
+}
+
+}
+
+void IntegrateParticlesAVX2(const ParticleArrays& particles, size_t begin, size_t end, const AccelerationField& field, float deltaTime)
+{
+    float accelerationX = field.acceleration.x * deltaTime;
+    float accelerationY = field.acceleration.y * deltaTime;
+    float accelerationZ = field.acceleration.z * deltaTime;
+    FieldLanes lanes = {
+        _mm256_set1_ps(accelerationX),
+        _mm256_set1_ps(accelerationY),
+        _mm256_set1_ps(accelerationZ),
+        _mm256_set1_ps(field.area.min.x),
+        _mm256_set1_ps(field.area.min.y),
+        _mm256_set1_ps(field.area.min.z),
+        _mm256_set1_ps(field.area.max.x),
+        _mm256_set1_ps(field.area.max.y),
+        _mm256_set1_ps(field.area.max.z),
+        _mm256_set1_ps(deltaTime),
+    };
+    size_t wordEnd = begin + (end - begin) / 32 * 32;
+    for (size_t word = begin; word < wordEnd; word += 32) {
+        uint32_t deadBits = 0;
+        for (size_t lane = 0; lane < 32; lane += kLanes) {
+            deadBits |= IntegrateLanes(particles, word + lane, lanes) << lane;
+        }
+        particles.deadMask[word / 32] = deadBits;
+    }
+    // 32個に満たない残りはスカラー版で
+    if (wordEnd < end) {
+        IntegrateParticlesScalar(particles, wordEnd, end, field, deltaTime);
+    }
+}
@@ -0,0 +1,84 @@
+#include "Particle.h"
+#include <smmintrin.h>
+
+namespace {
+
+const size_t kLanes = 4;
+
+// 加速度場と1フレームの時間をレジスタ全体に広げたもの
+struct FieldLanes {
+    __m128 accelerationX;
+    __m128 accelerationY;
+    __m128 accelerationZ;
+    __m128 minX;
+    __m128 minY;
+    __m128 minZ;
+    __m128 maxX;
+    __m128 maxY;
+    __m128 maxZ;
+    __m128 deltaTime;
+};
+
+// 4個分を進め、寿命が尽きたbitを返す(IntegrateParticlesScalarと同じ順番で計算する)
+uint32_t IntegrateLanes(const ParticleArrays& particles, size_t i, const FieldLanes& field)
+{
+    __m128 positionX = _mm_loadu_ps(particles.positionX + i);
+    __m128 positionY = _mm_loadu_ps(particles.positionY + i);
+    __m128 positionZ = _mm_loadu_ps(particles.positionZ + i);
+    __m128 velocityX = _mm_loadu_ps(particles.velocityX + i);
+    __m128 velocityY = _mm_loadu_ps(particles.velocityY + i);
+    __m128 velocityZ = _mm_loadu_ps(particles.velocityZ + i);
+
+    // 範囲外では足さない(-0 + 0 で符号が変わらないよう、足した結果と選ぶ)
+    __m128 isInside = _mm_and_ps(_mm_cmple_ps(field.minX, positionX), _mm_cmpge_ps(field.maxX, positionX));
+    isInside = _mm_and_ps(isInside, _mm_and_ps(_mm_cmple_ps(field.minY, positionY), _mm_cmpge_ps(field.maxY, positionY)));
+    isInside = _mm_and_ps(isInside, _mm_and_ps(_mm_cmple_ps(field.minZ, positionZ), _mm_cmpge_ps(field.maxZ, positionZ)));
+    velocityX = _mm_blendv_ps(velocityX, _mm_add_ps(velocityX, field.accelerationX), isInside);
+    velocityY = _mm_blendv_ps(velocityY, _mm_add_ps(velocityY, field.accelerationY), isInside);
+    velocityZ = _mm_blendv_ps(velocityZ, _mm_add_ps(velocityZ, field.accelerationZ), isInside);
+    _mm_storeu_ps(particles.velocityX + i, velocityX);
+    _mm_storeu_ps(particles.velocityY + i, velocityY);
+    _mm_storeu_ps(particles.velocityZ + i, velocityZ);
+    _mm_storeu_ps(particles.positionX + i, _mm_add_ps(positionX, _mm_mul_ps(velocityX, field.deltaTime)));
+    _mm_storeu_ps(particles.positionY + i, _mm_add_ps(positionY, _mm_mul_ps(velocityY, field.deltaTime)));
+    _mm_storeu_ps(particles.positionZ + i, _mm_add_ps(positionZ, _mm_mul_ps(velocityZ, field.deltaTime)));
+
+    __m128 lifeTime = _mm_loadu_ps(particles.lifeTimes + i);
+    __m128 currentTime = _mm_add_ps(_mm_loadu_ps(particles.currentTimes + i), field.deltaTime);
+    _mm_storeu_ps(particles.currentTimes + i, currentTime);
+    _mm_storeu_ps(particles.alphas + i, _mm_sub_ps(_mm_set1_ps(1.0f), _mm_div_ps(currentTime, lifeTime)));
+    return uint32_t(_mm_movemask_ps(_mm_cmple_ps(lifeTime, currentTime)));
+}
+
+}
+
+void IntegrateParticlesSSE(const ParticleArrays& particles, size_t begin, size_t end, const AccelerationField& field, float deltaTime)
+{
+    float accelerationX = field.acceleration.x * deltaTime;
+    float accelerationY = field.acceleration.y * deltaTime;
+    float accelerationZ = field.acceleration.z * deltaTime;
+    FieldLanes lanes = {
+        _mm_set1_ps(accelerationX),
+        _mm_set1_ps(accelerationY),
+        _mm_set1_ps(accelerationZ),
+        _mm_set1_ps(field.area.min.x),
+        _mm_set1_ps(field.area.min.y),
+        _mm_set1_ps(field.area.min.z),
+        _mm_set1_ps(field.area.max.x),
+        _mm_set1_ps(field.area.max.y),
+        _mm_set1_ps(field.area.max.z),
+        _mm_set1_ps(deltaTime),
+    };
+    size_t wordEnd = begin + (end - begin) / 32 * 32;
+    for (size_t word = begin; word < wordEnd; word += 32) {
+        uint32_t deadBits = 0;
+        for (size_t lane = 0; lane < 32; lane += kLanes) {
+            deadBits |= IntegrateLanes(particles, word + lane, lanes) << lane;
+        }
+        particles.deadMask[word / 32] = deadBits;
+    }
+    // 32個に満たない残りはスカラー版で
+    if (wordEnd < end) {
+        IntegrateParticlesScalar(particles, wordEnd, end, field, deltaTime);
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include "Model.h"
+#include <array>
+#include <cstdint>
+
+// 形の決まっている頂点データ
+//
+// どれもコンパイル時に作る定数で、実行時はMapしたリソースへコピーするだけにする。
+// 作った結果はstatic_assertで確かめておく。
+
+// パーティクル用の板ポリ(xy平面の-1から1、三角形2枚)
+constexpr std::array<VertexData, 6> kParticleVertices = { {
+    { { 1.0f, 1.0f, 0.0f, 1.0f }, { 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+    { { -1.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+    { { 1.0f, -1.0f, 0.0f, 1.0f }, { 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f } },
+    { { 1.0f, -1.0f, 0.0f, 1.0f }, { 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f } },
+    { { -1.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+    { { -1.0f, -1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f }, { 0.0f, 0.0f, 1.0f } },
+} };
+
+// スプライト用の四角形(スクリーン座標で640x360)
+constexpr std::array<VertexData, 4> kSpriteVertices = { {
+    { { 0.0f, 360.0f, 0.0f, 1.0f }, { 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f } },
+    { { 0.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+    { { 640.0f, 360.0f, 0.0f, 1.0f }, { 1.0f, 1.0f }, { 0.0f, 0.0f, 1.0f } },
+    { { 640.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+} };
+constexpr std::array<uint32_t, 6> kSpriteIndices = { 0, 1, 2, 1, 3, 2 };
+
+// 緯度経度で分割した半径1の球
+template <uint32_t kSubdivision>
+struct SphereMesh {
+    static constexpr uint32_t kVertexCount = (kSubdivision + 1) * (kSubdivision + 1);
+    static constexpr uint32_t kIndexCount = kSubdivision * kSubdivision * 6;
+    std::array<VertexData, kVertexCount> vertices;
+    std::array<uint32_t, kIndexCount> indices;
+};
+
+// 頂点は南極から緯度の順に並べ、経度の始めと終わりはUVが違うので別の頂点にする
+template <uint32_t kSubdivision>
+constexpr SphereMesh<kSubdivision> MakeSphereMesh()
+{
+    SphereMesh<kSubdivision> mesh {};
+    for (uint32_t latIndex = 0; latIndex < (kSubdivision + 1); ++latIndex) {
+        double lat = -std::numbers::pi / 2.0 + std::numbers::pi * double(latIndex) / double(kSubdivision);
+        float cosLat = float(ConstexprCos(lat));
+        float sinLat = float(ConstexprSin(lat));
+        for (uint32_t lonIndex = 0; lonIndex < (kSubdivision + 1); ++lonIndex) {
+            double lon = 2.0 * std::numbers::pi * double(lonIndex) / double(kSubdivision);
+            float cosLon = float(ConstexprCos(lon));
+            float sinLon = float(ConstexprSin(lon));
+
+            VertexData& vertex = mesh.vertices[latIndex * (kSubdivision + 1) + lonIndex];
+            vertex.position = { cosLat * cosLon, sinLat, cosLat * sinLon, 1.0f };
+            vertex.texcoord = { float(lonIndex) / float(kSubdivision), 1.0f - float(latIndex) / float(kSubdivision) };
+            vertex.normal = { cosLat * cosLon, sinLat, cosLat * sinLon };
+        }
+    }
+
+    for (uint32_t lat = 0; lat < kSubdivision; ++lat) {
+        for (uint32_t lon = 0; lon < kSubdivision; ++lon) {
+            uint32_t lt = lon + lat * (kSubdivision + 1);
+            uint32_t rt = (lon + 1) + lat * (kSubdivision + 1);
+            uint32_t lb = lon + (lat + 1) * (kSubdivision + 1);
+            uint32_t rb = (lon + 1) + (lat + 1) * (kSubdivision + 1);
+
+            uint32_t start = (lat * kSubdivision + lon) * 6;
+            mesh.indices[start + 0] = rb;
+            mesh.indices[start + 1] = rt;
+            mesh.indices[start + 2] = lt;
+            mesh.indices[start + 3] = rb;
+            mesh.indices[start + 4] = lt;
+            mesh.indices[start + 5] = lb;
+        }
+    }
+    return mesh;
+}
+
+// 全ての頂点が半径1の上にあり、インデックスが頂点数を超えていないか
+template <uint32_t kSubdivision>
+constexpr bool IsValidSphereMesh(const SphereMesh<kSubdivision>& mesh)
+{
+    for (const VertexData& vertex : mesh.vertices) {
+        float lengthSquared = vertex.position.x * vertex.position.x + vertex.position.y * vertex.position.y + vertex.position.z * vertex.position.z;
+        if (lengthSquared < 1.0f - 1e-5f || 1.0f + 1e-5f < lengthSquared) {
+            return false;
+        }
+    }
+    for (uint32_t index : mesh.indices) {
+        if (mesh.kVertexCount <= index) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr uint32_t kSphereSubdivision = 16;
+inline constexpr SphereMesh<kSphereSubdivision> kSphereMesh = MakeSphereMesh<kSphereSubdivision>();
+
+static_assert(kSphereMesh.kVertexCount == 289 && kSphereMesh.kIndexCount == 1536);
+static_assert(IsValidSphereMesh(kSphereMesh));
+// 南極と北極
+static_assert(kSphereMesh.vertices.front().position.y == -1.0f && kSphereMesh.vertices.back().position.y == 1.0f);
+// 赤道上の経度0はx軸の向き
+static_assert(kSphereMesh.vertices[(kSphereSubdivision / 2) * (kSphereSubdivision + 1)].position.x == 1.0f);
+static_assert(kParticleVertices[5].position.x == -1.0f && kParticleVertices[5].texcoord.y == 1.0f);
+static_assert(kSpriteIndices[4] == 3);
@@ -0,0 +1,325 @@
+#include "PrimitiveMesh.h"
+#include "MeshLod.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <numbers>
+
+namespace {
+
+const uint32_t kMaxLodCount = uint32_t(std::size(kLodTriangleRatios));
+
+Vector3 ToVector3(const Vector4& v) { return { v.x, v.y, v.z }; }
+Vector3 Subtract(const Vector3& a, const Vector3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+float DotProduct(const Vector3& a, const Vector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+Vector3 CrossProduct(const Vector3& a, const Vector3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+// 格子の頂点(column, row)が baseVertex + column + row * (subdivision + 1) にあるとき、
+// stepおきの頂点で四角形を三角形2枚にする(並びはMakeSphereMeshと同じ)。
+// 表はcolumnの向きをU、rowの向きをVとしてcross(V, U)の向きになる
+void AppendGridIndices(std::vector<uint32_t>& indices, uint32_t baseVertex, uint32_t subdivision, uint32_t step)
+{
+    uint32_t stride = subdivision + 1;
+    for (uint32_t row = 0; row < subdivision; row += step) {
+        for (uint32_t column = 0; column < subdivision; column += step) {
+            uint32_t lt = baseVertex + column + row * stride;
+            uint32_t rt = lt + step;
+            uint32_t lb = lt + step * stride;
+            uint32_t rb = lb + step;
+            indices.insert(indices.end(), { rb, rt, lt, rb, lt, lb });
+        }
+    }
+}
+
+// 半分にしてLODを作れる回数(偶数で、半分にしてもminSubdivision以上の間)
+uint32_t CountGridLods(uint32_t subdivision, uint32_t minSubdivision)
+{
+    uint32_t count = 0;
+    while (count < kMaxLodCount && subdivision % 2 == 0 && minSubdivision <= subdivision / 2) {
+        subdivision /= 2;
+        ++count;
+    }
+    return count;
+}
+
+// 原点を中心とする半径1の球面から、三角形の平面までの一番遠い距離(潰れた三角形は除く)
+float CalculateSphereError(const std::vector<VertexData>& vertices, const std::vector<uint32_t>& indices)
+{
+    float error = 0.0f;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        Vector3 p0 = ToVector3(vertices[indices[i]].position);
+        Vector3 normal = CrossProduct(Subtract(ToVector3(vertices[indices[i + 1]].position), p0), Subtract(ToVector3(vertices[indices[i + 2]].position), p0));
+        float length = std::sqrt(DotProduct(normal, normal));
+        if (length == 0.0f) {
+            continue;
+        }
+        error = std::max(error, 1.0f - DotProduct(normal, p0) / length);
+    }
+    return error;
+}
+
+// サブメッシュとマテリアルを1つずつ持つModelDataにする
+ModelData MakeModel(std::vector<VertexData>&& vertices, std::vector<uint32_t>&& indices)
+{
+    ModelData model;
+    model.vertices = std::move(vertices);
+    model.indices = std::move(indices);
+    model.submeshes.push_back({ 0, uint32_t(model.indices.size()), 0 });
+    model.materials.push_back({ "", "" });
+    return model;
+}
+
+void AddLod(ModelData& model, std::vector<uint32_t>&& indices, float error)
+{
+    MeshLod lod;
+    lod.submeshes.push_back({ 0, uint32_t(indices.size()), 0 });
+    lod.indices = std::move(indices);
+    lod.error = error;
+    model.lods.push_back(std::move(lod));
+}
+
+ModelData MakeUVSphere(uint32_t subdivision)
+{
+    // sin/cosは緯度と経度の表に1回ずつ求め、頂点は表の積で作る
+    // (倍精度で求めてfloatに丸めるので、MakeSphereMeshの値とほぼ同じになる)
+    uint32_t count = subdivision + 1;
+    std::vector<float> latSins(count), latCoss(count), lonSins(count), lonCoss(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        double lat = -std::numbers::pi / 2.0 + std::numbers::pi * double(i) / double(subdivision);
+        double lon = 2.0 * std::numbers::pi * double(i) / double(subdivision);
+        latSins[i] = float(std::sin(lat));
+        latCoss[i] = float(std::cos(lat));
+        lonSins[i] = float(std::sin(lon));
+        lonCoss[i] = float(std::cos(lon));
+    }
+
+    std::vector<VertexData> vertices(size_t(count) * count);
+    for (uint32_t latIndex = 0; latIndex < count; ++latIndex) {
+        float cosLat = latCoss[latIndex];
+        float sinLat = latSins[latIndex];
+        float v = 1.0f - float(latIndex) / float(subdivision);
+        VertexData* row = vertices.data() + size_t(latIndex) * count;
+        for (uint32_t lonIndex = 0; lonIndex < count; ++lonIndex) {
+            Vector3 normal = { cosLat * lonCoss[lonIndex], sinLat, cosLat * lonSins[lonIndex] };
+            row[lonIndex] = { { normal.x, normal.y, normal.z, 1.0f }, { float(lonIndex) / float(subdivision), v }, normal };
+        }
+    }
+
+    std::vector<uint32_t> indices;
+    indices.reserve(size_t(subdivision) * subdivision * 6);
+    AppendGridIndices(indices, 0, subdivision, 1);
+    ModelData model = MakeModel(std::move(vertices), std::move(indices));
+
+    uint32_t lodCount = CountGridLods(subdivision, 4);
+    for (uint32_t level = 1; level <= lodCount; ++level) {
+        std::vector<uint32_t> lodIndices;
+        AppendGridIndices(lodIndices, 0, subdivision, 1u << level);
+        float error = CalculateSphereError(model.vertices, lodIndices);
+        AddLod(model, std::move(lodIndices), error);
+    }
+    return model;
+}
+
+// 三角形を辺の中点で4つに分ける。中点の頂点はpositionsの後ろに足すので、元の頂点の番号は変わらない
+std::vector<uint32_t> SubdivideSphere(std::vector<Vector3>& positions, const std::vector<uint32_t>& indices)
+{
+    std::unordered_map<uint64_t, uint32_t> midpoints;
+    auto getMidpoint = [&](uint32_t a, uint32_t b) {
+        uint64_t key = (uint64_t(std::min(a, b)) << 32) | std::max(a, b);
+        auto [it, inserted] = midpoints.try_emplace(key, uint32_t(positions.size()));
+        if (inserted) {
+            Vector3 sum = { positions[a].x + positions[b].x, positions[a].y + positions[b].y, positions[a].z + positions[b].z };
+            positions.push_back(Normalize(sum));
+        }
+        return it->second;
+    };
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size() * 4);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        uint32_t ab = getMidpoint(a, b), bc = getMidpoint(b, c), ca = getMidpoint(c, a);
+        result.insert(result.end(), { a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca });
+    }
+    return result;
+}
+
+ModelData MakeIcosphere(uint32_t subdivision)
+{
+    const float t = std::numbers::phi_v<float>;
+    std::vector<Vector3> positions = {
+        { -1.0f, t, 0.0f }, { 1.0f, t, 0.0f }, { -1.0f, -t, 0.0f }, { 1.0f, -t, 0.0f },
+        { 0.0f, -1.0f, t }, { 0.0f, 1.0f, t }, { 0.0f, -1.0f, -t }, { 0.0f, 1.0f, -t },
+        { t, 0.0f, -1.0f }, { t, 0.0f, 1.0f }, { -t, 0.0f, -1.0f }, { -t, 0.0f, 1.0f },
+    };
+    for (Vector3& position : positions) {
+        position = Normalize(position);
+    }
+    std::vector<uint32_t> indices = {
+        0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+        1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+        3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+        4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1,
+    };
+    // 表が外を向くように揃える
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const Vector3& p0 = positions[indices[i]];
+        Vector3 normal = CrossProduct(Subtract(positions[indices[i + 1]], p0), Subtract(positions[indices[i + 2]], p0));
+        if (DotProduct(normal, p0) < 0.0f) {
+            std::swap(indices[i + 1], indices[i + 2]);
+        }
+    }
+
+    // 細かいものから順に、各回の分け方を残しておく(粗いものは細かいものの頂点の一部を使う)
+    std::vector<std::vector<uint32_t>> levels = { std::move(indices) };
+    for (uint32_t i = 0; i < subdivision; ++i) {
+        levels.push_back(SubdivideSphere(positions, levels.back()));
+    }
+    std::reverse(levels.begin(), levels.end());
+    levels.resize(std::min<size_t>(levels.size(), kMaxLodCount + 1));
+
+    std::vector<VertexData> vertices(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        const Vector3& p = positions[i];
+        float u = std::atan2(p.z, p.x) / (2.0f * std::numbers::pi_v<float>);
+        float v = 0.5f - std::asin(std::clamp(p.y, -1.0f, 1.0f)) / std::numbers::pi_v<float>;
+        vertices[i] = { { p.x, p.y, p.z, 1.0f }, { u < 0.0f ? u + 1.0f : u, v }, p };
+    }
+
+    // 経度の始めと終わりをまたぐ三角形は、uの小さい頂点を1を足した別の頂点にする(全てのLODで共有する)
+    std::unordered_map<uint32_t, uint32_t> seamVertices;
+    for (std::vector<uint32_t>& level : levels) {
+        for (size_t i = 0; i < level.size(); i += 3) {
+            float minU = std::min({ vertices[level[i]].texcoord.x, vertices[level[i + 1]].texcoord.x, vertices[level[i + 2]].texcoord.x });
+            float maxU = std::max({ vertices[level[i]].texcoord.x, vertices[level[i + 1]].texcoord.x, vertices[level[i + 2]].texcoord.x });
+            if (maxU - minU <= 0.5f) {
+                continue;
+            }
+            for (size_t corner = i; corner < i + 3; ++corner) {
+                uint32_t index = level[corner];
+                if (0.5f <= vertices[index].texcoord.x) {
+                    continue;
+                }
+                auto [it, inserted] = seamVertices.try_emplace(index, uint32_t(vertices.size()));
+                if (inserted) {
+                    VertexData vertex = vertices[index];
+                    vertex.texcoord.x += 1.0f;
+                    vertices.push_back(vertex);
+                }
+                level[corner] = it->second;
+            }
+        }
+    }
+
+    ModelData model = MakeModel(std::move(vertices), std::move(levels[0]));
+    for (size_t level = 1; level < levels.size(); ++level) {
+        float error = CalculateSphereError(model.vertices, levels[level]);
+        AddLod(model, std::move(levels[level]), error);
+    }
+    return model;
+}
+
+// 中心がcenterで、columnの向きがaxisU、rowの向きがaxisVの2x2の面(表はcross(axisV, axisU))
+void AppendFace(std::vector<VertexData>& vertices, const Vector3& center, const Vector3& axisU, const Vector3& axisV, uint32_t subdivision)
+{
+    Vector3 normal = CrossProduct(axisV, axisU);
+    for (uint32_t row = 0; row <= subdivision; ++row) {
+        float v = float(row) / float(subdivision);
+        float offsetV = float(2 * row) / float(subdivision) - 1.0f;
+        for (uint32_t column = 0; column <= subdivision; ++column) {
+            float u = float(column) / float(subdivision);
+            float offsetU = float(2 * column) / float(subdivision) - 1.0f;
+            Vector3 p = { center.x + axisU.x * offsetU + axisV.x * offsetV, center.y + axisU.y * offsetU + axisV.y * offsetV,
+                center.z + axisU.z * offsetU + axisV.z * offsetV };
+            vertices.push_back({ { p.x, p.y, p.z, 1.0f }, { u, v }, normal });
+        }
+    }
+}
+
+// 面の並びは+x, -x, +y, -y, +z, -z(四角形は+zの面を原点に置いたもの)
+struct Face {
+    Vector3 normal;
+    Vector3 axisU;
+    Vector3 axisV;
+};
+const Face kCubeFaces[] = {
+    { { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, -1.0f, 0.0f } },
+    { { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, -1.0f, 0.0f } },
+    { { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+    { { 0.0f, -1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } },
+    { { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } },
+    { { 0.0f, 0.0f, -1.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } },
+};
+
+ModelData MakeGrid(const Face* faces, uint32_t faceCount, bool isCentered, uint32_t subdivision)
+{
+    uint32_t faceVertexCount = (subdivision + 1) * (subdivision + 1);
+    std::vector<VertexData> vertices;
+    vertices.reserve(size_t(faceVertexCount) * faceCount);
+    for (uint32_t face = 0; face < faceCount; ++face) {
+        Vector3 center = isCentered ? Vector3 { 0.0f, 0.0f, 0.0f } : faces[face].normal;
+        AppendFace(vertices, center, faces[face].axisU, faces[face].axisV, subdivision);
+    }
+
+    // 平らなので、粗くしても形は変わらない
+    uint32_t lodCount = CountGridLods(subdivision, 1);
+    std::vector<std::vector<uint32_t>> levels(lodCount + 1);
+    for (uint32_t level = 0; level <= lodCount; ++level) {
+        for (uint32_t face = 0; face < faceCount; ++face) {
+            AppendGridIndices(levels[level], face * faceVertexCount, subdivision, 1u << level);
+        }
+    }
+    ModelData model = MakeModel(std::move(vertices), std::move(levels[0]));
+    for (uint32_t level = 1; level <= lodCount; ++level) {
+        AddLod(model, std::move(levels[level]), 0.0f);
+    }
+    return model;
+}
+
+} // namespace
+
+PrimitiveMesh MakePrimitiveMesh(PrimitiveType type, uint32_t subdivision)
+{
+    PrimitiveMesh mesh;
+    mesh.type = type;
+    switch (type) {
+    case PrimitiveType::UVSphere:
+        mesh.subdivision = std::max(subdivision, 2u);
+        mesh.model = MakeUVSphere(mesh.subdivision);
+        break;
+    case PrimitiveType::Icosphere:
+        mesh.subdivision = subdivision;
+        mesh.model = MakeIcosphere(mesh.subdivision);
+        break;
+    case PrimitiveType::Quad:
+        mesh.subdivision = std::max(subdivision, 1u);
+        mesh.model = MakeGrid(&kCubeFaces[4], 1, true, mesh.subdivision);
+        break;
+    case PrimitiveType::Cube:
+        mesh.subdivision = std::max(subdivision, 1u);
+        mesh.model = MakeGrid(kCubeFaces, uint32_t(std::size(kCubeFaces)), false, mesh.subdivision);
+        break;
+    }
+
+    // 境界球はAABBの中心から一番遠い頂点まで
+    mesh.bounds = CalculateBounds(mesh.model);
+    const AABB& bounds = mesh.bounds;
+    mesh.boundingSphere = { { (bounds.min.x + bounds.max.x) * 0.5f, (bounds.min.y + bounds.max.y) * 0.5f, (bounds.min.z + bounds.max.z) * 0.5f }, 0.0f };
+    for (const VertexData& vertex : mesh.model.vertices) {
+        Vector3 offset = Subtract(ToVector3(vertex.position), mesh.boundingSphere.center);
+        mesh.boundingSphere.radius = std::max(mesh.boundingSphere.radius, std::sqrt(DotProduct(offset, offset)));
+    }
+    return mesh;
+}
+
+const PrimitiveMesh& PrimitiveCache::Get(PrimitiveType type, uint32_t subdivision)
+{
+    uint64_t key = (uint64_t(type) << 32) | subdivision;
+    auto found = meshes_.find(key);
+    if (found != meshes_.end()) {
+        ++hitCount_;
+        return found->second;
+    }
+    ++buildCount_;
+    return meshes_.emplace(key, MakePrimitiveMesh(type, subdivision)).first->second;
+}
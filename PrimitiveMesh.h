@@ -0,0 +1,59 @@
+#pragma once
+#include "Model.h"
+#include "MyMath.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// 実行時に作る基本形状(球・四角形・立方体)
+//
+// Primitive.hの定数と違い、細かさを実行時に選べて、LODと境界も一緒に作る。
+//   - 結果はModelData(頂点・index・サブメッシュ1つ・マテリアル1つ)で、LODはlodsに入れる。
+//     LODは細かさを半分ずつにしたもので、元のメッシュの頂点の一部だけを使う(頂点は共有)。
+//     CopyIndices/GetLodIndexOffset/GetLodSubmeshesでモデルと同じように描ける
+//   - UV球はsin/cosを緯度と経度の表に1回ずつ求め、頂点は表の積で作る
+//   - 三角形の表は cross(p1 - p0, p2 - p0) の向きで、外側(四角形は+z)を向く
+//   - PrimitiveCacheで(形, 細かさ)毎に1つだけ作り、同じものを描くときは同じバッファを使う
+
+enum class PrimitiveType : uint32_t {
+    UVSphere, // 緯度経度で分割した半径1の球(頂点の並びはPrimitive.hのMakeSphereMeshと同じ)
+    Icosphere, // 正20面体を分割した半径1の球(極の周りのuvは歪む)
+    Quad, // xy平面の-1から1、表は+z。uは+x、vは-yの向き
+    Cube, // -1から1の立方体。面毎に頂点を分け、uvは面毎に0から1
+};
+
+// 細かさ(subdivision)の意味
+//   UVSphere: 緯度と経度の分割数(2以上)。偶数の間は半分にしてLODを作る(4未満にはしない)
+//   Icosphere: 三角形を4つに分ける回数(0で正20面体)。1回ずつ減らしてLODを作る
+//   Quad/Cube: 1辺の分割数(1以上)。偶数の間は半分にしてLODを作る(平らなので誤差は0)
+// LODは多くてもkLodTriangleRatiosと同じ数まで
+struct PrimitiveMesh {
+    PrimitiveType type;
+    uint32_t subdivision;
+    ModelData model;
+    AABB bounds; // ローカル空間の境界(カリング用)
+    Sphere boundingSphere;
+};
+
+// 作る。subdivisionが小さすぎるときは使える一番小さい値にする
+PrimitiveMesh MakePrimitiveMesh(PrimitiveType type, uint32_t subdivision);
+
+// 作った形状を(形, 細かさ)毎に持っておく
+//
+// Getで無ければ作り、あればそれを返す。返した参照はClearするかキャッシュが無くなるまで使える。
+// スレッドセーフではない
+class PrimitiveCache {
+public:
+    const PrimitiveMesh& Get(PrimitiveType type, uint32_t subdivision);
+    void Clear() { meshes_.clear(); }
+
+    size_t GetSize() const { return meshes_.size(); }
+    // Getで作った回数と、作らずに返した回数(計測用)
+    uint32_t GetBuildCount() const { return buildCount_; }
+    uint32_t GetHitCount() const { return hitCount_; }
+
+private:
+    std::unordered_map<uint64_t, PrimitiveMesh> meshes_;
+    uint32_t buildCount_ = 0;
+    uint32_t hitCount_ = 0;
+};
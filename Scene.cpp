@@ -0,0 +1,308 @@
+#include "Scene.h"
+#include "Culling.h"
+#include "MeshLod.h"
+#include "Primitive.h"
+#include "TransformBatch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+// timingsが渡されたときだけ時間を計る
+class PhaseTimer {
+public:
+    explicit PhaseTimer(SceneTimings* timings)
+        : timings_(timings)
+    {
+        if (timings_) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+    void Lap(double SceneTimings::* phase)
+    {
+        if (!timings_) {
+            return;
+        }
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        timings_->*phase += std::chrono::duration<double, std::micro>(now - start_).count();
+        start_ = now;
+    }
+
+private:
+    SceneTimings* timings_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// 板ポリの頂点で原点から一番遠いものまでの距離の2乗
+constexpr float CalculateMaxLengthSquared(const std::array<VertexData, 6>& vertices)
+{
+    float maxLengthSquared = 0.0f;
+    for (const VertexData& vertex : vertices) {
+        float lengthSquared = vertex.position.x * vertex.position.x + vertex.position.y * vertex.position.y + vertex.position.z * vertex.position.z;
+        maxLengthSquared = lengthSquared < maxLengthSquared ? maxLengthSquared : lengthSquared;
+    }
+    return maxLengthSquared;
+}
+constexpr float kParticleRadiusSquared = CalculateMaxLengthSquared(kParticleVertices);
+static_assert(kParticleRadiusSquared == 2.0f);
+
+Vector3 TransformPoint(const Vector3& point, const Matrix4x4& matrix)
+{
+    return {
+        point.x * matrix.m[0][0] + point.y * matrix.m[1][0] + point.z * matrix.m[2][0] + matrix.m[3][0],
+        point.x * matrix.m[0][1] + point.y * matrix.m[1][1] + point.z * matrix.m[2][1] + matrix.m[3][1],
+        point.x * matrix.m[0][2] + point.y * matrix.m[1][2] + point.z * matrix.m[2][2] + matrix.m[3][2],
+    };
+}
+
+// ローカルの球をワールド行列で変換する(半径は一番大きい拡縮に合わせる)
+Sphere TransformSphere(const Sphere& sphere, const Matrix4x4& matrix)
+{
+    float maxScaleSquared = 0.0f;
+    for (int i = 0; i < 3; ++i) {
+        float scaleSquared = matrix.m[i][0] * matrix.m[i][0] + matrix.m[i][1] * matrix.m[i][1] + matrix.m[i][2] * matrix.m[i][2];
+        maxScaleSquared = std::max(maxScaleSquared, scaleSquared);
+    }
+    return { TransformPoint(sphere.center, matrix), sphere.radius * std::sqrt(maxScaleSquared) };
+}
+
+}
+
+void InitializeScene(Scene& scene, uint32_t seed, float aspectRatio, size_t particleCapacity)
+{
+    scene.camera.SetTransform({ { 1.0f, 1.0f, 1.0f }, { 0.3f, 3.14f, 0.0f }, { 0.0f, 4.0f, 10.0f } });
+    scene.camera.SetProjection(0.45f, aspectRatio, 0.1f, 100.0f);
+    scene.sphereTransform = { { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+    scene.modelTransform = { { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+    // 球は半径1で作っている。モデルは読み込んだ後で差し替える
+    scene.sphereBounds = { { 0.0f, 0.0f, 0.0f }, 1.0f };
+    scene.modelBounds = { { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } };
+    scene.particleBounds = { { 0.0f, 0.0f, 0.0f }, std::sqrt(kParticleRadiusSquared) };
+
+    scene.emitter = {};
+    scene.emitter.count = 3;
+    scene.emitter.frequency = 0.5f;
+    scene.emitter.ferquencyTime = 0.0f;
+    scene.emitter.transform.translate = { 0.0f, 0.0f, 0.0f };
+    scene.emitter.transform.rotate = { 0.0f, 0.0f, 0.0f };
+    scene.emitter.transform.scale = { 1.0f, 1.0f, 1.0f };
+
+    scene.accelerationField.acceleration = { 15.0f, 0.0f, 0.0f };
+    scene.accelerationField.area.min = { -1.0f, -1.0f, -1.0f };
+    scene.accelerationField.area.max = { 1.0f, 1.0f, 1.0f };
+
+    scene.randomEngine.seed(seed);
+    scene.particles.Initialize(particleCapacity);
+    scene.threadPool = nullptr;
+    scene.particles.Spawn(scene.randomEngine, scene.emitter.transform.translate, 3);
+
+    scene.deltaTime = 1.0f / 60.0f;
+    scene.useBillboard = false;
+    scene.useCulling = true;
+    scene.usePackedModel = false;
+    scene.modelDequantizeMatrix = MakeIdentity4x4();
+    scene.sphereLodCount = 1;
+    scene.modelLodCount = 1;
+    scene.useModelLod = true;
+    scene.useSphereLod = true;
+    scene.useMeshletCulling = true;
+    scene.isSphereVisible = true;
+    scene.sphereLod = 0;
+    scene.isModelVisible = true;
+    scene.modelLod = 0;
+    scene.isModelMeshletCulled = false;
+    scene.modelMeshletStats = {};
+    scene.culledParticleCount = 0;
+    scene.sphereContacts.clear();
+}
+
+uint32_t UpdateScene(Scene& scene, const SceneTargets& targets, SceneTimings* timings)
+{
+    PhaseTimer timer(timings);
+    const float kDeltaTime = scene.deltaTime;
+
+    // カメラの行列は動かしたときだけ作り直される
+    const Matrix4x4& viewProjectionMatrix = scene.camera.GetViewProjectionMatrix();
+    timer.Lap(&SceneTimings::camera);
+
+    const Frustum& frustum = scene.camera.GetFrustum();
+
+    // 球体
+    const Transform& transformsphere = scene.sphereTransform;
+    Matrix4x4 worldMatrixsphere = MakeAffineMatrix(transformsphere);
+    Sphere worldSpheresphere = TransformSphere(scene.sphereBounds, worldMatrixsphere);
+    scene.isSphereVisible = !scene.useCulling || IsCollision(frustum, worldSpheresphere);
+    if (scene.isSphereVisible) {
+        Matrix4x4 worldViewProjectionMatrixsphere = Multiply(worldMatrixsphere, viewProjectionMatrix);
+        targets.sphere->WVP = worldViewProjectionMatrixsphere;
+        targets.sphere->world = worldMatrixsphere;
+        targets.sphere->worldInverseTranspose = MakeNormalMatrix(worldMatrixsphere);
+
+        scene.sphereLod = 0;
+        if (scene.useSphereLod && scene.sphereLodCount > 1) {
+            scene.sphereLod = SelectLod(CalculateScreenSize(scene.camera, worldSpheresphere), scene.sphereLodCount);
+        }
+    }
+
+    targets.sphereLight->direction = Normalize(targets.sphereLight->direction);
+    timer.Lap(&SceneTimings::sphere);
+
+    // モデルデータ
+    const Transform& transformModel = scene.modelTransform;
+    Matrix4x4 worldMatrixModel = MakeAffineMatrix(transformModel);
+    scene.isModelVisible = !scene.useCulling || IsCollision(frustum, TransformAABB(scene.modelBounds, worldMatrixModel));
+    if (scene.isModelVisible) {
+        // 法線は別に戻すので、worldInverseTransposeには掛けない
+        Matrix4x4 vertexWorldMatrixModel = scene.usePackedModel ? Multiply(scene.modelDequantizeMatrix, worldMatrixModel) : worldMatrixModel;
+        Matrix4x4 worldViewProjectionMatrixModel = Multiply(vertexWorldMatrixModel, viewProjectionMatrix);
+        targets.model->WVP = worldViewProjectionMatrixModel;
+        targets.model->world = vertexWorldMatrixModel;
+        targets.model->worldInverseTranspose = MakeNormalMatrix(worldMatrixModel);
+
+        // AABBを囲む球の映る大きさでLODを選ぶ
+        scene.modelLod = 0;
+        if (scene.useModelLod && scene.modelLodCount > 1) {
+            const AABB& bounds = scene.modelBounds;
+            Vector3 halfExtent = { (bounds.max.x - bounds.min.x) * 0.5f, (bounds.max.y - bounds.min.y) * 0.5f, (bounds.max.z - bounds.min.z) * 0.5f };
+            Sphere localSphere = { { bounds.min.x + halfExtent.x, bounds.min.y + halfExtent.y, bounds.min.z + halfExtent.z },
+                std::sqrt(halfExtent.x * halfExtent.x + halfExtent.y * halfExtent.y + halfExtent.z * halfExtent.z) };
+            float screenSize = CalculateScreenSize(scene.camera, TransformSphere(localSphere, worldMatrixModel));
+            scene.modelLod = SelectLod(screenSize, scene.modelLodCount);
+        }
+
+        // 元のメッシュを描くときは、見えないメッシュレットを除いたindexの範囲を作る
+        scene.isModelMeshletCulled = scene.useMeshletCulling && scene.modelLod == 0 && !scene.modelMeshlets.empty();
+        if (scene.isModelMeshletCulled) {
+            CullMeshlets(scene.modelMeshlets, scene.modelMeshletBounds, worldMatrixModel, Multiply(worldMatrixModel, viewProjectionMatrix),
+                scene.camera.GetTransform().translate, scene.modelMeshletVisibleMask, scene.modelDrawRanges, &scene.modelMeshletStats);
+        }
+    }
+
+    // 球とモデルの当たり判定は、球をモデルのローカル空間に移してBVHで調べる
+    scene.sphereContacts.clear();
+    if (!scene.modelBvh.IsEmpty()) {
+        scene.modelBvh.QuerySphere(TransformSphere(worldSpheresphere, InverseAffine(worldMatrixModel)), scene.sphereContacts);
+    }
+
+    targets.modelLight->direction = Normalize(targets.modelLight->direction);
+    timer.Lap(&SceneTimings::model);
+
+    const Matrix4x4& billboardMatrix = scene.camera.GetBillboardMatrix();
+    timer.Lap(&SceneTimings::billboard);
+
+    // 板ポリ
+    // kParticleRangeSize個ずつの範囲に分け、範囲毎にスレッドへ渡す。
+    // 分け方はスレッド数によらず、見えているものの詰める位置も範囲毎の数の累積和で決めるので、結果は常に同じ
+    ParticlePool& particles = scene.particles;
+    const float* positionX = particles.GetPositionX();
+    const float* positionY = particles.GetPositionY();
+    const float* positionZ = particles.GetPositionZ();
+    const Vector4* colors = particles.GetColors();
+    const float* alphas = particles.GetAlphas();
+    size_t particleCount = particles.GetSize();
+    uint32_t rangeCount = uint32_t((particleCount + kParticleRangeSize - 1) / kParticleRangeSize);
+    auto forEachRange = [&](auto&& function) {
+        if (scene.threadPool) {
+            scene.threadPool->ParallelFor(rangeCount, function);
+        } else {
+            for (uint32_t range = 0; range < rangeCount; ++range) {
+                function(range);
+            }
+        }
+    };
+
+    // 移動前の位置で境界球を作っておく
+    std::vector<Sphere>& particleSpheres = scene.particleSpheres;
+    particleSpheres.resize(particleCount);
+    // 回転しても収まるように、ローカルの中心までの距離を半径に足しておく(拡縮は1で固定)
+    const Sphere& particleBounds = scene.particleBounds;
+    float particleRadius = std::sqrt(particleBounds.center.x * particleBounds.center.x + particleBounds.center.y * particleBounds.center.y + particleBounds.center.z * particleBounds.center.z) + particleBounds.radius;
+    forEachRange([&](uint32_t range) {
+        size_t end = std::min(particleCount, (range + 1) * kParticleRangeSize);
+        for (size_t i = range * kParticleRangeSize; i < end; ++i) {
+            Vector3 translate = { positionX[i], positionY[i], positionZ[i] };
+            // ビルボードは平行移動の後に掛けるので、位置もビルボードで回す
+            Vector3 center = scene.useBillboard ? TransformPoint(translate, billboardMatrix) : translate;
+            particleSpheres[i] = { center, particleRadius };
+        }
+    });
+    timer.Lap(&SceneTimings::particle);
+
+    // 範囲毎に見えている数を数え、累積和で詰める位置を決める
+    std::vector<uint32_t>& visibleMask = scene.particleVisibleMask;
+    std::vector<size_t>& rangeOffsets = scene.particleRangeOffsets;
+    visibleMask.resize(GetVisibleMaskWordCount(particleCount));
+    rangeOffsets.assign(rangeCount + 1, 0);
+    forEachRange([&](uint32_t range) {
+        size_t begin = range * kParticleRangeSize;
+        size_t count = std::min(particleCount - begin, kParticleRangeSize);
+        uint32_t* rangeMask = visibleMask.data() + begin / 32;
+        if (scene.useCulling) {
+            rangeOffsets[range + 1] = CullSpheres(frustum, particleSpheres.data() + begin, count, rangeMask);
+        } else {
+            std::fill(rangeMask, rangeMask + GetVisibleMaskWordCount(count), ~0u);
+            rangeOffsets[range + 1] = count;
+        }
+    });
+    for (uint32_t range = 0; range < rangeCount; ++range) {
+        rangeOffsets[range + 1] += rangeOffsets[range];
+    }
+    size_t visibleCount = rangeOffsets[rangeCount];
+    timer.Lap(&SceneTimings::culling);
+
+    // 見えているものを範囲毎に決まった位置へ詰める(入りきらないものは描かない)。
+    // 行列は移動前の位置から作り、alphaは進めた後の値を入れる。描かないものも含めて全て進める
+    uint32_t numInstance = uint32_t(std::min<size_t>(visibleCount, targets.maxInstance));
+    std::vector<Transform>& instanceTransforms = scene.instanceTransforms;
+    std::vector<uint32_t>& instanceParticleIndices = scene.instanceParticleIndices;
+    instanceTransforms.resize(numInstance);
+    instanceParticleIndices.resize(numInstance);
+    forEachRange([&](uint32_t range) {
+        size_t begin = range * kParticleRangeSize;
+        size_t end = std::min(particleCount, begin + kParticleRangeSize);
+        size_t firstInstance = std::min<size_t>(rangeOffsets[range], numInstance);
+        size_t endInstance = std::min<size_t>(rangeOffsets[range + 1], numInstance);
+        size_t instance = firstInstance;
+        for (size_t i = begin; i < end && instance < endInstance; ++i) {
+            if (IsVisible(visibleMask.data(), i)) {
+                instanceTransforms[instance] = { { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }, { positionX[i], positionY[i], positionZ[i] } };
+                instanceParticleIndices[instance] = uint32_t(i);
+                targets.instancing[instance].color = colors[i];
+                ++instance;
+            }
+        }
+
+        IntegrateParticles(particles, scene.accelerationField, kDeltaTime, begin, end);
+        for (instance = firstInstance; instance < endInstance; ++instance) {
+            targets.instancing[instance].color.w = alphas[instanceParticleIndices[instance]];
+        }
+        MakeTransformMatricesBatch(instanceTransforms.data() + firstInstance, endInstance - firstInstance, viewProjectionMatrix,
+            scene.useBillboard ? &billboardMatrix : nullptr, MakeTransformBatchOutput(targets.instancing + firstInstance));
+    });
+    // このフレームで寿命が尽きたものは描いた後で消す
+    particles.RemoveDead();
+    scene.culledParticleCount = uint32_t(particleCount - visibleCount);
+    timer.Lap(&SceneTimings::particle);
+
+    Emitter& emitter = scene.emitter;
+    emitter.ferquencyTime += kDeltaTime;
+    if (emitter.frequency <= emitter.ferquencyTime) {
+        Emit(emitter, scene.randomEngine, particles);
+        emitter.ferquencyTime -= emitter.frequency;
+    }
+    timer.Lap(&SceneTimings::emit);
+
+    return numInstance;
+}
+
+bool PickModel(const Scene& scene, float ndcX, float ndcY, RayHit& hit)
+{
+    if (scene.modelBvh.IsEmpty()) {
+        return false;
+    }
+    // Inverse(WVP)で戻すので、t = 1が奥のクリップ面になる
+    Matrix4x4 worldViewProjectionMatrix = Multiply(MakeAffineMatrix(scene.modelTransform), scene.camera.GetViewProjectionMatrix());
+    Ray ray = MakeScreenRay(Inverse(worldViewProjectionMatrix), ndcX, ndcY);
+    return scene.modelBvh.Intersect(ray, 1.0f, hit);
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "Bvh.h"
+#include "Camera.h"
+#include "GPUData.h"
+#include "Meshlet.h"
+#include "MyMath.h"
+#include "Parallel.h"
+#include "Particle.h"
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+const size_t kSceneParticleCapacity = 65536; // パーティクルの最大数(これ以上は生成しない)
+
+// 毎フレーム更新するシーンの状態
+struct Scene {
+    Camera camera;
+    Transform sphereTransform;
+    Transform modelTransform;
+    Sphere sphereBounds; // 球のローカル空間での境界
+    uint32_t sphereLodCount; // 球のLODの数(GetLodCount。1ならLOD無し)
+    AABB modelBounds; // モデルのローカル空間での境界
+    Matrix4x4 modelDequantizeMatrix; // 詰めた頂点の位置をローカル空間に戻す行列(MakeDequantizeMatrix)
+    uint32_t modelLodCount; // モデルのLODの数(GetLodCount。1ならLOD無し)
+    std::vector<Meshlet> modelMeshlets; // モデルのメッシュレット(ModelData::meshletsの写し。空なら無し)
+    std::vector<Sphere> modelMeshletBounds;
+    Bvh modelBvh; // モデルの三角形のBVH(ローカル空間。空なら当たり判定をしない)
+    Sphere particleBounds; // パーティクル1つのローカル空間での境界
+    Emitter emitter;
+    AccelerationField accelerationField;
+    ParticlePool particles;
+    std::vector<Transform> instanceTransforms; // 描画するパーティクルのTransform(毎フレーム詰め直す)
+    std::vector<uint32_t> instanceParticleIndices; // instanceTransformsのパーティクルの番号
+    std::vector<Sphere> particleSpheres; // 生きているパーティクルのワールド空間での境界
+    std::vector<uint32_t> particleVisibleMask; // particleSpheresのカリング結果
+    std::vector<size_t> particleRangeOffsets; // kParticleRangeSize毎の範囲の、最初の見えているものが何番目か(最後は見えている数)
+    ThreadPool* threadPool; // パーティクルを範囲毎に分けて更新するスレッド(nullptrなら呼び出したスレッドだけ)
+    std::mt19937 randomEngine;
+    float deltaTime;
+    bool useBillboard;
+    bool useCulling;
+    bool usePackedModel; // モデルをPackedVertexDataで描く(WVPとworldの前にmodelDequantizeMatrixを掛ける)
+    bool useModelLod; // 画面に映る大きさでモデルのLODを選ぶ
+    bool useSphereLod; // 画面に映る大きさで球のLODを選ぶ
+    bool useMeshletCulling; // LOD0のときにメッシュレット毎にカリングする
+    // 以下はUpdateSceneの結果
+    bool isSphereVisible;
+    uint32_t sphereLod; // 描く球のLOD(0が元のメッシュ)
+    bool isModelVisible;
+    uint32_t modelLod; // 描くモデルのLOD(0が元のメッシュ)
+    bool isModelMeshletCulled; // trueならサブメッシュの代わりにmodelDrawRangesを描く
+    std::vector<Submesh> modelDrawRanges; // カリングで残ったメッシュレットのindexの範囲
+    std::vector<uint32_t> modelMeshletVisibleMask; // 作業用
+    MeshletCullStats modelMeshletStats;
+    uint32_t culledParticleCount; // 視錐台の外で詰めなかった数
+    std::vector<uint32_t> sphereContacts; // 球と重なるモデルの三角形の番号
+};
+
+// 更新結果の書き込み先(GPUリソースをMapしたアドレス)
+struct SceneTargets {
+    TransformationMatrix* sphere;
+    TransformationMatrix* model;
+    DirectionalLight* sphereLight;
+    DirectionalLight* modelLight;
+    ParticleForGPU* instancing;
+    uint32_t maxInstance;
+};
+
+// フェーズ毎の処理時間(マイクロ秒、加算していく)
+struct SceneTimings {
+    double camera;
+    double sphere;
+    double model;
+    double billboard;
+    double culling;
+    double particle;
+    double emit;
+};
+
+// 初期状態を作る
+// particleCapacity分のパーティクルをここで確保し、UpdateSceneでは確保しない
+void InitializeScene(Scene& scene, uint32_t seed, float aspectRatio, size_t particleCapacity = kSceneParticleCapacity);
+// 1フレーム分の更新。書き込んだインスタンス数を返す
+// 視錐台の外にあるものは行列を書き込まない(isSphereVisible/isModelVisibleを見て描画を飛ばす)
+uint32_t UpdateScene(Scene& scene, const SceneTargets& targets, SceneTimings* timings = nullptr);
+// スクリーンの点(NDC)を通るレイで、一番手前にあるモデルの三角形を探す(modelBvhが空ならfalse)
+bool PickModel(const Scene& scene, float ndcX, float ndcY, RayHit& hit);
@@ -0,0 +1,75 @@
+#pragma once
+#include <immintrin.h>
+
+// SIMDレジスタ単位のsin/cos(MatrixSSE.cpp/MatrixAVX2.cppから使う)
+//
+// 命令セットの違うファイルから使うので、staticにしてファイル毎に別の実体を持たせる(CMakeLists.txtを参照)。
+//
+// π/2単位で[-π/4, π/4]に畳んでから多項式で近似する(係数はCephesのsinf/cosf)。
+// π/2は3つに分けて引くので、|x| < 8192 なら誤差は絶対値で 2^-22 以内。
+
+// 4要素分のsinとcos (SSE4.1)
+static inline void SinCos128(__m128 x, __m128& sin, __m128& cos)
+{
+    const __m128 kTwoOverPi = _mm_set1_ps(0.636619772f);
+    const __m128 kPiOver2Hi = _mm_set1_ps(1.5703125f);
+    const __m128 kPiOver2Mid = _mm_set1_ps(4.837512969970703125e-4f);
+    const __m128 kPiOver2Lo = _mm_set1_ps(7.54978995489188216e-8f);
+
+    // 象限を求めて[-π/4, π/4]に畳む
+    __m128 quadrant = _mm_round_ps(_mm_mul_ps(x, kTwoOverPi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(quadrant, kPiOver2Hi));
+    r = _mm_sub_ps(r, _mm_mul_ps(quadrant, kPiOver2Mid));
+    r = _mm_sub_ps(r, _mm_mul_ps(quadrant, kPiOver2Lo));
+    __m128 r2 = _mm_mul_ps(r, r);
+
+    // sin(r) = r + r^3 * (s1 + r^2 * (s2 + r^2 * s3))
+    __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), r2), _mm_set1_ps(8.3321608736e-3f));
+    s = _mm_add_ps(_mm_mul_ps(s, r2), _mm_set1_ps(-1.6666654611e-1f));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, r2), r), r);
+    // cos(r) = 1 - r^2/2 + r^4 * (c1 + r^2 * (c2 + r^2 * c3))
+    __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), r2), _mm_set1_ps(-1.388731625493765e-3f));
+    c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(4.166664568298827e-2f));
+    c = _mm_mul_ps(_mm_mul_ps(c, r2), r2);
+    c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(r2, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+    // 象限が奇数ならsinとcosを入れ替え、sinは2,3、cosは1,2の象限で符号を反転する
+    __m128i q = _mm_cvtps_epi32(quadrant);
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+    sin = _mm_xor_ps(_mm_blendv_ps(s, c, swap), sinSign);
+    cos = _mm_xor_ps(_mm_blendv_ps(c, s, swap), cosSign);
+}
+
+#ifdef __AVX2__
+// 8要素分のsinとcos (AVX2)
+static inline void SinCos256(__m256 x, __m256& sin, __m256& cos)
+{
+    const __m256 kTwoOverPi = _mm256_set1_ps(0.636619772f);
+    const __m256 kPiOver2Hi = _mm256_set1_ps(1.5703125f);
+    const __m256 kPiOver2Mid = _mm256_set1_ps(4.837512969970703125e-4f);
+    const __m256 kPiOver2Lo = _mm256_set1_ps(7.54978995489188216e-8f);
+
+    __m256 quadrant = _mm256_round_ps(_mm256_mul_ps(x, kTwoOverPi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(quadrant, kPiOver2Hi));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(quadrant, kPiOver2Mid));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(quadrant, kPiOver2Lo));
+    __m256 r2 = _mm256_mul_ps(r, r);
+
+    __m256 s = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(-1.9515295891e-4f), r2), _mm256_set1_ps(8.3321608736e-3f));
+    s = _mm256_add_ps(_mm256_mul_ps(s, r2), _mm256_set1_ps(-1.6666654611e-1f));
+    s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, r2), r), r);
+    __m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(2.443315711809948e-5f), r2), _mm256_set1_ps(-1.388731625493765e-3f));
+    c = _mm256_add_ps(_mm256_mul_ps(c, r2), _mm256_set1_ps(4.166664568298827e-2f));
+    c = _mm256_mul_ps(_mm256_mul_ps(c, r2), r2);
+    c = _mm256_add_ps(_mm256_sub_ps(c, _mm256_mul_ps(r2, _mm256_set1_ps(0.5f))), _mm256_set1_ps(1.0f));
+
+    __m256i q = _mm256_cvtps_epi32(quadrant);
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+    __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+    __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+    sin = _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sinSign);
+    cos = _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), cosSign);
+}
+#endif
@@ -0,0 +1,79 @@
+#include "Sound.h"
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+SoundData SoundLoadWave(const char* filename)
+{
+
+    // ファイル入力ストリームのインスタンス
+    std::ifstream file;
+    // .wavファイルをバイナリモードで開く
+    file.open(filename, std::ios_base::binary);
+    // ファイルオープン失敗を検出する
+    assert(file.is_open());
+
+    // RIFFヘッダーの読み込み
+    RiffHeader riff;
+    file.read((char*)&riff, sizeof(riff));
+    // ファイルがRIFFかチェック
+    if (strncmp(riff.chunk.id, "RIFF", 4) != 0) {
+        assert(0);
+    }
+    // タイプがWAVEかチェック
+    if (strncmp(riff.type, "WAVE", 4) != 0) {
+        assert(0);
+    }
+
+    // Formatチャンクの読み込み
+    FormatChunk format = {};
+    // チャンクヘッダーの確認
+    file.read((char*)&format, sizeof(ChunkHeader));
+    if (strncmp(format.chunk.id, "fmt ", 4) != 0) {
+        assert(0);
+    }
+    // チャンク本体の読み込み
+    assert(format.chunk.size >= 0 && size_t(format.chunk.size) <= sizeof(format.fmt));
+    file.read((char*)&format.fmt, format.chunk.size);
+
+    // Dataチャンクの読み込み
+    ChunkHeader data;
+    file.read((char*)&data, sizeof(data));
+    // JUNKチャンクを検出した場合
+    if (strncmp(data.id, "JUNK", 4) == 0) {
+        // 読み込み位置をJUNKチャンクの終わりまで進める
+        file.seekg(data.size, std::ios_base::cur);
+        // 再度読み込み
+        file.read((char*)&data, sizeof(data));
+    }
+
+    if (strncmp(data.id, "data", 4) != 0) {
+        assert(0);
+    }
+
+    // Dataチャンクのデータ部の読み込み
+    char* pBuffer = new char[data.size];
+    file.read(pBuffer, data.size);
+
+    // waveファイルを閉じる
+    file.close();
+
+    // Returnするための音声データ
+    SoundData soundData = {};
+
+    soundData.wfex = format.fmt;
+    soundData.pBuffer = reinterpret_cast<BYTE*>(pBuffer);
+    soundData.bufferSize = data.size;
+
+    return soundData;
+}
+
+void SoundUhload(SoundData* soundData)
+{
+    // バッフアのメモリ解放
+    delete[] soundData->pBuffer;
+
+    soundData->pBuffer = 0;
+    soundData->bufferSize = 0;
+    soundData->wfex = {};
+}
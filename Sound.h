@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+// Windows以外ではWAVEFORMATEXと同じ並びの構造体を用意する
+#pragma pack(push, 1)
+struct WAVEFORMATEX {
+    uint16_t wFormatTag;
+    uint16_t nChannels;
+    uint32_t nSamplesPerSec;
+    uint32_t nAvgBytesPerSec;
+    uint16_t nBlockAlign;
+    uint16_t wBitsPerSample;
+    uint16_t cbSize;
+};
+#pragma pack(pop)
+using BYTE = uint8_t;
+#endif
+
+struct ChunkHeader {
+    char id[4]; // チャンク毎のID
+    int32_t size; // チャンクサイズ
+};
+struct RiffHeader {
+    ChunkHeader chunk; // "RIFF"
+    char type[4]; // "WAVE"
+};
+struct FormatChunk {
+    ChunkHeader chunk; // "fmt"
+    WAVEFORMATEX fmt; // 波型フォーマット
+};
+struct SoundData {
+    // 波型フォーマット
+    WAVEFORMATEX wfex;
+    // バッフアの先頭アドレス
+    BYTE* pBuffer;
+    // バッフアのサイズ
+    unsigned int bufferSize;
+};
+
+// waveファイルを読み込む
+SoundData SoundLoadWave(const char* filename);
+// 音声データ解放
+void SoundUhload(SoundData* soundData);
@@ -0,0 +1,155 @@
+#include "TransformBatch.h"
+#include "MatrixSimd.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+const ComposeTransformBlockFunction kComposeTransformBlock[kMatrixBackendCount] = {
+    ComposeTransformBlockScalar,
+#ifdef CG3_MATH_SSE
+    ComposeTransformBlockSSE,
+#else
+    ComposeTransformBlockScalar,
+#endif
+#ifdef CG3_MATH_AVX2
+    ComposeTransformBlockAVX2,
+#else
+    ComposeTransformBlockScalar,
+#endif
+};
+
+// オイラー角(block.rotateの1行目に入れておく)を回転行列にする
+void ComposeEulerRotate(TransformBlock& block)
+{
+    alignas(32) float sins[3][kTransformBlockSize];
+    alignas(32) float coss[3][kTransformBlockSize];
+    for (int axis = 0; axis < 3; ++axis) {
+        SinCos(block.rotate[0][axis], sins[axis], coss[axis], kTransformBlockSize);
+    }
+
+    // rotateX * (rotateY * rotateZ) を展開したもの
+    for (size_t lane = 0; lane < kTransformBlockSize; ++lane) {
+        float cx = coss[0][lane];
+        float sx = sins[0][lane];
+        float cy = coss[1][lane];
+        float sy = sins[1][lane];
+        float cz = coss[2][lane];
+        float sz = sins[2][lane];
+        float yz0[3] = { cy * cz, cy * sz, -sy };
+        float yz1[3] = { -sz, cz, 0.0f };
+        float yz2[3] = { sy * cz, sy * sz, cy };
+        for (int j = 0; j < 3; ++j) {
+            block.rotate[0][j][lane] = yz0[j];
+            block.rotate[1][j][lane] = cx * yz1[j] + sx * yz2[j];
+            block.rotate[2][j][lane] = -sx * yz1[j] + cx * yz2[j];
+        }
+    }
+}
+
+void SetQuaternionRotate(TransformBlock& block, size_t lane, const Quaternion& quaternion)
+{
+    Matrix4x4 rotate = MakeRotateMatrix(quaternion);
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            block.rotate[i][j][lane] = rotate.m[i][j];
+        }
+    }
+}
+
+Matrix4x4& At(Matrix4x4* base, size_t stride, size_t index)
+{
+    return *reinterpret_cast<Matrix4x4*>(reinterpret_cast<uint8_t*>(base) + stride * index);
+}
+
+}
+
+TransformBatchOutput MakeTransformBatchOutput(ParticleForGPU* instances)
+{
+    return { &instances->world, &instances->WVP, sizeof(ParticleForGPU) };
+}
+
+TransformBatchOutput MakeTransformBatchOutput(TransformationMatrix* matrices)
+{
+    return { &matrices->world, &matrices->WVP, sizeof(TransformationMatrix) };
+}
+
+void MakeTransformMatricesBatch(const Transform* transforms, size_t count, const Matrix4x4& viewProjection, const Matrix4x4* worldPost, const TransformBatchOutput& output)
+{
+    ComposeTransformBlockFunction compose = kComposeTransformBlock[GetActiveMatrixBackend()];
+    TransformBlock block {};
+    for (size_t first = 0; first < count; first += kTransformBlockSize) {
+        size_t blockCount = std::min(kTransformBlockSize, count - first);
+        bool hasQuaternion = false;
+        for (size_t lane = 0; lane < blockCount; ++lane) {
+            const Transform& transform = transforms[first + lane];
+            block.scale[0][lane] = transform.scale.x;
+            block.scale[1][lane] = transform.scale.y;
+            block.scale[2][lane] = transform.scale.z;
+            block.rotate[0][0][lane] = transform.rotate.x;
+            block.rotate[0][1][lane] = transform.rotate.y;
+            block.rotate[0][2][lane] = transform.rotate.z;
+            block.translate[0][lane] = transform.translate.x;
+            block.translate[1][lane] = transform.translate.y;
+            block.translate[2][lane] = transform.translate.z;
+            hasQuaternion = hasQuaternion || transform.useQuaternion;
+        }
+        ComposeEulerRotate(block);
+        if (hasQuaternion) {
+            for (size_t lane = 0; lane < blockCount; ++lane) {
+                if (transforms[first + lane].useQuaternion) {
+                    SetQuaternionRotate(block, lane, transforms[first + lane].quaternion);
+                }
+            }
+        }
+        compose(block, blockCount, viewProjection, worldPost, output, first);
+    }
+}
+
+void MakeTransformMatricesBatch(const TransformArrays& transforms, size_t count, const Matrix4x4& viewProjection, const Matrix4x4* worldPost, const TransformBatchOutput& output)
+{
+    ComposeTransformBlockFunction compose = kComposeTransformBlock[GetActiveMatrixBackend()];
+    TransformBlock block {};
+    for (size_t first = 0; first < count; first += kTransformBlockSize) {
+        size_t blockCount = std::min(kTransformBlockSize, count - first);
+        for (size_t lane = 0; lane < blockCount; ++lane) {
+            size_t i = first + lane;
+            block.scale[0][lane] = transforms.scaleX[i];
+            block.scale[1][lane] = transforms.scaleY[i];
+            block.scale[2][lane] = transforms.scaleZ[i];
+            block.rotate[0][0][lane] = transforms.rotateX[i];
+            block.rotate[0][1][lane] = transforms.rotateY[i];
+            block.rotate[0][2][lane] = transforms.rotateZ[i];
+            block.translate[0][lane] = transforms.translateX[i];
+            block.translate[1][lane] = transforms.translateY[i];
+            block.translate[2][lane] = transforms.translateZ[i];
+        }
+        ComposeEulerRotate(block);
+        compose(block, blockCount, viewProjection, worldPost, output, first);
+    }
+}
+
+void ComposeTransformBlockScalar(const TransformBlock& block, size_t count, const Matrix4x4& viewProjection, const Matrix4x4* worldPost, const TransformBatchOutput& output, size_t first)
+{
+    for (size_t lane = 0; lane < count; ++lane) {
+        Matrix4x4 world;
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                world.m[i][j] = block.scale[i][lane] * block.rotate[i][j][lane];
+            }
+            world.m[i][3] = 0.0f;
+            world.m[3][i] = block.translate[i][lane];
+        }
+        world.m[3][3] = 1.0f;
+        if (worldPost) {
+            world = MultiplyScalar(world, *worldPost);
+        }
+
+        if (output.world) {
+            At(output.world, output.stride, first + lane) = world;
+        }
+        if (output.wvp) {
+            At(output.wvp, output.stride, first + lane) = MultiplyScalar(world, viewProjection);
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "GPUData.h"
+#include "MyMath.h"
+#include <cstddef>
+
+// 複数のTransformからworld/WVPをまとめて作る
+//
+// viewProjectionは呼び出し側で1回だけ作って渡す。
+// 8個ずつSoAに並べ替え、SSE4.1なら4個、AVX2なら8個を同時に計算する。
+// オイラー角のsin/cosはSinCosでまとめて求めるので、誤差はMakeAffineMatrixと同じ(MatrixSimd.h)。
+// スカラー版は1個ずつMakeAffineMatrix→Multiplyしたものと符号付きゼロの違いを除いて一致する。
+
+// 書き込み先。worldとwvpはstrideバイト毎に並んでいる(nullptrなら書かない)
+struct TransformBatchOutput {
+    Matrix4x4* world;
+    Matrix4x4* wvp;
+    size_t stride;
+};
+TransformBatchOutput MakeTransformBatchOutput(ParticleForGPU* instances);
+TransformBatchOutput MakeTransformBatchOutput(TransformationMatrix* matrices);
+
+// SoAで並んだTransform(各配列はcount個)
+struct TransformArrays {
+    const float* scaleX;
+    const float* scaleY;
+    const float* scaleZ;
+    const float* rotateX;
+    const float* rotateY;
+    const float* rotateZ;
+    const float* translateX;
+    const float* translateY;
+    const float* translateZ;
+};
+
+// world = MakeAffineMatrix(transforms[i]) * worldPost(nullptrなら掛けない)
+// wvp = world * viewProjection
+// TransformのuseQuaternionに対応する。TransformArraysはオイラー角のみ
+void MakeTransformMatricesBatch(const Transform* transforms, size_t count, const Matrix4x4& viewProjection, const Matrix4x4* worldPost, const TransformBatchOutput& output);
+void MakeTransformMatricesBatch(const TransformArrays& transforms, size_t count, const Matrix4x4& viewProjection, const Matrix4x4* worldPost, const TransformBatchOutput& output);
+
+// 以下はSIMD実装用
+const size_t kTransformBlockSize = 8;
+
+// kTransformBlockSize個分のTransformを要素毎に並べたもの。回転は先に3x3行列にしておく
+struct alignas(32) TransformBlock {
+    float scale[3][kTransformBlockSize];
+    float rotate[3][3][kTransformBlockSize];
+    float translate[3][kTransformBlockSize];
+};
+
+// blockの先頭count個を計算して、output の first 番目から書き込む
+using ComposeTransformBlockFunction = void (*)(const TransformBlock& block, size_t count, const Matrix4x4& viewProjection, const Matrix4x4* worldPost, const TransformBatchOutput& output, size_t first);
+void ComposeTransformBlockScalar(const TransformBlock& block, size_t count, const Matrix4x4& viewProjection, const Matrix4x4* worldPost, const TransformBatchOutput& output, size_t first);
+#ifdef CG3_MATH_SSE
+void ComposeTransformBlockSSE(const TransformBlock& block, size_t count, const Matrix4x4& viewProjection, const Matrix4x4* worldPost, const TransformBatchOutput& output, size_t first);
+#endif
+#ifdef CG3_MATH_AVX2
+void ComposeTransformBlockAVX2(const TransformBlock& block, size_t count, const Matrix4x4& viewProjection, const Matrix4x4* worldPost, const TransformBatchOutput& output, size_t first);
+#endif
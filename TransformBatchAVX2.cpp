@@ -0,0 +1,90 @@
+#include "TransformBatch.h"
+#include <cstdint>
+#include <immintrin.h>
+
+namespace {
+
+const size_t kLanes = 8;
+
+// 各要素がkLanes個分のTransformの値を持つ4x4行列
+struct MatrixLanes {
+    __m256 m[4][4];
+};
+
+// 要素毎に a * b (スカラー版Multiplyと同じく左から順に足す)
+void MultiplyLanes(MatrixLanes& num, const MatrixLanes& a, const Matrix4x4& b)
+{
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            __m256 r = _mm256_mul_ps(a.m[i][0], _mm256_set1_ps(b.m[0][j]));
+            r = _mm256_add_ps(r, _mm256_mul_ps(a.m[i][1], _mm256_set1_ps(b.m[1][j])));
+            r = _mm256_add_ps(r, _mm256_mul_ps(a.m[i][2], _mm256_set1_ps(b.m[2][j])));
+            r = _mm256_add_ps(r, _mm256_mul_ps(a.m[i][3], _mm256_set1_ps(b.m[3][j])));
+            num.m[i][j] = r;
+        }
+    }
+}
+
+// 要素毎の並びからTransform毎の行列に戻して書き込む
+// 128bit毎に転置するので、下位にTransform 0-3、上位に4-7の行が入る
+void StoreLanes(const MatrixLanes& lanes, size_t count, Matrix4x4* base, size_t stride, size_t first)
+{
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(base) + stride * first;
+    for (int i = 0; i < 4; ++i) {
+        __m256 t0 = _mm256_unpacklo_ps(lanes.m[i][0], lanes.m[i][1]);
+        __m256 t1 = _mm256_unpackhi_ps(lanes.m[i][0], lanes.m[i][1]);
+        __m256 t2 = _mm256_unpacklo_ps(lanes.m[i][2], lanes.m[i][3]);
+        __m256 t3 = _mm256_unpackhi_ps(lanes.m[i][2], lanes.m[i][3]);
+        __m256 r0 = _mm256_shuffle_ps(t0, t2, 0x44);
+        __m256 r1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+        __m256 r2 = _mm256_shuffle_ps(t1, t3, 0x44);
+        __m256 r3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+        __m128 rows[kLanes] = {
+            _mm256_castps256_ps128(r0),
+            _mm256_castps256_ps128(r1),
+            _mm256_castps256_ps128(r2),
+            _mm256_castps256_ps128(r3),
+            _mm256_extractf128_ps(r0, 1),
+            _mm256_extractf128_ps(r1, 1),
+            _mm256_extractf128_ps(r2, 1),
+            _mm256_extractf128_ps(r3, 1),
+        };
+        for (size_t lane = 0; lane < count; ++lane) {
+            _mm_storeu_ps(reinterpret_cast<Matrix4x4*>(bytes + stride * lane)->m[i], rows[lane]);
+        }
+    }
+}
+
+}
+
+void ComposeTransformBlockAVX2(const TransformBlock& block, size_t count, const Matrix4x4& viewProjection, const Matrix4x4* worldPost, const TransformBatchOutput& output, size_t first)
+{
+    // 回転行列の各行に拡縮を掛け、平行移動を入れる
+    __m256 zero = _mm256_setzero_ps();
+    MatrixLanes world;
+    for (int i = 0; i < 3; ++i) {
+        __m256 scale = _mm256_load_ps(block.scale[i]);
+        for (int j = 0; j < 3; ++j) {
+            world.m[i][j] = _mm256_mul_ps(scale, _mm256_load_ps(block.rotate[i][j]));
+        }
+        world.m[3][i] = _mm256_load_ps(block.translate[i]);
+    }
+    world.m[0][3] = zero;
+    world.m[1][3] = zero;
+    world.m[2][3] = zero;
+    world.m[3][3] = _mm256_set1_ps(1.0f);
+    if (worldPost) {
+        MatrixLanes posted;
+        MultiplyLanes(posted, world, *worldPost);
+        world = posted;
+    }
+
+    if (output.world) {
+        StoreLanes(world, count, output.world, output.stride, first);
+    }
+    if (output.wvp) {
+        MatrixLanes wvp;
+        MultiplyLanes(wvp, world, viewProjection);
+        StoreLanes(wvp, count, output.wvp, output.stride, first);
+    }
+}
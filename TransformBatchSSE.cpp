@@ -0,0 +1,85 @@
+#include "TransformBatch.h"
+#include <cstdint>
+#include <smmintrin.h>
+
+namespace {
+
+const size_t kLanes = 4;
+
+// 各要素がkLanes個分のTransformの値を持つ4x4行列
+struct MatrixLanes {
+    __m128 m[4][4];
+};
+
+// 要素毎に a * b (スカラー版Multiplyと同じく左から順に足す)
+void MultiplyLanes(MatrixLanes& num, const MatrixLanes& a, const Matrix4x4& b)
+{
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            __m128 r = _mm_mul_ps(a.m[i][0], _mm_set1_ps(b.m[0][j]));
+            r = _mm_add_ps(r, _mm_mul_ps(a.m[i][1], _mm_set1_ps(b.m[1][j])));
+            r = _mm_add_ps(r, _mm_mul_ps(a.m[i][2], _mm_set1_ps(b.m[2][j])));
+            r = _mm_add_ps(r, _mm_mul_ps(a.m[i][3], _mm_set1_ps(b.m[3][j])));
+            num.m[i][j] = r;
+        }
+    }
+}
+
+// 要素毎の並びからTransform毎の行列に戻して書き込む
+void StoreLanes(const MatrixLanes& lanes, size_t count, Matrix4x4* base, size_t stride, size_t first)
+{
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(base) + stride * first;
+    for (int i = 0; i < 4; ++i) {
+        __m128 r0 = lanes.m[i][0];
+        __m128 r1 = lanes.m[i][1];
+        __m128 r2 = lanes.m[i][2];
+        __m128 r3 = lanes.m[i][3];
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        __m128 rows[kLanes] = { r0, r1, r2, r3 };
+        for (size_t lane = 0; lane < count; ++lane) {
+            _mm_storeu_ps(reinterpret_cast<Matrix4x4*>(bytes + stride * lane)->m[i], rows[lane]);
+        }
+    }
+}
+
+void ComposeLanes(const TransformBlock& block, size_t offset, size_t count, const Matrix4x4& viewProjection, const Matrix4x4* worldPost, const TransformBatchOutput& output, size_t first)
+{
+    // 回転行列の各行に拡縮を掛け、平行移動を入れる
+    __m128 zero = _mm_setzero_ps();
+    MatrixLanes world;
+    for (int i = 0; i < 3; ++i) {
+        __m128 scale = _mm_load_ps(block.scale[i] + offset);
+        for (int j = 0; j < 3; ++j) {
+            world.m[i][j] = _mm_mul_ps(scale, _mm_load_ps(block.rotate[i][j] + offset));
+        }
+        world.m[3][i] = _mm_load_ps(block.translate[i] + offset);
+    }
+    world.m[0][3] = zero;
+    world.m[1][3] = zero;
+    world.m[2][3] = zero;
+    world.m[3][3] = _mm_set1_ps(1.0f);
+    if (worldPost) {
+        MatrixLanes posted;
+        MultiplyLanes(posted, world, *worldPost);
+        world = posted;
+    }
+
+    if (output.world) {
+        StoreLanes(world, count, output.world, output.stride, first);
+    }
+    if (output.wvp) {
+        MatrixLanes wvp;
+        MultiplyLanes(wvp, world, viewProjection);
+        StoreLanes(wvp, count, output.wvp, output.stride, first);
+    }
+}
+
+}
+
+void ComposeTransformBlockSSE(const TransformBlock& block, size_t count, const Matrix4x4& viewProjection, const Matrix4x4* worldPost, const TransformBatchOutput& output, size_t first)
+{
+    for (size_t offset = 0; offset < count; offset += kLanes) {
+        size_t laneCount = count - offset < kLanes ? count - offset : kLanes;
+        ComposeLanes(block, offset, laneCount, viewProjection, worldPost, output, first + offset);
+    }
+}
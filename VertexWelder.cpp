@@ -0,0 +1,79 @@
+#include "VertexWelder.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace {
+
+static_assert(sizeof(VertexData) == sizeof(uint32_t) * 9, "VertexDataに隙間があるとハッシュと比較が合わなくなる");
+
+size_t HashVertex(const VertexData& vertex)
+{
+    uint32_t words[9];
+    std::memcpy(words, &vertex, sizeof(words));
+    uint64_t hash = 0x9E3779B97F4A7C15ull;
+    for (uint32_t word : words) {
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+    }
+    return size_t(hash ^ (hash >> 32));
+}
+
+}
+
+VertexWelder::VertexWelder(std::vector<VertexData>& vertices, size_t expectedVertexCount)
+    : vertices_(vertices)
+    , mask_(0)
+{
+    // 使用率が半分以下になる大きさにする。既に入っている頂点も探せるようにする
+    Rehash(std::bit_ceil(std::max<size_t>(16, std::max(expectedVertexCount, vertices_.size()) * 2)));
+}
+
+uint32_t VertexWelder::Add(const VertexData& vertex)
+{
+    size_t slot = HashVertex(vertex) & mask_;
+    while (slots_[slot] != 0) {
+        uint32_t index = slots_[slot] - 1;
+        if (std::memcmp(&vertices_[index], &vertex, sizeof(VertexData)) == 0) {
+            return index;
+        }
+        slot = (slot + 1) & mask_;
+    }
+    uint32_t index = uint32_t(vertices_.size());
+    vertices_.push_back(vertex);
+    slots_[slot] = index + 1;
+    if (vertices_.size() * 2 > slots_.size()) {
+        Rehash(slots_.size() * 2);
+    }
+    return index;
+}
+
+void VertexWelder::Clear()
+{
+    vertices_.clear();
+    std::fill(slots_.begin(), slots_.end(), 0u);
+}
+
+void VertexWelder::Rehash(size_t slotCount)
+{
+    slots_.assign(slotCount, 0);
+    mask_ = slotCount - 1;
+    for (uint32_t index = 0; index < vertices_.size(); ++index) {
+        size_t slot = HashVertex(vertices_[index]) & mask_;
+        while (slots_[slot] != 0) {
+            slot = (slot + 1) & mask_;
+        }
+        slots_[slot] = index + 1;
+    }
+}
+
+void WeldVertices(const std::vector<VertexData>& source, std::vector<VertexData>& vertices, std::vector<uint32_t>& indices)
+{
+    vertices.clear();
+    indices.clear();
+    indices.reserve(source.size());
+    // まとめると1/3から1/6程度になることが多い
+    VertexWelder welder(vertices, source.size() / 3);
+    for (const VertexData& vertex : source) {
+        indices.push_back(welder.Add(vertex));
+    }
+}
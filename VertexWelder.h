@@ -0,0 +1,32 @@
+#pragma once
+#include "Model.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 位置/uv/法線が全く同じ頂点を1つにまとめる
+//
+// 頂点のbit列をハッシュにしたオープンアドレス法の表で探し、同じものが無ければ追加する。
+// 表には頂点の番号だけを持ち、頂点自体は渡した配列に詰めていく。
+// 比較はbit単位なので、0.0と-0.0は別の頂点になる。
+class VertexWelder {
+public:
+    // verticesに追加していく。expectedVertexCountはまとめた後の頂点数の見込み(表の初期サイズ)
+    VertexWelder(std::vector<VertexData>& vertices, size_t expectedVertexCount);
+
+    // 同じ頂点があればその番号、無ければ追加した番号を返す
+    uint32_t Add(const VertexData& vertex);
+    // 頂点と表を空にする(表の大きさはそのまま。決まった数ずつまとめるときに使う)
+    void Clear();
+
+private:
+    // 表をslotCount(2の累乗)の大きさで作り直す
+    void Rehash(size_t slotCount);
+
+    std::vector<VertexData>& vertices_;
+    std::vector<uint32_t> slots_; // 頂点の番号+1(0は空き)
+    size_t mask_;
+};
+
+// 三角形を並べただけの頂点列をまとめて、頂点とindexにする
+void WeldVertices(const std::vector<VertexData>& source, std::vector<VertexData>& vertices, std::vector<uint32_t>& indices);
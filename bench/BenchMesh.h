@@ -0,0 +1,48 @@
+#pragma once
+#include "Model.h"
+#include <cmath>
+#include <cstdint>
+
+// ベンチマークで使う、作ったメッシュと小さなベクトルの計算
+
+// 1辺gridSize区画のなめらかな起伏(三角形の数は gridSize * gridSize * 2)。
+// -1から1の範囲に広がり、法線は高さの差分から出す
+inline ModelData MakeTerrain(uint32_t gridSize)
+{
+    ModelData modelData;
+    uint32_t rowSize = gridSize + 1;
+    float cellSize = 2.0f / float(gridSize);
+    auto height = [](float x, float z) { return 0.2f * std::sin(x * 3.0f) * std::cos(z * 2.0f) + 0.05f * std::sin(x * 11.0f + z * 7.0f); };
+    for (uint32_t z = 0; z < rowSize; ++z) {
+        for (uint32_t x = 0; x < rowSize; ++x) {
+            float px = -1.0f + cellSize * float(x);
+            float pz = -1.0f + cellSize * float(z);
+            float dx = (height(px + 1e-3f, pz) - height(px - 1e-3f, pz)) / 2e-3f;
+            float dz = (height(px, pz + 1e-3f) - height(px, pz - 1e-3f)) / 2e-3f;
+            float rcpLength = 1.0f / std::sqrt(dx * dx + 1.0f + dz * dz);
+            modelData.vertices.push_back({ { px, height(px, pz), pz, 1.0f }, { float(x) / float(gridSize), float(z) / float(gridSize) },
+                { -dx * rcpLength, rcpLength, -dz * rcpLength } });
+        }
+    }
+    for (uint32_t z = 0; z < gridSize; ++z) {
+        for (uint32_t x = 0; x < gridSize; ++x) {
+            uint32_t lt = z * rowSize + x;
+            uint32_t rt = lt + 1;
+            uint32_t lb = lt + rowSize;
+            uint32_t rb = lb + 1;
+            modelData.indices.insert(modelData.indices.end(), { lt, lb, rt, rt, lb, rb });
+        }
+    }
+    modelData.submeshes.push_back({ 0, uint32_t(modelData.indices.size()), 0 });
+    modelData.materials.push_back({ "Material", "" });
+    return modelData;
+}
+
+inline Vector3 GetPosition(const ModelData& modelData, uint32_t index)
+{
+    const Vector4& p = modelData.vertices[index].position;
+    return { p.x, p.y, p.z };
+}
+
+inline float Dot(const Vector3& a, const Vector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Vector3 Sub(const Vector3& a, const Vector3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
@@ -0,0 +1,124 @@
+#pragma once
+#include "Model.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+// objの読み込みのベンチマーク(cg3_obj_benchとcg3_obj_stream_bench)で使う、objの生成とModelDataの比較
+
+// 1辺gridSize区画の格子の地形(面数は gridSize * gridSize * 2)
+// Blenderの出力と同じく小数6桁・法線4桁で書く
+inline void WriteTerrain(const std::filesystem::path& path, uint32_t gridSize)
+{
+    std::mt19937 engine(gridSize);
+    std::uniform_real_distribution<float> height(-0.5f, 0.5f);
+    std::FILE* file = std::fopen(path.string().c_str(), "w");
+    std::fprintf(file, "# synthetic terrain %ux%u\nmtllib terrain.mtl\no Terrain\n", gridSize, gridSize);
+    uint32_t rowSize = gridSize + 1;
+    float cellSize = 2.0f / float(gridSize);
+    for (uint32_t z = 0; z < rowSize; ++z) {
+        for (uint32_t x = 0; x < rowSize; ++x) {
+            std::fprintf(file, "v %f %f %f\n", -1.0f + cellSize * float(x), height(engine), -1.0f + cellSize * float(z));
+        }
+    }
+    for (uint32_t z = 0; z < rowSize; ++z) {
+        for (uint32_t x = 0; x < rowSize; ++x) {
+            std::fprintf(file, "vt %f %f\n", float(x) / float(gridSize), float(z) / float(gridSize));
+        }
+    }
+    for (uint32_t z = 0; z < rowSize; ++z) {
+        for (uint32_t x = 0; x < rowSize; ++x) {
+            float nx = height(engine) * 0.2f;
+            float nz = height(engine) * 0.2f;
+            float rcpLength = 1.0f / std::sqrt(nx * nx + 1.0f + nz * nz);
+            std::fprintf(file, "vn %.4f %.4f %.4f\n", nx * rcpLength, rcpLength, nz * rcpLength);
+        }
+    }
+    std::fprintf(file, "usemtl Material\ns off\n");
+    for (uint32_t z = 0; z < gridSize; ++z) {
+        for (uint32_t x = 0; x < gridSize; ++x) {
+            uint32_t lt = z * rowSize + x + 1;
+            uint32_t rt = lt + 1;
+            uint32_t lb = lt + rowSize;
+            uint32_t rb = lb + 1;
+            std::fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", lt, lt, lt, lb, lb, lb, rt, rt, rt);
+            std::fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", rt, rt, rt, lb, lb, lb, rb, rb, rb);
+        }
+    }
+    std::fclose(file);
+}
+
+// サブメッシュとマテリアルが同じか
+inline bool IsSameMaterials(const ModelData& a, const ModelData& b)
+{
+    if (a.submeshes.size() != b.submeshes.size() || a.materials.size() != b.materials.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.submeshes.size(); ++i) {
+        const Submesh& sa = a.submeshes[i];
+        const Submesh& sb = b.submeshes[i];
+        if (sa.indexOffset != sb.indexOffset || sa.indexCount != sb.indexCount || sa.materialIndex != sb.materialIndex) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < a.materials.size(); ++i) {
+        if (a.materials[i].name != b.materials[i].name || a.materials[i].textureFilePath != b.materials[i].textureFilePath) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// LODが全く同じか
+inline bool IsSameLods(const ModelData& a, const ModelData& b)
+{
+    if (a.lods.size() != b.lods.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.lods.size(); ++i) {
+        const MeshLod& la = a.lods[i];
+        const MeshLod& lb = b.lods[i];
+        if (la.indices != lb.indices || la.error != lb.error || la.submeshes.size() != lb.submeshes.size()) {
+            return false;
+        }
+        for (size_t s = 0; s < la.submeshes.size(); ++s) {
+            if (la.submeshes[s].indexOffset != lb.submeshes[s].indexOffset || la.submeshes[s].indexCount != lb.submeshes[s].indexCount
+                || la.submeshes[s].materialIndex != lb.submeshes[s].materialIndex) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// メッシュレットが全く同じか
+inline bool IsSameMeshlets(const ModelData& a, const ModelData& b)
+{
+    return a.meshlets.size() == b.meshlets.size() && a.meshletBounds.size() == b.meshletBounds.size()
+        && (a.meshlets.empty() || std::memcmp(a.meshlets.data(), b.meshlets.data(), sizeof(Meshlet) * a.meshlets.size()) == 0)
+        && (a.meshletBounds.empty() || std::memcmp(a.meshletBounds.data(), b.meshletBounds.data(), sizeof(Sphere) * a.meshletBounds.size()) == 0);
+}
+
+// 頂点とindexが全く同じか
+inline bool IsIdentical(const ModelData& a, const ModelData& b)
+{
+    return a.vertices.size() == b.vertices.size() && a.indices == b.indices && IsSameMaterials(a, b) && IsSameLods(a, b) && IsSameMeshlets(a, b)
+        && (a.vertices.empty() || std::memcmp(a.vertices.data(), b.vertices.data(), sizeof(VertexData) * a.vertices.size()) == 0);
+}
+
+// indicesの順に並べた頂点が一致するか
+inline bool IsSame(const ModelData& a, const ModelData& b)
+{
+    if (a.indices.size() != b.indices.size() || !IsSameMaterials(a, b)) {
+        return false;
+    }
+    for (size_t i = 0; i < a.indices.size(); ++i) {
+        if (std::memcmp(&a.vertices[a.indices[i]], &b.vertices[b.indices[i]], sizeof(VertexData)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,363 @@
+// 三角形のBVHの構築と検索を計測する
+//
+// resources/terrain.objと、なめらかな起伏の格子・正20面体の球(三角形の数を指定して作る)でBvh::Buildの時間を
+// 1スレッドと--threadsで比べ、ノードと三角形の並びがスレッド数によらず同じかを確かめる。
+// ランダムなレイ(半分は真上から下へ、マウスで選ぶときのように)で一番近い交点・何かに当たるか、
+// ランダムな球(弾の当たり判定のように)で重なる三角形を求め、1回あたりの時間を出す。
+// 結果は全ての三角形を調べたものと比べ、違えば失敗にする
+//   - 一番近い交点の距離が同じ(同じ距離の三角形が2枚あればどちらでもよい)
+//   - 当たるかどうかが同じ。球と重なる三角形の集合が同じ
+//   - スカラー版とSIMD版で交点の距離・三角形・uvが全く同じ
+//   - 全ての三角形がちょうど1回ずつ葉に入り、子の箱が中身を全て含む
+#include "BenchMesh.h"
+#include "Bvh.h"
+#include "MatrixSimd.h"
+#include "Model.h"
+#include "Parallel.h"
+#include "PrimitiveMesh.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    size_t maxTriangles = 2000000;
+    uint32_t rayCount = 10000;
+    uint32_t verifyCount = 300; // 全ての三角形を調べて比べる数
+    uint32_t threadCount = 0;
+    std::string resources = "resources";
+};
+
+void PrintUsage()
+{
+    std::printf("usage: cg3_bvh_bench [--max-triangles N] [--rays N] [--verify N] [--threads N] [--resources DIR]\n");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--max-triangles" && hasValue) {
+            options.maxTriangles = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--rays" && hasValue) {
+            options.rayCount = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--verify" && hasValue) {
+            options.verifyCount = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--threads" && hasValue) {
+            options.threadCount = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--resources" && hasValue) {
+            options.resources = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 全ての三角形を調べる(式はBvhIntersectScalarと同じ)。hitがnullptrなら当たるかだけ
+bool IntersectBruteForce(const ModelData& modelData, const Ray& ray, float maxT, RayHit* hit)
+{
+    const Vector3& o = ray.origin;
+    const Vector3& d = ray.direction;
+    float bestT = maxT;
+    bool isHit = false;
+    for (uint32_t triangle = 0; triangle < modelData.indices.size() / 3; ++triangle) {
+        Vector3 v0 = GetPosition(modelData, modelData.indices[triangle * 3]);
+        Vector3 e1 = Sub(GetPosition(modelData, modelData.indices[triangle * 3 + 1]), v0);
+        Vector3 e2 = Sub(GetPosition(modelData, modelData.indices[triangle * 3 + 2]), v0);
+        float px = d.y * e2.z - d.z * e2.y;
+        float py = d.z * e2.x - d.x * e2.z;
+        float pz = d.x * e2.y - d.y * e2.x;
+        float inverseDet = 1.0f / (e1.x * px + e1.y * py + e1.z * pz);
+        Vector3 s = Sub(o, v0);
+        float u = (s.x * px + s.y * py + s.z * pz) * inverseDet;
+        float qx = s.y * e1.z - s.z * e1.y;
+        float qy = s.z * e1.x - s.x * e1.z;
+        float qz = s.x * e1.y - s.y * e1.x;
+        float v = (d.x * qx + d.y * qy + d.z * qz) * inverseDet;
+        float t = (e2.x * qx + e2.y * qy + e2.z * qz) * inverseDet;
+        if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t < bestT) {
+            if (!hit) {
+                return true;
+            }
+            bestT = t;
+            *hit = { t, triangle, u, v };
+            isHit = true;
+        }
+    }
+    return isHit;
+}
+
+// 点と三角形の距離の2乗(Bvh.cppと同じ式)
+float DistanceSquaredToTriangle(const Vector3& p, const Vector3& a, const Vector3& ab, const Vector3& ac)
+{
+    auto distanceSquared = [&](const Vector3& q) { return Dot(Sub(p, q), Sub(p, q)); };
+    Vector3 ap = Sub(p, a);
+    float d1 = Dot(ab, ap);
+    float d2 = Dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        return distanceSquared(a);
+    }
+    Vector3 bp = Sub(ap, ab);
+    float d3 = Dot(ab, bp);
+    float d4 = Dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) {
+        return Dot(bp, bp);
+    }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        float v = d1 / (d1 - d3);
+        return distanceSquared({ a.x + ab.x * v, a.y + ab.y * v, a.z + ab.z * v });
+    }
+    Vector3 cp = Sub(ap, ac);
+    float d5 = Dot(ab, cp);
+    float d6 = Dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) {
+        return Dot(cp, cp);
+    }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        float w = d2 / (d2 - d6);
+        return distanceSquared({ a.x + ac.x * w, a.y + ac.y * w, a.z + ac.z * w });
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        return distanceSquared({ a.x + ab.x + (ac.x - ab.x) * w, a.y + ab.y + (ac.y - ab.y) * w, a.z + ab.z + (ac.z - ab.z) * w });
+    }
+    float denominator = 1.0f / (va + vb + vc);
+    float v = vb * denominator;
+    float w = vc * denominator;
+    return distanceSquared({ a.x + ab.x * v + ac.x * w, a.y + ab.y * v + ac.y * w, a.z + ab.z * v + ac.z * w });
+}
+
+std::vector<uint32_t> QuerySphereBruteForce(const ModelData& modelData, const Sphere& sphere)
+{
+    std::vector<uint32_t> triangles;
+    for (uint32_t triangle = 0; triangle < modelData.indices.size() / 3; ++triangle) {
+        Vector3 v0 = GetPosition(modelData, modelData.indices[triangle * 3]);
+        Vector3 e1 = Sub(GetPosition(modelData, modelData.indices[triangle * 3 + 1]), v0);
+        Vector3 e2 = Sub(GetPosition(modelData, modelData.indices[triangle * 3 + 2]), v0);
+        if (DistanceSquaredToTriangle(sphere.center, v0, e1, e2) <= sphere.radius * sphere.radius) {
+            triangles.push_back(triangle);
+        }
+    }
+    return triangles;
+}
+
+bool Contains(const BvhNode& node, uint32_t i, const Vector3& p)
+{
+    return node.minX[i] <= p.x && p.x <= node.maxX[i] && node.minY[i] <= p.y && p.y <= node.maxY[i] && node.minZ[i] <= p.z && p.z <= node.maxZ[i];
+}
+
+// 子の箱が中身の三角形の頂点を全て含むか(三角形の番号を数えながら辿る)
+bool IsValidSubtree(const Bvh& bvh, const ModelData& modelData, uint32_t nodeIndex, std::vector<uint32_t>& triangleCounts,
+    std::vector<uint32_t>& subtreeTriangles)
+{
+    const BvhNode& node = bvh.GetNodes()[nodeIndex];
+    for (uint32_t i = 0; i < 4; ++i) {
+        if (node.children[i] == kBvhNone) {
+            continue;
+        }
+        std::vector<uint32_t> triangles;
+        if (node.packCounts[i] == 0) {
+            if (node.children[i] <= nodeIndex || !IsValidSubtree(bvh, modelData, node.children[i], triangleCounts, triangles)) {
+                return false;
+            }
+        } else {
+            for (uint32_t p = node.children[i]; p < node.children[i] + node.packCounts[i]; ++p) {
+                for (uint32_t triangle : bvh.GetPacks()[p].triangleIndices) {
+                    if (triangle != kBvhNone) {
+                        ++triangleCounts[triangle];
+                        triangles.push_back(triangle);
+                    }
+                }
+            }
+            if (triangles.empty() || kBvhMaxLeafTriangles < triangles.size()) {
+                return false;
+            }
+        }
+        for (uint32_t triangle : triangles) {
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                if (!Contains(node, i, GetPosition(modelData, modelData.indices[triangle * 3 + corner]))) {
+                    return false;
+                }
+            }
+        }
+        subtreeTriangles.insert(subtreeTriangles.end(), triangles.begin(), triangles.end());
+    }
+    return true;
+}
+
+bool IsValidBvh(const Bvh& bvh, const ModelData& modelData)
+{
+    std::vector<uint32_t> triangleCounts(modelData.indices.size() / 3, 0);
+    std::vector<uint32_t> triangles;
+    if (!IsValidSubtree(bvh, modelData, 0, triangleCounts, triangles)) {
+        return false;
+    }
+    return std::all_of(triangleCounts.begin(), triangleCounts.end(), [](uint32_t count) { return count == 1; });
+}
+
+bool IsSameBvh(const Bvh& a, const Bvh& b)
+{
+    return a.GetNodeCount() == b.GetNodeCount() && a.GetPackCount() == b.GetPackCount()
+        && std::memcmp(a.GetNodes().data(), b.GetNodes().data(), sizeof(BvhNode) * a.GetNodeCount()) == 0
+        && std::memcmp(a.GetPacks().data(), b.GetPacks().data(), sizeof(BvhTrianglePack) * a.GetPackCount()) == 0;
+}
+
+template <typename Function>
+double MeasureMicroseconds(uint32_t count, Function function)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; ++i) {
+        function(i);
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / double(std::max(count, 1u));
+}
+
+bool Measure(const std::string& name, const ModelData& modelData, const Options& options)
+{
+    size_t triangleCount = modelData.indices.size() / 3;
+    Bvh bvh;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bvh.Build(modelData, 1);
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    Bvh parallelBvh;
+    uint32_t threadCount = GetWorkerThreadCount(options.threadCount);
+    start = std::chrono::steady_clock::now();
+    parallelBvh.Build(modelData, threadCount);
+    double parallelBuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    bool isDeterministic = IsSameBvh(bvh, parallelBvh);
+    bool isValid = IsValidBvh(bvh, modelData);
+    std::printf("%-20s %9zu triangles  build %8.2f ms, %u threads %8.2f ms  %7zu nodes %8zu packs (%.2f triangles/pack) %7.2f MB  %s %s\n",
+        name.c_str(), triangleCount, buildMs, threadCount, parallelBuildMs, bvh.GetNodeCount(), bvh.GetPackCount(),
+        double(triangleCount) / double(std::max<size_t>(bvh.GetPackCount(), 1)), double(bvh.GetMemorySize()) / (1024.0 * 1024.0),
+        isValid ? "valid" : "INVALID", isDeterministic ? "deterministic" : "NOT DETERMINISTIC");
+
+    // レイは箱を少し広げた中から、箱の中の点へ向ける。偶数番目は真上から真下へ
+    const AABB& bounds = bvh.GetBounds();
+    Vector3 size = Sub(bounds.max, bounds.min);
+    std::mt19937 randomEngine(1234);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    auto randomPoint = [&](float margin) {
+        return Vector3 { bounds.min.x + size.x * (distribution(randomEngine) * (1.0f + 2.0f * margin) - margin),
+            bounds.min.y + size.y * (distribution(randomEngine) * (1.0f + 2.0f * margin) - margin),
+            bounds.min.z + size.z * (distribution(randomEngine) * (1.0f + 2.0f * margin) - margin) };
+    };
+    std::vector<Ray> rays(options.rayCount);
+    for (uint32_t i = 0; i < options.rayCount; ++i) {
+        if (i % 2 == 0) {
+            Vector3 target = randomPoint(0.0f);
+            rays[i] = { { target.x, bounds.max.y + size.y + 1.0f, target.z }, { 0.0f, -(2.0f * size.y + 2.0f), 0.0f } };
+        } else {
+            Vector3 origin = randomPoint(0.5f);
+            rays[i] = { origin, Sub(randomPoint(0.0f), origin) };
+        }
+    }
+    const float kMaxT = 4.0f;
+
+    // 全ての三角形を調べたものと比べる
+    uint32_t verifyCount = std::min(options.verifyCount, options.rayCount);
+    uint32_t mismatchCount = 0;
+    uint32_t hitCount = 0;
+    double bruteForceUs = MeasureMicroseconds(verifyCount, [&](uint32_t i) {
+        RayHit expected {}, actual {};
+        bool isExpected = IntersectBruteForce(modelData, rays[i], kMaxT, &expected);
+        bool isActual = bvh.Intersect(rays[i], kMaxT, actual);
+        hitCount += isActual ? 1 : 0;
+        if (isExpected != isActual || bvh.IsOccluded(rays[i], kMaxT) != isExpected || (isExpected && expected.t != actual.t)) {
+            ++mismatchCount;
+        }
+    });
+
+    // バックエンド毎に全てのレイを調べ、スカラー版と同じかを確かめる
+    MatrixBackend activeBackend = GetActiveMatrixBackend();
+    std::vector<RayHit> scalarHits(options.rayCount, RayHit { -1.0f, kBvhNone, 0.0f, 0.0f });
+    bool isSameBackends = true;
+    for (int backend = 0; backend < kMatrixBackendCount; ++backend) {
+        if (!IsMatrixBackendSupported(MatrixBackend(backend))) {
+            continue;
+        }
+        SetActiveMatrixBackend(MatrixBackend(backend));
+        std::vector<RayHit> hits(options.rayCount, RayHit { -1.0f, kBvhNone, 0.0f, 0.0f });
+        double closestUs = MeasureMicroseconds(options.rayCount, [&](uint32_t i) { bvh.Intersect(rays[i], kMaxT, hits[i]); });
+        uint32_t occludedCount = 0;
+        double anyUs = MeasureMicroseconds(options.rayCount, [&](uint32_t i) { occludedCount += bvh.IsOccluded(rays[i], kMaxT) ? 1 : 0; });
+        if (backend == kMatrixBackendScalar) {
+            scalarHits = hits;
+        }
+        bool isSame = std::memcmp(hits.data(), scalarHits.data(), sizeof(RayHit) * hits.size()) == 0;
+        isSameBackends = isSameBackends && isSame;
+        std::printf("%-20s   %-6s closest hit %7.3f us/ray, any hit %7.3f us/ray (%u hits)%s\n", "", GetMatrixBackendName(MatrixBackend(backend)), closestUs,
+            anyUs, occludedCount, isSame ? "" : "  DIFFERENT FROM SCALAR");
+    }
+    SetActiveMatrixBackend(activeBackend);
+    std::printf("%-20s   brute force %10.3f us/ray, %u / %u rays hit, %u mismatches\n", "", bruteForceUs, hitCount, verifyCount, mismatchCount);
+
+    // 球は三角形の重心に置き、半径は箱の対角線の1%
+    float radius = std::sqrt(Dot(size, size)) * 0.01f;
+    std::uniform_int_distribution<uint32_t> triangleDistribution(0, uint32_t(triangleCount - 1));
+    std::vector<Sphere> spheres(options.rayCount);
+    for (Sphere& sphere : spheres) {
+        uint32_t triangle = triangleDistribution(randomEngine);
+        Vector3 p0 = GetPosition(modelData, modelData.indices[triangle * 3]);
+        Vector3 p1 = GetPosition(modelData, modelData.indices[triangle * 3 + 1]);
+        Vector3 p2 = GetPosition(modelData, modelData.indices[triangle * 3 + 2]);
+        sphere = { { (p0.x + p1.x + p2.x) / 3.0f, (p0.y + p1.y + p2.y) / 3.0f, (p0.z + p1.z + p2.z) / 3.0f }, radius };
+    }
+    std::vector<uint32_t> triangles;
+    size_t overlapCount = 0;
+    double sphereUs = MeasureMicroseconds(options.rayCount, [&](uint32_t i) {
+        triangles.clear();
+        overlapCount += bvh.QuerySphere(spheres[i], triangles);
+    });
+    uint32_t sphereMismatchCount = 0;
+    for (uint32_t i = 0; i < verifyCount; ++i) {
+        triangles.clear();
+        bvh.QuerySphere(spheres[i], triangles);
+        std::sort(triangles.begin(), triangles.end());
+        sphereMismatchCount += triangles != QuerySphereBruteForce(modelData, spheres[i]) ? 1 : 0;
+    }
+    std::printf("%-20s   sphere %7.3f us/query (%.1f triangles), %u mismatches\n", "", sphereUs, double(overlapCount) / double(std::max(options.rayCount, 1u)),
+        sphereMismatchCount);
+
+    return isValid && isDeterministic && isSameBackends && mismatchCount == 0 && sphereMismatchCount == 0;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    bool isAllValid = true;
+    if (std::filesystem::exists(std::filesystem::path(options.resources) / "terrain.obj")) {
+        isAllValid = Measure("terrain.obj", LoadObjFile(options.resources, "terrain.obj"), options) && isAllValid;
+    }
+    // 三角形の数が10倍ずつ増えるように大きさを決める
+    for (size_t triangles = 20000; triangles <= options.maxTriangles; triangles *= 10) {
+        uint32_t gridSize = uint32_t(std::sqrt(double(triangles) / 2.0));
+        isAllValid = Measure("grid_" + std::to_string(gridSize * gridSize * 2), MakeTerrain(gridSize), options) && isAllValid;
+        uint32_t level = 0;
+        while ((20u << (2 * (level + 1))) <= triangles) {
+            ++level;
+        }
+        PrimitiveMesh sphere = MakePrimitiveMesh(PrimitiveType::Icosphere, level);
+        isAllValid = Measure("icosphere_" + std::to_string(sphere.model.indices.size() / 3), sphere.model, options) && isAllValid;
+    }
+    return isAllValid ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+// ウィンドウもデバイスも作らずに、メインループの更新処理だけをNフレーム回して計測する
+#include "GPUData.h"
+#include "MeshCache.h"
+#include "MeshLod.h"
+#include "Model.h"
+#include "Primitive.h"
+#include "PrimitiveMesh.h"
+#include "Scene.h"
+#include "Sound.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    uint32_t frames = 1000;
+    uint32_t seed = 0;
+    uint32_t emitCount = 3;
+    uint32_t maxInstance = 100;
+    uint32_t threadCount = 1;
+    bool useBillboard = false;
+    bool useCulling = true;
+    std::string resources = "resources";
+};
+
+void PrintUsage()
+{
+    std::printf(
+        "usage: cg3_headless_bench [--frames N] [--seed S] [--emit-count C]\n"
+        "                          [--max-instance M] [--threads T] [--billboard] [--no-culling] [--resources DIR]\n");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--frames" && hasValue) {
+            options.frames = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--emit-count" && hasValue) {
+            options.emitCount = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--max-instance" && hasValue) {
+            options.maxInstance = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--threads" && hasValue) {
+            options.threadCount = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--billboard") {
+            options.useBillboard = true;
+        } else if (arg == "--no-culling") {
+            options.useCulling = false;
+        } else if (arg == "--resources" && hasValue) {
+            options.resources = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+double ElapsedMicroseconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PrintPhase(const char* name, double total, uint32_t frames)
+{
+    std::printf("  %-10s %12.1f us total %10.3f us/frame\n", name, total, total / double(frames));
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    // アセット読み込み(あれば)
+    std::filesystem::path resources(options.resources);
+    AABB modelBounds = { { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } };
+    uint32_t modelLodCount = 1;
+    std::vector<Meshlet> modelMeshlets;
+    std::vector<Sphere> modelMeshletBounds;
+    Bvh modelBvh;
+    if (std::filesystem::exists(resources / "terrain.obj")) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool usedCache = false;
+        ModelData model = LoadObjFileCached(options.resources, "terrain.obj", 1, &usedCache);
+        double elapsed = ElapsedMicroseconds(start);
+        MeshStats stats = CalculateMeshStats(model);
+        std::printf("LoadObjFileCached(terrain.obj): %zu -> %zu vertices (x%.2f), %zu indices, %u LODs, %s, %.1f us\n", stats.sourceVertexCount,
+            stats.vertexCount, stats.vertexReductionRatio, model.indices.size(), GetLodCount(model), usedCache ? "cache" : "parsed", elapsed);
+        modelBounds = CalculateBounds(model);
+        modelLodCount = GetLodCount(model);
+        modelMeshlets = model.meshlets;
+        modelMeshletBounds = model.meshletBounds;
+        start = std::chrono::steady_clock::now();
+        modelBvh.Build(model);
+        std::printf("Bvh::Build(terrain.obj): %zu nodes, %zu bytes, %.1f us\n", modelBvh.GetNodeCount(), modelBvh.GetMemorySize(), ElapsedMicroseconds(start));
+    }
+    if (std::filesystem::exists(resources / "fanfare.wav")) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        SoundData soundData = SoundLoadWave((resources / "fanfare.wav").string().c_str());
+        std::printf("SoundLoadWave(fanfare.wav): %u bytes, %.1f us\n", soundData.bufferSize, ElapsedMicroseconds(start));
+        SoundUhload(&soundData);
+    }
+
+    // GPUリソースの代わりにCPUのメモリへ書き込む
+    TransformationMatrix sphere {};
+    TransformationMatrix model {};
+    DirectionalLight sphereLight { { 1.0f, 1.0f, 1.0f, 1.0f }, { 0.0f, -1.0f, 0.0f }, 1.0f };
+    DirectionalLight modelLight { { 1.0f, 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }, 0.0f };
+    std::vector<ParticleForGPU> instancing(options.maxInstance);
+
+    SceneTargets targets {};
+    targets.sphere = &sphere;
+    targets.model = &model;
+    targets.sphereLight = &sphereLight;
+    targets.modelLight = &modelLight;
+    targets.instancing = instancing.data();
+    targets.maxInstance = options.maxInstance;
+
+    Scene scene;
+    InitializeScene(scene, options.seed, 1280.0f / 720.0f);
+    scene.emitter.count = options.emitCount;
+    scene.useBillboard = options.useBillboard;
+    scene.useCulling = options.useCulling;
+    ThreadPool threadPool(options.threadCount);
+    scene.threadPool = &threadPool;
+    scene.modelBounds = modelBounds;
+    scene.modelLodCount = modelLodCount;
+    scene.modelMeshlets = modelMeshlets;
+    scene.modelMeshletBounds = modelMeshletBounds;
+    scene.modelBvh = modelBvh;
+    // 球はmain.cppと同じものを使う
+    PrimitiveCache primitiveCache;
+    const PrimitiveMesh& sphereMesh = primitiveCache.Get(PrimitiveType::UVSphere, kSphereSubdivision * 2);
+    scene.sphereBounds = sphereMesh.boundingSphere;
+    scene.sphereLodCount = GetLodCount(sphereMesh.model);
+
+    SceneTimings timings {};
+    uint64_t totalInstance = 0;
+    size_t peakParticle = 0;
+    uint64_t totalCulled = 0;
+    uint64_t totalMeshletCulled = 0;
+    uint64_t totalSphereLod = 0;
+    uint64_t totalSphereContact = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < options.frames; ++frame) {
+        totalInstance += UpdateScene(scene, targets, &timings);
+        totalCulled += scene.culledParticleCount;
+        totalSphereLod += scene.sphereLod;
+        totalSphereContact += scene.sphereContacts.size();
+        if (scene.isModelMeshletCulled) {
+            totalMeshletCulled += scene.modelMeshletStats.frustumCulledTriangleCount + scene.modelMeshletStats.backfaceCulledTriangleCount;
+        }
+        if (scene.particles.GetSize() > peakParticle) {
+            peakParticle = scene.particles.GetSize();
+        }
+    }
+    double total = ElapsedMicroseconds(start);
+
+    uint32_t frames = options.frames ? options.frames : 1;
+    std::printf("frames: %u, seed: %u, emit count: %u, max instance: %u, threads: %u, billboard: %s, culling: %s\n", options.frames, options.seed,
+        options.emitCount, options.maxInstance, threadPool.GetThreadCount(), options.useBillboard ? "on" : "off", options.useCulling ? "on" : "off");
+    std::printf("particles: %zu alive, %zu peak, %.1f instances/frame, %.1f culled/frame\n",
+        scene.particles.GetSize(), peakParticle, double(totalInstance) / double(frames), double(totalCulled) / double(frames));
+    std::printf("sphere: %u LODs, %.2f average LOD\n", scene.sphereLodCount, double(totalSphereLod) / double(frames));
+    std::printf("model: %zu meshlets, %.1f triangles culled/frame, %.1f sphere contacts/frame\n", modelMeshlets.size(),
+        double(totalMeshletCulled) / double(frames), double(totalSphereContact) / double(frames));
+    RayHit pickHit {};
+    if (PickModel(scene, 0.0f, 0.0f, pickHit)) {
+        std::printf("pick(screen center): triangle %u, t %.4f\n", pickHit.triangleIndex, pickHit.t);
+    }
+    PrintPhase("camera", timings.camera, frames);
+    PrintPhase("sphere", timings.sphere, frames);
+    PrintPhase("model", timings.model, frames);
+    PrintPhase("billboard", timings.billboard, frames);
+    PrintPhase("culling", timings.culling, frames);
+    PrintPhase("particle", timings.particle, frames);
+    PrintPhase("emit", timings.emit, frames);
+    PrintPhase("frame", total, frames);
+    return 0;
+}
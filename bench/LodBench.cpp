@@ -0,0 +1,137 @@
+// LODの生成を計測する
+//
+// resources/terrain.objと、なめらかな起伏の格子(三角形の数を指定して作る)でBuildLodChainの時間と、
+// 各LODの三角形の数・誤差・頂点キャッシュのACMRを出す。
+// 同じ入力で2回作って結果が全く同じか(決まった結果になるか)も確かめ、違えば失敗にする。
+// 最後に、各LODに切り替わるカメラからの距離(半径1の球、初期状態のカメラ)を出す。
+#include "BenchMesh.h"
+#include "MeshCache.h"
+#include "MeshLod.h"
+#include "MeshOptimizer.h"
+#include "Model.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    size_t maxTriangles = 2000000;
+    std::string resources = "resources";
+};
+
+void PrintUsage()
+{
+    std::printf("usage: cg3_lod_bench [--max-triangles N] [--resources DIR]\n");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--max-triangles" && hasValue) {
+            options.maxTriangles = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--resources" && hasValue) {
+            options.resources = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IsSameLods(const ModelData& a, const ModelData& b)
+{
+    if (a.lods.size() != b.lods.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.lods.size(); ++i) {
+        if (a.lods[i].indices != b.lods[i].indices || a.lods[i].error != b.lods[i].error) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 三角形の数が減っていき、indexが頂点の範囲に収まっているか
+bool IsValidChain(const ModelData& modelData)
+{
+    size_t previousCount = modelData.indices.size();
+    for (const MeshLod& lod : modelData.lods) {
+        if (lod.indices.size() >= previousCount || lod.submeshes.size() != modelData.submeshes.size()) {
+            return false;
+        }
+        for (uint32_t index : lod.indices) {
+            if (index >= modelData.vertices.size()) {
+                return false;
+            }
+        }
+        previousCount = lod.indices.size();
+    }
+    return true;
+}
+
+bool Measure(const std::string& name, ModelData modelData)
+{
+    OptimizeMesh(modelData);
+    size_t triangleCount = modelData.indices.size() / 3;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    BuildLodChain(modelData);
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    ModelData again = modelData;
+    BuildLodChain(again);
+    bool isDeterministic = IsSameLods(modelData, again);
+    bool isValid = IsValidChain(modelData);
+
+    AABB bounds = CalculateBounds(modelData);
+    float extent = std::max({ bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y, bounds.max.z - bounds.min.z });
+    std::printf("%-20s %9zu triangles  build %9.2f ms (%6.2f Mtriangles/s)  %s, %s\n", name.c_str(), triangleCount, buildMs,
+        double(triangleCount) / buildMs * 1e-3, isDeterministic ? "deterministic" : "NOT DETERMINISTIC", isValid ? "valid" : "INVALID");
+    for (size_t i = 0; i < modelData.lods.size(); ++i) {
+        const MeshLod& lod = modelData.lods[i];
+        VertexCacheStats stats = AnalyzeVertexCache(lod.indices.data(), lod.indices.size(), modelData.vertices.size());
+        std::printf("%-20s   LOD%zu %9zu triangles (%5.1f%%)  error %.3e (%.3f%% of extent)  ACMR %.3f\n", "", i + 1, lod.indices.size() / 3,
+            100.0 * double(lod.indices.size() / 3) / double(triangleCount), lod.error, extent > 0.0f ? 100.0f * lod.error / extent : 0.0f,
+            stats.acmr);
+    }
+    return isDeterministic && isValid;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    bool isAllValid = true;
+    if (std::filesystem::exists(std::filesystem::path(options.resources) / "terrain.obj")) {
+        isAllValid = Measure("terrain.obj", LoadObjFile(options.resources, "terrain.obj")) && isAllValid;
+    }
+    // 三角形の数が10倍ずつ増えるように格子の大きさを決める
+    for (size_t triangles = 20000; triangles <= options.maxTriangles; triangles *= 10) {
+        uint32_t gridSize = uint32_t(std::sqrt(double(triangles) / 2.0));
+        isAllValid = Measure("grid_" + std::to_string(gridSize * gridSize * 2), MakeTerrain(gridSize)) && isAllValid;
+    }
+
+    // 切り替わる距離(画面の大きさは 半径 / (距離 * tan(fovY / 2)))
+    Camera camera;
+    camera.SetProjection(0.45f, 16.0f / 9.0f, 0.1f, 100.0f);
+    std::printf("LOD switch distance for a unit sphere (fovY %.2f):", camera.GetFovY());
+    for (size_t i = 0; i < std::size(kLodScreenSizes); ++i) {
+        float distance = 1.0f / (kLodScreenSizes[i] * std::tan(camera.GetFovY() * 0.5f));
+        Sphere sphere = { { 0.0f, 0.0f, distance * 1.001f }, 1.0f };
+        std::printf("  LOD%zu > %.2f (selects %u)", i + 1, distance, SelectLod(CalculateScreenSize(camera, sphere), uint32_t(i + 2)));
+    }
+    std::printf("\n");
+    return isAllValid ? 0 : 1;
+}
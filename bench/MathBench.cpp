@@ -0,0 +1,417 @@
+// Matrix4x4の各実装(スカラー/SSE4.1/AVX2)の速度と、スカラー版との差を計測する
+// 後半はアフィン/剛体/法線用の特殊な逆行列を汎用のInverseと比べ、
+// Transformの一括変換(MakeTransformMatricesBatch)を1個ずつの計算と比べる。
+// 最後にSinCosの精度とクォータニオン経由の行列がオイラー角のものと一致するかと、
+// 視錐台カリングの速度とスカラー版との一致を見る
+#include "Culling.h"
+#include "MatrixSimd.h"
+#include "MyMath.h"
+#include "TransformBatch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numbers>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint32_t kSeed = 20241016;
+const size_t kInputCount = 4096;
+const size_t kBatchCount = 16384;
+
+// floatを整数として比較できる並びに変換する
+int64_t OrderedBits(float value)
+{
+    int32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits < 0 ? int64_t(INT32_MIN) - bits : int64_t(bits);
+}
+
+int64_t UlpDistance(float a, float b)
+{
+    if (a == b) {
+        return 0; // +0と-0は同じとみなす
+    }
+    return std::llabs(OrderedBits(a) - OrderedBits(b));
+}
+
+struct Difference {
+    int64_t maxUlp = 0;
+    double maxRelative = 0.0; // 行列の最大要素に対する誤差
+};
+
+void Accumulate(Difference& diff, const Matrix4x4& reference, const Matrix4x4& value)
+{
+    float scale = 0.0f;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            scale = std::max(scale, std::fabs(reference.m[i][j]));
+        }
+    }
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            diff.maxUlp = std::max(diff.maxUlp, UlpDistance(reference.m[i][j], value.m[i][j]));
+            double error = std::fabs(double(reference.m[i][j]) - double(value.m[i][j]));
+            diff.maxRelative = std::max(diff.maxRelative, scale > 0.0f ? error / scale : error);
+        }
+    }
+}
+
+struct Inputs {
+    std::vector<Matrix4x4> lhs;
+    std::vector<Matrix4x4> rhs;
+    std::vector<Matrix4x4> affine;
+    std::vector<Matrix4x4> rigid; // 拡縮なし
+    std::vector<Transform> transforms;
+};
+
+Inputs MakeInputs(size_t count)
+{
+    std::mt19937 engine(kSeed);
+    std::uniform_real_distribution<float> any(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> angle(-std::numbers::pi_v<float>, std::numbers::pi_v<float>);
+    std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+
+    Inputs inputs;
+    for (size_t i = 0; i < count; ++i) {
+        Matrix4x4 a;
+        Matrix4x4 b;
+        for (int r = 0; r < 4; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                a.m[r][c] = any(engine);
+                b.m[r][c] = any(engine);
+            }
+        }
+        inputs.lhs.push_back(a);
+        inputs.rhs.push_back(b);
+
+        Transform transform {
+            { scale(engine), scale(engine), scale(engine) },
+            { angle(engine), angle(engine), angle(engine) },
+            { any(engine), any(engine), any(engine) },
+        };
+        inputs.transforms.push_back(transform);
+        inputs.affine.push_back(MakeAffineMatrixScalar(transform.scale, transform.rotate, transform.translate));
+        inputs.rigid.push_back(MakeAffineMatrixScalar({ 1.0f, 1.0f, 1.0f }, transform.rotate, transform.translate));
+    }
+    return inputs;
+}
+
+// 1回分の処理時間(ns)。最適化で消されないように結果は配列に書き出す
+template <typename Function>
+double MeasureNanoseconds(size_t count, uint32_t repeat, Function&& function)
+{
+    double best = 1e30;
+    for (uint32_t r = 0; r < repeat; ++r) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            function(i);
+        }
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, elapsed / double(count));
+    }
+    return best;
+}
+
+Matrix4x4 Transpose(const Matrix4x4& m)
+{
+    Matrix4x4 num;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            num.m[i][j] = m.m[j][i];
+        }
+    }
+    return num;
+}
+
+void PrintRow(const char* operation, MatrixBackend backend, double nanoseconds, double scalarNanoseconds, const Difference& diff)
+{
+    std::printf("%-18s %-8s %9.2f ns/op %10.2f Mops/s  x%5.2f  max %lld ulp, rel %.3g\n",
+        operation, GetMatrixBackendName(backend), nanoseconds, 1e3 / nanoseconds, scalarNanoseconds / nanoseconds,
+        static_cast<long long>(diff.maxUlp), diff.maxRelative);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t repeat = 50;
+    if (argc > 1) {
+        repeat = uint32_t(std::max(1l, std::strtol(argv[1], nullptr, 10)));
+    }
+
+    Inputs inputs = MakeInputs(kInputCount);
+    std::vector<Matrix4x4> output(kInputCount);
+
+    // スカラー版の結果を基準にする
+    const MatrixKernels& scalar = GetMatrixKernels(kMatrixBackendScalar);
+    std::vector<Matrix4x4> multiplyReference(kInputCount);
+    std::vector<Matrix4x4> inverseReference(kInputCount);
+    std::vector<Matrix4x4> affineReference(kInputCount);
+    for (size_t i = 0; i < kInputCount; ++i) {
+        multiplyReference[i] = scalar.multiply(inputs.lhs[i], inputs.rhs[i]);
+        inverseReference[i] = scalar.inverse(inputs.affine[i]);
+        const Transform& t = inputs.transforms[i];
+        affineReference[i] = scalar.makeAffineMatrix(t.scale, t.rotate, t.translate);
+    }
+
+    std::printf("inputs: %zu, repeat: %u, active backend: %s\n", kInputCount, repeat, GetMatrixBackendName(GetActiveMatrixBackend()));
+
+    double scalarTimes[3] = {};
+    for (int b = 0; b < kMatrixBackendCount; ++b) {
+        MatrixBackend backend = MatrixBackend(b);
+        if (!IsMatrixBackendSupported(backend)) {
+            std::printf("%-8s not available\n", GetMatrixBackendName(backend));
+            continue;
+        }
+        const MatrixKernels& kernels = GetMatrixKernels(backend);
+
+        Difference diff;
+        double ns = MeasureNanoseconds(kInputCount, repeat, [&](size_t i) { output[i] = kernels.multiply(inputs.lhs[i], inputs.rhs[i]); });
+        for (size_t i = 0; i < kInputCount; ++i) {
+            Accumulate(diff, multiplyReference[i], output[i]);
+        }
+        if (backend == kMatrixBackendScalar) {
+            scalarTimes[0] = ns;
+        }
+        PrintRow("Multiply", backend, ns, scalarTimes[0], diff);
+
+        diff = {};
+        ns = MeasureNanoseconds(kInputCount, repeat, [&](size_t i) { output[i] = kernels.inverse(inputs.affine[i]); });
+        for (size_t i = 0; i < kInputCount; ++i) {
+            Accumulate(diff, inverseReference[i], output[i]);
+        }
+        if (backend == kMatrixBackendScalar) {
+            scalarTimes[1] = ns;
+        }
+        PrintRow("Inverse", backend, ns, scalarTimes[1], diff);
+
+        diff = {};
+        ns = MeasureNanoseconds(kInputCount, repeat, [&](size_t i) {
+            const Transform& t = inputs.transforms[i];
+            output[i] = kernels.makeAffineMatrix(t.scale, t.rotate, t.translate);
+        });
+        for (size_t i = 0; i < kInputCount; ++i) {
+            Accumulate(diff, affineReference[i], output[i]);
+        }
+        if (backend == kMatrixBackendScalar) {
+            scalarTimes[2] = ns;
+        }
+        PrintRow("MakeAffineMatrix", backend, ns, scalarTimes[2], diff);
+    }
+
+    // 同じバックエンドの汎用Inverseを基準に、特殊な逆行列がどれだけ安いか
+    std::vector<Matrix4x4> rigidReference(kInputCount);
+    std::vector<Matrix4x4> normalReference(kInputCount);
+    for (size_t i = 0; i < kInputCount; ++i) {
+        rigidReference[i] = InverseScalar(inputs.rigid[i]);
+        // 平行移動の行と列は使わないので0にして比べる
+        normalReference[i] = Transpose(inverseReference[i]);
+        for (int j = 0; j < 4; ++j) {
+            normalReference[i].m[3][j] = 0.0f;
+            normalReference[i].m[j][3] = 0.0f;
+        }
+    }
+
+    std::printf("\nspecialized inverses (speedup vs Inverse on the same backend)\n");
+    for (int b = 0; b < kMatrixBackendCount; ++b) {
+        MatrixBackend backend = MatrixBackend(b);
+        if (!IsMatrixBackendSupported(backend)) {
+            continue;
+        }
+        const MatrixKernels& kernels = GetMatrixKernels(backend);
+
+        Difference diff;
+        double base = MeasureNanoseconds(kInputCount, repeat, [&](size_t i) { output[i] = kernels.inverse(inputs.affine[i]); });
+        double ns = MeasureNanoseconds(kInputCount, repeat, [&](size_t i) { output[i] = kernels.inverseAffine(inputs.affine[i]); });
+        for (size_t i = 0; i < kInputCount; ++i) {
+            Accumulate(diff, inverseReference[i], output[i]);
+        }
+        PrintRow("InverseAffine", backend, ns, base, diff);
+
+        diff = {};
+        base = MeasureNanoseconds(kInputCount, repeat, [&](size_t i) { output[i] = kernels.inverse(inputs.rigid[i]); });
+        ns = MeasureNanoseconds(kInputCount, repeat, [&](size_t i) { output[i] = kernels.inverseRigid(inputs.rigid[i]); });
+        for (size_t i = 0; i < kInputCount; ++i) {
+            Accumulate(diff, rigidReference[i], output[i]);
+        }
+        PrintRow("InverseRigid", backend, ns, base, diff);
+
+        // 以前のworldInverseTransposeはInverseだけで転置していなかったので、転置込みと比べる
+        diff = {};
+        base = MeasureNanoseconds(kInputCount, repeat, [&](size_t i) { output[i] = Transpose(kernels.inverse(inputs.affine[i])); });
+        ns = MeasureNanoseconds(kInputCount, repeat, [&](size_t i) { output[i] = kernels.makeNormalMatrix(inputs.affine[i]); });
+        for (size_t i = 0; i < kInputCount; ++i) {
+            Matrix4x4 value = output[i];
+            for (int j = 0; j < 4; ++j) {
+                value.m[3][j] = 0.0f;
+                value.m[j][3] = 0.0f;
+            }
+            Accumulate(diff, normalReference[i], value);
+        }
+        PrintRow("MakeNormalMatrix", backend, ns, base, diff);
+    }
+
+    // 以前のパーティクル1個分の計算(毎回射影行列を作り、Multiplyを2回)と一括変換を比べる
+    std::vector<Transform> batchTransforms(kBatchCount);
+    for (size_t i = 0; i < kBatchCount; ++i) {
+        batchTransforms[i] = inputs.transforms[i % kInputCount];
+    }
+    Matrix4x4 view = InverseScalar(inputs.rigid[0]);
+    Matrix4x4 viewProjection = MultiplyScalar(view, MakePrespectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f));
+    std::vector<ParticleForGPU> batchReference(kBatchCount);
+    std::vector<ParticleForGPU> batchOutput(kBatchCount);
+    for (size_t i = 0; i < kBatchCount; ++i) {
+        const Transform& t = batchTransforms[i];
+        batchReference[i].world = MakeAffineMatrixScalar(t.scale, t.rotate, t.translate);
+        batchReference[i].WVP = MultiplyScalar(batchReference[i].world, viewProjection);
+    }
+
+    std::printf("\ntransform batch, %zu transforms (speedup vs per-object on the same backend)\n", kBatchCount);
+    MatrixBackend activeBackend = GetActiveMatrixBackend();
+    for (int b = 0; b < kMatrixBackendCount; ++b) {
+        MatrixBackend backend = MatrixBackend(b);
+        if (!IsMatrixBackendSupported(backend)) {
+            continue;
+        }
+        const MatrixKernels& kernels = GetMatrixKernels(backend);
+        SetActiveMatrixBackend(backend);
+
+        double perObject = MeasureNanoseconds(kBatchCount, repeat, [&](size_t i) {
+            const Transform& t = batchTransforms[i];
+            Matrix4x4 world = kernels.makeAffineMatrix(t.scale, t.rotate, t.translate);
+            Matrix4x4 projection = MakePrespectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f);
+            batchOutput[i].WVP = kernels.multiply(world, kernels.multiply(view, projection));
+            batchOutput[i].world = world;
+        });
+        double batch = MeasureNanoseconds(1, repeat, [&](size_t) {
+            MakeTransformMatricesBatch(batchTransforms.data(), kBatchCount, viewProjection, nullptr, MakeTransformBatchOutput(batchOutput.data()));
+        }) / double(kBatchCount);
+
+        Difference diff;
+        for (size_t i = 0; i < kBatchCount; ++i) {
+            Accumulate(diff, batchReference[i].world, batchOutput[i].world);
+            Accumulate(diff, batchReference[i].WVP, batchOutput[i].WVP);
+        }
+        PrintRow("TransformBatch", backend, batch, perObject, diff);
+    }
+    SetActiveMatrixBackend(activeBackend);
+
+    // SinCosはdoubleのsin/cosとの差(絶対値)を見る
+    std::vector<float> radians(kInputCount * 4);
+    std::vector<float> sins(radians.size());
+    std::vector<float> coss(radians.size());
+    std::mt19937 engine(kSeed);
+    std::uniform_real_distribution<float> wide(-8192.0f, 8192.0f);
+    std::uniform_real_distribution<float> narrow(-std::numbers::pi_v<float>, std::numbers::pi_v<float>);
+    for (size_t i = 0; i < radians.size(); ++i) {
+        radians[i] = i % 2 == 0 ? narrow(engine) : wide(engine);
+    }
+    std::printf("\nsincos, %zu angles in [-pi, pi] and [-8192, 8192] (speedup vs scalar)\n", radians.size());
+    double scalarSinCos = 0.0;
+    for (int b = 0; b < kMatrixBackendCount; ++b) {
+        MatrixBackend backend = MatrixBackend(b);
+        if (!IsMatrixBackendSupported(backend)) {
+            continue;
+        }
+        const MatrixKernels& kernels = GetMatrixKernels(backend);
+        double ns = MeasureNanoseconds(1, repeat, [&](size_t) { kernels.sinCos(radians.data(), sins.data(), coss.data(), radians.size()); }) / double(radians.size());
+        if (backend == kMatrixBackendScalar) {
+            scalarSinCos = ns;
+        }
+        double maxError = 0.0;
+        for (size_t i = 0; i < radians.size(); ++i) {
+            maxError = std::max(maxError, std::fabs(double(sins[i]) - std::sin(double(radians[i]))));
+            maxError = std::max(maxError, std::fabs(double(coss[i]) - std::cos(double(radians[i]))));
+        }
+        std::printf("%-18s %-8s %9.2f ns/op %10.2f Mops/s  x%5.2f  max abs %.3g (2^%.1f)\n", "SinCos", GetMatrixBackendName(backend), ns, 1e3 / ns,
+            scalarSinCos / ns, maxError, std::log2(maxError));
+    }
+
+    // クォータニオン経由の行列が、同じオイラー角から作った行列と一致するか
+    Difference eulerDiff;
+    Difference roundTripDiff;
+    for (size_t i = 0; i < kInputCount; ++i) {
+        const Transform& t = inputs.transforms[i];
+        Quaternion q = MakeEulerQuaternion(t.rotate);
+        Accumulate(eulerDiff, affineReference[i], MakeAffineMatrix(t.scale, q, t.translate));
+        Accumulate(roundTripDiff, affineReference[i], MakeAffineMatrixScalar(t.scale, MakeEulerAngles(q), t.translate));
+    }
+    std::printf("\nquaternion vs euler matrix: max rel %.3g, euler -> quaternion -> euler: max rel %.3g\n", eulerDiff.maxRelative, roundTripDiff.maxRelative);
+    double eulerNs = MeasureNanoseconds(kInputCount, repeat, [&](size_t i) {
+        const Transform& t = inputs.transforms[i];
+        output[i] = MakeAffineMatrix(t.scale, t.rotate, t.translate);
+    });
+    std::vector<Quaternion> quaternions(kInputCount);
+    for (size_t i = 0; i < kInputCount; ++i) {
+        quaternions[i] = MakeEulerQuaternion(inputs.transforms[i].rotate);
+    }
+    double quaternionNs = MeasureNanoseconds(kInputCount, repeat, [&](size_t i) {
+        const Transform& t = inputs.transforms[i];
+        output[i] = MakeAffineMatrix(t.scale, quaternions[i], t.translate);
+    });
+    std::printf("MakeAffineMatrix   euler %.2f ns/op, quaternion %.2f ns/op (x%.2f)\n", eulerNs, quaternionNs, eulerNs / quaternionNs);
+    std::vector<Quaternion> blended(kInputCount);
+    double slerpNs = MeasureNanoseconds(kInputCount, repeat, [&](size_t i) { blended[i] = Slerp(quaternions[i], quaternions[(i + 1) % kInputCount], 0.3f); });
+    double nlerpNs = MeasureNanoseconds(kInputCount, repeat, [&](size_t i) { blended[i] = Nlerp(quaternions[i], quaternions[(i + 1) % kInputCount], 0.3f); });
+    std::printf("Slerp %.2f ns/op, Nlerp %.2f ns/op\n", slerpNs, nlerpNs);
+
+    // 視錐台カリング。端数の処理も通るように8の倍数からずらした数にする
+    const size_t kCullCount = kBatchCount + 5;
+    std::vector<Sphere> spheres(kCullCount);
+    std::vector<AABB> aabbs(kCullCount);
+    std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> size(0.1f, 3.0f);
+    for (size_t i = 0; i < kCullCount; ++i) {
+        spheres[i] = { { position(engine), position(engine), position(engine) }, size(engine) };
+        Vector3 extent = { size(engine), size(engine), size(engine) };
+        aabbs[i].min = { spheres[i].center.x - extent.x, spheres[i].center.y - extent.y, spheres[i].center.z - extent.z };
+        aabbs[i].max = { spheres[i].center.x + extent.x, spheres[i].center.y + extent.y, spheres[i].center.z + extent.z };
+    }
+    Frustum frustum = MakeFrustum(viewProjection);
+    std::vector<uint32_t> referenceMask(GetVisibleMaskWordCount(kCullCount));
+    std::vector<uint32_t> visibleMask(referenceMask.size());
+    std::vector<uint32_t> visibleIndices(kCullCount);
+    std::printf("\nfrustum culling, %zu bounds (speedup vs scalar)\n", kCullCount);
+    const char* cullNames[2] = { "CullSpheres", "CullAABBs" };
+    for (int shape = 0; shape < 2; ++shape) {
+        std::fill(referenceMask.begin(), referenceMask.end(), 0u);
+        if (shape == 0) {
+            CullSpheresScalar(frustum, spheres.data(), kCullCount, referenceMask.data());
+        } else {
+            CullAABBsScalar(frustum, aabbs.data(), kCullCount, referenceMask.data());
+        }
+        double scalarNs = 0.0;
+        for (int b = 0; b < kMatrixBackendCount; ++b) {
+            MatrixBackend backend = MatrixBackend(b);
+            if (!IsMatrixBackendSupported(backend)) {
+                continue;
+            }
+            SetActiveMatrixBackend(backend);
+            size_t visibleCount = 0;
+            double ns = MeasureNanoseconds(1, repeat, [&](size_t) {
+                visibleCount = shape == 0 ? CullSpheres(frustum, spheres.data(), kCullCount, visibleMask.data())
+                                          : CullAABBs(frustum, aabbs.data(), kCullCount, visibleMask.data());
+            }) / double(kCullCount);
+            if (backend == kMatrixBackendScalar) {
+                scalarNs = ns;
+            }
+            size_t mismatch = 0;
+            for (size_t i = 0; i < kCullCount; ++i) {
+                mismatch += IsVisible(visibleMask.data(), i) != IsVisible(referenceMask.data(), i);
+            }
+            std::printf("%-18s %-8s %9.2f ns/op %10.2f Mops/s  x%5.2f  visible %zu, mismatch %zu\n", cullNames[shape], GetMatrixBackendName(backend), ns, 1e3 / ns,
+                scalarNs / ns, visibleCount, mismatch);
+        }
+    }
+    SetActiveMatrixBackend(activeBackend);
+    double listNs = MeasureNanoseconds(1, repeat, [&](size_t) { MakeVisibleList(visibleMask.data(), kCullCount, visibleIndices.data()); }) / double(kCullCount);
+    std::printf("MakeVisibleList    %.2f ns/bound\n", listNs);
+    return 0;
+}
@@ -0,0 +1,665 @@
+// 数学ライブラリの関数を1つずつ計測する
+//
+// 固定シードで作った入力(ランダム/特異に近い/剛体/アフィンなど)に対して、
+// 実装(スカラー/SSE4.1/AVX2)毎に ns/op と ops/s、doubleで計算した値との誤差を出す。
+// 誤差は参照の行列(ベクトル)の最大要素に対する相対誤差で、最大と平均を出す。
+// 当たり判定は参照と結果が食い違った数を数える。
+// --json で同じ内容をJSONに書き出すので、SIMD版や近似版を入れたときの比較に使う。
+#include "Culling.h"
+#include "MatrixSimd.h"
+#include "MyMath.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numbers>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint32_t kSeed = 20241016;
+
+struct Options {
+    size_t count = 4096;
+    uint32_t repeat = 20;
+    std::string filter; // 関数名にこれを含むものだけ計測する
+    std::string jsonPath; // 空なら書き出さない。"-"なら標準出力
+};
+
+void PrintUsage()
+{
+    std::printf("usage: cg3_math_suite [--count N] [--repeat R] [--filter NAME] [--json FILE|-]\n");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--count" && hasValue) {
+            options.count = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--repeat" && hasValue) {
+            options.repeat = std::max<uint32_t>(1, uint32_t(std::strtoul(argv[++i], nullptr, 10)));
+        } else if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        } else if (arg == "--json" && hasValue) {
+            options.jsonPath = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// doubleで計算する参照実装
+struct MatrixD {
+    double m[4][4];
+};
+
+MatrixD ToDouble(const Matrix4x4& matrix)
+{
+    MatrixD num;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            num.m[i][j] = matrix.m[i][j];
+        }
+    }
+    return num;
+}
+
+MatrixD MultiplyD(const MatrixD& m1, const MatrixD& m2)
+{
+    MatrixD num {};
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            for (int k = 0; k < 4; ++k) {
+                num.m[i][j] += m1.m[i][k] * m2.m[k][j];
+            }
+        }
+    }
+    return num;
+}
+
+// 部分ピボット付きのガウス・ジョルダン法
+MatrixD InverseD(const MatrixD& matrix)
+{
+    double a[4][8];
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            a[i][j] = matrix.m[i][j];
+            a[i][j + 4] = i == j ? 1.0 : 0.0;
+        }
+    }
+    for (int column = 0; column < 4; ++column) {
+        int pivot = column;
+        for (int row = column + 1; row < 4; ++row) {
+            if (std::fabs(a[row][column]) > std::fabs(a[pivot][column])) {
+                pivot = row;
+            }
+        }
+        for (int j = 0; j < 8; ++j) {
+            std::swap(a[column][j], a[pivot][j]);
+        }
+        double rcpPivot = 1.0 / a[column][column];
+        for (int j = 0; j < 8; ++j) {
+            a[column][j] *= rcpPivot;
+        }
+        for (int row = 0; row < 4; ++row) {
+            if (row == column) {
+                continue;
+            }
+            double factor = a[row][column];
+            for (int j = 0; j < 8; ++j) {
+                a[row][j] -= factor * a[column][j];
+            }
+        }
+    }
+    MatrixD num;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            num.m[i][j] = a[i][j + 4];
+        }
+    }
+    return num;
+}
+
+MatrixD TransposeD(const MatrixD& matrix)
+{
+    MatrixD num;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            num.m[i][j] = matrix.m[j][i];
+        }
+    }
+    return num;
+}
+
+MatrixD MakeRotateXD(double radian)
+{
+    return { { { 1, 0, 0, 0 }, { 0, std::cos(radian), std::sin(radian), 0 }, { 0, -std::sin(radian), std::cos(radian), 0 }, { 0, 0, 0, 1 } } };
+}
+MatrixD MakeRotateYD(double radian)
+{
+    return { { { std::cos(radian), 0, -std::sin(radian), 0 }, { 0, 1, 0, 0 }, { std::sin(radian), 0, std::cos(radian), 0 }, { 0, 0, 0, 1 } } };
+}
+MatrixD MakeRotateZD(double radian)
+{
+    return { { { std::cos(radian), std::sin(radian), 0, 0 }, { -std::sin(radian), std::cos(radian), 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } } };
+}
+
+MatrixD MakeAffineD(const Transform& transform)
+{
+    MatrixD rotate = MultiplyD(MakeRotateXD(transform.rotate.x), MultiplyD(MakeRotateYD(transform.rotate.y), MakeRotateZD(transform.rotate.z)));
+    const double scale[3] = { transform.scale.x, transform.scale.y, transform.scale.z };
+    MatrixD num {};
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            num.m[i][j] = scale[i] * rotate.m[i][j];
+        }
+    }
+    num.m[3][0] = transform.translate.x;
+    num.m[3][1] = transform.translate.y;
+    num.m[3][2] = transform.translate.z;
+    num.m[3][3] = 1.0;
+    return num;
+}
+
+// 誤差の最大と平均
+struct ErrorStats {
+    double max = 0.0;
+    double sum = 0.0;
+    size_t count = 0;
+    size_t mismatches = 0;
+
+    void Add(double error)
+    {
+        max = std::max(max, error);
+        sum += error;
+        ++count;
+    }
+    double Mean() const { return count ? sum / double(count) : 0.0; }
+};
+
+// 参照の最大要素に対する各要素の誤差
+void AddMatrixError(ErrorStats& stats, const MatrixD& reference, const Matrix4x4& value)
+{
+    double scale = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            scale = std::max(scale, std::fabs(reference.m[i][j]));
+        }
+    }
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            double error = std::fabs(reference.m[i][j] - double(value.m[i][j]));
+            stats.Add(scale > 0.0 ? error / scale : error);
+        }
+    }
+}
+
+// 1回分の処理時間(ns)。repeat回のうち一番速いもの
+template <typename Function>
+double MeasureNanoseconds(size_t count, uint32_t repeat, Function&& function)
+{
+    double best = 1e30;
+    for (uint32_t r = 0; r < repeat; ++r) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            function(i);
+        }
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, elapsed / double(count));
+    }
+    return best;
+}
+
+// 入力セット
+struct MatrixSet {
+    const char* name;
+    std::vector<Matrix4x4> matrices;
+};
+struct TransformSet {
+    const char* name;
+    std::vector<Transform> transforms;
+};
+struct VectorSet {
+    const char* name;
+    std::vector<Vector3> vectors;
+};
+struct AngleSet {
+    const char* name;
+    std::vector<float> radians;
+};
+
+struct Inputs {
+    MatrixSet random { "random", {} };
+    MatrixSet nearSingular { "near-singular", {} }; // 条件数が1e4程度
+    MatrixSet rigid { "rigid", {} };
+    MatrixSet affine { "affine", {} };
+    TransformSet affineTransforms { "affine", {} };
+    TransformSet rigidTransforms { "rigid", {} };
+    TransformSet largeAngleTransforms { "large-angle", {} }; // 回転が±1000ラジアン
+    VectorSet vectors { "random", {} };
+    VectorSet tinyVectors { "tiny", {} }; // 長さが1e-15程度
+    VectorSet hugeVectors { "huge", {} }; // 長さが1e15程度
+    AngleSet angles { "random", {} };
+    AngleSet largeAngles { "large-angle", {} };
+    std::vector<AABB> aabbs;
+    std::vector<Vector3> points;
+    std::vector<Sphere> spheres;
+};
+
+Inputs MakeInputs(size_t count)
+{
+    std::mt19937 engine(kSeed);
+    std::uniform_real_distribution<float> any(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> angle(-std::numbers::pi_v<float>, std::numbers::pi_v<float>);
+    std::uniform_real_distribution<float> largeAngle(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+    std::uniform_real_distribution<float> size(0.1f, 3.0f);
+
+    Inputs inputs;
+    for (size_t i = 0; i < count; ++i) {
+        Matrix4x4 random;
+        for (int r = 0; r < 4; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                random.m[r][c] = any(engine);
+            }
+        }
+        inputs.random.matrices.push_back(random);
+
+        // 4行目をほかの行の組み合わせに近づける
+        Matrix4x4 nearSingular = random;
+        for (int c = 0; c < 4; ++c) {
+            nearSingular.m[3][c] = random.m[0][c] + 0.5f * random.m[1][c] + 1e-4f * any(engine);
+        }
+        inputs.nearSingular.matrices.push_back(nearSingular);
+
+        Transform transform {
+            { scale(engine), scale(engine), scale(engine) },
+            { angle(engine), angle(engine), angle(engine) },
+            { any(engine), any(engine), any(engine) },
+        };
+        Transform rigid = transform;
+        rigid.scale = { 1.0f, 1.0f, 1.0f };
+        Transform large = transform;
+        large.rotate = { largeAngle(engine), largeAngle(engine), largeAngle(engine) };
+        inputs.affineTransforms.transforms.push_back(transform);
+        inputs.rigidTransforms.transforms.push_back(rigid);
+        inputs.largeAngleTransforms.transforms.push_back(large);
+        inputs.affine.matrices.push_back(MakeAffineMatrixScalar(transform.scale, transform.rotate, transform.translate));
+        inputs.rigid.matrices.push_back(MakeAffineMatrixScalar(rigid.scale, rigid.rotate, rigid.translate));
+
+        Vector3 vector = { any(engine), any(engine), any(engine) };
+        inputs.vectors.vectors.push_back(vector);
+        inputs.tinyVectors.vectors.push_back(vector * 1e-16f);
+        inputs.hugeVectors.vectors.push_back(vector * 1e14f);
+        inputs.angles.radians.push_back(angle(engine));
+        inputs.largeAngles.radians.push_back(largeAngle(engine));
+
+        Vector3 center = { any(engine) * 6.0f, any(engine) * 6.0f, any(engine) * 6.0f };
+        Vector3 extent = { size(engine), size(engine), size(engine) };
+        inputs.aabbs.push_back({ { center.x - extent.x, center.y - extent.y, center.z - extent.z }, { center.x + extent.x, center.y + extent.y, center.z + extent.z } });
+        inputs.points.push_back({ center.x + extent.x * 1.5f * unit(engine), center.y + extent.y * 1.5f * unit(engine), center.z + extent.z * 1.5f * unit(engine) });
+        inputs.spheres.push_back({ center, size(engine) });
+    }
+    return inputs;
+}
+
+struct Result {
+    std::string operation;
+    std::string variant;
+    std::string inputSet;
+    size_t count;
+    double nanoseconds;
+    ErrorStats error;
+};
+
+class Suite {
+public:
+    Suite(const Options& options, const Inputs& inputs)
+        : options_(options)
+        , inputs_(inputs)
+        , matrixOutput_(options.count)
+        , vectorOutput_(options.count)
+        , boolOutput_(options.count)
+    {
+    }
+
+    void Run();
+    const std::vector<Result>& GetResults() const { return results_; }
+
+private:
+    bool IsSelected(const char* operation) const { return options_.filter.empty() || std::string(operation).find(options_.filter) != std::string::npos; }
+    void Add(const char* operation, const char* variant, const char* inputSet, double nanoseconds, const ErrorStats& error);
+
+    void RunMultiply();
+    void RunInverse();
+    void RunMakeAffineMatrix();
+    void RunMakeRotateMatrix();
+    void RunNormalize();
+    void RunIsCollision();
+
+    const Options& options_;
+    const Inputs& inputs_;
+    std::vector<Matrix4x4> matrixOutput_;
+    std::vector<Vector3> vectorOutput_;
+    std::vector<uint8_t> boolOutput_;
+    std::vector<Result> results_;
+};
+
+void Suite::Add(const char* operation, const char* variant, const char* inputSet, double nanoseconds, const ErrorStats& error)
+{
+    results_.push_back({ operation, variant, inputSet, options_.count, nanoseconds, error });
+    std::printf("%-18s %-8s %-14s %9.2f ns/op %10.2f Mops/s  max %.3g mean %.3g", operation, variant, inputSet,
+        nanoseconds, 1e3 / nanoseconds, error.max, error.Mean());
+    if (error.mismatches) {
+        std::printf("  mismatch %zu", error.mismatches);
+    }
+    std::printf("\n");
+}
+
+void Suite::RunMultiply()
+{
+    if (!IsSelected("Multiply")) {
+        return;
+    }
+    const MatrixSet* sets[] = { &inputs_.random, &inputs_.nearSingular, &inputs_.rigid, &inputs_.affine };
+    for (const MatrixSet* set : sets) {
+        // 隣同士を掛ける
+        const std::vector<Matrix4x4>& m = set->matrices;
+        size_t count = m.size();
+        for (int b = 0; b < kMatrixBackendCount; ++b) {
+            MatrixBackend backend = MatrixBackend(b);
+            if (!IsMatrixBackendSupported(backend)) {
+                continue;
+            }
+            const MatrixKernels& kernels = GetMatrixKernels(backend);
+            double ns = MeasureNanoseconds(count, options_.repeat, [&](size_t i) { matrixOutput_[i] = kernels.multiply(m[i], m[(i + 1) % count]); });
+            ErrorStats error;
+            for (size_t i = 0; i < count; ++i) {
+                AddMatrixError(error, MultiplyD(ToDouble(m[i]), ToDouble(m[(i + 1) % count])), matrixOutput_[i]);
+            }
+            Add("Multiply", GetMatrixBackendName(backend), set->name, ns, error);
+        }
+    }
+}
+
+void Suite::RunInverse()
+{
+    using InverseFunction = Matrix4x4 (*)(const Matrix4x4&);
+    struct Variant {
+        const char* operation;
+        InverseFunction MatrixKernels::* function;
+        std::vector<const MatrixSet*> sets;
+        bool transposeReference; // 法線行列は逆行列の転置
+    };
+    const Variant variants[] = {
+        { "Inverse", &MatrixKernels::inverse, { &inputs_.random, &inputs_.nearSingular, &inputs_.rigid, &inputs_.affine }, false },
+        { "InverseAffine", &MatrixKernels::inverseAffine, { &inputs_.rigid, &inputs_.affine }, false },
+        { "InverseRigid", &MatrixKernels::inverseRigid, { &inputs_.rigid }, false },
+        { "MakeNormalMatrix", &MatrixKernels::makeNormalMatrix, { &inputs_.rigid, &inputs_.affine }, true },
+    };
+    for (const Variant& variant : variants) {
+        if (!IsSelected(variant.operation)) {
+            continue;
+        }
+        for (const MatrixSet* set : variant.sets) {
+            const std::vector<Matrix4x4>& m = set->matrices;
+            std::vector<MatrixD> references(m.size());
+            for (size_t i = 0; i < m.size(); ++i) {
+                references[i] = InverseD(ToDouble(m[i]));
+                if (variant.transposeReference) {
+                    // 平行移動の部分は0、m[3][3]は1にする(MakeNormalMatrixと同じ)
+                    references[i] = TransposeD(references[i]);
+                    for (int k = 0; k < 3; ++k) {
+                        references[i].m[k][3] = 0.0;
+                        references[i].m[3][k] = 0.0;
+                    }
+                    references[i].m[3][3] = 1.0;
+                }
+            }
+            for (int b = 0; b < kMatrixBackendCount; ++b) {
+                MatrixBackend backend = MatrixBackend(b);
+                if (!IsMatrixBackendSupported(backend)) {
+                    continue;
+                }
+                InverseFunction function = GetMatrixKernels(backend).*variant.function;
+                double ns = MeasureNanoseconds(m.size(), options_.repeat, [&](size_t i) { matrixOutput_[i] = function(m[i]); });
+                ErrorStats error;
+                for (size_t i = 0; i < m.size(); ++i) {
+                    AddMatrixError(error, references[i], matrixOutput_[i]);
+                }
+                Add(variant.operation, GetMatrixBackendName(backend), set->name, ns, error);
+            }
+        }
+    }
+}
+
+void Suite::RunMakeAffineMatrix()
+{
+    if (!IsSelected("MakeAffineMatrix")) {
+        return;
+    }
+    const TransformSet* sets[] = { &inputs_.affineTransforms, &inputs_.rigidTransforms, &inputs_.largeAngleTransforms };
+    for (const TransformSet* set : sets) {
+        const std::vector<Transform>& t = set->transforms;
+        for (int b = 0; b < kMatrixBackendCount; ++b) {
+            MatrixBackend backend = MatrixBackend(b);
+            if (!IsMatrixBackendSupported(backend)) {
+                continue;
+            }
+            const MatrixKernels& kernels = GetMatrixKernels(backend);
+            double ns = MeasureNanoseconds(t.size(), options_.repeat, [&](size_t i) { matrixOutput_[i] = kernels.makeAffineMatrix(t[i].scale, t[i].rotate, t[i].translate); });
+            ErrorStats error;
+            for (size_t i = 0; i < t.size(); ++i) {
+                AddMatrixError(error, MakeAffineD(t[i]), matrixOutput_[i]);
+            }
+            Add("MakeAffineMatrix", GetMatrixBackendName(backend), set->name, ns, error);
+        }
+    }
+}
+
+void Suite::RunMakeRotateMatrix()
+{
+    struct Variant {
+        const char* operation;
+        Matrix4x4 (*function)(float);
+        MatrixD (*reference)(double);
+    };
+    // constexprの関数は引数を変えられるように一度ポインタに入れる
+    const Variant variants[] = {
+        { "MakeRotateXMatrix", [](float radian) { return MakeRotateXMatrix(radian); }, MakeRotateXD },
+        { "MakeRotateYMatrix", [](float radian) { return MakeRotateYMatrix(radian); }, MakeRotateYD },
+        { "MakeRotateZMatrix", [](float radian) { return MakeRotateZMatrix(radian); }, MakeRotateZD },
+    };
+    const AngleSet* sets[] = { &inputs_.angles, &inputs_.largeAngles };
+    for (const Variant& variant : variants) {
+        if (!IsSelected(variant.operation)) {
+            continue;
+        }
+        for (const AngleSet* set : sets) {
+            const std::vector<float>& radians = set->radians;
+            double ns = MeasureNanoseconds(radians.size(), options_.repeat, [&](size_t i) { matrixOutput_[i] = variant.function(radians[i]); });
+            ErrorStats error;
+            for (size_t i = 0; i < radians.size(); ++i) {
+                AddMatrixError(error, variant.reference(radians[i]), matrixOutput_[i]);
+            }
+            Add(variant.operation, "scalar", set->name, ns, error);
+        }
+    }
+}
+
+void Suite::RunNormalize()
+{
+    if (!IsSelected("Normalize")) {
+        return;
+    }
+    const VectorSet* sets[] = { &inputs_.vectors, &inputs_.tinyVectors, &inputs_.hugeVectors };
+    for (const VectorSet* set : sets) {
+        const std::vector<Vector3>& v = set->vectors;
+        double ns = MeasureNanoseconds(v.size(), options_.repeat, [&](size_t i) { vectorOutput_[i] = Normalize(v[i]); });
+        ErrorStats error;
+        for (size_t i = 0; i < v.size(); ++i) {
+            double length = std::sqrt(double(v[i].x) * v[i].x + double(v[i].y) * v[i].y + double(v[i].z) * v[i].z);
+            const double reference[3] = { v[i].x / length, v[i].y / length, v[i].z / length };
+            const float value[3] = { vectorOutput_[i].x, vectorOutput_[i].y, vectorOutput_[i].z };
+            for (int k = 0; k < 3; ++k) {
+                // 長さが0やinfになって結果がNaNのときは誤差1とみなす
+                double e = std::fabs(reference[k] - double(value[k]));
+                error.Add(std::isnan(e) ? 1.0 : e);
+            }
+        }
+        Add("Normalize", "scalar", set->name, ns, error);
+    }
+}
+
+void Suite::RunIsCollision()
+{
+    size_t count = inputs_.aabbs.size();
+    if (IsSelected("IsCollision")) {
+        // AABBと点。参照はdoubleで同じ比較をしたもの
+        double ns = MeasureNanoseconds(count, options_.repeat, [&](size_t i) { boolOutput_[i] = IsCollision(inputs_.aabbs[i], inputs_.points[i]); });
+        ErrorStats error;
+        for (size_t i = 0; i < count; ++i) {
+            const AABB& aabb = inputs_.aabbs[i];
+            const Vector3& p = inputs_.points[i];
+            bool reference = double(aabb.min.x) <= p.x && p.x <= double(aabb.max.x) && double(aabb.min.y) <= p.y && p.y <= double(aabb.max.y)
+                && double(aabb.min.z) <= p.z && p.z <= double(aabb.max.z);
+            error.Add(reference != bool(boolOutput_[i]));
+            error.mismatches += reference != bool(boolOutput_[i]);
+        }
+        Add("IsCollision", "scalar", "aabb-point", ns, error);
+    }
+
+    // 視錐台と球。参照はdoubleのビュープロジェクション行列から取り出した平面で判定したもの
+    if (!IsSelected("IsCollision") && !IsSelected("CullSpheres")) {
+        return;
+    }
+    Matrix4x4 view = InverseRigidScalar(MakeAffineMatrixScalar({ 1.0f, 1.0f, 1.0f }, { 0.3f, 0.5f, 0.0f }, { 0.0f, 4.0f, -30.0f }));
+    Matrix4x4 viewProjection = MultiplyScalar(view, MakePrespectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f));
+    Frustum frustum = MakeFrustum(viewProjection);
+    MatrixD vp = ToDouble(viewProjection);
+    std::vector<uint8_t> references(count);
+    for (size_t i = 0; i < count; ++i) {
+        const Sphere& sphere = inputs_.spheres[i];
+        bool visible = true;
+        for (int p = 0; p < 6; ++p) {
+            double plane[4];
+            for (int k = 0; k < 4; ++k) {
+                const double column[4] = { vp.m[k][0], vp.m[k][1], vp.m[k][2], vp.m[k][3] };
+                const double planes[6] = { column[3] + column[0], column[3] - column[0], column[3] + column[1], column[3] - column[1], column[2], column[3] - column[2] };
+                plane[k] = planes[p];
+            }
+            double length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+            double distance = (plane[0] * sphere.center.x + plane[1] * sphere.center.y + plane[2] * sphere.center.z + plane[3]) / length;
+            visible = visible && distance >= -double(sphere.radius);
+        }
+        references[i] = visible;
+    }
+    auto addCullError = [&](ErrorStats& error, size_t i, bool visible) {
+        error.Add(bool(references[i]) != visible);
+        error.mismatches += bool(references[i]) != visible;
+    };
+    if (IsSelected("IsCollision")) {
+        double ns = MeasureNanoseconds(count, options_.repeat, [&](size_t i) { boolOutput_[i] = IsCollision(frustum, inputs_.spheres[i]); });
+        ErrorStats error;
+        for (size_t i = 0; i < count; ++i) {
+            addCullError(error, i, boolOutput_[i]);
+        }
+        Add("IsCollision", "scalar", "frustum-sphere", ns, error);
+    }
+    if (IsSelected("CullSpheres")) {
+        // 一括判定はバックエンド毎に計る
+        std::vector<uint32_t> visibleMask(GetVisibleMaskWordCount(count));
+        MatrixBackend activeBackend = GetActiveMatrixBackend();
+        for (int b = 0; b < kMatrixBackendCount; ++b) {
+            MatrixBackend backend = MatrixBackend(b);
+            if (!IsMatrixBackendSupported(backend)) {
+                continue;
+            }
+            SetActiveMatrixBackend(backend);
+            double ns = MeasureNanoseconds(1, options_.repeat, [&](size_t) { CullSpheres(frustum, inputs_.spheres.data(), count, visibleMask.data()); }) / double(count);
+            ErrorStats error;
+            for (size_t i = 0; i < count; ++i) {
+                addCullError(error, i, IsVisible(visibleMask.data(), i));
+            }
+            Add("CullSpheres", GetMatrixBackendName(backend), "frustum-sphere", ns, error);
+        }
+        SetActiveMatrixBackend(activeBackend);
+    }
+}
+
+void Suite::Run()
+{
+    RunMultiply();
+    RunInverse();
+    RunMakeAffineMatrix();
+    RunMakeRotateMatrix();
+    RunNormalize();
+    RunIsCollision();
+}
+
+// JSONの値(数値がinf/NaNのときはnullにする)
+void WriteNumber(std::FILE* file, double value)
+{
+    if (std::isfinite(value)) {
+        std::fprintf(file, "%.9g", value);
+    } else {
+        std::fprintf(file, "null");
+    }
+}
+
+void WriteJson(std::FILE* file, const Options& options, const std::vector<Result>& results)
+{
+    std::fprintf(file, "{\n  \"seed\": %u,\n  \"count\": %zu,\n  \"repeat\": %u,\n  \"activeBackend\": \"%s\",\n  \"results\": [\n",
+        kSeed, options.count, options.repeat, GetMatrixBackendName(GetActiveMatrixBackend()));
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        std::fprintf(file, "    {\"operation\": \"%s\", \"variant\": \"%s\", \"inputSet\": \"%s\", \"count\": %zu, \"nsPerOp\": ",
+            result.operation.c_str(), result.variant.c_str(), result.inputSet.c_str(), result.count);
+        WriteNumber(file, result.nanoseconds);
+        std::fprintf(file, ", \"opsPerSec\": ");
+        WriteNumber(file, 1e9 / result.nanoseconds);
+        std::fprintf(file, ", \"maxError\": ");
+        WriteNumber(file, result.error.max);
+        std::fprintf(file, ", \"meanError\": ");
+        WriteNumber(file, result.error.Mean());
+        std::fprintf(file, ", \"mismatches\": %zu}%s\n", result.error.mismatches, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    Inputs inputs = MakeInputs(options.count);
+    std::printf("seed: %u, count: %zu, repeat: %u, active backend: %s\n", kSeed, options.count, options.repeat, GetMatrixBackendName(GetActiveMatrixBackend()));
+    Suite suite(options, inputs);
+    suite.Run();
+
+    if (!options.jsonPath.empty()) {
+        std::FILE* file = options.jsonPath == "-" ? stdout : std::fopen(options.jsonPath.c_str(), "w");
+        if (!file) {
+            std::fprintf(stderr, "cannot open %s\n", options.jsonPath.c_str());
+            return 1;
+        }
+        WriteJson(file, options, suite.GetResults());
+        if (file != stdout) {
+            std::fclose(file);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,268 @@
+// メッシュレットの生成とカリングを計測する
+//
+// resources/terrain.objと、なめらかな起伏の格子・球(三角形の数を指定して作る)でBuildMeshletsの時間と、
+// メッシュレットの数・平均の頂点数と三角形の数・OptimizeMeshだけの後と全て済んだ後の頂点キャッシュのACMRを出す。
+// いくつかのカメラの位置で、見えるメッシュレットの数、視錐台の外と裏向きで除いた三角形の数、CullMeshletsの時間を出す。
+// 除きすぎていないかも全ての三角形で確かめ、違えば失敗にする
+//   - 境界球は塊の全ての頂点を含む
+//   - 視錐台の外とした塊は、全ての頂点が同じ面の外にある
+//   - 裏向きとした塊は、全ての三角形がカメラに裏を向けている
+//   - ACMRがOptimizeMeshだけのときより悪くならず、頂点はindexで初めて使われる順のまま
+#include "BenchMesh.h"
+#include "Camera.h"
+#include "Culling.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "Meshlet.h"
+#include "Model.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+const float kPi = 3.14159265f;
+
+struct Options {
+    size_t maxTriangles = 2000000;
+    uint32_t iterations = 20;
+    std::string resources = "resources";
+};
+
+void PrintUsage()
+{
+    std::printf("usage: cg3_meshlet_bench [--max-triangles N] [--iterations N] [--resources DIR]\n");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--max-triangles" && hasValue) {
+            options.maxTriangles = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--iterations" && hasValue) {
+            options.iterations = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--resources" && hasValue) {
+            options.resources = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 半径1の球(緯度latitudeCount、経度longitudeCount分割。三角形は外に表を向ける)
+ModelData MakeSphere(uint32_t latitudeCount, uint32_t longitudeCount)
+{
+    ModelData modelData;
+    uint32_t rowSize = longitudeCount + 1;
+    for (uint32_t lat = 0; lat <= latitudeCount; ++lat) {
+        float theta = kPi * float(lat) / float(latitudeCount) - kPi * 0.5f;
+        for (uint32_t lon = 0; lon <= longitudeCount; ++lon) {
+            float phi = 2.0f * kPi * float(lon) / float(longitudeCount);
+            Vector3 p = { std::cos(theta) * std::cos(phi), std::sin(theta), std::cos(theta) * std::sin(phi) };
+            modelData.vertices.push_back({ { p.x, p.y, p.z, 1.0f }, { float(lon) / float(longitudeCount), float(lat) / float(latitudeCount) }, p });
+        }
+    }
+    for (uint32_t lat = 0; lat < latitudeCount; ++lat) {
+        for (uint32_t lon = 0; lon < longitudeCount; ++lon) {
+            uint32_t lb = lat * rowSize + lon;
+            uint32_t rb = lb + 1;
+            uint32_t lt = lb + rowSize;
+            uint32_t rt = lt + 1;
+            // 極では片方の三角形が潰れるので入れない
+            if (lat != 0) {
+                modelData.indices.insert(modelData.indices.end(), { lb, lt, rb });
+            }
+            if (lat != latitudeCount - 1) {
+                modelData.indices.insert(modelData.indices.end(), { rb, lt, rt });
+            }
+        }
+    }
+    modelData.submeshes.push_back({ 0, uint32_t(modelData.indices.size()), 0 });
+    modelData.materials.push_back({ "Material", "" });
+    return modelData;
+}
+
+// 全ての三角形が、サブメッシュの範囲の中でちょうど1回ずつメッシュレットに入っているか
+bool IsValidMeshlets(const ModelData& modelData, const std::vector<uint32_t>& sourceIndices)
+{
+    size_t triangleCount = 0;
+    for (const Meshlet& meshlet : modelData.meshlets) {
+        if (meshlet.indexOffset != triangleCount * 3 || meshlet.triangleCount == 0 || meshlet.triangleCount > kMeshletMaxTriangles
+            || meshlet.vertexCount > kMeshletMaxVertices) {
+            return false;
+        }
+        triangleCount += meshlet.triangleCount;
+    }
+    if (triangleCount * 3 != modelData.indices.size()) {
+        return false;
+    }
+    // 三角形の集合は同じ
+    auto sortTriangles = [](const std::vector<uint32_t>& indices) {
+        std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+        for (size_t t = 0; t < triangles.size(); ++t) {
+            triangles[t] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] };
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    };
+    return sortTriangles(sourceIndices) == sortTriangles(modelData.indices);
+}
+
+// 頂点がindexで初めて使われる順に並んでいるか(OptimizeVertexFetchの結果が残っているか)
+bool IsFetchOrdered(const ModelData& modelData)
+{
+    uint32_t nextVertex = 0;
+    for (uint32_t index : modelData.indices) {
+        if (index > nextVertex) {
+            return false;
+        }
+        nextVertex += index == nextVertex;
+    }
+    return nextVertex == modelData.vertices.size();
+}
+
+// カリングで除いた塊が本当に見えないか、全ての三角形で確かめる
+bool IsConservative(const ModelData& modelData, const Frustum& frustum, const Vector3& cameraPosition, const std::vector<uint32_t>& visibleMask)
+{
+    for (size_t i = 0; i < modelData.meshlets.size(); ++i) {
+        const Meshlet& meshlet = modelData.meshlets[i];
+        const Sphere& bounds = modelData.meshletBounds[i];
+        const uint32_t* indices = modelData.indices.data() + meshlet.indexOffset;
+        uint32_t indexCount = meshlet.triangleCount * 3;
+        float tolerance = bounds.radius * 1e-4f + 1e-6f;
+        for (uint32_t k = 0; k < indexCount; ++k) {
+            Vector3 offset = Sub(GetPosition(modelData, indices[k]), bounds.center);
+            if (std::sqrt(Dot(offset, offset)) > bounds.radius + tolerance) {
+                return false;
+            }
+        }
+        if (!IsVisible(visibleMask.data(), i)) {
+            bool isOutside = false;
+            for (const Plane& plane : frustum.planes) {
+                bool isAllOutside = true;
+                for (uint32_t k = 0; k < indexCount && isAllOutside; ++k) {
+                    isAllOutside = Dot(plane.normal, GetPosition(modelData, indices[k])) + plane.distance < 0.0f;
+                }
+                isOutside = isOutside || isAllOutside;
+            }
+            if (!isOutside) {
+                return false;
+            }
+        } else if (IsMeshletBackfacing(meshlet, bounds, cameraPosition)) {
+            for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+                Vector3 p0 = GetPosition(modelData, indices[t * 3]);
+                Vector3 e0 = Sub(GetPosition(modelData, indices[t * 3 + 1]), p0);
+                Vector3 e1 = Sub(GetPosition(modelData, indices[t * 3 + 2]), p0);
+                Vector3 normal = { e0.y * e1.z - e0.z * e1.y, e0.z * e1.x - e0.x * e1.z, e0.x * e1.y - e0.y * e1.x };
+                if (Dot(normal, Sub(p0, cameraPosition)) < 0.0f) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+struct CameraPose {
+    const char* name;
+    Vector3 rotate;
+    Vector3 offset; // 境界球の中心から、半径を1とした位置
+};
+
+const CameraPose kCameraPoses[] = {
+    { "front", { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -4.0f } },
+    { "near", { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.2f } },
+    { "above", { kPi * 0.5f, 0.0f, 0.0f }, { 0.0f, 3.0f, 0.0f } },
+    { "below", { -kPi * 0.5f, 0.0f, 0.0f }, { 0.0f, -3.0f, 0.0f } },
+    { "inside", { 0.3f, 0.8f, 0.0f }, { 0.0f, 0.0f, 0.0f } },
+};
+
+bool Measure(const std::string& name, ModelData modelData, uint32_t iterations)
+{
+    OptimizeMesh(modelData);
+    std::vector<uint32_t> sourceIndices = modelData.indices;
+    VertexCacheStats before = AnalyzeVertexCache(modelData.indices.data(), modelData.indices.size(), modelData.vertices.size());
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    BuildMeshlets(modelData);
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    VertexCacheStats after = AnalyzeVertexCache(modelData.indices.data(), modelData.indices.size(), modelData.vertices.size());
+    bool isValid = IsValidMeshlets(modelData, sourceIndices);
+    bool isCacheKept = after.acmr <= before.acmr && IsFetchOrdered(modelData);
+
+    size_t triangleCount = modelData.indices.size() / 3;
+    size_t meshletCount = modelData.meshlets.size();
+    size_t vertexSum = 0;
+    for (const Meshlet& meshlet : modelData.meshlets) {
+        vertexSum += meshlet.vertexCount;
+    }
+    std::printf("%-20s %9zu triangles  build %8.2f ms (%6.2f Mtriangles/s)  %7zu meshlets (%.1f vertices, %.1f triangles)  ACMR %.3f -> %.3f%s  %s\n",
+        name.c_str(), triangleCount, buildMs, double(triangleCount) / buildMs * 1e-3, meshletCount,
+        double(vertexSum) / double(std::max<size_t>(meshletCount, 1)), double(triangleCount) / double(std::max<size_t>(meshletCount, 1)), before.acmr,
+        after.acmr, isCacheKept ? "" : " WORSE ORDER", isValid ? "valid" : "INVALID");
+
+    AABB aabb = CalculateBounds(modelData);
+    Vector3 center = { (aabb.min.x + aabb.max.x) * 0.5f, (aabb.min.y + aabb.max.y) * 0.5f, (aabb.min.z + aabb.max.z) * 0.5f };
+    Vector3 halfSize = Sub(aabb.max, center);
+    float radius = std::sqrt(Dot(halfSize, halfSize));
+
+    bool isAllConservative = true;
+    std::vector<uint32_t> visibleMask;
+    std::vector<Submesh> drawRanges;
+    for (const CameraPose& pose : kCameraPoses) {
+        Camera camera;
+        camera.SetRotate(pose.rotate);
+        camera.SetTranslate({ center.x + pose.offset.x * radius, center.y + pose.offset.y * radius, center.z + pose.offset.z * radius });
+        const Vector3& cameraPosition = camera.GetTransform().translate;
+        Matrix4x4 worldMatrix = MakeIdentity4x4();
+        MeshletCullStats stats {};
+        start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; ++i) {
+            CullMeshlets(modelData.meshlets, modelData.meshletBounds, worldMatrix, camera.GetViewProjectionMatrix(), cameraPosition, visibleMask,
+                drawRanges, &stats);
+        }
+        double cullUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / double(std::max(iterations, 1u));
+        bool isConservative = IsConservative(modelData, MakeFrustum(camera.GetViewProjectionMatrix()), cameraPosition, visibleMask);
+        isAllConservative = isAllConservative && isConservative;
+        size_t culled = stats.frustumCulledTriangleCount + stats.backfaceCulledTriangleCount;
+        std::printf("%-20s   %-7s %7u / %7u meshlets  culled %9zu (%5.1f%%): frustum %9zu, backface %9zu  %4zu ranges  cull %9.2f us  %s\n", "",
+            pose.name, stats.visibleMeshletCount, stats.meshletCount, culled, 100.0 * double(culled) / double(std::max<size_t>(stats.triangleCount, 1)),
+            stats.frustumCulledTriangleCount, stats.backfaceCulledTriangleCount, drawRanges.size(), cullUs,
+            isConservative ? "conservative" : "NOT CONSERVATIVE");
+    }
+    return isValid && isCacheKept && isAllConservative;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    bool isAllValid = true;
+    if (std::filesystem::exists(std::filesystem::path(options.resources) / "terrain.obj")) {
+        isAllValid = Measure("terrain.obj", LoadObjFile(options.resources, "terrain.obj"), options.iterations) && isAllValid;
+    }
+    // 三角形の数が10倍ずつ増えるように大きさを決める
+    for (size_t triangles = 20000; triangles <= options.maxTriangles; triangles *= 10) {
+        uint32_t gridSize = uint32_t(std::sqrt(double(triangles) / 2.0));
+        isAllValid = Measure("grid_" + std::to_string(gridSize * gridSize * 2), MakeTerrain(gridSize), options.iterations) && isAllValid;
+        uint32_t latitudeCount = uint32_t(std::sqrt(double(triangles) / 4.0));
+        ModelData sphere = MakeSphere(latitudeCount, latitudeCount * 2);
+        std::string sphereName = "sphere_" + std::to_string(sphere.indices.size() / 3);
+        isAllValid = Measure(sphereName, std::move(sphere), options.iterations) && isAllValid;
+    }
+    return isAllValid ? 0 : 1;
+}
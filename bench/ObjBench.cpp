@@ -0,0 +1,329 @@
+// objの読み込みを計測する
+//
+// resources/terrain.objと、それを大きくした格子状の地形(面数を指定して生成する)を
+// LoadObjFileStream(istringstream版)とLoadObjFile(マップしてfrom_charsで読む版)で読み、
+// 時間と結果が一致するか、頂点をまとめてどれだけ減ったかを出す。
+// PackedVertexDataに詰めたときの大きさと誤差(上限を超えたら失敗にする)、
+// OptimizeMeshの時間と、頂点キャッシュを真似して数えたACMR/ATVR/ヒット率の前後も出す。
+// BuildMeshletsとBuildLodChainの時間、メッシュレットとLODの数も出す(詳しくはcg3_meshlet_benchとcg3_lod_bench)。
+// 2回目以降に使う.cg3meshキャッシュの書き込みと読み込みの時間も出し、中の値を壊したキャッシュが使われないことを確かめる。
+// --threadsを付けると、大きいファイルはスレッド数を1から倍々に増やして並列で読み、1スレッドとの比較も出す。
+// 生成したファイルは一時ディレクトリに置いて最後に消す。
+#include "BenchObj.h"
+#include "MeshCache.h"
+#include "MeshLod.h"
+#include "Meshlet.h"
+#include "MeshOptimizer.h"
+#include "PackedVertex.h"
+#include "Model.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    uint32_t repeat = 3;
+    uint32_t maxThreads = 0; // 0なら並列では読まない
+    size_t maxFaces = 2000000;
+    std::string resources = "resources";
+};
+
+void PrintUsage()
+{
+    std::printf("usage: cg3_obj_bench [--repeat R] [--max-faces N] [--threads T] [--resources DIR]\n");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--repeat" && hasValue) {
+            options.repeat = std::max<uint32_t>(1, uint32_t(std::strtoul(argv[++i], nullptr, 10)));
+        } else if (arg == "--max-faces" && hasValue) {
+            options.maxFaces = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && hasValue) {
+            options.maxThreads = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--resources" && hasValue) {
+            options.resources = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// サブメッシュ毎の三角形の集まりが同じか(順番は問わない)
+bool IsSameTriangleSet(const ModelData& a, const ModelData& b)
+{
+    if (a.indices.size() != b.indices.size() || !IsSameMaterials(a, b)) {
+        return false;
+    }
+    using Triangle = std::array<VertexData, 3>;
+    auto less = [](const Triangle& x, const Triangle& y) { return std::memcmp(x.data(), y.data(), sizeof(Triangle)) < 0; };
+    for (const Submesh& submesh : a.submeshes) {
+        std::vector<Triangle> ta(submesh.indexCount / 3);
+        std::vector<Triangle> tb(submesh.indexCount / 3);
+        for (size_t i = 0; i < submesh.indexCount; ++i) {
+            ta[i / 3][i % 3] = a.vertices[a.indices[submesh.indexOffset + i]];
+            tb[i / 3][i % 3] = b.vertices[b.indices[submesh.indexOffset + i]];
+        }
+        std::sort(ta.begin(), ta.end(), less);
+        std::sort(tb.begin(), tb.end(), less);
+        if (std::memcmp(ta.data(), tb.data(), sizeof(Triangle) * ta.size()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// キャッシュのサブメッシュ・LOD・メッシュレットの値を1つずつ壊し、全てOpenで弾かれるかを確かめる。
+// 範囲はちょうど1つはみ出すようにする
+bool CheckCorruptedCache(const std::string& cachePath)
+{
+    std::vector<char> bytes;
+    {
+        std::ifstream file(cachePath, std::ios_base::binary);
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    if (bytes.size() < sizeof(MeshCacheHeader)) {
+        return false;
+    }
+    MeshCacheHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    auto read = [&bytes](uint64_t offset) {
+        uint32_t value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(value));
+        return value;
+    };
+
+    // 壊す所(ファイルの先頭からの位置)と入れる値
+    struct Corruption {
+        std::string name;
+        uint64_t offset;
+        uint32_t value;
+    };
+    std::vector<Corruption> corruptions;
+    // サブメッシュの表のsubmeshIndex番目を、limit個のindexからはみ出させる
+    auto addSubmesh = [&](const char* prefix, uint64_t submeshIndex, uint32_t limit) {
+        uint64_t offset = header.submeshOffset + sizeof(MeshCacheSubmesh) * submeshIndex;
+        uint32_t indexOffset = read(offset + offsetof(MeshCacheSubmesh, indexOffset));
+        uint32_t indexCount = read(offset + offsetof(MeshCacheSubmesh, indexCount));
+        std::string name = prefix;
+        corruptions.push_back({ name + " indexOffset", offset + offsetof(MeshCacheSubmesh, indexOffset), limit - indexCount + 1 });
+        corruptions.push_back({ name + " indexCount", offset + offsetof(MeshCacheSubmesh, indexCount), limit - indexOffset + 1 });
+        corruptions.push_back({ name + " materialIndex", offset + offsetof(MeshCacheSubmesh, materialIndex), header.materialCount });
+    };
+    if (header.submeshCount > 0) {
+        addSubmesh("submesh", 0, header.indexCount);
+    }
+    if (header.lodCount > 0) {
+        uint64_t offset = header.lodOffset;
+        uint32_t totalIndexCount = header.indexCount + header.lodIndexCount;
+        uint32_t indexOffset = read(offset + offsetof(MeshCacheLod, indexOffset));
+        uint32_t indexCount = read(offset + offsetof(MeshCacheLod, indexCount));
+        uint32_t submeshOffset = read(offset + offsetof(MeshCacheLod, submeshOffset));
+        corruptions.push_back({ "lod indexOffset", offset + offsetof(MeshCacheLod, indexOffset), totalIndexCount - indexCount + 1 });
+        corruptions.push_back({ "lod indexCount", offset + offsetof(MeshCacheLod, indexCount), totalIndexCount - indexOffset + 1 });
+        corruptions.push_back({ "lod submeshOffset", offset + offsetof(MeshCacheLod, submeshOffset), header.submeshCount * header.lodCount + 1 });
+        if (header.submeshCount > 0) {
+            addSubmesh("lod submesh", submeshOffset, indexCount);
+        }
+    }
+    if (header.meshletCount > 0) {
+        uint64_t offset = header.meshletOffset;
+        uint32_t indexOffset = read(offset + offsetof(Meshlet, indexOffset));
+        uint32_t triangleCount = read(offset + offsetof(Meshlet, triangleCount));
+        corruptions.push_back({ "meshlet indexOffset", offset + offsetof(Meshlet, indexOffset), header.indexCount - triangleCount * 3 + 1 });
+        corruptions.push_back({ "meshlet triangleCount", offset + offsetof(Meshlet, triangleCount), (header.indexCount - indexOffset) / 3 + 1 });
+        corruptions.push_back({ "meshlet materialIndex", offset + offsetof(Meshlet, materialIndex), header.materialCount });
+    }
+    // indexの値は元のメッシュの途中とLODの最後で、頂点の数ちょうどにする
+    if (header.indexCount > 0) {
+        corruptions.push_back({ "index value", header.indexOffset + sizeof(uint32_t) * (header.indexCount / 2), header.vertexCount });
+    }
+    if (header.lodIndexCount > 0) {
+        uint64_t lastIndex = uint64_t(header.indexCount) + header.lodIndexCount - 1;
+        corruptions.push_back({ "lod index value", header.indexOffset + sizeof(uint32_t) * lastIndex, header.vertexCount });
+    }
+
+    std::string corruptPath = cachePath + ".corrupt";
+    auto canOpen = [&corruptPath](const std::vector<char>& data) {
+        {
+            std::ofstream file(corruptPath, std::ios_base::binary | std::ios_base::trunc);
+            file.write(data.data(), std::streamsize(data.size()));
+        }
+        MeshCacheFile cache;
+        return cache.Open(corruptPath);
+    };
+    bool isValid = canOpen(bytes);
+    size_t rejectedCount = 0;
+    for (const Corruption& corruption : corruptions) {
+        std::vector<char> corrupted = bytes;
+        std::memcpy(corrupted.data() + corruption.offset, &corruption.value, sizeof(corruption.value));
+        if (!canOpen(corrupted)) {
+            ++rejectedCount;
+        } else {
+            std::printf("%-24s corrupted %s was not rejected\n", "", corruption.name.c_str());
+        }
+    }
+    std::filesystem::remove(corruptPath);
+    bool isAllRejected = isValid && rejectedCount == corruptions.size();
+    std::printf("%-24s cache corruption: %zu / %zu fields rejected  %s\n", "", rejectedCount, corruptions.size(), isAllRejected ? "ok" : "NOT REJECTED");
+    return isAllRejected;
+}
+
+// 一番速かった回の時間(ms)
+template <typename Function>
+double MeasureMilliseconds(uint32_t repeat, Function&& function)
+{
+    double best = 1e30;
+    for (uint32_t r = 0; r < repeat; ++r) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+bool Compare(const std::string& directoryPath, const std::string& filename, uint32_t repeat, uint32_t maxThreads)
+{
+    std::filesystem::path path = std::filesystem::path(directoryPath) / filename;
+    double megabytes = double(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+
+    ModelData stream;
+    ModelData mapped;
+    double streamMs = MeasureMilliseconds(repeat, [&] { stream = LoadObjFileStream(directoryPath, filename); });
+    double mappedMs = MeasureMilliseconds(repeat, [&] { mapped = LoadObjFile(directoryPath, filename); });
+    bool isSame = IsSame(stream, mapped);
+    size_t faceCount = mapped.indices.size() / 3;
+    std::printf("%-24s %9zu faces %8.2f MB  stream %9.2f ms (%7.1f MB/s)  mapped %8.2f ms (%7.1f MB/s, %6.2f Mfaces/s)  x%.2f  %s\n",
+        filename.c_str(), faceCount, megabytes, streamMs, megabytes / streamMs * 1e3, mappedMs, megabytes / mappedMs * 1e3,
+        double(faceCount) / mappedMs * 1e-3, streamMs / mappedMs, isSame ? "same" : "DIFFERENT");
+    MeshStats stats = CalculateMeshStats(mapped);
+    std::printf("%-24s vertices %zu -> %zu (x%.2f), %u-bit index, %.2f MB -> %.2f MB\n", "", stats.sourceVertexCount, stats.vertexCount,
+        stats.vertexReductionRatio, stats.indexSize * 8, double(stats.sourceBytes) / (1024.0 * 1024.0), double(stats.bytes) / (1024.0 * 1024.0));
+
+    // 詰めた頂点形式
+    QuantizationError quantizationError = MeasureQuantizationError(mapped.vertices, CalculateBounds(mapped));
+    bool isWithinBounds = quantizationError.position <= kPositionQuantizationError && quantizationError.texcoord <= kTexcoordRelativeError
+        && quantizationError.normalDegrees <= kNormalQuantizationErrorDegrees;
+    std::printf("%-24s packed vertices %.2f MB -> %.2f MB, max error position %.2e (of extent), uv %.2e, normal %.4f deg  %s\n", "",
+        double(sizeof(VertexData) * mapped.vertices.size()) / (1024.0 * 1024.0),
+        double(sizeof(PackedVertexData) * mapped.vertices.size()) / (1024.0 * 1024.0), quantizationError.position, quantizationError.texcoord,
+        quantizationError.normalDegrees, isWithinBounds ? "ok" : "OUT OF BOUNDS");
+    isSame = isSame && isWithinBounds;
+
+    // 描画順の最適化
+    ModelData optimized;
+    double optimizeMs = MeasureMilliseconds(repeat, [&] {
+        optimized = mapped;
+        OptimizeMesh(optimized);
+    });
+    VertexCacheStats before = AnalyzeVertexCache(mapped.indices.data(), mapped.indices.size(), mapped.vertices.size());
+    VertexCacheStats after = AnalyzeVertexCache(optimized.indices.data(), optimized.indices.size(), optimized.vertices.size());
+    bool isOptimizedSame = IsSameTriangleSet(mapped, optimized);
+    std::printf("%-24s optimize %.2f ms  ACMR %.3f -> %.3f  ATVR %.3f -> %.3f  hit %.1f%% -> %.1f%% (FIFO %u)  %s\n", "", optimizeMs, before.acmr,
+        after.acmr, before.atvr, after.atvr, before.hitRate * 100.0f, after.hitRate * 100.0f, kVertexCacheSize,
+        isOptimizedSame ? "same" : "DIFFERENT");
+    isSame = isSame && isOptimizedSame;
+
+    // メッシュレットとLOD(キャッシュには両方入るので、比べる前に作っておく)
+    double meshletMs = MeasureMilliseconds(1, [&] { BuildMeshlets(optimized); });
+    std::printf("%-24s meshlets %.2f ms  %zu meshlets\n", "", meshletMs, optimized.meshlets.size());
+    double lodMs = MeasureMilliseconds(1, [&] { BuildLodChain(optimized); });
+    std::printf("%-24s LOD chain %.2f ms ", "", lodMs);
+    for (const MeshLod& lod : optimized.lods) {
+        std::printf(" %zu (error %.2e)", lod.indices.size() / 3, lod.error);
+    }
+    std::printf("\n");
+
+    // キャッシュ。1回目は書き込み、2回目からはマップして読む
+    std::string cachePath = GetMeshCachePath(directoryPath, filename);
+    std::filesystem::remove(cachePath);
+    bool usedCache = false;
+    double writeMs = MeasureMilliseconds(1, [&] { LoadObjFileCached(directoryPath, filename, 1, &usedCache); });
+    ModelData cached;
+    double cachedMs = MeasureMilliseconds(repeat, [&] { cached = LoadObjFileCached(directoryPath, filename, 1, &usedCache); });
+    // ModelDataを作らずに、マップした所からアップロード用のバッファへコピーするだけの場合
+    std::vector<VertexData> uploadVertices(cached.vertices.size());
+    std::vector<uint32_t> uploadIndices(GetTotalIndexCount(cached));
+    double uploadMs = MeasureMilliseconds(repeat, [&] {
+        MeshCacheFile cache;
+        if (cache.Open(cachePath) && cache.IsUpToDate()) {
+            std::memcpy(uploadVertices.data(), cache.GetVertices(), sizeof(VertexData) * cache.GetHeader().vertexCount);
+            std::memcpy(uploadIndices.data(), cache.GetIndices(), sizeof(uint32_t) * (cache.GetHeader().indexCount + cache.GetHeader().lodIndexCount));
+        }
+    });
+    bool isCacheIdentical = usedCache && IsIdentical(optimized, cached);
+    std::printf("%-24s cache write %.2f ms, load %.3f ms (%7.1f MB/s of obj, x%.1f vs parse), map+copy %.3f ms  %s\n", "", writeMs,
+        cachedMs, megabytes / cachedMs * 1e3, mappedMs / cachedMs, uploadMs, isCacheIdentical ? "identical" : "DIFFERENT");
+    isSame = isSame && isCacheIdentical && CheckCorruptedCache(cachePath);
+
+    for (uint32_t threadCount = 2; threadCount <= maxThreads; threadCount *= 2) {
+        ModelData parallel;
+        double parallelMs = MeasureMilliseconds(repeat, [&] { parallel = LoadObjFile(directoryPath, filename, threadCount); });
+        bool isIdentical = IsIdentical(mapped, parallel);
+        std::printf("%-24s %2u threads %8.2f ms (%7.1f MB/s)  x%.2f vs 1 thread  %s\n", "", threadCount, parallelMs,
+            megabytes / parallelMs * 1e3, mappedMs / parallelMs, isIdentical ? "identical" : "DIFFERENT");
+        isSame = isSame && isIdentical;
+    }
+    return isSame;
+}
+
+}
+
+// 半精度の全ての値が変換して戻すと同じになるか(NaNは除く)
+bool CheckHalfRoundTrip()
+{
+    uint32_t failures = 0;
+    for (uint32_t value = 0; value <= 0xFFFF; ++value) {
+        bool isNaN = (value & 0x7C00) == 0x7C00 && (value & 0x3FF) != 0;
+        if (!isNaN && FloatToHalf(HalfToFloat(uint16_t(value))) != value) {
+            ++failures;
+        }
+    }
+    std::printf("half round trip: %u failures\n", failures);
+    return failures == 0;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    bool isAllSame = CheckHalfRoundTrip();
+    if (std::filesystem::exists(std::filesystem::path(options.resources) / "terrain.obj")) {
+        isAllSame = Compare(options.resources, "terrain.obj", options.repeat, 0) && isAllSame;
+    }
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "cg3_obj_bench";
+    std::filesystem::create_directories(directory);
+    {
+        std::ofstream material(directory / "terrain.mtl");
+        material << "newmtl Material\nmap_Kd grass.png\n";
+    }
+    // 面数が10倍ずつ増えるように格子の大きさを決める
+    for (size_t faces = 2000; faces <= options.maxFaces; faces *= 10) {
+        uint32_t gridSize = uint32_t(std::sqrt(double(faces) / 2.0));
+        std::string filename = "terrain_" + std::to_string(gridSize * gridSize * 2) + ".obj";
+        WriteTerrain(directory / filename, gridSize);
+        isAllSame = Compare(directory.string(), filename, options.repeat, options.maxThreads) && isAllSame;
+    }
+    std::filesystem::remove_all(directory);
+    return isAllSame ? 0 : 1;
+}
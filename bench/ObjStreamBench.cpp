@@ -0,0 +1,190 @@
+// 決まった量のメモリでのobjの読み込み(ImportObjStreaming)を計測する
+//
+// 格子状の地形(面数を指定して生成する)を--budgetのメモリで読んで、時間とピークのRSSを出す。
+// 次にresources/terrain.objと、マテリアルが2つで法線の無い四角形の面の小さなobjを読み、
+// 頂点をまとめる数に収まるときはLoadObjFileと頂点・index・サブメッシュ・マテリアルが完全に一致するか、
+// まとめる数を小さくしたときはindexの順に並べた頂点が一致するかを確かめる。
+// 最後に地形をLoadObjFileでメモリに全て読んだときのピークのRSSと、結果が一致するかを出す
+// (RSSはプロセスの最大値なので、ImportObjStreamingを一番先に計測する)。
+// 生成したファイルは一時ディレクトリに置いて最後に消す。
+#include "BenchObj.h"
+#include "MeshCache.h"
+#include "Model.h"
+#include "ObjParser.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+struct Options {
+    size_t faces = 2000000;
+    size_t budgetMegabytes = 16;
+    bool compare = true;
+    std::string resources = "resources";
+};
+
+void PrintUsage()
+{
+    std::printf("usage: cg3_obj_stream_bench [--faces N] [--budget MB] [--no-compare] [--resources DIR]\n");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--faces" && hasValue) {
+            options.faces = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--budget" && hasValue) {
+            options.budgetMegabytes = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--no-compare") {
+            options.compare = false;
+        } else if (arg == "--resources" && hasValue) {
+            options.resources = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// プロセスのピークのRSS(MB)。取れなければ0
+double GetPeakMemoryMegabytes()
+{
+#ifdef _WIN32
+    return 0.0;
+#else
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return double(usage.ru_maxrss) / 1024.0; // LinuxではKB
+#endif
+}
+
+// 四角形の面を行毎に2つのマテリアルで交互に塗った、法線もuvも無い格子(負のindexで書く)
+void WriteQuadGrid(const std::filesystem::path& path, uint32_t gridSize)
+{
+    std::FILE* file = std::fopen(path.string().c_str(), "w");
+    std::fprintf(file, "mtllib terrain.mtl\n");
+    for (uint32_t z = 0; z < gridSize; ++z) {
+        std::fprintf(file, "usemtl %s\n", z % 2 == 0 ? "Material" : "Rock");
+        for (uint32_t x = 0; x < gridSize; ++x) {
+            // 面の直前に4つの頂点を書いて後ろから数える
+            auto height = [](uint32_t px, uint32_t pz) { return 0.1f * std::sin(float(px) * 0.7f) * std::cos(float(pz) * 0.3f); };
+            std::fprintf(file, "v %u %f %u\nv %u %f %u\nv %u %f %u\nv %u %f %u\n", x, height(x, z), z, x, height(x, z + 1), z + 1, x + 1,
+                height(x + 1, z + 1), z + 1, x + 1, height(x + 1, z), z);
+            std::fprintf(file, "f -4 -3 -2 -1\n");
+        }
+    }
+    std::fclose(file);
+}
+
+// 書いたキャッシュを開いて読む。開けなければ空
+ModelData ReadCache(const std::string& cachePath, bool& isUpToDate)
+{
+    MeshCacheFile cache;
+    if (!cache.Open(cachePath)) {
+        isUpToDate = false;
+        return {};
+    }
+    isUpToDate = cache.IsUpToDate();
+    return cache.ToModelData();
+}
+
+// 小さいファイルをLoadObjFileと比べる。memoryBudgetが0なら頂点を全体でまとめられる大きさにする
+bool Verify(const std::string& directoryPath, const std::string& filename, const std::string& cachePath, size_t memoryBudget)
+{
+    ObjStreamOptions streamOptions;
+    if (memoryBudget != 0) {
+        streamOptions.memoryBudget = memoryBudget;
+    }
+    ObjStreamInfo info;
+    bool isImported = ImportObjStreaming(directoryPath, filename, cachePath, streamOptions, &info);
+    bool isUpToDate = false;
+    ModelData streamed = ReadCache(cachePath, isUpToDate);
+    ModelData loaded = LoadObjFile(directoryPath, filename);
+    bool isSame = false;
+    const char* result = "FAILED";
+    if (isImported && isUpToDate) {
+        // 1回でまとめたときは完全に同じになる
+        isSame = info.weldWindowCount == 1 ? IsIdentical(streamed, loaded) : IsSame(streamed, loaded);
+        result = isSame ? (info.weldWindowCount == 1 ? "identical" : "same") : "DIFFERENT";
+    }
+    std::printf("%-24s budget %8zu KB  %7zu triangles  %7zu -> %7zu vertices (LoadObjFile %zu)  %u weld windows  %s\n", filename.c_str(),
+        streamOptions.memoryBudget / 1024, info.triangleCount, info.triangleCount * 3, info.vertexCount, loaded.vertices.size(),
+        info.weldWindowCount, result);
+    return isSame;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "cg3_obj_stream_bench";
+    std::filesystem::create_directories(directory);
+    {
+        std::ofstream material(directory / "terrain.mtl");
+        material << "newmtl Material\nmap_Kd grass.png\nnewmtl Rock\nmap_Kd rock.png\n";
+    }
+    std::string cachePath = (directory / "streamed.cg3mesh").string();
+    std::string smallCachePath = (directory / "small.cg3mesh").string();
+
+    // 大きいファイル(RSSはプロセスの最大値なので、他のものより先に読む)
+    uint32_t gridSize = uint32_t(std::sqrt(double(options.faces) / 2.0));
+    std::string filename = "terrain_" + std::to_string(gridSize * gridSize * 2) + ".obj";
+    WriteTerrain(directory / filename, gridSize);
+    double megabytes = double(std::filesystem::file_size(directory / filename)) / (1024.0 * 1024.0);
+
+    ObjStreamOptions streamOptions;
+    streamOptions.memoryBudget = options.budgetMegabytes * 1024 * 1024;
+    ObjStreamInfo info;
+    double baseMegabytes = GetPeakMemoryMegabytes();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool isImported = ImportObjStreaming(directory.string(), filename, cachePath, streamOptions, &info);
+    double streamMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    double streamPeakMegabytes = GetPeakMemoryMegabytes();
+    std::printf("%-24s %9zu faces %8.2f MB  stream %9.2f ms (%6.1f MB/s)  budget %zu MB  peak RSS %.1f MB (+%.1f MB)  %s\n", filename.c_str(),
+        info.triangleCount, megabytes, streamMs, megabytes / streamMs * 1e3, options.budgetMegabytes, streamPeakMegabytes,
+        streamPeakMegabytes - baseMegabytes, isImported ? "ok" : "FAILED");
+    std::printf("%-24s %zu positions, %zu vertices, %u weld windows, temporary files %.2f MB, output %.2f MB\n", "", info.positionCount,
+        info.vertexCount, info.weldWindowCount, double(info.temporaryBytes) / (1024.0 * 1024.0),
+        isImported ? double(std::filesystem::file_size(cachePath)) / (1024.0 * 1024.0) : 0.0);
+    bool isAllSame = isImported;
+
+    // 小さいファイルでLoadObjFileと比べる
+    if (std::filesystem::exists(std::filesystem::path(options.resources) / "terrain.obj")) {
+        isAllSame = Verify(options.resources, "terrain.obj", smallCachePath, 0) && isAllSame;
+        isAllSame = Verify(options.resources, "terrain.obj", smallCachePath, 1) && isAllSame; // まとめる数は最小(1024頂点)
+    }
+    WriteQuadGrid(directory / "quads.obj", 200);
+    isAllSame = Verify(directory.string(), "quads.obj", smallCachePath, 0) && isAllSame;
+    isAllSame = Verify(directory.string(), "quads.obj", smallCachePath, 1) && isAllSame;
+
+    if (options.compare) {
+        start = std::chrono::steady_clock::now();
+        ModelData loaded = LoadObjFile(directory.string(), filename);
+        double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        double loadPeakMegabytes = GetPeakMemoryMegabytes();
+        bool isUpToDate = false;
+        bool isSame = isImported && IsSame(ReadCache(cachePath, isUpToDate), loaded) && isUpToDate;
+        std::printf("%-24s LoadObjFile %9.2f ms  peak RSS %.1f MB  %s\n", "", loadMs, loadPeakMegabytes, isSame ? "same" : "DIFFERENT");
+        isAllSame = isAllSame && isSame;
+    }
+    std::filesystem::remove_all(directory);
+    return isAllSame ? 0 : 1;
+}
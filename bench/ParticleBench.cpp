@@ -0,0 +1,399 @@
+// パーティクルの更新を、以前のstd::list<Particle>とParticlePoolで比べる
+//
+// 1000個から10倍ずつ--max-particles個まで、同じ乱数で作ったパーティクルを両方に入れ、
+// 1フレーム毎に 加速度場 -> 移動と経過時間 -> 寿命が尽きたものを消す -> 消えた分を作り直す を繰り返して
+// 1フレームの時間と、1秒あたりに更新できるパーティクルの数を出す(1スレッド)。
+// 経過時間は寿命の中でばらつかせておき、毎フレームいくつかが消えるようにする。
+// 最後に両方の中身(順番は違う)を並べ替えて比べ、違えば失敗にする。
+// ParticlePoolのフレームでメモリを確保していないかも数える(operator newを数える)
+// 続けてIntegrateParticlesだけをバックエンド毎に計り、結果がスカラー版と全く同じかを確かめる。
+// 最後にパーティクルだけのシーンをUpdateSceneで進め、スレッド数を1から倍々に増やして
+// 1フレームの時間を出し、パーティクルと書き込んだインスタンスが1スレッドと全く同じかを確かめる
+#include "GPUData.h"
+#include "MatrixSimd.h"
+#include "Parallel.h"
+#include "Particle.h"
+#include "Scene.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <new>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+std::atomic<size_t> allocationCount { 0 };
+
+}
+
+void* operator new(size_t size)
+{
+    ++allocationCount;
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+
+namespace {
+
+struct Options {
+    size_t maxParticles = 10000000;
+    size_t maxListParticles = 10000000; // これより多いときはstd::listを計らない
+    size_t maxSceneParticles = 1000000;
+    uint32_t threadCount = 0; // シーンで試す最大のスレッド数(0ならCPUのスレッド数と4の大きい方)
+    size_t updatesPerSize = 30000000; // 1つの数で更新するパーティクルの延べ数(フレーム数を決める)
+    uint32_t seed = 0;
+};
+
+void PrintUsage()
+{
+    std::printf("usage: cg3_particle_bench [--max-particles N] [--max-list-particles N] [--max-scene-particles N] [--threads T]\n"
+                "                          [--updates N] [--seed S]\n");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--max-particles" && hasValue) {
+            options.maxParticles = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--max-list-particles" && hasValue) {
+            options.maxListParticles = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--max-scene-particles" && hasValue) {
+            options.maxSceneParticles = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && hasValue) {
+            options.threadCount = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--updates" && hasValue) {
+            options.updatesPerSize = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 以前のScene.cppが持っていたパーティクル
+struct ListParticle {
+    Transform transform;
+    Vector3 velocity;
+    Vector4 color;
+    float lifeTime;
+    float currentTime;
+};
+
+ListParticle ToListParticle(const Particle& particle)
+{
+    return { { { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }, particle.translate }, particle.velocity, particle.color, particle.lifeTime, particle.currentTime };
+}
+
+// 以前のUpdateSceneと同じ処理を1回のループで行う(全て描画したものとして動かす)
+void UpdateList(std::list<ListParticle>& particles, const AccelerationField& field, float deltaTime)
+{
+    for (std::list<ListParticle>::iterator particleIterator = particles.begin(); particleIterator != particles.end();) {
+        ListParticle& particle = *particleIterator;
+        if (IsCollision(field.area, particle.transform.translate)) {
+            particle.velocity += field.acceleration * deltaTime;
+        }
+        particle.transform.translate += particle.velocity * deltaTime;
+        particle.currentTime += deltaTime;
+        if (particle.lifeTime <= particle.currentTime) {
+            particleIterator = particles.erase(particleIterator);
+            continue;
+        }
+        ++particleIterator;
+    }
+}
+
+// 比べるために、全ての値をビット列のまま並べる
+using ParticleKey = std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t>;
+
+uint32_t ToBits(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+ParticleKey MakeKey(const Vector3& translate, const Vector3& velocity, float lifeTime, float currentTime)
+{
+    return { ToBits(lifeTime), ToBits(currentTime), ToBits(translate.x), ToBits(translate.y), ToBits(translate.z), ToBits(velocity.x), ToBits(velocity.y),
+        ToBits(velocity.z) };
+}
+
+double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool Measure(size_t particleCount, const Options& options)
+{
+    const float kDeltaTime = 1.0f / 60.0f;
+    uint32_t frames = uint32_t(std::clamp<size_t>(options.updatesPerSize / particleCount, 3, 2000));
+    // Sceneと同じ加速度場。作る範囲(-1から1)の中にある
+    AccelerationField field = { { 15.0f, 0.0f, 0.0f }, { { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } } };
+
+    // 同じ乱数で最初のパーティクルを作り、経過時間をばらつかせる
+    std::mt19937 initialEngine(options.seed);
+    std::uniform_real_distribution<float> ageDistribution(0.0f, 1.0f);
+    std::vector<Particle> initialParticles(particleCount);
+    for (Particle& particle : initialParticles) {
+        particle = MakeNewParticle(initialEngine, { 0.0f, 0.0f, 0.0f });
+        particle.currentTime = particle.lifeTime * ageDistribution(initialEngine);
+    }
+
+    bool isListMeasured = particleCount <= options.maxListParticles;
+    double listMs = 0.0;
+    std::list<ListParticle> listParticles;
+    if (isListMeasured) {
+        for (const Particle& particle : initialParticles) {
+            listParticles.push_back(ToListParticle(particle));
+        }
+        std::mt19937 randomEngine(options.seed + 1);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            UpdateList(listParticles, field, kDeltaTime);
+            while (listParticles.size() < particleCount) {
+                listParticles.push_back(ToListParticle(MakeNewParticle(randomEngine, { 0.0f, 0.0f, 0.0f })));
+            }
+        }
+        listMs = ElapsedMilliseconds(start) / double(frames);
+    }
+
+    ParticlePool pool;
+    pool.Initialize(particleCount);
+    for (const Particle& particle : initialParticles) {
+        pool.Add(particle);
+    }
+    std::mt19937 randomEngine(options.seed + 1);
+    size_t spawnCount = 0;
+    size_t startAllocationCount = allocationCount;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        IntegrateParticles(pool, field, kDeltaTime);
+        pool.RemoveDead();
+        spawnCount += pool.Spawn(randomEngine, { 0.0f, 0.0f, 0.0f }, particleCount - pool.GetSize());
+    }
+    double poolMs = ElapsedMilliseconds(start) / double(frames);
+    size_t frameAllocationCount = allocationCount - startAllocationCount;
+
+    bool isSame = true;
+    if (isListMeasured) {
+        std::vector<ParticleKey> listKeys;
+        std::vector<ParticleKey> poolKeys;
+        listKeys.reserve(particleCount);
+        poolKeys.reserve(particleCount);
+        for (const ListParticle& particle : listParticles) {
+            listKeys.push_back(MakeKey(particle.transform.translate, particle.velocity, particle.lifeTime, particle.currentTime));
+        }
+        for (size_t i = 0; i < pool.GetSize(); ++i) {
+            Particle particle = pool.Get(i);
+            poolKeys.push_back(MakeKey(particle.translate, particle.velocity, particle.lifeTime, particle.currentTime));
+        }
+        std::sort(listKeys.begin(), listKeys.end());
+        std::sort(poolKeys.begin(), poolKeys.end());
+        isSame = listKeys == poolKeys;
+    }
+
+    double poolRate = double(particleCount) / (poolMs * 1e-3) / 1e6;
+    if (isListMeasured) {
+        double listRate = double(particleCount) / (listMs * 1e-3) / 1e6;
+        std::printf("%9zu particles %5u frames  list %10.3f ms/frame %8.1f M/s  pool %10.3f ms/frame %8.1f M/s  x%6.2f  %.1f respawned/frame  %zu allocations  %s\n",
+            particleCount, frames, listMs, listRate, poolMs, poolRate, listMs / poolMs, double(spawnCount) / double(frames), frameAllocationCount,
+            isSame ? "same" : "DIFFERENT");
+    } else {
+        std::printf("%9zu particles %5u frames  list %10s %19s  pool %10.3f ms/frame %8.1f M/s  %7s  %.1f respawned/frame  %zu allocations\n", particleCount,
+            frames, "-", "", poolMs, poolRate, "", double(spawnCount) / double(frames), frameAllocationCount);
+    }
+    return isSame && frameAllocationCount == 0;
+}
+
+bool IsSamePool(const ParticlePool& a, const ParticlePool& b)
+{
+    size_t count = a.GetSize();
+    auto isSame = [count](const float* x, const float* y) { return std::memcmp(x, y, sizeof(float) * count) == 0; };
+    return a.GetSize() == b.GetSize() && isSame(a.GetPositionX(), b.GetPositionX()) && isSame(a.GetPositionY(), b.GetPositionY())
+        && isSame(a.GetPositionZ(), b.GetPositionZ()) && isSame(a.GetVelocityX(), b.GetVelocityX()) && isSame(a.GetVelocityY(), b.GetVelocityY())
+        && isSame(a.GetVelocityZ(), b.GetVelocityZ()) && isSame(a.GetCurrentTimes(), b.GetCurrentTimes()) && isSame(a.GetAlphas(), b.GetAlphas())
+        && std::memcmp(a.GetDeadMask(), b.GetDeadMask(), sizeof(uint32_t) * ((count + 31) / 32)) == 0;
+}
+
+// IntegrateParticlesだけをバックエンド毎に計る(消さないので、寿命が尽きたものも進め続ける)
+bool MeasureIntegrate(size_t particleCount, const Options& options)
+{
+    const float kDeltaTime = 1.0f / 60.0f;
+    uint32_t frames = uint32_t(std::clamp<size_t>(options.updatesPerSize / particleCount, 3, 2000));
+    AccelerationField field = { { 15.0f, 0.0f, 0.0f }, { { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } } };
+    // 端数を残すために少し足す。境界上の位置・-0の速度・寿命ちょうどのものも混ぜる
+    ParticlePool initialPool;
+    initialPool.Initialize(particleCount + 13);
+    std::mt19937 randomEngine(options.seed);
+    for (size_t i = 0; i < initialPool.GetCapacity(); ++i) {
+        Particle particle = MakeNewParticle(randomEngine, { 0.0f, 0.0f, 0.0f });
+        if (i % 97 == 0) {
+            particle.translate.x = 1.0f;
+            particle.velocity.y = -0.0f;
+        }
+        if (i % 101 == 0) {
+            particle.currentTime = particle.lifeTime - kDeltaTime;
+        }
+        initialPool.Add(particle);
+    }
+
+    ParticlePool scalarPool;
+    double scalarMs = 0.0;
+    bool isAllSame = true;
+    MatrixBackend activeBackend = GetActiveMatrixBackend();
+    std::printf("%9zu particles %5u frames  integrate", initialPool.GetSize(), frames);
+    for (int b = 0; b < kMatrixBackendCount; ++b) {
+        MatrixBackend backend = MatrixBackend(b);
+        if (!IsMatrixBackendSupported(backend)) {
+            continue;
+        }
+        SetActiveMatrixBackend(backend);
+        ParticlePool pool = initialPool;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            IntegrateParticles(pool, field, kDeltaTime);
+        }
+        double ms = ElapsedMilliseconds(start) / double(frames);
+        bool isSame = true;
+        if (backend == kMatrixBackendScalar) {
+            scalarPool = pool;
+            scalarMs = ms;
+        } else {
+            isSame = IsSamePool(pool, scalarPool);
+        }
+        isAllSame = isAllSame && isSame;
+        std::printf("  %s %8.3f ms %8.1f M/s x%5.2f%s", GetMatrixBackendName(backend), ms, double(pool.GetSize()) / (ms * 1e-3) / 1e6, scalarMs / ms,
+            isSame ? "" : " DIFFERENT FROM SCALAR");
+    }
+    SetActiveMatrixBackend(activeBackend);
+    std::printf("\n");
+    return isAllSame;
+}
+
+// パーティクルだけのシーン。particleCount個を広い範囲にばらまき、毎フレーム消える分(平均の寿命2秒)くらいを作る
+struct ParticleScene {
+    Scene scene;
+    std::vector<ParticleForGPU> instancing;
+    TransformationMatrix sphere;
+    TransformationMatrix model;
+    DirectionalLight sphereLight;
+    DirectionalLight modelLight;
+    SceneTargets targets;
+};
+
+void InitializeParticleScene(ParticleScene& particleScene, size_t particleCount, uint32_t maxInstance, uint32_t seed)
+{
+    Scene& scene = particleScene.scene;
+    InitializeScene(scene, seed, 16.0f / 9.0f, particleCount * 2);
+    scene.particles.Clear();
+    std::mt19937 randomEngine(seed);
+    std::uniform_real_distribution<float> centerDistribution(-15.0f, 15.0f);
+    std::uniform_real_distribution<float> ageDistribution(0.0f, 1.0f);
+    Vector3 center = { 0.0f, 0.0f, 0.0f };
+    for (size_t i = 0; i < particleCount; ++i) {
+        if (i % 1024 == 0) {
+            center = { centerDistribution(randomEngine), centerDistribution(randomEngine), centerDistribution(randomEngine) };
+        }
+        Particle particle = MakeNewParticle(randomEngine, center);
+        particle.currentTime = particle.lifeTime * ageDistribution(randomEngine);
+        scene.particles.Add(particle);
+    }
+    scene.emitter.count = uint32_t(particleCount / 120);
+    scene.emitter.frequency = 1.0f / 60.0f;
+
+    particleScene.instancing.assign(maxInstance, {});
+    particleScene.sphereLight = { { 1.0f, 1.0f, 1.0f, 1.0f }, { 0.0f, -1.0f, 0.0f }, 1.0f };
+    particleScene.modelLight = { { 1.0f, 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }, 0.0f };
+    particleScene.targets = { &particleScene.sphere, &particleScene.model, &particleScene.sphereLight, &particleScene.modelLight,
+        particleScene.instancing.data(), maxInstance };
+}
+
+bool MeasureScene(size_t particleCount, const Options& options)
+{
+    uint32_t frames = uint32_t(std::clamp<size_t>(options.updatesPerSize / particleCount, 3, 200));
+    uint32_t maxInstance = uint32_t(std::min<size_t>(particleCount, 1000000));
+    uint32_t maxThreadCount = options.threadCount ? options.threadCount : std::max(4u, GetWorkerThreadCount(0));
+
+    ParticlePool referencePool;
+    std::vector<ParticleForGPU> referenceInstancing;
+    uint32_t referenceInstanceCount = 0;
+    double referenceMs = 0.0;
+    bool isAllSame = true;
+    std::printf("%9zu particles %5u frames  scene", particleCount, frames);
+    std::vector<uint32_t> threadCounts;
+    for (uint32_t threadCount = 1; threadCount < maxThreadCount; threadCount *= 2) {
+        threadCounts.push_back(threadCount);
+    }
+    threadCounts.push_back(maxThreadCount);
+    for (uint32_t threadCount : threadCounts) {
+        ParticleScene particleScene;
+        InitializeParticleScene(particleScene, particleCount, maxInstance, options.seed);
+        ThreadPool threadPool(threadCount);
+        particleScene.scene.threadPool = &threadPool;
+        uint32_t instanceCount = 0;
+        SceneTimings timings {};
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            instanceCount = UpdateScene(particleScene.scene, particleScene.targets, &timings);
+        }
+        double ms = ElapsedMilliseconds(start) / double(frames);
+
+        bool isSame = true;
+        if (threadCount == 1) {
+            referencePool = particleScene.scene.particles;
+            referenceInstancing = particleScene.instancing;
+            referenceInstanceCount = instanceCount;
+            referenceMs = ms;
+        } else {
+            isSame = IsSamePool(particleScene.scene.particles, referencePool) && instanceCount == referenceInstanceCount
+                && std::memcmp(particleScene.instancing.data(), referenceInstancing.data(), sizeof(ParticleForGPU) * instanceCount) == 0;
+        }
+        isAllSame = isAllSame && isSame;
+        std::printf("  %u threads %8.3f ms x%5.2f%s", threadCount, ms, referenceMs / ms, isSame ? "" : " DIFFERENT FROM 1 THREAD");
+        if (threadCount == maxThreadCount) {
+            std::printf("  (%zu alive, %u instances)", particleScene.scene.particles.GetSize(), instanceCount);
+        }
+    }
+    std::printf("\n");
+    return isAllSame;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    std::printf("pool: %zu bytes/particle + 1 bit, list: %zu bytes/particle + node and allocation overhead\n",
+        sizeof(float) * 9 + sizeof(Vector4), sizeof(ListParticle));
+    bool isAllValid = true;
+    for (size_t particleCount = 1000; particleCount <= options.maxParticles; particleCount *= 10) {
+        isAllValid = Measure(particleCount, options) && isAllValid;
+    }
+    for (size_t particleCount = 1000; particleCount <= options.maxParticles; particleCount *= 10) {
+        isAllValid = MeasureIntegrate(particleCount, options) && isAllValid;
+    }
+    for (size_t particleCount = 10000; particleCount <= options.maxSceneParticles; particleCount *= 10) {
+        isAllValid = MeasureScene(particleCount, options) && isAllValid;
+    }
+    return isAllValid ? 0 : 1;
+}
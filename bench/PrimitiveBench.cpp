@@ -0,0 +1,274 @@
+// 実行時に作る基本形状(PrimitiveMesh)を計測する
+//
+// UV球をsin/cosの表で作る時間と、頂点毎にstd::sin/cosを呼んで作る時間を細かさ毎に比べる。
+// 作ったものは全ての形と細かさで確かめ、違えば失敗にする
+//   - UV球の細かさ16はPrimitive.hのkSphereMeshと同じ並びで、位置の差は1e-6以下
+//   - indexが頂点の数を超えない。三角形の表は外(四角形は+z)を向き、LODも同じ
+//   - LODの三角形の数は1つ前の1/4。球の頂点は半径1の上にある
+//   - 境界のAABBと球が全ての頂点を含む。正20面体の球は1枚の三角形でuが0.5以上離れない
+// 最後にPrimitiveCacheで同じ形を何度も取り出し、作るのが1回だけで同じものを返すかを確かめる
+#include "MeshLod.h"
+#include "Primitive.h"
+#include "PrimitiveMesh.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numbers>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    uint32_t maxSubdivision = 1024;
+    uint32_t iterations = 20;
+};
+
+void PrintUsage()
+{
+    std::printf("usage: cg3_primitive_bench [--max-subdivision N] [--iterations N]\n");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--max-subdivision" && hasValue) {
+            options.maxSubdivision = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--iterations" && hasValue) {
+            options.iterations = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* GetTypeName(PrimitiveType type)
+{
+    switch (type) {
+    case PrimitiveType::UVSphere:
+        return "uv_sphere";
+    case PrimitiveType::Icosphere:
+        return "icosphere";
+    case PrimitiveType::Quad:
+        return "quad";
+    case PrimitiveType::Cube:
+        return "cube";
+    }
+    return "";
+}
+
+// 頂点毎にsin/cosを呼ぶ元の作り方(比較用。並びはMakeSphereMeshと同じで、LODは作らない)
+ModelData MakeSpherePerVertex(uint32_t subdivision)
+{
+    ModelData model;
+    std::vector<VertexData>& vertices = model.vertices;
+    vertices.resize((subdivision + 1) * (subdivision + 1));
+    for (uint32_t latIndex = 0; latIndex < (subdivision + 1); ++latIndex) {
+        float lat = -std::numbers::pi_v<float> / 2.0f + std::numbers::pi_v<float> * float(latIndex) / float(subdivision);
+        for (uint32_t lonIndex = 0; lonIndex < (subdivision + 1); ++lonIndex) {
+            float lon = 2.0f * std::numbers::pi_v<float> * float(lonIndex) / float(subdivision);
+            VertexData& vertex = vertices[latIndex * (subdivision + 1) + lonIndex];
+            vertex.position = { std::cos(lat) * std::cos(lon), std::sin(lat), std::cos(lat) * std::sin(lon), 1.0f };
+            vertex.texcoord = { float(lonIndex) / float(subdivision), 1.0f - float(latIndex) / float(subdivision) };
+            vertex.normal = { vertex.position.x, vertex.position.y, vertex.position.z };
+        }
+    }
+    for (uint32_t lat = 0; lat < subdivision; ++lat) {
+        for (uint32_t lon = 0; lon < subdivision; ++lon) {
+            uint32_t lt = lon + lat * (subdivision + 1);
+            uint32_t rt = (lon + 1) + lat * (subdivision + 1);
+            uint32_t lb = lon + (lat + 1) * (subdivision + 1);
+            uint32_t rb = (lon + 1) + (lat + 1) * (subdivision + 1);
+            model.indices.insert(model.indices.end(), { rb, rt, lt, rb, lt, lb });
+        }
+    }
+    return model;
+}
+
+// 表の向きが外を向いているか(潰れた三角形は数えない)。球と立方体は中心からの向き、四角形は+z
+bool IsOutward(const PrimitiveMesh& mesh, const std::vector<uint32_t>& indices)
+{
+    const std::vector<VertexData>& vertices = mesh.model.vertices;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const Vector4& p0 = vertices[indices[i]].position;
+        const Vector4& p1 = vertices[indices[i + 1]].position;
+        const Vector4& p2 = vertices[indices[i + 2]].position;
+        Vector3 e0 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+        Vector3 e1 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+        Vector3 normal = { e0.y * e1.z - e0.z * e1.y, e0.z * e1.x - e0.x * e1.z, e0.x * e1.y - e0.y * e1.x };
+        if (normal.x == 0.0f && normal.y == 0.0f && normal.z == 0.0f) {
+            continue;
+        }
+        Vector3 outward = { p0.x + p1.x + p2.x, p0.y + p1.y + p2.y, p0.z + p1.z + p2.z };
+        if (mesh.type == PrimitiveType::Quad) {
+            outward = { 0.0f, 0.0f, 1.0f };
+        }
+        if (normal.x * outward.x + normal.y * outward.y + normal.z * outward.z <= 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IsValidPrimitive(const PrimitiveMesh& mesh)
+{
+    const ModelData& model = mesh.model;
+    bool isSphere = mesh.type == PrimitiveType::UVSphere || mesh.type == PrimitiveType::Icosphere;
+    for (uint32_t level = 0; level < GetLodCount(model); ++level) {
+        const std::vector<uint32_t>& indices = level == 0 ? model.indices : model.lods[level - 1].indices;
+        const std::vector<Submesh>& submeshes = GetLodSubmeshes(model, level);
+        if (indices.empty() || indices.size() % 3 != 0 || submeshes.size() != 1 || submeshes[0].indexCount != indices.size()) {
+            return false;
+        }
+        if (level != 0) {
+            size_t previousCount = level == 1 ? model.indices.size() : model.lods[level - 2].indices.size();
+            if (indices.size() * 4 != previousCount) {
+                return false;
+            }
+        }
+        for (uint32_t index : indices) {
+            if (model.vertices.size() <= index) {
+                return false;
+            }
+        }
+        if (!IsOutward(mesh, indices)) {
+            return false;
+        }
+        if (mesh.type == PrimitiveType::Icosphere) {
+            for (size_t i = 0; i < indices.size(); i += 3) {
+                float u0 = model.vertices[indices[i]].texcoord.x;
+                float u1 = model.vertices[indices[i + 1]].texcoord.x;
+                float u2 = model.vertices[indices[i + 2]].texcoord.x;
+                if (0.5f < std::max({ u0, u1, u2 }) - std::min({ u0, u1, u2 })) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    const Sphere& sphere = mesh.boundingSphere;
+    for (const VertexData& vertex : model.vertices) {
+        const Vector4& p = vertex.position;
+        if (isSphere && 1e-5f < std::abs(p.x * p.x + p.y * p.y + p.z * p.z - 1.0f)) {
+            return false;
+        }
+        if (p.x < mesh.bounds.min.x || p.y < mesh.bounds.min.y || p.z < mesh.bounds.min.z || mesh.bounds.max.x < p.x || mesh.bounds.max.y < p.y
+            || mesh.bounds.max.z < p.z) {
+            return false;
+        }
+        Vector3 offset = { p.x - sphere.center.x, p.y - sphere.center.y, p.z - sphere.center.z };
+        if (sphere.radius * (1.0f + 1e-6f) < std::sqrt(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// MakePrimitiveMeshの細かさ16とkSphereMeshの位置の差の最大(並びが違えば負)
+float CompareWithConstexprSphere()
+{
+    PrimitiveMesh mesh = MakePrimitiveMesh(PrimitiveType::UVSphere, kSphereSubdivision);
+    if (mesh.model.vertices.size() != kSphereMesh.kVertexCount
+        || !std::equal(mesh.model.indices.begin(), mesh.model.indices.end(), kSphereMesh.indices.begin(), kSphereMesh.indices.end())) {
+        return -1.0f;
+    }
+    float maxDifference = 0.0f;
+    for (size_t i = 0; i < kSphereMesh.kVertexCount; ++i) {
+        const VertexData& a = mesh.model.vertices[i];
+        const VertexData& b = kSphereMesh.vertices[i];
+        if (a.texcoord.x != b.texcoord.x || a.texcoord.y != b.texcoord.y) {
+            return -1.0f;
+        }
+        maxDifference = std::max({ maxDifference, std::abs(a.position.x - b.position.x), std::abs(a.position.y - b.position.y),
+            std::abs(a.position.z - b.position.z) });
+    }
+    return maxDifference;
+}
+
+template <typename Function>
+double MeasureMilliseconds(uint32_t iterations, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        function();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / double(iterations);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    bool isAllValid = true;
+    float constexprDifference = CompareWithConstexprSphere();
+    std::printf("uv_sphere 16 vs kSphereMesh: %s (max position difference %.3g)\n", 0.0f <= constexprDifference && constexprDifference <= 1e-6f ? "same" : "DIFFERENT",
+        double(constexprDifference));
+    isAllValid = 0.0f <= constexprDifference && constexprDifference <= 1e-6f && isAllValid;
+
+    // 形と細かさ毎に、作る時間・頂点と三角形の数・LOD
+    const PrimitiveType types[] = { PrimitiveType::UVSphere, PrimitiveType::Icosphere, PrimitiveType::Quad, PrimitiveType::Cube };
+    for (PrimitiveType type : types) {
+        // 正20面体の球は1回で三角形が4倍になるので、UV球と同じくらいの三角形の数までにする
+        uint32_t maxSubdivision = options.maxSubdivision;
+        if (type == PrimitiveType::Icosphere) {
+            maxSubdivision = 0;
+            while ((20u << (2 * (maxSubdivision + 1))) <= 2 * options.maxSubdivision * options.maxSubdivision) {
+                ++maxSubdivision;
+            }
+        }
+        for (uint32_t subdivision = type == PrimitiveType::Icosphere ? 0 : type == PrimitiveType::UVSphere ? 2 : 1; subdivision <= maxSubdivision;
+             subdivision = type == PrimitiveType::Icosphere ? subdivision + 1 : subdivision * 2) {
+            uint32_t iterations = std::max(1u, options.iterations * 16 / std::max(16u, subdivision));
+            if (type == PrimitiveType::Icosphere) {
+                iterations = std::max(1u, options.iterations >> std::min(subdivision, 31u));
+            }
+            PrimitiveMesh mesh;
+            double elapsed = MeasureMilliseconds(iterations, [&] { mesh = MakePrimitiveMesh(type, subdivision); });
+            bool isValid = IsValidPrimitive(mesh);
+            isAllValid = isValid && isAllValid;
+
+            std::printf("%-10s %5u: %8zu vertices %8zu triangles, %u LODs (", GetTypeName(type), mesh.subdivision, mesh.model.vertices.size(),
+                mesh.model.indices.size() / 3, GetLodCount(mesh.model));
+            for (const MeshLod& lod : mesh.model.lods) {
+                std::printf(" %zu/%.4f", lod.indices.size() / 3, double(lod.error));
+            }
+            std::printf(" ), radius %.3f, %9.3f ms%s\n", double(mesh.boundingSphere.radius), elapsed, isValid ? "" : " INVALID");
+        }
+    }
+
+    // UV球: sin/cosの表と、頂点毎にsin/cosを呼ぶもの
+    for (uint32_t subdivision = 16; subdivision <= options.maxSubdivision; subdivision *= 4) {
+        uint32_t iterations = std::max(1u, options.iterations * 16 / subdivision);
+        ModelData perVertex;
+        double perVertexElapsed = MeasureMilliseconds(iterations, [&] { perVertex = MakeSpherePerVertex(subdivision); });
+        PrimitiveMesh mesh;
+        double tableElapsed = MeasureMilliseconds(iterations, [&] { mesh = MakePrimitiveMesh(PrimitiveType::UVSphere, subdivision); });
+        std::printf("uv_sphere %5u: per-vertex sin/cos %9.3f ms (no LODs), table %9.3f ms (with LODs)\n", subdivision, perVertexElapsed,
+            tableElapsed);
+    }
+
+    // 同じ形を何度も取り出しても作るのは1回
+    PrimitiveCache cache;
+    const uint32_t kSphereCount = 1000;
+    const PrimitiveMesh* first = &cache.Get(PrimitiveType::UVSphere, 32);
+    bool isShared = true;
+    double getElapsed = MeasureMilliseconds(kSphereCount, [&] { isShared = &cache.Get(PrimitiveType::UVSphere, 32) == first && isShared; });
+    cache.Get(PrimitiveType::Cube, 4);
+    cache.Get(PrimitiveType::UVSphere, 16);
+    isShared = isShared && cache.GetSize() == 3 && cache.GetBuildCount() == 3 && cache.GetHitCount() == kSphereCount;
+    std::printf("cache: %u spheres -> %zu meshes, %u builds, %u hits, %.4f us/get%s\n", kSphereCount + 1, cache.GetSize(), cache.GetBuildCount(),
+        cache.GetHitCount(), getElapsed * 1000.0, isShared ? "" : " NOT SHARED");
+    isAllValid = isShared && isAllValid;
+    return isAllValid ? 0 : 1;
+}
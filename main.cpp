@@ -1,5 +1,16 @@
 #include "externals/DirectXTex/d3dx12.h"
 
+#include "GPUData.h"
+#include "MeshCache.h"
+#include "MeshLod.h"
+#include "Model.h"
+#include "PackedVertex.h"
+#include "MyMath.h"
+#include "Particle.h"
+#include "Primitive.h"
+#include "PrimitiveMesh.h"
+#include "Scene.h"
+#include "Sound.h"
 #include "externals/DirectXTex/DirectXTex.h"
 #include "externals/imgui/imgui.h"
 #include "externals/imgui/imgui_impl_dx12.h"
@@ -33,75 +44,6 @@
 
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
-struct Vector2 {
-    float x;
-    float y;
-};
-struct Vector3 {
-    float x;
-    float y;
-    float z;
-};
-struct Vector4 {
-    float x;
-    float y;
-    float z;
-    float w;
-};
-struct Matrix4x4 {
-    float m[4][4];
-};
-struct AABB {
-    Vector3 min;
-    Vector3 max;
-};
-struct Transform {
-    Vector3 scale;
-    Vector3 rotate;
-    Vector3 translate;
-};
-struct VertexData {
-    Vector4 position;
-    Vector2 texcoord;
-    Vector3 normal;
-};
-struct Material {
-    Vector4 color;
-    int32_t enableLighting;
-    float padding[3];
-    Matrix4x4 uvTransform;
-    float shininess;
-};
-struct TransformationMatrix {
-    Matrix4x4 WVP;
-    Matrix4x4 world;
-    Matrix4x4 worldInverseTranspose;
-};
-struct ParticleForGPU {
-    Matrix4x4 WVP;
-    Matrix4x4 world;
-    Vector4 color;
-};
-struct DirectionalLight {
-    Vector4 color;
-    Vector3 direction;
-    float intensity;
-};
-struct MaterialData {
-    std::string textureFilePath;
-};
-struct ModelData {
-    std::vector<VertexData> vertices;
-    MaterialData material;
-};
-struct PointLigth {
-    Vector4 color; // 色
-    Vector3 position; // 位置
-    float intensity; // 輝度
-    float radius; // ライトの届く最大距離
-    float decay; // 減衰率
-    float Padding[2];
-};
 struct D3DResourceLeakChecker {
     ~D3DResourceLeakChecker()
     {
@@ -114,37 +56,6 @@ struct D3DResourceLeakChecker {
         }
     }
 };
-struct AccelerationField {
-    Vector3 acceleration;
-    AABB area;
-};
-struct ChunkHeader {
-    char id[4]; // チャンク毎のID
-    int32_t size; // チャンクサイズ
-};
-struct RiffHeader {
-    ChunkHeader chunk; // "RIFF"
-    char type[4]; // "WAVE"
-};
-struct FormatChunk {
-    ChunkHeader chunk; // "fmt"
-    WAVEFORMATEX fmt; // 波型フォーマット
-};
-struct SoundData {
-    // 波型フォーマット
-    WAVEFORMATEX wfex;
-    // バッフアの先頭アドレス
-    BYTE* pBuffer;
-    // バッフアのサイズ
-    unsigned int bufferSize;
-};
-struct Particle {
-    Transform transform;
-    Vector3 velocity;
-    Vector4 color;
-    float lifeTime;
-    float currentTime;
-};
 enum BlendMode {
     kBlendModeNone, // ブレンドなし
     kBlendModeNormal, // 通常αブレンド
@@ -153,52 +64,6 @@ enum BlendMode {
     kBlendModeMultily, // 乗算
     kBlendModeScreen, // スクリーン
 };
-struct Emitter {
-    Transform transform;
-    uint32_t count;
-    float frequency;
-    float ferquencyTime;
-};
-struct CameraForGPU {
-    Vector3 worldPosition;
-};
-struct SpotLigth {
-    Vector4 color;
-    Vector3 position;
-    float intensity;
-    Vector3 direction;
-    float distance;
-    float decay;
-    float cosAngle;
-    float cosFalloffStart; // スポットライトの内側の角度（減衰開始の余弦）
-    float padding[2];
-};
-
-Particle MakeNewParticle(std::mt19937& randomEngine, const Vector3& translate)
-{
-    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
-    std::uniform_real_distribution<float> distColor(0.0f, 1.0f);
-    std::uniform_real_distribution<float> distTime(1.0f, 3.0f);
-    Particle particle;
-    particle.transform.scale = { 1.0f, 1.0f, 1.0f };
-    particle.transform.rotate = { 0.0f, 0.0f, 0.0f };
-    Vector3 randomTranslate { distribution(randomEngine), distribution(randomEngine), distribution(randomEngine) };
-    particle.transform.translate = { translate.x + randomTranslate.x, translate.y + randomTranslate.y, translate.z + randomTranslate.z };
-    particle.velocity = { distribution(randomEngine), distribution(randomEngine), distribution(randomEngine) };
-    particle.color = { distColor(randomEngine), distColor(randomEngine), distColor(randomEngine), 1.0f };
-    particle.lifeTime = distTime(randomEngine);
-    particle.currentTime = 0;
-    return particle;
-}
-
-std::list<Particle> Emit(const Emitter& emitter, std::mt19937& randomEngine)
-{
-    std::list<Particle> particles;
-    for (uint32_t count = 0; count < emitter.count; ++count) {
-        particles.push_back(MakeNewParticle(randomEngine, emitter.transform.translate));
-    }
-    return particles;
-}
 
 D3D12_BLEND_DESC CreateBlendDesc(BlendMode mode)
 {
@@ -251,198 +116,6 @@ D3D12_BLEND_DESC CreateBlendDesc(BlendMode mode)
     return desc;
 }
 
-Matrix4x4 MakeIdentity4x4()
-{
-    Matrix4x4 num;
-    num = { { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 } };
-    return num;
-}
-
-Matrix4x4 MakeRotateXMatrix(float radian)
-{
-    Matrix4x4 num;
-    num = { 1, 0, 0, 0,
-        0, std::cos(radian), std::sin(radian), 0,
-        0, std::sin(-radian), std::cos(radian), 0,
-        0, 0, 0, 1 };
-    return num;
-}
-Matrix4x4 MakeRotateYMatrix(float radian)
-{
-    Matrix4x4 num;
-    num = { std::cos(radian), 0, std::sin(-radian), 0,
-        0, 1, 0, 0,
-        std::sin(radian), 0, std::cos(radian), 0,
-        0, 0, 0, 1 };
-    return num;
-}
-Matrix4x4 MakeRotateZMatrix(float radian)
-{
-    Matrix4x4 num;
-    num = { std::cos(radian), std::sin(radian), 0, 0,
-        std::sin(-radian), std::cos(radian), 0, 0,
-        0, 0, 1, 0,
-        0, 0, 0, 1 };
-    return num;
-}
-Matrix4x4 MakeScaleMatrix(const Vector3& scale)
-{
-
-    Matrix4x4 result { scale.x, 0.0f, 0.0f, 0.0f, 0.0f, scale.y, 0.0f, 0.0f, 0.0f, 0.0f, scale.z, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
-
-    return result;
-}
-Matrix4x4 MakeTranslateMatrix(const Vector3& translate)
-{
-    Matrix4x4 result { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, translate.x, translate.y, translate.z, 1.0f };
-
-    return result;
-}
-Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2)
-{
-    Matrix4x4 num;
-    num.m[0][0] = m1.m[0][0] * m2.m[0][0] + m1.m[0][1] * m2.m[1][0] + m1.m[0][2] * m2.m[2][0] + m1.m[0][3] * m2.m[3][0];
-    num.m[0][1] = m1.m[0][0] * m2.m[0][1] + m1.m[0][1] * m2.m[1][1] + m1.m[0][2] * m2.m[2][1] + m1.m[0][3] * m2.m[3][1];
-    num.m[0][2] = m1.m[0][0] * m2.m[0][2] + m1.m[0][1] * m2.m[1][2] + m1.m[0][2] * m2.m[2][2] + m1.m[0][3] * m2.m[3][2];
-    num.m[0][3] = m1.m[0][0] * m2.m[0][3] + m1.m[0][1] * m2.m[1][3] + m1.m[0][2] * m2.m[2][3] + m1.m[0][3] * m2.m[3][3];
-
-    num.m[1][0] = m1.m[1][0] * m2.m[0][0] + m1.m[1][1] * m2.m[1][0] + m1.m[1][2] * m2.m[2][0] + m1.m[1][3] * m2.m[3][0];
-    num.m[1][1] = m1.m[1][0] * m2.m[0][1] + m1.m[1][1] * m2.m[1][1] + m1.m[1][2] * m2.m[2][1] + m1.m[1][3] * m2.m[3][1];
-    num.m[1][2] = m1.m[1][0] * m2.m[0][2] + m1.m[1][1] * m2.m[1][2] + m1.m[1][2] * m2.m[2][2] + m1.m[1][3] * m2.m[3][2];
-    num.m[1][3] = m1.m[1][0] * m2.m[0][3] + m1.m[1][1] * m2.m[1][3] + m1.m[1][2] * m2.m[2][3] + m1.m[1][3] * m2.m[3][3];
-
-    num.m[2][0] = m1.m[2][0] * m2.m[0][0] + m1.m[2][1] * m2.m[1][0] + m1.m[2][2] * m2.m[2][0] + m1.m[2][3] * m2.m[3][0];
-    num.m[2][1] = m1.m[2][0] * m2.m[0][1] + m1.m[2][1] * m2.m[1][1] + m1.m[2][2] * m2.m[2][1] + m1.m[2][3] * m2.m[3][1];
-    num.m[2][2] = m1.m[2][0] * m2.m[0][2] + m1.m[2][1] * m2.m[1][2] + m1.m[2][2] * m2.m[2][2] + m1.m[2][3] * m2.m[3][2];
-    num.m[2][3] = m1.m[2][0] * m2.m[0][3] + m1.m[2][1] * m2.m[1][3] + m1.m[2][2] * m2.m[2][3] + m1.m[2][3] * m2.m[3][3];
-
-    num.m[3][0] = m1.m[3][0] * m2.m[0][0] + m1.m[3][1] * m2.m[1][0] + m1.m[3][2] * m2.m[2][0] + m1.m[3][3] * m2.m[3][0];
-    num.m[3][1] = m1.m[3][0] * m2.m[0][1] + m1.m[3][1] * m2.m[1][1] + m1.m[3][2] * m2.m[2][1] + m1.m[3][3] * m2.m[3][1];
-    num.m[3][2] = m1.m[3][0] * m2.m[0][2] + m1.m[3][1] * m2.m[1][2] + m1.m[3][2] * m2.m[2][2] + m1.m[3][3] * m2.m[3][2];
-    num.m[3][3] = m1.m[3][0] * m2.m[0][3] + m1.m[3][1] * m2.m[1][3] + m1.m[3][2] * m2.m[2][3] + m1.m[3][3] * m2.m[3][3];
-
-    return num;
-}
-Vector3 Multiply(const Vector3& m1, const float& m2)
-{
-    Vector3 num;
-    num.x = m1.x * m2;
-    num.y = m1.y * m2;
-    num.z = m1.z * m2;
-
-    return num;
-}
-Matrix4x4 Inverse(const Matrix4x4& m)
-{
-    float determinant;
-    Matrix4x4 num;
-
-    determinant = m.m[0][0] * m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[0][0] * m.m[1][2] * m.m[2][3] * m.m[3][1] + m.m[0][0] * m.m[1][3] * m.m[2][1] * m.m[3][2]
-        - m.m[0][0] * m.m[1][3] * m.m[2][2] * m.m[3][1] - m.m[0][0] * m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[0][0] * m.m[1][1] * m.m[2][3] * m.m[3][2]
-        - m.m[0][1] * m.m[1][0] * m.m[2][2] * m.m[3][3] - m.m[0][2] * m.m[1][0] * m.m[2][3] * m.m[3][1] - m.m[0][3] * m.m[1][0] * m.m[2][1] * m.m[3][2]
-        + m.m[0][3] * m.m[1][0] * m.m[2][2] * m.m[3][1] + m.m[0][2] * m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[0][1] * m.m[1][0] * m.m[2][3] * m.m[3][2]
-        + m.m[0][1] * m.m[1][2] * m.m[2][0] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] * m.m[3][1] + m.m[0][3] * m.m[1][1] * m.m[2][0] * m.m[3][2]
-        - m.m[0][3] * m.m[1][2] * m.m[2][0] * m.m[3][1] - m.m[0][2] * m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[0][1] * m.m[1][3] * m.m[2][0] * m.m[3][2]
-        - m.m[0][1] * m.m[1][2] * m.m[2][3] * m.m[3][0] - m.m[0][2] * m.m[1][3] * m.m[2][1] * m.m[3][0] - m.m[0][3] * m.m[1][1] * m.m[2][2] * m.m[3][0]
-        + m.m[0][3] * m.m[1][2] * m.m[2][1] * m.m[3][0] + m.m[0][2] * m.m[1][1] * m.m[2][3] * m.m[3][0] + m.m[0][1] * m.m[1][3] * m.m[2][2] * m.m[3][0];
-
-    if (determinant == 0.0f) {
-        return m;
-    };
-
-    num.m[0][0] = (m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[1][2] * m.m[2][3] * m.m[3][1] + m.m[1][3] * m.m[2][1] * m.m[3][2] - m.m[1][3] * m.m[2][2] * m.m[3][1] - m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[1][1] * m.m[2][3] * m.m[3][2]) / determinant;
-    num.m[0][1] = (-m.m[0][1] * m.m[2][2] * m.m[3][3] - m.m[0][2] * m.m[2][3] * m.m[3][1] - m.m[0][3] * m.m[2][1] * m.m[3][2] + m.m[0][3] * m.m[2][2] * m.m[3][1] + m.m[0][2] * m.m[2][1] * m.m[3][3] + m.m[0][1] * m.m[2][3] * m.m[3][2]) / determinant;
-    num.m[0][2] = (m.m[0][1] * m.m[1][2] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[3][1] + m.m[0][3] * m.m[1][1] * m.m[3][2] - m.m[0][3] * m.m[1][2] * m.m[3][1] - m.m[0][2] * m.m[1][1] * m.m[3][3] - m.m[0][1] * m.m[1][3] * m.m[3][2]) / determinant;
-    num.m[0][3] = (-m.m[0][1] * m.m[1][2] * m.m[2][3] - m.m[0][2] * m.m[1][3] * m.m[2][1] - m.m[0][3] * m.m[1][1] * m.m[2][2] + m.m[0][3] * m.m[1][2] * m.m[2][1] + m.m[0][2] * m.m[1][1] * m.m[2][3] + m.m[0][1] * m.m[1][3] * m.m[2][2]) / determinant;
-
-    num.m[1][0] = (-m.m[1][0] * m.m[2][2] * m.m[3][3] - m.m[1][2] * m.m[2][3] * m.m[3][0] - m.m[1][3] * m.m[2][0] * m.m[3][2] + m.m[1][3] * m.m[2][2] * m.m[3][0] + m.m[1][2] * m.m[2][0] * m.m[3][3] + m.m[1][0] * m.m[2][3] * m.m[3][2]) / determinant;
-    num.m[1][1] = (m.m[0][0] * m.m[2][2] * m.m[3][3] + m.m[0][2] * m.m[2][3] * m.m[3][0] + m.m[0][3] * m.m[2][0] * m.m[3][2] - m.m[0][3] * m.m[2][2] * m.m[3][0] - m.m[0][2] * m.m[2][0] * m.m[3][3] - m.m[0][0] * m.m[2][3] * m.m[3][2]) / determinant;
-    num.m[1][2] = (-m.m[0][0] * m.m[1][2] * m.m[3][3] - m.m[0][2] * m.m[1][3] * m.m[3][0] - m.m[0][3] * m.m[1][0] * m.m[3][2] + m.m[0][3] * m.m[1][2] * m.m[3][0] + m.m[0][2] * m.m[1][0] * m.m[3][3] + m.m[0][0] * m.m[1][3] * m.m[3][2]) / determinant;
-    num.m[1][3] = (m.m[0][0] * m.m[1][2] * m.m[2][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] + m.m[0][3] * m.m[1][0] * m.m[2][2] - m.m[0][3] * m.m[1][2] * m.m[2][0] - m.m[0][2] * m.m[1][0] * m.m[2][3] - m.m[0][0] * m.m[1][3] * m.m[2][2]) / determinant;
-
-    num.m[2][0] = (m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[1][1] * m.m[2][3] * m.m[3][0] + m.m[1][3] * m.m[2][0] * m.m[3][1] - m.m[1][3] * m.m[2][1] * m.m[3][0] - m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[1][0] * m.m[2][3] * m.m[3][1]) / determinant;
-    num.m[2][1] = (-m.m[0][0] * m.m[2][1] * m.m[3][3] - m.m[0][1] * m.m[2][3] * m.m[3][0] - m.m[0][3] * m.m[2][0] * m.m[3][1] + m.m[0][3] * m.m[2][1] * m.m[3][0] + m.m[0][1] * m.m[2][0] * m.m[3][3] + m.m[0][0] * m.m[2][3] * m.m[3][1]) / determinant;
-    num.m[2][2] = (m.m[0][0] * m.m[1][1] * m.m[3][3] + m.m[0][1] * m.m[1][3] * m.m[3][0] + m.m[0][3] * m.m[1][0] * m.m[3][1] - m.m[0][3] * m.m[1][1] * m.m[3][0] - m.m[0][1] * m.m[1][0] * m.m[3][3] - m.m[0][0] * m.m[1][3] * m.m[3][1]) / determinant;
-    num.m[2][3] = (-m.m[0][0] * m.m[1][1] * m.m[2][3] - m.m[0][1] * m.m[1][3] * m.m[2][0] - m.m[0][3] * m.m[1][0] * m.m[2][1] + m.m[0][3] * m.m[1][1] * m.m[2][0] + m.m[0][1] * m.m[1][0] * m.m[2][3] + m.m[0][0] * m.m[1][3] * m.m[2][1]) / determinant;
-
-    num.m[3][0] = (-m.m[1][0] * m.m[2][1] * m.m[3][2] - m.m[1][1] * m.m[2][2] * m.m[3][0] - m.m[1][2] * m.m[2][0] * m.m[3][1] + m.m[1][2] * m.m[2][1] * m.m[3][0] + m.m[1][1] * m.m[2][0] * m.m[3][2] + m.m[1][0] * m.m[2][2] * m.m[3][1]) / determinant;
-    num.m[3][1] = (m.m[0][0] * m.m[2][1] * m.m[3][2] + m.m[0][1] * m.m[2][2] * m.m[3][0] + m.m[0][2] * m.m[2][0] * m.m[3][1] - m.m[0][2] * m.m[2][1] * m.m[3][0] - m.m[0][1] * m.m[2][0] * m.m[3][2] - m.m[0][0] * m.m[2][2] * m.m[3][1]) / determinant;
-    num.m[3][2] = (-m.m[0][0] * m.m[1][1] * m.m[3][2] - m.m[0][1] * m.m[1][2] * m.m[3][0] - m.m[0][2] * m.m[1][0] * m.m[3][1] + m.m[0][2] * m.m[1][1] * m.m[3][0] + m.m[0][1] * m.m[1][0] * m.m[3][2] + m.m[0][0] * m.m[1][2] * m.m[3][1]) / determinant;
-    num.m[3][3] = (m.m[0][0] * m.m[1][1] * m.m[2][2] + m.m[0][1] * m.m[1][2] * m.m[2][0] + m.m[0][2] * m.m[1][0] * m.m[2][1] - m.m[0][2] * m.m[1][1] * m.m[2][0] - m.m[0][1] * m.m[1][0] * m.m[2][2] - m.m[0][0] * m.m[1][2] * m.m[2][1]) / determinant;
-
-    return num;
-}
-Vector3 Normalize(const Vector3& v)
-{
-    float Normalize;
-    Vector3 num;
-    Normalize = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
-    num.x = v.x / Normalize;
-    num.y = v.y / Normalize;
-    num.z = v.z / Normalize;
-    return num;
-}
-Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Vector3& translate)
-{
-    Matrix4x4 rotateX = MakeRotateXMatrix(rotate.x);
-    Matrix4x4 rotateY = MakeRotateYMatrix(rotate.y);
-    Matrix4x4 rotateZ = MakeRotateZMatrix(rotate.z);
-    Matrix4x4 rotateXYZ = Multiply(rotateX, Multiply(rotateY, rotateZ));
-
-    Matrix4x4 num;
-    num.m[0][0] = scale.x * rotateXYZ.m[0][0];
-    num.m[0][1] = scale.x * rotateXYZ.m[0][1];
-    num.m[0][2] = scale.x * rotateXYZ.m[0][2];
-    num.m[0][3] = 0.0f * 0.0f * 0.0f * 0.0f;
-    num.m[1][0] = scale.y * rotateXYZ.m[1][0];
-    num.m[1][1] = scale.y * rotateXYZ.m[1][1];
-    num.m[1][2] = scale.y * rotateXYZ.m[1][2];
-    num.m[1][3] = 0.0f * 0.0f * 0.0f * 0.0f;
-    num.m[2][0] = scale.z * rotateXYZ.m[2][0];
-    num.m[2][1] = scale.z * rotateXYZ.m[2][1];
-    num.m[2][2] = scale.z * rotateXYZ.m[2][2];
-    num.m[2][3] = 0.0f * 0.0f * 0.0f * 0.0f;
-    num.m[3][0] = translate.x;
-    num.m[3][1] = translate.y;
-    num.m[3][2] = translate.z;
-    num.m[3][3] = 1.0f;
-    return num;
-}
-
-Matrix4x4 MakePrespectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip)
-{
-    Matrix4x4 num;
-    num = { (1 / aspectRatio) * (1 / tanf(fovY / 2)), 0, 0, 0, 0, (1 / tanf(fovY / 2)), 0, 0, 0, 0, farClip / (farClip - nearClip), 1, 0, 0, (-nearClip * farClip) / (farClip - nearClip) };
-    return num;
-}
-Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float bottom, float nearClip, float farClip)
-{
-    Matrix4x4 num;
-    num = { 2 / (right - left), 0, 0, 0, 0, 2 / (top - bottom), 0, 0, 0, 0, 1 / (farClip - nearClip), 0, (left + right) / (left - right),
-        (top + bottom) / (bottom - top),
-        nearClip / (nearClip - farClip), 1 };
-    return num;
-}
-
-bool IsCollision(const AABB& aabb, const Vector3& point)
-{
-    if ((aabb.min.x <= point.x && aabb.max.x >= point.x)
-        && (aabb.min.y <= point.y && aabb.max.y >= point.y)
-        && (aabb.min.z <= point.z && aabb.max.z >= point.z)) {
-        return true;
-    }
-    return false;
-}
-
-Vector3 operator*(const Vector3& m1, const float& m2) { return Multiply(m1, m2); }
-Vector3& operator+=(Vector3& lhv, const Vector3& rhv)
-{
-    lhv.x += rhv.x;
-    lhv.y += rhv.y;
-    lhv.z += rhv.z;
-    return lhv;
-}
-
 Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferResource(const Microsoft::WRL::ComPtr<ID3D12Device>& device, size_t sizwInBytes)
 {
     // 頂点リソース用のヒープを設定
@@ -566,29 +239,6 @@ void Log(std::ostream& os, const std::string& message)
     OutputDebugStringA(message.c_str());
 }
 
-MaterialData LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename)
-{
-    MaterialData materialData; // 構築するMaterialData
-    std::string line; // ファイルから読み込んだ1行を格納するもの
-    std::ifstream file(directoryPath + "/" + filename); // ファイルを開く
-    assert(file.is_open()); // 開けられないなら止める
-
-    while (std::getline(file, line)) {
-        std::string identifier;
-        std::istringstream s(line);
-        s >> identifier;
-
-        // identfierに応じた処理
-        if (identifier == "map_Kd") {
-            std::string textureFilename;
-            s >> textureFilename;
-            // 連結してファイルパスにする
-            materialData.textureFilePath = directoryPath + "/" + textureFilename;
-        }
-    }
-    return materialData;
-}
-
 DirectX::ScratchImage LoadTexture(const std::string& filePath)
 {
     // テクスチャファイルを読み込んでプログラムで使えるようにする
@@ -605,156 +255,6 @@ DirectX::ScratchImage LoadTexture(const std::string& filePath)
     return mipImages;
 }
 
-ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename)
-{
-    ModelData modelData; // 構築するmodeldata
-    std::vector<Vector4> positions; // 位置
-    std::vector<Vector3> normals; // 法線
-    std::vector<Vector2> texcoords; // テクスチャ座標
-    std::string line; // ファイルから読んだ1行を格納するもの
-
-    // ファイルを開く
-    std::ifstream file(directoryPath + "/" + filename);
-    assert(file.is_open()); // 開けられないなら止める
-
-    while (std::getline(file, line)) {
-        std::string identifier;
-        std::istringstream s(line);
-        s >> identifier; // 先頭の識別子を読む
-
-        // identifierに応じた処理
-        if (identifier == "v") {
-            Vector4 position;
-            s >> position.x >> position.y >> position.z;
-            position.w = 1.0f;
-            positions.push_back(position);
-        } else if (identifier == "vt") {
-            Vector2 texcoord;
-            s >> texcoord.x >> texcoord.y;
-            texcoords.push_back(texcoord);
-        } else if (identifier == "vn") {
-            Vector3 normal;
-            s >> normal.x >> normal.y >> normal.z;
-            normals.push_back(normal);
-        } else if (identifier == "f") {
-            // 面は三角形限定,その他未対応
-
-            VertexData triangle[3];
-
-            for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex) {
-                std::string vertexDefinition;
-                s >> vertexDefinition;
-                // 頂点の要素へのindexは[位置/uv/法線]で格納されているので.分割してindexを取得する
-                std::istringstream v(vertexDefinition);
-                uint32_t elementIndeices[3];
-                for (int32_t element = 0; element < 3; ++element) {
-                    std::string index;
-                    std::getline(v, index, '/'); // 区切りインデクスを読んでいく
-                    elementIndeices[element] = std::stoi(index);
-                }
-                // 要素へのindexから,実際の要素の値を取得して,頂点を構築する
-                Vector4 position = positions[elementIndeices[0] - 1];
-                Vector2 texcoord = texcoords[elementIndeices[1] - 1];
-                Vector3 normal = normals[elementIndeices[2] - 1];
-
-                // 位置の反転&法線の反転&左下原点
-                position.x *= -1.0f;
-                texcoord.y = 1.0f - texcoord.y;
-                normal.x *= -1.0f;
-
-                triangle[faceVertex] = { position, texcoord, normal };
-            }
-            // 頂点を逆順で登録することで、周り順を逆にする
-            modelData.vertices.push_back(triangle[2]);
-            modelData.vertices.push_back(triangle[1]);
-            modelData.vertices.push_back(triangle[0]);
-        } else if (identifier == "mtllib") {
-            // materialTemplateLibraryファイルの名前を取得する
-            std::string materialFilename;
-            s >> materialFilename;
-            // 基本的のobjファイルと同一階級にmtlは存在させるので,ディレクトリ名とファイル名を返す
-            modelData.material = LoadMaterialTemplateFile(directoryPath, materialFilename);
-        }
-    }
-
-    return modelData;
-}
-
-SoundData SoundLoadWave(const char* filename)
-{
-
-    // ファイル入力ストリームのインスタンス
-    std::ifstream file;
-    // .wavファイルをバイナリモードで開く
-    file.open(filename, std::ios_base::binary);
-    // ファイルオープン失敗を検出する
-    assert(file.is_open());
-
-    // RIFFヘッダーの読み込み
-    RiffHeader riff;
-    file.read((char*)&riff, sizeof(riff));
-    // ファイルがRIFFかチェック
-    if (strncmp(riff.chunk.id, "RIFF", 4) != 0) {
-        assert(0);
-    }
-    // タイプがWAVEかチェック
-    if (strncmp(riff.type, "WAVE", 4) != 0) {
-        assert(0);
-    }
-
-    // Formatチャンクの読み込み
-    FormatChunk format = {};
-    // チャンクヘッダーの確認
-    file.read((char*)&format, sizeof(ChunkHeader));
-    if (strncmp(format.chunk.id, "fmt ", 4) != 0) {
-        assert(0);
-    }
-    // チャンク本体の読み込み
-    assert(format.chunk.size <= sizeof(format.fmt));
-    file.read((char*)&format.fmt, format.chunk.size);
-
-    // Dataチャンクの読み込み
-    ChunkHeader data;
-    file.read((char*)&data, sizeof(data));
-    // JUNKチャンクを検出した場合
-    if (strncmp(data.id, "JUNK", 4) == 0) {
-        // 読み込み位置をJUNKチャンクの終わりまで進める
-        file.seekg(data.size, std::ios_base::cur);
-        // 再度読み込み
-        file.read((char*)&data, sizeof(data));
-    }
-
-    if (strncmp(data.id, "data", 4) != 0) {
-        assert(0);
-    }
-
-    // Dataチャンクのデータ部の読み込み
-    char* pBuffer = new char[data.size];
-    file.read(pBuffer, data.size);
-
-    // waveファイルを閉じる
-    file.close();
-
-    // Returnするための音声データ
-    SoundData soundData = {};
-
-    soundData.wfex = format.fmt;
-    soundData.pBuffer = reinterpret_cast<BYTE*>(pBuffer);
-    soundData.bufferSize = data.size;
-
-    return soundData;
-}
-
-void SoundUhload(SoundData* soundData)
-{
-    // バッフアのメモリ解放
-    delete[] soundData->pBuffer;
-
-    soundData->pBuffer = 0;
-    soundData->bufferSize = 0;
-    soundData->wfex = {};
-}
-
 void SoundPlayWave(IXAudio2* xAudio2, const SoundData& soundData)
 {
     HRESULT result;
@@ -1313,6 +813,27 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     inputLayoutDesc.pInputElementDescs = inputElementDescs;
     inputLayoutDesc.NumElements = _countof(inputElementDescs);
 
+    // PackedVertexData用のInputLayout(Object3dPacked.VS.hlslで戻す)
+    D3D12_INPUT_ELEMENT_DESC packedInputElementDescs[3] = {};
+    packedInputElementDescs[0].SemanticName = "POSITION";
+    packedInputElementDescs[0].SemanticIndex = 0;
+    packedInputElementDescs[0].Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+    packedInputElementDescs[0].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+
+    packedInputElementDescs[1].SemanticName = "TEXCOORD";
+    packedInputElementDescs[1].SemanticIndex = 0;
+    packedInputElementDescs[1].Format = DXGI_FORMAT_R16G16_FLOAT;
+    packedInputElementDescs[1].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+
+    packedInputElementDescs[2].SemanticName = "NORMAL";
+    packedInputElementDescs[2].SemanticIndex = 0;
+    packedInputElementDescs[2].Format = DXGI_FORMAT_R16G16_SNORM;
+    packedInputElementDescs[2].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+
+    D3D12_INPUT_LAYOUT_DESC packedInputLayoutDesc {};
+    packedInputLayoutDesc.pInputElementDescs = packedInputElementDescs;
+    packedInputLayoutDesc.NumElements = _countof(packedInputElementDescs);
+
     // BlendStateの設定
     D3D12_BLEND_DESC blendDesc {};
     // 全ての色要素を書き込む
@@ -1372,6 +893,19 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     hr = device->CreateGraphicsPipelineState(&graphicsPipelineStateDesc, IID_PPV_ARGS(&graphicsPipelineState));
     assert(SUCCEEDED(hr));
 
+    // PackedVertexDataのモデル用(頂点シェーダーと入力レイアウトだけ違う)
+    Microsoft::WRL::ComPtr<IDxcBlob> packedVertexShaderBlob = CompileShader(L"Object3dPacked.VS.hlsl", L"vs_6_0", dxcUtils, dxcCompiler, includeHandler, logStream);
+    assert(packedVertexShaderBlob != nullptr);
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> packedGraphicsPipelineState = CreateGraphicsPipelineState(
+        device.Get(),
+        rootSignature.Get(),
+        packedInputLayoutDesc,
+        rasterizerDesc,
+        depthStencilDesc,
+        { packedVertexShaderBlob->GetBufferPointer(), packedVertexShaderBlob->GetBufferSize() },
+        { pixeShaderBlob->GetBufferPointer(), pixeShaderBlob->GetBufferSize() },
+        blendDesc);
+
     // Particle用RootParameter作成 ===========================================================================================================================
 
     // Particle用RootSignature作成
@@ -1600,11 +1134,18 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
     // Transform変数を作る
     Transform transform { { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
-    Transform cameratransform { { 1.0f, 1.0f, 1.0f }, { 0.3f, 3.14f, 0.0f }, { 0.0f, 4.0f, 10.0f } };
 
     float kWindowWidth = 1280.0f;
     float kWindowHeight = 720.0f;
 
+    // カメラ・球・モデル・パーティクルの状態
+    std::random_device seedGenerator;
+    Scene scene;
+    InitializeScene(scene, seedGenerator(), kWindowWidth / kWindowHeight);
+    // パーティクルの更新に使うスレッド(CPUのスレッド数)
+    ThreadPool threadPool;
+    scene.threadPool = &threadPool;
+
     // ImGui初期化
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -1702,18 +1243,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     VertexData* vertexDataSprite = nullptr;
     vertexResourceSprite->Map(0, nullptr, reinterpret_cast<void**>(&vertexDataSprite));
     // 1枚目
-    vertexDataSprite[0].position = { 0.0f, 360.0f, 0.0f, 1.0f };
-    vertexDataSprite[0].texcoord = { 0.0f, 1.0f };
-    vertexDataSprite[0].normal = { 0.0f, 0.0f, 1.0f };
-    vertexDataSprite[1].position = { 0.0f, 0.0f, 0.0f, 1.0f };
-    vertexDataSprite[1].texcoord = { 0.0f, 0.0f };
-    vertexDataSprite[1].normal = { 0.0f, 0.0f, 1.0f };
-    vertexDataSprite[2].position = { 640.0f, 360.0f, 0.0f, 1.0f };
-    vertexDataSprite[2].texcoord = { 1.0f, 1.0f };
-    vertexDataSprite[2].normal = { 0.0f, 0.0f, 1.0f };
-    vertexDataSprite[3].position = { 640.0f, 0.0f, 0.0f, 1.0f };
-    vertexDataSprite[3].texcoord = { 1.0f, 0.0f };
-    vertexDataSprite[3].normal = { 0.0f, 0.0f, 1.0f };
+    std::memcpy(vertexDataSprite, kSpriteVertices.data(), sizeof(VertexData) * kSpriteVertices.size());
 
     // インデックスリソースにデータを書き込む
     Microsoft::WRL::ComPtr<ID3D12Resource> indexResourceSprite = CreateBufferResource(device, sizeof(uint32_t) * 6);
@@ -1728,12 +1258,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
     uint32_t* indexDataSprite = nullptr;
     indexResourceSprite->Map(0, nullptr, reinterpret_cast<void**>(&indexDataSprite));
-    indexDataSprite[0] = 0;
-    indexDataSprite[1] = 1;
-    indexDataSprite[2] = 2;
-    indexDataSprite[3] = 1;
-    indexDataSprite[4] = 3;
-    indexDataSprite[5] = 2;
+    std::memcpy(indexDataSprite, kSpriteIndices.data(), sizeof(uint32_t) * kSpriteIndices.size());
 
     // Sprite用のマテリアルリソースを作る
     Microsoft::WRL::ComPtr<ID3D12Resource> materialResourceSprite = CreateBufferResource(device, sizeof(Material));
@@ -1782,10 +1307,18 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     // 弾
     // =============================================================================================
 
-    const uint32_t kSubdivision = 16;
+    // 球はPrimitiveCacheから取り出す(同じ形と細かさならバッファを1つにできる)
+    // 細かさを半分ずつにしたLODも一緒に作られる
+    PrimitiveCache primitiveCache;
+    const uint32_t kSubdivision = kSphereSubdivision * 2;
+    const PrimitiveMesh& sphereMesh = primitiveCache.Get(PrimitiveType::UVSphere, kSubdivision);
+    scene.sphereBounds = sphereMesh.boundingSphere;
+    scene.sphereLodCount = GetLodCount(sphereMesh.model);
     // 球の頂点数
-    const uint32_t sphervertexNum = (kSubdivision + 1) * (kSubdivision + 1);
-    const uint32_t spherindexNum = kSubdivision * kSubdivision * 6;
+    const uint32_t sphervertexNum = uint32_t(sphereMesh.model.vertices.size());
+    // LODのインデックスは元のメッシュの後ろに続けて入れる
+    const uint32_t spherindexSize = GetIndexSize(sphereMesh.model);
+    const uint32_t spherindexNum = uint32_t(GetTotalIndexCount(sphereMesh.model));
 
     // 頂点場合はびゅーを作成する
     Microsoft::WRL::ComPtr<ID3D12Resource> vertexResourcesphere = CreateBufferResource(device, sizeof(VertexData) * sphervertexNum);
@@ -1804,65 +1337,21 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     vertexResourcesphere->Map(0, nullptr, reinterpret_cast<void**>(&vertexDatasphere));
 
     // インデックスリソースにデータを書き込む
-    Microsoft::WRL::ComPtr<ID3D12Resource> indexResourcesphere = CreateBufferResource(device, sizeof(uint32_t) * spherindexNum);
+    Microsoft::WRL::ComPtr<ID3D12Resource> indexResourcesphere = CreateBufferResource(device, spherindexSize * spherindexNum);
 
     D3D12_INDEX_BUFFER_VIEW indexBufferViewsphere {};
     // リソースの先頭のアドレスから使う
     indexBufferViewsphere.BufferLocation = indexResourcesphere->GetGPUVirtualAddress();
-    // 使用するリソースのサイズはインデックス6つ分のサイズ
-    indexBufferViewsphere.SizeInBytes = sizeof(uint32_t) * spherindexNum;
-    // インデックスはuint32_Tとする
-    indexBufferViewsphere.Format = DXGI_FORMAT_R32_UINT;
-
-    uint32_t* indexDatasphere = nullptr;
-    indexResourcesphere->Map(0, nullptr, reinterpret_cast<void**>(&indexDatasphere));
-
-    const float kLonEvery = 2.0f * std::numbers::pi_v<float> / (float)kSubdivision;
-    const float KLatEvery = std::numbers::pi_v<float> / (float)kSubdivision;
-
-    for (uint32_t latIndex = 0; latIndex < (kSubdivision + 1); ++latIndex) {
-        float lat = -std::numbers::pi_v<float> / 2.0f + KLatEvery * float(latIndex);
-        for (uint32_t lonIndex = 0; lonIndex < (kSubdivision + 1); ++lonIndex) {
-            float lon = lonIndex * float(kLonEvery);
-
-            //  計算
-            VertexData a = {
-                { std::cosf(lat) * std::cosf(lon),
-                    std::sinf(lat),
-                    std::cosf(lat) * std::sinf(lon),
-                    1.0f },
-                { float(lonIndex) / float(kSubdivision),
-                    1.0f - float(latIndex) / float(kSubdivision) },
-                {
-                    std::cosf(lat) * std::cosf(lon),
-                    std::sinf(lat),
-                    std::cosf(lat) * std::sinf(lon),
-                }
-            };
-
-            uint32_t start = (latIndex * (kSubdivision + 1) + lonIndex);
-            vertexDatasphere[start] = a;
-        }
-    }
+    // 使用するリソースのサイズはインデックスの数分のサイズ
+    indexBufferViewsphere.SizeInBytes = spherindexSize * spherindexNum;
+    // 頂点が65536個以下なら16bit、それ以上なら32bitのインデックスにする
+    indexBufferViewsphere.Format = spherindexSize == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 
-    for (uint32_t lat = 0; lat < kSubdivision; ++lat) {
-        for (uint32_t lon = 0; lon < kSubdivision; ++lon) {
+    void* indexDatasphere = nullptr;
+    indexResourcesphere->Map(0, nullptr, &indexDatasphere);
 
-            uint32_t lt = lon + lat * (kSubdivision + 1);
-            uint32_t rt = (lon + 1) + lat * (kSubdivision + 1);
-            uint32_t lb = lon + (lat + 1) * (kSubdivision + 1);
-            uint32_t rb = (lon + 1) + (lat + 1) * (kSubdivision + 1);
-
-            uint32_t start = (lat * kSubdivision + lon) * 6;
-
-            indexDatasphere[start + 5] = lb;
-            indexDatasphere[start + 4] = lt;
-            indexDatasphere[start + 3] = rb;
-            indexDatasphere[start + 2] = lt;
-            indexDatasphere[start + 1] = rt;
-            indexDatasphere[start + 0] = rb;
-        }
-    }
+    std::memcpy(vertexDatasphere, sphereMesh.model.vertices.data(), sizeof(VertexData) * sphervertexNum);
+    CopyIndices(sphereMesh.model, indexDatasphere);
 
     // sphere用のtransformmatrix用のリソースを作る
     Microsoft::WRL::ComPtr<ID3D12Resource> transformationMatrixResourcesphere = CreateBufferResource(device, sizeof(TransformationMatrix));
@@ -1874,8 +1363,6 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     transformationMatrixDatasphere->WVP = MakeIdentity4x4();
     transformationMatrixDatasphere->world = MakeIdentity4x4();
     transformationMatrixDatasphere->worldInverseTranspose = MakeIdentity4x4();
-    // 動かす用のtransform
-    Transform transformsphere { { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
 
     // sphere用のマテリアルリソースを作る
     Microsoft::WRL::ComPtr<ID3D12Resource> materialResourcesphere = CreateBufferResource(device, sizeof(Material));
@@ -1907,7 +1394,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     // mapして書き込み
     CameraDataResourcesphere->Map(0, nullptr, reinterpret_cast<void**>(&CameraForGPUDatasphere));
     // 今回は白を書き込んでみる
-    CameraForGPUDatasphere->worldPosition = cameratransform.translate;
+    CameraForGPUDatasphere->worldPosition = scene.camera.GetTransform().translate;
 
     // 切り替えフラグ
     bool useMonsterBall = true;
@@ -1917,7 +1404,14 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     /// ==============================================================================================================
 
     // モデル読み込み
-    ModelData model = LoadObjFile("resources", "terrain.obj");
+    // 2回目からはresources/terrain.cg3meshを読む
+    ModelData model = LoadObjFileCached("resources", "terrain.obj");
+    scene.modelBounds = CalculateBounds(model);
+    scene.modelLodCount = GetLodCount(model);
+    scene.modelMeshlets = model.meshlets;
+    scene.modelMeshletBounds = model.meshletBounds;
+    // クリックでモデルを選んだり、球との当たり判定に使う
+    scene.modelBvh.Build(model, 0);
 
     // 画像読み込み
     DirectX::ScratchImage mip2 = LoadTexture("resources/grass.png");
@@ -1934,6 +1428,31 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
     device->CreateShaderResourceView(textureResource3.Get(), &srvDesc3, textureSrvHandleCPU3);
 
+    // マテリアル毎のテクスチャ(SRVは6番から使う)
+    // テクスチャの無いマテリアルは3枚目(grass.png)を使う
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> materialTextureResources;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> materialIntermediateResources;
+    std::vector<D3D12_GPU_DESCRIPTOR_HANDLE> materialSrvHandlesGPU;
+    for (const MaterialData& material : model.materials) {
+        if (material.textureFilePath.empty()) {
+            materialSrvHandlesGPU.push_back(textureSrvHandleGPU3);
+            continue;
+        }
+        uint32_t srvIndex = 6 + uint32_t(materialTextureResources.size());
+        DirectX::ScratchImage mipImagesMaterial = LoadTexture(material.textureFilePath);
+        const DirectX::TexMetadata& metadataMaterial = mipImagesMaterial.GetMetadata();
+        materialTextureResources.push_back(CreateTextureResource(device, metadataMaterial));
+        materialIntermediateResources.push_back(UploadTextureData(materialTextureResources.back(), mipImagesMaterial, device, commandList.Get()));
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDescMaterial {};
+        srvDescMaterial.Format = metadataMaterial.format;
+        srvDescMaterial.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDescMaterial.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDescMaterial.Texture2D.MipLevels = UINT(metadataMaterial.mipLevels);
+        device->CreateShaderResourceView(materialTextureResources.back().Get(), &srvDescMaterial, GetCPUDescriptorHandle(srvDescriptorHeap.Get(), desriptorSizeSRV, srvIndex));
+        materialSrvHandlesGPU.push_back(GetGPUDescriptorHandle(srvDescriptorHeap.Get(), desriptorSizeSRV, srvIndex));
+    }
+
     // 頂点リソースを作成
     Microsoft::WRL::ComPtr<ID3D12Resource> vertexResourceModel = CreateBufferResource(device, sizeof(VertexData) * model.vertices.size());
 
@@ -1948,19 +1467,38 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     vertexResourceModel->Map(0, nullptr, reinterpret_cast<void**>(&vertexDataModel)); // 書き込むためのアドレス取得
     std::memcpy(vertexDataModel, model.vertices.data(), sizeof(VertexData) * model.vertices.size()); // 頂点データをリソースにコピー
 
+    // 詰めた頂点(16バイト)のリソース。位置はモデルのAABBの中の0〜1にする
+    std::vector<PackedVertexData> packedVerticesModel = PackVertices(model.vertices, scene.modelBounds);
+    Microsoft::WRL::ComPtr<ID3D12Resource> packedVertexResourceModel = CreateBufferResource(device, sizeof(PackedVertexData) * packedVerticesModel.size());
+
+    D3D12_VERTEX_BUFFER_VIEW packedVertexBufferViewModel {};
+    packedVertexBufferViewModel.BufferLocation = packedVertexResourceModel->GetGPUVirtualAddress();
+    packedVertexBufferViewModel.SizeInBytes = UINT(sizeof(PackedVertexData) * packedVerticesModel.size());
+    packedVertexBufferViewModel.StrideInBytes = sizeof(PackedVertexData);
+
+    PackedVertexData* packedVertexDataModel = nullptr;
+    packedVertexResourceModel->Map(0, nullptr, reinterpret_cast<void**>(&packedVertexDataModel));
+    std::memcpy(packedVertexDataModel, packedVerticesModel.data(), sizeof(PackedVertexData) * packedVerticesModel.size());
+    scene.modelDequantizeMatrix = MakeDequantizeMatrix(scene.modelBounds);
+    scene.usePackedModel = true;
+
     // インデックスリソースにデータを書き込む
-    Microsoft::WRL::ComPtr<ID3D12Resource> indexResourceModel = CreateBufferResource(device, sizeof(uint32_t) * model.vertices.size());
+    // 頂点が65536個以下なら16bit、それ以上なら32bitのインデックスにする
+    // LODのインデックスは元のメッシュの後ろに続けて入れる
+    uint32_t indexSizeModel = GetIndexSize(model);
+    size_t indexCountModel = GetTotalIndexCount(model);
+    Microsoft::WRL::ComPtr<ID3D12Resource> indexResourceModel = CreateBufferResource(device, indexSizeModel * indexCountModel);
 
     D3D12_INDEX_BUFFER_VIEW indexBufferViewModel {};
     // リソースの先頭のアドレスから使う
     indexBufferViewModel.BufferLocation = indexResourceModel->GetGPUVirtualAddress();
-    // 使用するリソースのサイズはインデックス6つ分のサイズ
-    indexBufferViewModel.SizeInBytes = UINT(sizeof(uint32_t) * model.vertices.size());
-    // インデックスはuint32_Tとする
-    indexBufferViewModel.Format = DXGI_FORMAT_R32_UINT;
+    // 使用するリソースのサイズはインデックスの数分のサイズ
+    indexBufferViewModel.SizeInBytes = UINT(indexSizeModel * indexCountModel);
+    indexBufferViewModel.Format = indexSizeModel == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 
-    uint32_t* indexDataModel = nullptr;
-    indexResourceModel->Map(0, nullptr, reinterpret_cast<void**>(&indexDataModel));
+    void* indexDataModel = nullptr;
+    indexResourceModel->Map(0, nullptr, &indexDataModel);
+    CopyIndices(model, indexDataModel);
 
     // sphere用のマテリアルリソースを作る
     Microsoft::WRL::ComPtr<ID3D12Resource> materialResourceModel = CreateBufferResource(device, sizeof(Material));
@@ -1986,8 +1524,6 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     transformationMatrixDataModel->world = MakeIdentity4x4();
     transformationMatrixDataModel->worldInverseTranspose = MakeIdentity4x4();
 
-    Transform transformModel { { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
-
     // 平行光源
     Microsoft::WRL::ComPtr<ID3D12Resource> directionalLightMatrixResourceModel = CreateBufferResource(device, sizeof(DirectionalLight));
     // データを書き込み
@@ -2005,7 +1541,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     // mapして書き込み
     CameraDataResourceModel->Map(0, nullptr, reinterpret_cast<void**>(&CameraForGPUDataModel));
     // 今回は白を書き込んでみる
-    CameraForGPUDataModel->worldPosition = cameratransform.translate;
+    CameraForGPUDataModel->worldPosition = scene.camera.GetTransform().translate;
 
     // 共通ポイントライト
     Microsoft::WRL::ComPtr<ID3D12Resource> pointLigth = CreateBufferResource(device, sizeof(PointLigth));
@@ -2064,51 +1600,31 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     D3D12_GPU_DESCRIPTOR_HANDLE instancingSrvHandleGPU6 = GetGPUDescriptorHandle(srvDescriptorHeap.Get(), desriptorSizeSRV, 5);
     device->CreateShaderResourceView(instancingResource.Get(), &instancingSrvDesc, instancingSrvHandleCPU6);
 
-    std::random_device seedGenerator;
-    std::mt19937 randomEngine(seedGenerator());
-    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
-
-    Emitter emitter {};
-    emitter.count = 3;
-    emitter.frequency = 0.5f;
-    emitter.ferquencyTime = 0.0f;
-    emitter.transform.translate = { 0.0f, 0.0f, 0.0f };
-    emitter.transform.rotate = { 0.0f, 0.0f, 0.0f };
-    emitter.transform.scale = { 1.0f, 1.0f, 1.0f };
-
-    std::list<Particle> Particles;
-    Particles.push_back(MakeNewParticle(randomEngine, emitter.transform.translate));
-    Particles.push_back(MakeNewParticle(randomEngine, emitter.transform.translate));
-    Particles.push_back(MakeNewParticle(randomEngine, emitter.transform.translate));
-
-    const float kDeltaTime = 1.0f / 60.0f;
-
     // 頂点リソースを作成
-    Microsoft::WRL::ComPtr<ID3D12Resource> instancingvertexResource = CreateBufferResource(device, sizeof(VertexData) * model.vertices.size());
+    Microsoft::WRL::ComPtr<ID3D12Resource> instancingvertexResource = CreateBufferResource(device, sizeof(VertexData) * kParticleVertices.size());
 
     // 頂点バッファビューを作成
     D3D12_VERTEX_BUFFER_VIEW instancingvertexBufferView {};
     instancingvertexBufferView.BufferLocation = instancingvertexResource->GetGPUVirtualAddress(); // リソースの先頭のアドレスから使用
-    instancingvertexBufferView.SizeInBytes = UINT(sizeof(VertexData) * model.vertices.size()); // 使用するリソースのサイズ
+    instancingvertexBufferView.SizeInBytes = UINT(sizeof(VertexData) * kParticleVertices.size()); // 使用するリソースのサイズ
     instancingvertexBufferView.StrideInBytes = sizeof(VertexData); // 1頂点当たりのサイズ
 
     VertexData* instancingVertexData = nullptr;
     instancingvertexResource->Map(0, nullptr, reinterpret_cast<void**>(&instancingVertexData));
-    instancingVertexData[0] = { { 1.0f, 1.0f, 0.0f, 1.0f }, { 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
-    instancingVertexData[1] = { { -1.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
-    instancingVertexData[2] = { { 1.0f, -1.0f, 0.0f, 1.0f }, { 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f } };
-    instancingVertexData[3] = { { 1.0f, -1.0f, 0.0f, 1.0f }, { 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f } };
-    instancingVertexData[4] = { { -1.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
-    instancingVertexData[5] = { { -1.0f, -1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f }, { 0.0f, 0.0f, 1.0f } };
+    std::memcpy(instancingVertexData, kParticleVertices.data(), sizeof(VertexData) * kParticleVertices.size());
 
     /*for (uint32_t index = 0; index < kNumMaxInstance; ++index) {
         instancingData[index].color = Particles[index].color;
     }*/
 
-    AccelerationField accelerationField;
-    accelerationField.acceleration = { 15.0f, 0.0f, 0.0f };
-    accelerationField.area.min = { -1.0f, -1.0f, -1.0f };
-    accelerationField.area.max = { 1.0f, 1.0f, 1.0f };
+    // 更新処理の書き込み先
+    SceneTargets sceneTargets {};
+    sceneTargets.sphere = transformationMatrixDatasphere;
+    sceneTargets.model = transformationMatrixDataModel;
+    sceneTargets.sphereLight = directionalLightDatasphere;
+    sceneTargets.modelLight = directionalLightDataModel;
+    sceneTargets.instancing = instancingData;
+    sceneTargets.maxInstance = kNumMaxInstance;
 
     /// ============================================================================================================
     /// 音声データ
@@ -2138,7 +1654,10 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
     const char* blendModeNames[] = { "None", "Normal", "Add", "Subtract", "Multiply", "Screen" };
     static BlendMode blendMode = kBlendModeNone;
     static BlendMode prevMode = blendMode;
-    bool useBillboard = false;
+
+    // 最後にクリックしたモデルの三角形
+    bool isModelPicked = false;
+    RayHit modelPickHit {};
 
     MSG msg {};
     // ウィンドウの×ボタンが押されるまでループ
@@ -2156,18 +1675,19 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
             ImGui::Begin("Settings");
 
             if (ImGui::Button("add particle")) {
-                Particles.splice(Particles.end(), Emit(emitter, randomEngine));
+                Emit(scene.emitter, scene.randomEngine, scene.particles);
             }
 
-            ImGui::DragFloat3("EmitterTranslate", &emitter.transform.translate.x, 0.01f, -100.0f, 100.0f);
+            ImGui::DragFloat3("EmitterTranslate", &scene.emitter.transform.translate.x, 0.01f, -100.0f, 100.0f);
 
             prevMode = blendMode;
             ImGui::Combo("Mode", (int*)&blendMode, blendModeNames, IM_ARRAYSIZE(blendModeNames));
-            ImGui::Checkbox("useBillboard", &useBillboard);
+            ImGui::Checkbox("useBillboard", &scene.useBillboard);
+            ImGui::Checkbox("useCulling", &scene.useCulling);
+            ImGui::Text("particles: %zu / %zu", scene.particles.GetSize(), scene.particles.GetCapacity());
+            ImGui::Text("culled particles: %u", scene.culledParticleCount);
             if (ImGui::Button("add particle")) {
-                Particles.push_back(MakeNewParticle(randomEngine, emitter.transform.translate));
-                Particles.push_back(MakeNewParticle(randomEngine, emitter.transform.translate));
-                Particles.push_back(MakeNewParticle(randomEngine, emitter.transform.translate));
+                scene.particles.Spawn(scene.randomEngine, scene.emitter.transform.translate, 3);
             }
 
             if (blendMode != prevMode) {
@@ -2182,15 +1702,37 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
                     { vertexShaderBlob->GetBufferPointer(), vertexShaderBlob->GetBufferSize() },
                     { pixeShaderBlob->GetBufferPointer(), pixeShaderBlob->GetBufferSize() },
                     blendDesc);
+                packedGraphicsPipelineState = CreateGraphicsPipelineState(
+                    device.Get(),
+                    rootSignature.Get(),
+                    packedInputLayoutDesc,
+                    rasterizerDesc,
+                    depthStencilDesc,
+                    { packedVertexShaderBlob->GetBufferPointer(), packedVertexShaderBlob->GetBufferSize() },
+                    { pixeShaderBlob->GetBufferPointer(), pixeShaderBlob->GetBufferSize() },
+                    blendDesc);
 
                 prevMode = blendMode;
             }
 
             if (ImGui::CollapsingHeader("Model##Model")) {
-                ImGui::DragFloat3("Translate##Model", &transformModel.translate.x, 0.01f);
-                ImGui::SliderAngle("RotateX##Model", &transformModel.rotate.x);
-                ImGui::SliderAngle("RotateY##Model", &transformModel.rotate.y);
-                ImGui::SliderAngle("RotateZ##Model", &transformModel.rotate.z);
+                ImGui::Checkbox("usePackedVertex##Model", &scene.usePackedModel);
+                ImGui::Checkbox("useLod##Model", &scene.useModelLod);
+                ImGui::Text("LOD %u / %u", scene.modelLod, scene.modelLodCount - 1);
+                ImGui::Checkbox("useMeshletCulling##Model", &scene.useMeshletCulling);
+                ImGui::Text("meshlets %u / %u, culled triangles: frustum %zu, backface %zu", scene.modelMeshletStats.visibleMeshletCount,
+                    scene.modelMeshletStats.meshletCount, scene.modelMeshletStats.frustumCulledTriangleCount,
+                    scene.modelMeshletStats.backfaceCulledTriangleCount);
+                if (isModelPicked) {
+                    ImGui::Text("picked triangle %u (t %.4f)", modelPickHit.triangleIndex, modelPickHit.t);
+                } else {
+                    ImGui::Text("picked triangle: none");
+                }
+                ImGui::Text("sphere contacts: %zu triangles", scene.sphereContacts.size());
+                ImGui::DragFloat3("Translate##Model", &scene.modelTransform.translate.x, 0.01f);
+                ImGui::SliderAngle("RotateX##Model", &scene.modelTransform.rotate.x);
+                ImGui::SliderAngle("RotateY##Model", &scene.modelTransform.rotate.y);
+                ImGui::SliderAngle("RotateZ##Model", &scene.modelTransform.rotate.z);
                 ImGui::ColorEdit4("Color##Model", &(materialDataModel->color).x);
                 ImGui::SliderFloat3("direction##ModelLight", &directionalLightDataModel->direction.x, -1.0f, 1.0f);
                 ImGui::DragFloat("intensity##ModelLight", &directionalLightDataModel->intensity, 0.01f);
@@ -2199,8 +1741,15 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
             ImGui::End();
 
             ImGui::Begin("Ligth");
-            ImGui::DragFloat3("cameratransform##", &cameratransform.translate.x, 0.01f);
-            ImGui::DragFloat3("camerarotate##", &cameratransform.rotate.x, 0.01f);
+            // カメラは変更があったときだけ行列を作り直すのでSetを通す
+            Vector3 cameraTranslate = scene.camera.GetTransform().translate;
+            if (ImGui::DragFloat3("cameratransform##", &cameraTranslate.x, 0.01f)) {
+                scene.camera.SetTranslate(cameraTranslate);
+            }
+            Vector3 cameraRotate = scene.camera.GetTransform().rotate;
+            if (ImGui::DragFloat3("camerarotate##", &cameraRotate.x, 0.01f)) {
+                scene.camera.SetRotate(cameraRotate);
+            }
             if (ImGui::CollapsingHeader("PointLigthData##PointLigth")) {
                 ImGui::DragFloat3("Position##PointLigth", &PointLigthData->position.x, 0.01f);
                 ImGui::ColorEdit4("color##PointLigth", &(PointLigthData->color).x);
@@ -2221,89 +1770,34 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
             ImGui::End();
 
             ImGui::Begin("sphere");
-            ImGui::DragFloat3("Translate##Sphere", &transformsphere.translate.x, 0.01f);
-            ImGui::DragFloat3("Rotate##Sphere", &transformsphere.rotate.x, 0.01f);
-            ImGui::DragFloat3("Scale##Sphere", &transformsphere.scale.x, 0.01f);
+            ImGui::DragFloat3("Translate##Sphere", &scene.sphereTransform.translate.x, 0.01f);
+            ImGui::DragFloat3("Rotate##Sphere", &scene.sphereTransform.rotate.x, 0.01f);
+            ImGui::DragFloat3("Scale##Sphere", &scene.sphereTransform.scale.x, 0.01f);
             ImGui::ColorEdit4("Color##sphere", &(materialDatasphere->color).x);
             ImGui::Checkbox("useMonsterBall", &useMonsterBall);
+            ImGui::Checkbox("useLod##Sphere", &scene.useSphereLod);
+            ImGui::Text("LOD %u / %u", scene.sphereLod, scene.sphereLodCount - 1);
             ImGui::SliderFloat3("direction##SphereLight", &directionalLightDatasphere->direction.x, -1.0f, 1.0f);
             ImGui::DragFloat("intensity##SphereLight", &directionalLightDatasphere->intensity, 0.01f);
             ImGui::SliderFloat4("Color##SphereLight", &directionalLightDatasphere->color.x, -20.0f, 20.0f);
             ImGui::ColorEdit4("Color##SphereLight", &(directionalLightDatasphere->color).x);
             ImGui::End();
 
+            // ImGuiの上以外で左クリックしたら、カーソルの下にあるモデルの三角形を探す
+            ImGuiIO& io = ImGui::GetIO();
+            if (ImGui::IsMouseClicked(ImGuiMouseButton_Left) && !io.WantCaptureMouse) {
+                float ndcX = io.MousePos.x / io.DisplaySize.x * 2.0f - 1.0f;
+                float ndcY = 1.0f - io.MousePos.y / io.DisplaySize.y * 2.0f;
+                isModelPicked = PickModel(scene, ndcX, ndcY, modelPickHit);
+            }
+
             // update/更新処理
 
             // imguiのUI
             /* ImGui::ShowDemoWindow();*/
 
-            Matrix4x4 cameraMatrix = MakeAffineMatrix(cameratransform.scale, cameratransform.rotate, cameratransform.translate);
-            Matrix4x4 viewMatrix = Inverse(cameraMatrix);
-
-            // 球体
-            Matrix4x4 worldMatrixsphere = MakeAffineMatrix(transformsphere.scale, transformsphere.rotate, transformsphere.translate);
-            Matrix4x4 projectionMatrixsphere = MakePrespectiveFovMatrix(0.45f, float(kWindowWidth) / float(kWindowHeight), 0.1f, 100.0f);
-            Matrix4x4 worldViewProjectionMatrixsphere = Multiply(worldMatrixsphere, Multiply(viewMatrix, projectionMatrixsphere));
-            transformationMatrixDatasphere->WVP = worldViewProjectionMatrixsphere;
-            transformationMatrixDatasphere->world = worldMatrixsphere;
-            transformationMatrixDatasphere->worldInverseTranspose = Inverse(worldMatrixsphere);
-
-            directionalLightDatasphere->direction = Normalize(directionalLightDatasphere->direction);
-
-            // モデルデータ
-
-            Matrix4x4 worldMatrixModel = MakeAffineMatrix(transformModel.scale, transformModel.rotate, transformModel.translate);
-            Matrix4x4 projectionMatrixModel = MakePrespectiveFovMatrix(0.45f, float(kWindowWidth) / float(kWindowHeight), 0.1f, 100.0f);
-            Matrix4x4 worldViewProjectionMatrixModel = Multiply(worldMatrixModel, Multiply(viewMatrix, projectionMatrixModel));
-            transformationMatrixDataModel->WVP = worldViewProjectionMatrixModel;
-            transformationMatrixDataModel->world = worldMatrixModel;
-
-            directionalLightDataModel->direction = Normalize(directionalLightDataModel->direction);
-
-            Matrix4x4 backToFrontMatrix = MakeRotateYMatrix(std::numbers::pi_v<float>);
-            Matrix4x4 billboardMatrix = Multiply(backToFrontMatrix, cameraMatrix);
-            billboardMatrix.m[3][0] = 0.0f;
-            billboardMatrix.m[3][1] = 0.0f;
-            billboardMatrix.m[3][2] = 0.0f;
-
-            // 板ポリ
-            uint32_t numInstance = 0;
-            for (std::list<Particle>::iterator particleIterator = Particles.begin(); particleIterator != Particles.end();) {
-                if ((*particleIterator).lifeTime <= (*particleIterator).currentTime) {
-                    particleIterator = Particles.erase(particleIterator);
-                    continue;
-                }
-
-                if (IsCollision(accelerationField.area, (*particleIterator).transform.translate)) {
-                    (*particleIterator).velocity += accelerationField.acceleration * kDeltaTime;
-                }
-
-                if (numInstance < kNumMaxInstance) {
-                    Matrix4x4 worldMatrixpori = MakeAffineMatrix((*particleIterator).transform.scale, (*particleIterator).transform.rotate, (*particleIterator).transform.translate);
-                    if (useBillboard) {
-                        worldMatrixpori = Multiply(worldMatrixpori, billboardMatrix);
-                    }
-                    Matrix4x4 projectionMatrixpori = MakePrespectiveFovMatrix(0.45f, float(kWindowWidth) / float(kWindowHeight), 0.1f, 100.0f);
-                    Matrix4x4 worldViewProjectionMatrixpori = Multiply(worldMatrixpori, Multiply(viewMatrix, projectionMatrixpori));
-
-                    (*particleIterator).transform.translate += (*particleIterator).velocity * kDeltaTime;
-                    (*particleIterator).currentTime += kDeltaTime;
-                    float alpha = 1.0f - ((*particleIterator).currentTime / (*particleIterator).lifeTime);
-                    instancingData[numInstance].WVP = worldViewProjectionMatrixpori;
-                    instancingData[numInstance].world = worldMatrixpori;
-                    instancingData[numInstance].color = (*particleIterator).color;
-                    instancingData[numInstance].color.w = alpha;
-                    ++numInstance;
-                }
-
-                ++particleIterator;
-            }
-
-            emitter.ferquencyTime += kDeltaTime;
-            if (emitter.frequency <= emitter.ferquencyTime) {
-                Particles.splice(Particles.end(), Emit(emitter, randomEngine));
-                emitter.ferquencyTime -= emitter.frequency;
-            }
+            // カメラ・球・モデル・パーティクルの更新
+            uint32_t numInstance = UpdateScene(scene, sceneTargets);
 
             // draw
             ImGui::Render();
@@ -2360,14 +1854,24 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
             commandList->SetGraphicsRootConstantBufferView(6, spotLigth->GetGPUVirtualAddress());
             commandList->IASetIndexBuffer(&indexBufferViewsphere);
 
-            commandList->DrawIndexedInstanced(spherindexNum, 1, 0, 0, 0);
+            if (scene.isSphereVisible) {
+                uint32_t lodIndexOffset = GetLodIndexOffset(sphereMesh.model, scene.sphereLod);
+                for (const Submesh& submesh : GetLodSubmeshes(sphereMesh.model, scene.sphereLod)) {
+                    commandList->DrawIndexedInstanced(submesh.indexCount, 1, lodIndexOffset + submesh.indexOffset, 0, 0);
+                }
+            }
 
             //
             // モデルデータ
             //
 
-            commandList->SetGraphicsRootDescriptorTable(2, textureSrvHandleGPU3);
-            commandList->IASetVertexBuffers(0, 1, &vertexBufferViewModel);
+            // 詰めた頂点ならPSOと頂点バッファを切り替える(ルートシグネチャは同じ)
+            if (scene.usePackedModel) {
+                commandList->SetPipelineState(packedGraphicsPipelineState.Get());
+                commandList->IASetVertexBuffers(0, 1, &packedVertexBufferViewModel);
+            } else {
+                commandList->IASetVertexBuffers(0, 1, &vertexBufferViewModel);
+            }
             commandList->SetGraphicsRootConstantBufferView(0, materialResourceModel->GetGPUVirtualAddress());
             commandList->SetGraphicsRootConstantBufferView(1, transformationMatrixResourceModel->GetGPUVirtualAddress());
             commandList->SetGraphicsRootConstantBufferView(3, directionalLightMatrixResourceModel->GetGPUVirtualAddress());
@@ -2376,7 +1880,19 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
             commandList->IASetIndexBuffer(&indexBufferViewModel);
 
-            commandList->DrawInstanced(UINT(model.vertices.size()), 1, 0, 0);
+            if (scene.isModelVisible) {
+                // 三角形はマテリアル毎にまとめてあるので、テクスチャの切り替えはマテリアルの数で済む
+                // メッシュレットのカリングをしたときは、残った範囲だけを描く
+                uint32_t lodIndexOffset = GetLodIndexOffset(model, scene.modelLod);
+                const std::vector<Submesh>& drawRanges = scene.isModelMeshletCulled ? scene.modelDrawRanges : GetLodSubmeshes(model, scene.modelLod);
+                for (const Submesh& submesh : drawRanges) {
+                    if (submesh.indexCount == 0) {
+                        continue;
+                    }
+                    commandList->SetGraphicsRootDescriptorTable(2, materialSrvHandlesGPU[submesh.materialIndex]);
+                    commandList->DrawIndexedInstanced(submesh.indexCount, 1, lodIndexOffset + submesh.indexOffset, 0, 0);
+                }
+            }
 
             // 板ポリ
             commandList->SetGraphicsRootSignature(ParticlerootSignature.Get());